@@ -672,6 +672,62 @@ CPLErr KEARasterBand::DeleteNoDataValue()
     }
 }
 
+double KEARasterBand::GetOffset(int *pbSuccess)
+{
+    try
+    {
+        double dfOffset = this->m_pImageIO->getImageBandOffset(this->nBand);
+        if( pbSuccess != nullptr )
+            *pbSuccess = 1;
+        return dfOffset;
+    }
+    catch (const kealib::KEAIOException &)
+    {
+        return GDALPamRasterBand::GetOffset(pbSuccess);
+    }
+}
+
+CPLErr KEARasterBand::SetOffset(double dfNewOffset)
+{
+    try
+    {
+        this->m_pImageIO->setImageBandOffset(this->nBand, dfNewOffset);
+    }
+    catch (const kealib::KEAIOException &)
+    {
+        return CE_Failure;
+    }
+    return CE_None;
+}
+
+double KEARasterBand::GetScale(int *pbSuccess)
+{
+    try
+    {
+        double dfScale = this->m_pImageIO->getImageBandScale(this->nBand);
+        if( pbSuccess != nullptr )
+            *pbSuccess = 1;
+        return dfScale;
+    }
+    catch (const kealib::KEAIOException &)
+    {
+        return GDALPamRasterBand::GetScale(pbSuccess);
+    }
+}
+
+CPLErr KEARasterBand::SetScale(double dfNewScale)
+{
+    try
+    {
+        this->m_pImageIO->setImageBandScale(this->nBand, dfNewScale);
+    }
+    catch (const kealib::KEAIOException &)
+    {
+        return CE_Failure;
+    }
+    return CE_None;
+}
+
 CPLErr KEARasterBand::GetDefaultHistogram( double *pdfMin, double *pdfMax,
                                         int *pnBuckets, GUIntBig ** ppanHistogram,
                                         int bForce,
@@ -100,6 +100,12 @@ public:
 
     virtual CPLErr DeleteNoDataValue();
 
+    // virtual methods for the scale and offset
+    virtual double GetOffset(int *pbSuccess=nullptr);
+    virtual CPLErr SetOffset(double dfNewOffset);
+    virtual double GetScale(int *pbSuccess=nullptr);
+    virtual CPLErr SetScale(double dfNewScale);
+
     // histogram methods
     CPLErr GetDefaultHistogram( double *pdfMin, double *pdfMax,
                                         int *pnBuckets, GUIntBig ** ppanHistogram,
@@ -274,6 +274,8 @@ void CopyRAT(GDALRasterBand *pBand, kealib::KEAImageIO *pImageIO, int nBand)
         delete[] pnInt64Buffer;
         delete[] pfDoubleBuffer;
 
+        // the last rows may still be buffered, write them while errors can be reported
+        keaAtt->flush();
         delete keaAtt;
         for(auto iterField = fields->begin(); iterField != fields->end(); ++iterField)
         {
@@ -131,32 +131,31 @@ GDALDataset *KEADataset::Open( GDALOpenInfo * poOpenInfo )
     {
         try
         {
+            // a page buffer only helps files created with PAGE_SIZE
+            size_t nPageBufSize = kealib::KEA_PAGE_BUF_SIZE;
+            const char *pszValue = CSLFetchNameValue( poOpenInfo->papszOpenOptions, "PAGE_BUF_SIZE" );
+            if( pszValue != nullptr )
+                nPageBufSize = atol( pszValue );
+
             // try and open it in the appropriate mode
-            H5::H5File *pH5File;
+            H5::H5File *pH5File = nullptr;
             if( poOpenInfo->eAccess == GA_ReadOnly )
             {
                 // use the virtual driver so we can open files using
                 // /vsicurl etc
-                // do this same as libkea
-                H5::FileAccPropList keaAccessPlist =
-                    H5::FileAccPropList(H5::FileAccPropList::DEFAULT);
-                keaAccessPlist.setCache(
-                    kealib::KEA_MDC_NELMTS, kealib::KEA_RDCC_NELMTS,
-                    kealib::KEA_RDCC_NBYTES, kealib::KEA_RDCC_W0);
-                keaAccessPlist.setSieveBufSize(kealib::KEA_SIEVE_BUF);
-                hsize_t blockSize = kealib::KEA_META_BLOCKSIZE;
-                keaAccessPlist.setMetaBlockSize(blockSize);
-                // but set the driver
-                keaAccessPlist.setDriver(HDF5VFLGetFileDriver(), nullptr);
-
-                const H5std_string keaImgFilePath(poOpenInfo->pszFilename);
-                pH5File = new H5::H5File(keaImgFilePath, H5F_ACC_RDONLY,
-                                         H5::FileCreatPropList::DEFAULT,
-                                         keaAccessPlist);
+                pH5File = kealib::KEAImageIO::openKeaH5RDOnly( poOpenInfo->pszFilename,
+                                    kealib::KEA_MDC_NELMTS, kealib::KEA_RDCC_NELMTS,
+                                    kealib::KEA_RDCC_NBYTES, kealib::KEA_RDCC_W0,
+                                    kealib::KEA_SIEVE_BUF, kealib::KEA_META_BLOCKSIZE,
+                                    nPageBufSize, HDF5VFLGetFileDriver() );
             }
             else
             {
-                pH5File = kealib::KEAImageIO::openKeaH5RW( poOpenInfo->pszFilename );
+                pH5File = kealib::KEAImageIO::openKeaH5RW( poOpenInfo->pszFilename,
+                                    kealib::KEA_MDC_NELMTS, kealib::KEA_RDCC_NELMTS,
+                                    kealib::KEA_RDCC_NBYTES, kealib::KEA_RDCC_W0,
+                                    kealib::KEA_SIEVE_BUF, kealib::KEA_META_BLOCKSIZE,
+                                    nPageBufSize );
             }
             // create the KEADataset object
             KEADataset *pDataset = new KEADataset( pH5File, poOpenInfo->eAccess );
@@ -245,7 +244,7 @@ GDALDataset *KEADataset::Create( const char * pszFilename,
     if( pszValue != nullptr )
         nimageblockSize = atol( pszValue );
 
-    unsigned int nattblockSize = kealib::KEA_ATT_CHUNK_SIZE;
+    unsigned int nattblockSize = kealib::KEA_ATT_CHUNK_SIZE_AUTO;
     pszValue = CSLFetchNameValue( papszParmList, "ATTBLOCKSIZE" );
     if( pszValue != nullptr )
         nattblockSize = atol( pszValue );
@@ -280,6 +279,11 @@ GDALDataset *KEADataset::Create( const char * pszFilename,
     if( pszValue != nullptr )
         nmetaBlockSize = atol( pszValue );
 
+    hsize_t nfileSpacePageSize = kealib::KEA_FILE_SPACE_PAGE_SIZE;
+    pszValue = CSLFetchNameValue( papszParmList, "PAGE_SIZE" );
+    if( pszValue != nullptr )
+        nfileSpacePageSize = atol( pszValue );
+
     unsigned int ndeflate = kealib::KEA_DEFLATE;
     pszValue = CSLFetchNameValue( papszParmList, "DEFLATE" );
     if( pszValue != nullptr )
@@ -299,7 +303,8 @@ GDALDataset *KEADataset::Create( const char * pszFilename,
                                                     nullptr, nullptr, nimageblockSize, 
                                                     nattblockSize, nmdcElmts, nrdccNElmts,
                                                     nrdccNBytes, nrdccW0, nsieveBuf, 
-                                                    nmetaBlockSize, ndeflate );
+                                                    nmetaBlockSize, ndeflate,
+                                                    kealib::kea_extend_none, nfileSpacePageSize );
 
         // create our dataset object                            
         KEADataset *pDataset = new KEADataset( keaImgH5File, GA_Update );
@@ -353,7 +358,7 @@ GDALDataset *KEADataset::CreateCopy( const char * pszFilename, GDALDataset *pSrc
     if( pszValue != nullptr )
         nimageblockSize = atol( pszValue );
 
-    unsigned int nattblockSize = kealib::KEA_ATT_CHUNK_SIZE;
+    unsigned int nattblockSize = kealib::KEA_ATT_CHUNK_SIZE_AUTO;
     pszValue = CSLFetchNameValue( papszParmList, "ATTBLOCKSIZE" );
     if( pszValue != nullptr )
         nattblockSize = atol( pszValue );
@@ -388,6 +393,11 @@ GDALDataset *KEADataset::CreateCopy( const char * pszFilename, GDALDataset *pSrc
     if( pszValue != nullptr )
         nmetaBlockSize = atol( pszValue );
 
+    hsize_t nfileSpacePageSize = kealib::KEA_FILE_SPACE_PAGE_SIZE;
+    pszValue = CSLFetchNameValue( papszParmList, "PAGE_SIZE" );
+    if( pszValue != nullptr )
+        nfileSpacePageSize = atol( pszValue );
+
     unsigned int ndeflate = kealib::KEA_DEFLATE;
     pszValue = CSLFetchNameValue( papszParmList, "DEFLATE" );
     if( pszValue != nullptr )
@@ -404,39 +414,67 @@ GDALDataset *KEADataset::CreateCopy( const char * pszFilename, GDALDataset *pSrc
     int nBands = pSrcDs->GetRasterCount();
     GDALDataType eType = pSrcDs->GetRasterBand(1)->GetRasterDataType();
 
+    // another KEA file with the layout left alone can be cloned
+    // without decompressing and recompressing every chunk. THEMATIC
+    // doesn't change the layout, it is applied to the result below.
+    KEADataset *pSrcKEADs = dynamic_cast<KEADataset*>( pSrcDs );
+    bool bCloneFile = ( pSrcKEADs != nullptr ) &&
+                ( CSLFetchNameValue( papszParmList, "IMAGEBLOCKSIZE" ) == nullptr ) &&
+                ( CSLFetchNameValue( papszParmList, "ATTBLOCKSIZE" ) == nullptr ) &&
+                ( CSLFetchNameValue( papszParmList, "DEFLATE" ) == nullptr ) &&
+                ( CSLFetchNameValue( papszParmList, "PAGE_SIZE" ) == nullptr );
+
     try
     {
-        // now create it
-        H5::H5File *keaImgH5File = kealib::KEAImageIO::createKEAImage( pszFilename,
-                                                    GDAL_to_KEA_Type( eType ),
-                                                    nXSize, nYSize, nBands,
-                                                    nullptr, nullptr, nimageblockSize, 
-                                                    nattblockSize, nmdcElmts, nrdccNElmts,
-                                                    nrdccNBytes, nrdccW0, nsieveBuf, 
-                                                    nmetaBlockSize, ndeflate );
-
-        // create the imageio
-        kealib::KEAImageIO *pImageIO = new kealib::KEAImageIO();
-        
-        // open the file
-        pImageIO->openKEAImageHeader( keaImgH5File );
-
-        // copy file
-        if( !CopyFile( pSrcDs, pImageIO, pfnProgress, pProgressData) )
+        H5::H5File *keaImgH5File = nullptr;
+        if( bCloneFile )
         {
-            delete pImageIO;
-            return nullptr;
-        }
-
-        // close it
-        try
-        {
-            pImageIO->close();
+            kealib::KEAImageIO *pSrcImageIO = static_cast<kealib::KEAImageIO*>( pSrcKEADs->GetInternalHandle( nullptr ) );
+            // make sure anything GDAL has cached in the source is on disk first
+            pSrcKEADs->FlushCache();
+            keaImgH5File = kealib::KEAImageIO::cloneKEAImage( pSrcImageIO, pszFilename,
+                                                    nmdcElmts, nrdccNElmts, nrdccNBytes,
+                                                    nrdccW0, nsieveBuf, nmetaBlockSize );
+            keaImgH5File->close();
+            delete keaImgH5File;
+            if( pfnProgress != nullptr )
+                pfnProgress( 1.0, nullptr, pProgressData );
         }
-        catch (const kealib::KEAIOException &e)
+        else
         {
+            // now create it
+            keaImgH5File = kealib::KEAImageIO::createKEAImage( pszFilename,
+                                                        GDAL_to_KEA_Type( eType ),
+                                                        nXSize, nYSize, nBands,
+                                                        nullptr, nullptr, nimageblockSize, 
+                                                        nattblockSize, nmdcElmts, nrdccNElmts,
+                                                        nrdccNBytes, nrdccW0, nsieveBuf, 
+                                                        nmetaBlockSize, ndeflate,
+                                                        kealib::kea_extend_none, nfileSpacePageSize );
+
+            // create the imageio
+            kealib::KEAImageIO *pImageIO = new kealib::KEAImageIO();
+        
+            // open the file
+            pImageIO->openKEAImageHeader( keaImgH5File );
+
+            // copy file
+            if( !CopyFile( pSrcDs, pImageIO, pfnProgress, pProgressData) )
+            {
+                delete pImageIO;
+                return nullptr;
+            }
+
+            // close it
+            try
+            {
+                pImageIO->close();
+            }
+            catch (const kealib::KEAIOException &e)
+            {
+            }
+            delete pImageIO;
         }
-        delete pImageIO;
 
         // now open it again - because the constructor loads all the info
         // in we need to copy the data first....
@@ -447,6 +485,7 @@ GDALDataset *KEADataset::CreateCopy( const char * pszFilename, GDALDataset *pSrc
         pDataset->SetDescription( pszFilename );
 
         // set all to thematic if asked - overrides whatever set by CopyFile
+        // or came with the cloned file
         if( bThematic )
         {
             for( int nCount = 0; nCount < nBands; nCount++ )
@@ -787,7 +826,7 @@ CPLErr KEADataset::AddBand(GDALDataType eType, char **papszOptions)
 {
     // process any creation options in papszOptions
     unsigned int nimageBlockSize = kealib::KEA_IMAGE_CHUNK_SIZE;
-    unsigned int nattBlockSize = kealib::KEA_ATT_CHUNK_SIZE;
+    unsigned int nattBlockSize = kealib::KEA_ATT_CHUNK_SIZE_AUTO;
     unsigned int ndeflate = kealib::KEA_DEFLATE;
     if (papszOptions != nullptr) {
         const char *pszValue = CSLFetchNameValue(papszOptions,"IMAGEBLOCKSIZE");
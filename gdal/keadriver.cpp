@@ -58,7 +58,7 @@ void GDALRegister_KEA()
         poDriver->SetMetadataItem( GDAL_DMD_CREATIONOPTIONLIST, "\
 <CreationOptionList> \
 <Option name='IMAGEBLOCKSIZE' type='int' description='The size of each block for image data'/> \
-<Option name='ATTBLOCKSIZE' type='int' description='The size of each block for attribute data'/> \
+<Option name='ATTBLOCKSIZE' type='int' description='The size of each block for attribute data (0 chooses it from the number of rows)'/> \
 <Option name='MDC_NELMTS' type='int' description='Number of elements in the meta data cache'/> \
 <Option name='RDCC_NELMTS' type='int' description='Number of elements in the raw data chunk cache'/> \
 <Option name='RDCC_NBYTES' type='int' description='Total size of the raw data chunk cache, in bytes'/> \
@@ -67,7 +67,12 @@ void GDALRegister_KEA()
 <Option name='META_BLOCKSIZE' type='int' description='Sets the minimum size of metadata block allocations'/> \
 <Option name='DEFLATE' type='int' description='0 (no compression) to 9 (max compression)'/> \
 <Option name='THEMATIC' type='boolean' description='If YES then all bands are set to thematic'/> \
+<Option name='PAGE_SIZE' type='int' description='File space page size in bytes. Enables paged aggregation (needs HDF5 1.10.1 to read)'/> \
 </CreationOptionList>" );
+        poDriver->SetMetadataItem( GDAL_DMD_OPENOPTIONLIST, "\
+<OpenOptionList> \
+<Option name='PAGE_BUF_SIZE' type='int' description='Size of the page buffer in bytes, for files created with PAGE_SIZE'/> \
+</OpenOptionList>" );
 
         // pointer to open function
         poDriver->pfnOpen = KEADataset::Open;
@@ -55,6 +55,15 @@ KEARasterAttributeTable::KEARasterAttributeTable(kealib::KEAAttributeTable *poKE
 
 KEARasterAttributeTable::~KEARasterAttributeTable()
 {
+    // the destructor of the table can't report a failed write
+    try
+    {
+        m_poKEATable->flush();
+    }
+    catch(const kealib::KEAException &e)
+    {
+        CPLError( CE_Failure, CPLE_AppDefined, "Failed to write attributes: %s", e.what() );
+    }
     // can't just delete thanks to Windows
     kealib::KEAAttributeTable::destroyAttributeTable(m_poKEATable);
     CPLDestroyMutex( m_hMutex );
@@ -708,6 +717,7 @@ CPLErr KEARasterAttributeTable::ValuesIO(GDALRWFlag eRWFlag, int iField, int iSt
             "Dataset not open in update mode");
         return CE_Failure;
     }*/
+    CPLMutexHolderD( &m_hMutex );
 
     if( iField < 0 || iField >= (int) m_aoFields.size() )
     {
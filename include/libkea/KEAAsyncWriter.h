@@ -0,0 +1,138 @@
+/*
+ *  KEAAsyncWriter.h
+ *  LibKEA
+ *
+ *  Copyright 2026 LibKEA. All rights reserved.
+ *
+ *  This file is part of LibKEA.
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify,
+ *  merge, publish, distribute, sublicense, and/or sell copies of the
+ *  Software, and to permit persons to whom the Software is furnished
+ *  to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ *  ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *  CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef KEAAsyncWriter_H
+#define KEAAsyncWriter_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "libkea/KEACommon.h"
+#include "libkea/KEAException.h"
+
+namespace kealib{
+    
+    class KEAImageIO;
+    
+    /**
+     * Write-behind queue for KEAImageIO::writeImageBlock2BandAsync. Blocks
+     * are copied into a bounded queue and written by a dedicated thread.
+     * Adjacent partial blocks are held back and merged until they cover
+     * whole chunks so each chunk is compressed and written once. A partial
+     * block is written anyway if no neighbour turns up within a short time.
+     */
+    class KEA_EXPORT KEAAsyncWriter
+    {
+    public:
+        KEAAsyncWriter(KEAImageIO *io, uint64_t maxQueuedBytes=KEA_WRITE_QUEUE_SIZE);
+        KEAAsyncWriter(const KEAAsyncWriter&) = delete;
+        KEAAsyncWriter& operator=(const KEAAsyncWriter&) = delete;
+        
+        /**
+         * Copies the block and queues it, blocking while the queue is full.
+         * The future becomes ready once the block is in the file, or holds
+         * the exception if the write failed.
+         */
+        std::future<void> submit(uint32_t band, const void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeOut, uint64_t ySizeOut, uint64_t xSizeBuf, KEADataType inDataType);
+        
+        /**
+         * Blocks until everything submitted so far has been written. The
+         * first error since the last call is rethrown.
+         */
+        void wait();
+        
+        void setMaxQueuedBytes(uint64_t maxQueuedBytes);
+        uint64_t getMaxQueuedBytes();
+        
+        /**
+         * Writes anything still queued and stops the writer thread. Errors
+         * are not reported, call wait() first to get them.
+         */
+        ~KEAAsyncWriter();
+        
+    protected:
+        struct KEAWriteRequest
+        {
+            uint32_t band;
+            KEADataType dataType;
+            uint64_t xOff;
+            uint64_t yOff;
+            uint64_t xSize;
+            uint64_t ySize;
+            std::vector<char> data;
+            std::promise<void> promise;
+        };
+        
+        // requests which together cover a rectangle
+        struct KEAWriteGroup
+        {
+            uint32_t band;
+            KEADataType dataType;
+            uint64_t xOff;
+            uint64_t yOff;
+            uint64_t xSize;
+            uint64_t ySize;
+            std::vector<KEAWriteRequest*> parts;
+        };
+        
+        void writerLoop();
+        uint64_t addToHeld(KEAWriteRequest *request);
+        bool chunkAligned(const KEAWriteGroup &group);
+        uint64_t writeGroup(KEAWriteGroup &group);
+        
+        KEAImageIO *io;
+        std::thread writer;
+        std::mutex queueMutex;
+        std::condition_variable queueCond;
+        std::condition_variable spaceCond;
+        std::condition_variable idleCond;
+        std::deque<KEAWriteRequest*> queue;
+        uint64_t maxQueuedBytes;
+        // bytes queued or held which have not been written
+        uint64_t queuedBytes;
+        uint32_t numWaiting;
+        uint32_t numBlockedProducers;
+        bool busy;
+        bool stopping;
+        std::exception_ptr firstError;
+        
+        // only touched by the writer thread
+        std::vector<KEAWriteGroup> held;
+        std::map<uint32_t, uint64_t> bandBlockSizes;
+    };
+    
+}
+
+#endif
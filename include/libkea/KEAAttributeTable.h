@@ -173,20 +173,60 @@ namespace kealib{
         virtual size_t getMaxGlobalColIdx() const;
         virtual void addRows(size_t numRows)=0;
         
-        virtual void exportToKeaFile(H5::H5File *keaImg, unsigned int band, unsigned int chunkSize=KEA_ATT_CHUNK_SIZE, unsigned int deflate=KEA_DEFLATE)=0;
+        virtual void exportToKeaFile(H5::H5File *keaImg, unsigned int band, unsigned int chunkSize=KEA_ATT_CHUNK_SIZE_AUTO, unsigned int deflate=KEA_DEFLATE)=0;
         virtual void exportToASCII(const std::string &outputFile);
         
+        /**
+         * Writes any changes the table still holds in memory to the file.
+         * Nothing to do for tables which are not backed by a file. Call it
+         * before destroyAttributeTable() to see any error, the destructor
+         * has to discard them.
+         */
+        virtual void flush();
+        
         virtual void printAttributeTableHeaderInfo();
         
         virtual ~KEAAttributeTable();
 
         // for cross heap use in Windows
         static void destroyAttributeTable(KEAAttributeTable *pTable);
+        
+        /**
+         * Returns the chunk size (rows) to use for a table of numRows rows when
+         * KEA_ATT_CHUNK_SIZE_AUTO is given: KEA_ATT_CHUNK_SIZE for small tables,
+         * doubled until it covers the table or a chunk of elementSize byte
+         * values would exceed KEA_ATT_CHUNK_BYTES.
+         */
+        static size_t getAutoChunkSize(size_t numRows, size_t elementSize=sizeof(int64_t));
+        /**
+         * Read/write the flag on the chunk size header of a band's table which
+         * records that the chunk size is chosen from the number of rows when
+         * the table is exported or the image repacked.
+         */
+        static bool getAutoChunkSizeFlag(H5::H5File *keaImg, const std::string &bandPathBase);
+        static void setAutoChunkSizeFlag(H5::H5File *keaImg, const std::string &bandPathBase, bool autoChunkSize);
+        /**
+         * Read/bump the counter on the chunk size header of a band's table
+         * which changes whenever its data datasets are replaced, so open
+         * tables can tell their dataset handles are out of date. 0 if the
+         * table has never been rechunked.
+         */
+        static uint64_t getDataGeneration(H5::H5File *keaImg, const std::string &bandPathBase);
+        static void bumpDataGeneration(H5::H5File *keaImg, const std::string &bandPathBase);
     protected:
         static H5::CompType* createAttibuteIdxCompTypeDisk();
         static H5::CompType* createAttibuteIdxCompTypeMem();
         static H5::CompType* createKeaStringCompTypeDisk();
         static H5::CompType* createKeaStringCompTypeMem();
+        /**
+         * Copies a data (or neighbours) dataset of a table to one with
+         * chunkRows rows per chunk, keeping its type, extent and filters
+         * apart from the deflate level unless it is KEA_REPACK_KEEP.
+         * Nothing is done if it is already stored that way. Returns whether
+         * the dataset was replaced, in which case the caller must bump the
+         * table's data generation.
+         */
+        static bool rechunkDataset(H5::H5File *keaImg, const std::string &path, hsize_t chunkRows, uint32_t deflate=KEA_REPACK_KEEP);
         virtual void addAttBoolField(KEAATTField field, bool val)=0;
         virtual void addAttIntField(KEAATTField field, int64_t val)=0;
         virtual void addAttFloatField(KEAATTField field, float val)=0;
@@ -32,7 +32,11 @@
 #define KEAAttributeTableFile_H
 
 #include <iostream>
+#include <list>
+#include <map>
+#include <mutex>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include <H5Cpp.h>
@@ -42,6 +46,23 @@
 #include "libkea/KEAAttributeTable.h"
 
 namespace kealib{
+    
+    /**
+     * Counters of the chunk cache of a KEAAttributeTableFile.
+     */
+    struct KEAATTChunkCacheStats
+    {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        uint64_t writeBacks;
+        size_t numChunks;
+        size_t bytes;
+        // short writes held in the write buffer
+        uint64_t bufferedWrites;
+        uint64_t bufferFlushes;
+        size_t bufferBytes;
+    };
        
     class KEA_EXPORT KEAAttributeTableFile : public KEAAttributeTable
     {
@@ -92,7 +113,36 @@ namespace kealib{
         void addRows(size_t numRows);
         
         static KEAAttributeTable* createKeaAtt(H5::H5File *keaImg, unsigned int band, unsigned int chunkSize=KEA_ATT_CHUNK_SIZE, unsigned int deflate=KEA_DEFLATE);
-        void exportToKeaFile(H5::H5File *keaImg, unsigned int band, unsigned int chunkSize=KEA_ATT_CHUNK_SIZE, unsigned int deflate=KEA_DEFLATE);
+        /**
+         * Only supports the table's own band: rewrites the data with the
+         * given chunk size (KEA_ATT_CHUNK_SIZE_AUTO to choose it from the
+         * number of rows, now and when the image is repacked) and deflate
+         * level (KEA_REPACK_KEEP keeps the existing compression). This is
+         * the only time the table's chunk size changes.
+         */
+        void exportToKeaFile(H5::H5File *keaImg, unsigned int band, unsigned int chunkSize=KEA_ATT_CHUNK_SIZE_AUTO, unsigned int deflate=KEA_DEFLATE);
+        
+        /**
+         * Sets the memory budget (bytes) of the cache of decoded column
+         * chunks which serves reads and writes shorter than a chunk. Dirty
+         * chunks are written back when evicted, on flush() and when the
+         * table is destroyed. 0 disables the cache. The cache is locked
+         * internally so that threads can read the table concurrently.
+         */
+        void setChunkCacheSize(size_t bytes);
+        size_t getChunkCacheSize() const;
+        KEAATTChunkCacheStats getChunkCacheStats() const;
+        /**
+         * Sets the size (bytes) of the buffer which collects short writes to
+         * chunks that are not cached. The buffered rows are written one
+         * chunk at a time when the buffer is full, on flush() and when the
+         * table is destroyed. 0 writes them straight to the file. Errors
+         * writing them when the table is destroyed are lost, so call
+         * flush() before destroyAttributeTable() to see them.
+         */
+        void setWriteBufferSize(size_t bytes);
+        size_t getWriteBufferSize() const;
+        void flush();
         
         ~KEAAttributeTableFile();
     protected:
@@ -102,6 +152,122 @@ namespace kealib{
         H5::H5File *keaImg;
         std::string bandPathBase;
 
+        /**
+         * An open data dataset of the table with its file dataspace and the
+         * memory type used to transfer it (strings and neighbours only).
+         */
+        struct KEAATTDataCache
+        {
+            bool open;
+            H5::DataSet dataset;
+            H5::DataSpace dataspace;
+            H5::DataType memType;
+        };
+        mutable KEAATTDataCache boolData;
+        mutable KEAATTDataCache intData;
+        mutable KEAATTDataCache floatData;
+        mutable KEAATTDataCache stringData;
+        mutable KEAATTDataCache neighboursData;
+        // the data generation of the file when the datasets were opened
+        mutable uint64_t dataGeneration;
+
+        /**
+         * Returns the open data dataset for the type, opening it and checking
+         * its extent on first use.
+         */
+        KEAATTDataCache& getDataCache(KEAFieldDataType dataType) const;
+        /**
+         * Returns false, after closing the cached datasets, if another table
+         * on the band has replaced them since they were opened.
+         */
+        bool dataCacheCurrent() const;
+        /**
+         * Closes the cached datasets. Must be called whenever the datasets
+         * are extended or recreated.
+         */
+        void resetDataCache() const;
+        
+        void readBoolFieldsH5(size_t startfid, size_t len, size_t colIdx, bool *pbBuffer) const;
+        void readIntFieldsH5(size_t startfid, size_t len, size_t colIdx, int64_t *pnBuffer) const;
+        void readFloatFieldsH5(size_t startfid, size_t len, size_t colIdx, double *pfBuffer) const;
+        void readStringFieldsH5(size_t startfid, size_t len, size_t colIdx, std::vector<std::string> *psBuffer) const;
+        void writeBoolFieldsH5(size_t startfid, size_t len, size_t colIdx, bool *pbBuffer) const;
+        void writeIntFieldsH5(size_t startfid, size_t len, size_t colIdx, int64_t *pnBuffer) const;
+        void writeFloatFieldsH5(size_t startfid, size_t len, size_t colIdx, double *pfBuffer) const;
+        void writeStringFieldsH5(size_t startfid, size_t len, size_t colIdx, std::vector<std::string> *papszStrList) const;
+        /**
+         * Read/write len values of the column. The buffer holds values of
+         * the column type (std::string for string columns).
+         */
+        void readFieldsH5(KEAFieldDataType dataType, size_t startfid, size_t len, size_t colIdx, void *buffer) const;
+        void writeFieldsH5(KEAFieldDataType dataType, size_t startfid, size_t len, size_t colIdx, const void *buffer) const;
+        
+        /**
+         * A decoded chunk of one column, chunkSize rows (fewer at the end
+         * of the table) starting at startfid.
+         */
+        struct KEAATTChunk
+        {
+            KEAFieldDataType dataType;
+            size_t colIdx;
+            size_t startfid;
+            size_t len;
+            std::vector<char> data;
+            std::vector<std::string> strings;
+            bool dirty;
+            size_t bytes;
+            // rows [first, second) of the chunk held in the write buffer
+            std::map<size_t, size_t> ranges;
+            
+            void* values()
+            {
+                return (dataType == kea_att_string) ? static_cast<void*>(strings.data()) : static_cast<void*>(data.data());
+            }
+        };
+        typedef std::tuple<int, size_t, size_t> KEAATTChunkKey;
+        // most recently used first
+        mutable std::list<KEAATTChunk> chunkCache;
+        mutable std::map<KEAATTChunkKey, std::list<KEAATTChunk>::iterator> chunkCacheIndex;
+        mutable KEAATTChunkCacheStats chunkCacheStats;
+        size_t chunkCacheSize;
+        // chunks with buffered writes, never also in chunkCache
+        mutable std::map<KEAATTChunkKey, KEAATTChunk> writeBuffer;
+        size_t writeBufferSize;
+        // guards the open datasets, chunk cache and write buffer, which
+        // the const getters also change
+        mutable std::recursive_mutex cacheMutex;
+        
+        size_t getChunkRows() const;
+        bool useChunkCache(size_t len) const;
+        KEAATTChunk* findChunk(KEAFieldDataType dataType, size_t colIdx, size_t chunkIdx) const;
+        KEAATTChunk& loadChunk(KEAFieldDataType dataType, size_t colIdx, size_t chunkIdx) const;
+        void writeBackChunk(KEAATTChunk &chunk) const;
+        void evictChunks(size_t maxBytes) const;
+        void clearChunkCache();
+        void bufferWrite(KEAFieldDataType dataType, size_t colIdx, size_t chunkIdx, size_t startfid, size_t len, const void *buffer);
+        void flushWriteBuffer() const;
+        /**
+         * Copies the rows of the chunk which overlap [startfid, startfid+len)
+         * between the chunk and the buffer, in the direction given.
+         */
+        static void copyChunkRows(KEAATTChunk &chunk, size_t startfid, size_t len, void *buffer, bool toChunk);
+        /**
+         * Read/write through the chunk cache and write buffer. Short requests
+         * are served from cached chunks (short writes to other chunks are
+         * buffered), longer ones go to the file and keep the cached and
+         * buffered chunks up to date.
+         */
+        void readFields(KEAFieldDataType dataType, size_t startfid, size_t len, size_t colIdx, void *buffer) const;
+        void writeFields(KEAFieldDataType dataType, size_t startfid, size_t len, size_t colIdx, const void *buffer);
+
+        /**
+         * Rechunks the data and neighbours datasets to the given number of
+         * rows per chunk and deflate level, if they exist. The caches must
+         * be empty. Other tables open on the band reopen the datasets when
+         * they next use them.
+         */
+        void rechunkData(size_t chunkRows, uint32_t deflateIn=KEA_REPACK_KEEP);
+
         void updateSizeHeader(hsize_t nbools, hsize_t nints, hsize_t nfloats, hsize_t nstrings);
 };
     
@@ -91,7 +91,7 @@ namespace kealib{
         
         void addRows(size_t numRows);
         
-        void exportToKeaFile(H5::H5File *keaImg, unsigned int band, unsigned int chunkSize=KEA_ATT_CHUNK_SIZE, unsigned int deflate=KEA_DEFLATE);
+        void exportToKeaFile(H5::H5File *keaImg, unsigned int band, unsigned int chunkSize=KEA_ATT_CHUNK_SIZE_AUTO, unsigned int deflate=KEA_DEFLATE);
         
         static KEAAttributeTable* createKeaAtt(H5::H5File *keaImg, unsigned int band);
         
@@ -0,0 +1,205 @@
+/*
+ *  KEABlockProcessor.h
+ *  LibKEA
+ *
+ *  Copyright 2026 LibKEA. All rights reserved.
+ *
+ *  This file is part of LibKEA.
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify,
+ *  merge, publish, distribute, sublicense, and/or sell copies of the
+ *  Software, and to permit persons to whom the Software is furnished
+ *  to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ *  ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *  CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef KEABlockProcessor_H
+#define KEABlockProcessor_H
+
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#include "libkea/KEACommon.h"
+#include "libkea/KEAException.h"
+
+namespace kealib{
+
+    class KEAImageIO;
+
+    /**
+     * The pixels of one band within a block, in the type asked for when the
+     * band was added. Rows are packed, xSize values each.
+     */
+    struct KEABlockBuffer
+    {
+        KEADataType dataType;
+        std::vector<char> data;
+        bool hasNoData;
+        // the band's no data value, 0 when hasNoData is false
+        double noData;
+
+        /**
+         * The no data value of a band read as IDs (kea_64int), e.g. clumps
+         * or table rows. False if there is none or it is not a whole number
+         * within the range of int64_t, so no pixel can match it.
+         */
+        bool getIDNoData(int64_t *value) const
+        {
+            return this->hasNoData && KEABlockBuffer::valueToID(this->noData, value);
+        }
+        /**
+         * Converts value to an ID, false if it is not a whole number within
+         * the range of int64_t.
+         */
+        static bool valueToID(double value, int64_t *id)
+        {
+            if((value != std::floor(value)) || (value < -9223372036854775808.0) || (value >= 9223372036854775808.0))
+            {
+                return false;
+            }
+            *id = static_cast<int64_t>(value);
+            return true;
+        }
+    };
+
+    /**
+     * A block handed to the processing function. Blocks on the right and
+     * bottom edges of the image are smaller than the block size. Input
+     * buffers include margin extra pixels on each side, so their rows are
+     * xSize + 2 * margin values long; margin pixels off the image hold the
+     * band's no data value (or 0). Output buffers have no margin and start
+     * out filled with the output band's no data value (or 0).
+     */
+    struct KEA_EXPORT KEABlock
+    {
+        uint64_t blockIndex;
+        uint64_t xOff;
+        uint64_t yOff;
+        uint64_t xSize;
+        uint64_t ySize;
+        uint64_t margin;
+        std::vector<KEABlockBuffer> inputs;
+        std::vector<KEABlockBuffer> outputs;
+
+        uint64_t getNumPixels() const
+        {
+            return this->xSize * this->ySize;
+        }
+        uint64_t getInputXSize() const
+        {
+            return this->xSize + (2 * this->margin);
+        }
+        uint64_t getInputYSize() const
+        {
+            return this->ySize + (2 * this->margin);
+        }
+        template <typename T>
+        const T* getInput(size_t idx) const
+        {
+            return reinterpret_cast<const T*>(this->inputs.at(idx).data.data());
+        }
+        template <typename T>
+        T* getOutput(size_t idx)
+        {
+            return reinterpret_cast<T*>(this->outputs.at(idx).data.data());
+        }
+    };
+
+    typedef std::function<void(KEABlock &block)> KEABlockFunction;
+
+    /**
+     * Runs a function over an image block by block. The input bands are
+     * read, the function is called and the output bands written with blocks
+     * spread across a thread pool. Each thread takes the next block as soon
+     * as it is free, and at most getMaxBlocksInFlight() blocks are held in
+     * memory. Outputs are written by one thread at a time in block order,
+     * so a failure leaves the output complete up to the failed block.
+     *
+     * All bands must be the same size. Images which are not in thread safe
+     * mode are only accessed under KEAImageIO::getH5Mutex(), so one thread
+     * at a time across all of them.
+     */
+    class KEA_EXPORT KEABlockProcessor
+    {
+    public:
+        /**
+         * A numThreads of 0 uses the number of hardware threads available.
+         */
+        KEABlockProcessor(uint32_t numThreads=0);
+        KEABlockProcessor(const KEABlockProcessor&) = delete;
+        KEABlockProcessor& operator=(const KEABlockProcessor&) = delete;
+
+        /**
+         * Adds a band to read. Pixels are converted to dataType. Returns the
+         * index of the band in KEABlock::inputs.
+         */
+        size_t addInput(KEAImageIO *io, uint32_t band, KEADataType dataType);
+        /**
+         * Adds a band to write. The buffer passed to the function holds
+         * values of dataType. Returns the index in KEABlock::outputs.
+         */
+        size_t addOutput(KEAImageIO *io, uint32_t band, KEADataType dataType);
+
+        /**
+         * Edge length of the blocks. Defaults to the block size of the
+         * first output band, or the first input if there are no outputs.
+         */
+        void setBlockSize(uint64_t blockSize);
+        uint64_t getBlockSize() const;
+        /**
+         * Defaults to twice the number of threads.
+         */
+        void setMaxBlocksInFlight(uint32_t maxBlocks);
+        /**
+         * Number of pixels around each block also read from the inputs.
+         * Defaults to 0.
+         */
+        void setMargin(uint64_t margin);
+        uint64_t getMargin() const;
+        uint32_t getMaxBlocksInFlight() const;
+        uint32_t getNumThreads() const;
+
+        /**
+         * Processes the whole image, returning once every block has been
+         * written. If commitFunc is given it is called for each block after
+         * its outputs are written, in block order and never by two threads
+         * at once, so it can merge per block results without locking. The
+         * first exception thrown by func, commitFunc or by a read or write
+         * is rethrown after the blocks in progress have finished.
+         */
+        void run(const KEABlockFunction &func, const KEABlockFunction &commitFunc=KEABlockFunction());
+
+    protected:
+        struct KEABlockBand
+        {
+            KEAImageIO *io;
+            uint32_t band;
+            KEADataType dataType;
+        };
+
+        std::vector<KEABlockBand> inputs;
+        std::vector<KEABlockBand> outputs;
+        uint32_t numThreads;
+        uint64_t blockSize;
+        uint32_t maxBlocksInFlight;
+        uint64_t margin;
+    };
+
+}
+
+#endif
@@ -56,6 +56,8 @@ namespace kealib{
     static const std::string KEA_DATASETNAME_HEADER_FILETYPE( "/HEADER/FILETYPE" );
     static const std::string KEA_DATASETNAME_HEADER_GENERATOR( "/HEADER/GENERATOR" );
     static const std::string KEA_DATASETNAME_HEADER_VERSION( "/HEADER/VERSION" );
+    // all of the above plus the per band values in one compact dataset
+    static const std::string KEA_DATASETNAME_HEADER_CONSOLIDATED( "/HEADER/CONSOLIDATED" );
     
 	static const std::string KEA_DATASETNAME_METADATA( "/METADATA" );
     static const std::string KEA_DATASETNAME_BAND( "/BAND" );
@@ -67,6 +69,8 @@ namespace kealib{
     static const std::string KEA_BANDNAME_TYPE( "/LAYER_TYPE" );
     static const std::string KEA_BANDNAME_USAGE( "/LAYER_USAGE" );
     static const std::string KEA_BANDNAME_NO_DATA_VAL( "/NO_DATA_VAL" );
+    static const std::string KEA_BANDNAME_SCALE( "/SCALE" );
+    static const std::string KEA_BANDNAME_OFFSET( "/OFFSET" );
     static const std::string KEA_BANDNAME_METADATA( "/METADATA" );
     static const std::string KEA_BANDNAME_METADATA_MIN( "/METADATA/STATISTICS_MINIMUM" );
     static const std::string KEA_BANDNAME_METADATA_MAX( "/METADATA/STATISTICS_MAXIMUM" );
@@ -123,6 +127,9 @@ namespace kealib{
     static const std::string KEA_ATTRIBUTENAME_CLASS( "CLASS" );
 	static const std::string KEA_ATTRIBUTENAME_IMAGE_VERSION( "IMAGE_VERSION" );
     static const std::string KEA_ATTRIBUTENAME_BLOCK_SIZE( "BLOCK_SIZE" );
+    static const std::string KEA_ATTRIBUTENAME_AUTO_CHUNK_SIZE( "AUTO_CHUNK_SIZE" );
+    static const std::string KEA_ATTRIBUTENAME_HEADER_GENERATION( "HEADER_GENERATION" );
+    static const std::string KEA_ATTRIBUTENAME_DATA_GENERATION( "DATA_GENERATION" );
     
     static const std::string KEA_NODATA_DEFINED( "NO_DATA_DEFINED" );
     
@@ -132,9 +139,17 @@ namespace kealib{
     static const double KEA_RDCC_W0( 0.75 ); // 0.75
     static const hsize_t  KEA_SIEVE_BUF( 65536 ); // 65536
     static const hsize_t  KEA_META_BLOCKSIZE( 2048 ); // 2048
+    static const hsize_t  KEA_FILE_SPACE_PAGE_SIZE( 0 ); // 0 = no paged aggregation
+    static const size_t  KEA_PAGE_BUF_SIZE( 0 ); // 0 = no page buffer
     static const unsigned int KEA_DEFLATE( 1 ); // 1
     static const hsize_t KEA_IMAGE_CHUNK_SIZE( 256 ); // 256
     static const hsize_t KEA_ATT_CHUNK_SIZE( 1000 ); // 1000
+    static const hsize_t KEA_ATT_CHUNK_SIZE_AUTO( 0 ); // choose from the number of rows
+    static const size_t KEA_ATT_CHUNK_BYTES( 1048576 ); // 1 MiB, largest automatic chunk
+    static const size_t KEA_ATT_CHUNK_CACHE_SIZE( 8388608 ); // 8 MiB
+    static const size_t KEA_ATT_WRITE_BUFFER_SIZE( 4194304 ); // 4 MiB
+    static const uint64_t KEA_WRITE_QUEUE_SIZE( 67108864 ); // 64 MiB
+    static const uint32_t KEA_REPACK_KEEP( 0xFFFFFFFF ); // keep the existing setting when repacking
     
     enum KEADataType
     {
@@ -157,6 +172,17 @@ namespace kealib{
         kea_thematic = 1
     };
     
+    /**
+     * Which image dimensions may be grown after creation
+     * (see KEAImageIO::extendImage).
+     */
+    enum KEAImageExtend
+    {
+        kea_extend_none = 0,
+        kea_extend_y = 1,
+        kea_extend_xy = 2
+    };
+    
     enum KEABandClrInterp
     {
         kea_generic = 0,
@@ -191,6 +217,30 @@ namespace kealib{
         uint64_t ySize;
     };
     
+    /**
+     * A band as returned by KEAImageIO::probeKEAImage. 64 bit integer no
+     * data values may not be exact as a double.
+     */
+    struct KEAImageBandSummary
+    {
+        KEADataType dataType;
+        KEALayerType layerType;
+        KEABandClrInterp clrInterp;
+        std::string description;
+        bool noDataDefined;
+        double noDataValue;
+        uint32_t numOverviews;
+        double scale;
+        double offset;
+    };
+    
+    struct KEAImageHeaderSummary
+    {
+        std::string keaVersion;
+        KEAImageSpatialInfo spatialInfo;
+        std::vector<KEAImageBandSummary> bands;
+    };
+    
     struct KEAImageGCP
     {
         std::string pszId;
@@ -305,6 +355,31 @@ namespace kealib{
         return strDT;
     }
     
+    inline size_t getDataTypeSize(KEADataType dataType)
+    {
+        size_t dtSize = 0;
+        switch(dataType)
+        {
+            case kea_8int:
+            case kea_8uint:
+                dtSize = 1; break;
+            case kea_16int:
+            case kea_16uint:
+                dtSize = 2; break;
+            case kea_32int:
+            case kea_32uint:
+            case kea_32float:
+                dtSize = 4; break;
+            case kea_64int:
+            case kea_64uint:
+            case kea_64float:
+                dtSize = 8; break;
+            default:
+                dtSize = 0; break;
+        }
+        return dtSize;
+    }
+    
     
 }
 
@@ -34,6 +34,13 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <tuple>
 
 #include <H5Cpp.h>
 
@@ -43,18 +50,136 @@
 #include "libkea/KEAAttributeTableInMem.h"
 #include "libkea/KEAAttributeTableFile.h"
 
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define KEA_HAVE_COROUTINES 1
+#endif
+#endif
+
 namespace kealib{
+    
+    class KEAAsyncWriter;
+    class KEAThreadPool;
+#ifdef KEA_HAVE_COROUTINES
+    class KEAReadBlockAwaitable;
+#endif
         
     class KEA_EXPORT KEAImageIO
     {
     public:
         KEAImageIO();
+        
+        /**
+         * In thread safe mode the object may be shared between threads. Reads
+         * of pixel data run concurrently: only fetching the compressed chunks
+         * from the file is serialised, decompression and type conversion happen
+         * in the calling thread. Anything which modifies the file takes an
+         * exclusive lock. Off by default. Attribute tables returned by
+         * getAttributeTable() are not covered. Must be set before the object
+         * is shared between threads.
+         */
+        void setThreadSafe(bool threadSafe);
+        bool isThreadSafe() const;
+        /**
+         * Mutex protecting all calls into HDF5 made by the thread safe
+         * read path. Shared by all KEAImageIO objects. Hold it to use images
+         * which are not in thread safe mode alongside ones which are.
+         */
+        static std::recursive_mutex& getH5Mutex();
                 
         void openKEAImageHeader(H5::H5File *keaImgH5File);
         
+        /**
+         * Files written by this version of libkea carry a copy of the image
+         * and band headers in a single dataset, which is all that is read on
+         * open. Returns whether the file being read has one.
+         */
+        bool consolidatedHeaderPresent();
+        
+        /**
+         * Writes the consolidated header again from the individual header
+         * datasets. Needed when the file has been edited since by a version
+         * of libkea which does not know about it.
+         */
+        void rebuildConsolidatedHeader();
+        
         void writeImageBlock2Band(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeOut, uint64_t ySizeOut, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType);
         void readImageBlock2Band(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType);
         
+        /**
+         * Reads physical values rather than the stored ones: each value is
+         * multiplied by the band scale and has the offset added, and no
+         * data values come back as NaN. outDataType must be kea_32float or
+         * kea_64float. This is done as each chunk is decoded so there is no
+         * second pass over the block.
+         */
+        void readImageBlock2BandScaled(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType outDataType);
+        
+        /**
+         * Queues the read on the internal I/O threads and returns straight
+         * away. data must stay valid until the future is ready. Concurrent
+         * reads needing the same chunk share a single fetch and decode.
+         * Thread safe mode must have been switched on with setThreadSafe(true).
+         */
+        std::future<void> readImageBlock2BandAsync(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType);
+        
+        /**
+         * As above but calls callback on an I/O thread when the read has
+         * finished, with the error if it failed. For event loops which
+         * cannot block on a future. The callback must not throw.
+         */
+        void readImageBlock2BandAsync(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType, std::function<void(std::exception_ptr)> callback);
+        
+#ifdef KEA_HAVE_COROUTINES
+        /**
+         * C++20 version for use with co_await. The coroutine is resumed
+         * on one of the I/O threads.
+         */
+        KEAReadBlockAwaitable readImageBlock2BandAwaitable(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType);
+#endif
+        
+        /**
+         * Number of threads used for asynchronous reads, 0 for the number
+         * of hardware threads. Only has an effect before the first read.
+         */
+        void setAsyncReadThreads(uint32_t numThreads);
+        
+        /**
+         * Copies the block into a queue written by a background thread and
+         * returns straight away. The caller only blocks while more than
+         * getAsyncWriteQueueSize() bytes are waiting. Adjacent blocks are
+         * merged into whole chunks before writing. The future becomes ready
+         * once the block is in the file and carries any error from the write.
+         * As the writer thread shares the object, thread safe mode must have
+         * been switched on with setThreadSafe(true). Queued blocks are not visible to reads until
+         * waitForAsyncWrites() or close() has returned.
+         */
+        std::future<void> writeImageBlock2BandAsync(uint32_t band, const void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeOut, uint64_t ySizeOut, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType);
+        
+        /**
+         * Blocks until all queued writes are in the file and rethrows the
+         * first error since the last call. close() does the same.
+         */
+        void waitForAsyncWrites();
+        void setAsyncWriteQueueSize(uint64_t maxQueuedBytes);
+        uint64_t getAsyncWriteQueueSize();
+        
+        /**
+         * Reads the values of a set of bands at numPoints scattered pixel
+         * locations. The output is columnar, i.e., all the points for bands[0]
+         * followed by all the points for bands[1] etc. so data must hold
+         * bands.size() * numPoints values of inDataType. The points are grouped
+         * by image chunk so each chunk is only decoded once and the chunks are
+         * spread over numThreads threads (0 = number of hardware threads),
+         * which are kept for later calls. Chunks are only decoded in parallel
+         * when kealib is built with zlib and HDF5 1.10.5 or later and the
+         * band only uses the shuffle and deflate filters - otherwise HDF5
+         * decodes them one at a time, so the points are sampled on the
+         * calling thread.
+         */
+        void samplePoints(const std::vector<uint32_t> &bands, const uint64_t *xPxls, const uint64_t *yPxls, size_t numPoints, void *data, KEADataType inDataType, uint32_t numThreads=0);
+        
         void createMask(uint32_t band, uint32_t deflate=KEA_DEFLATE);
         void writeImageBlock2BandMask(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeOut, uint64_t ySizeOut, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType);
         void readImageBlock2BandMask(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType);
@@ -95,6 +220,20 @@ namespace kealib{
         
         KEADataType getImageBandDataType(uint32_t band);
         
+        /**
+         * Returns which dimensions of the image can be grown with extendImage.
+         */
+        KEAImageExtend getImageExtend();
+        
+        /**
+         * Grows the image to newXSize x newYSize pixels. The image must have
+         * been created extendable in the dimensions being grown and the new
+         * size must not be smaller than the current one. New pixels read as
+         * the fill value (0, or 255 for masks). Overviews are not resized and
+         * should be rebuilt once acquisition has finished.
+         */
+        void extendImage(uint64_t newXSize, uint64_t newYSize);
+        
         std::string getKEAImageVersion();
         
         void setImageBandLayerType(uint32_t band, KEALayerType imgLayerType);
@@ -103,6 +242,15 @@ namespace kealib{
         void setImageBandClrInterp(uint32_t band, KEABandClrInterp imgLayerClrInterp);
         KEABandClrInterp getImageBandClrInterp(uint32_t band);
         
+        /**
+         * Physical value = stored value * scale + offset. Bands where these
+         * have not been set have a scale of 1 and an offset of 0.
+         */
+        void setImageBandScale(uint32_t band, double scale);
+        double getImageBandScale(uint32_t band);
+        void setImageBandOffset(uint32_t band, double offset);
+        double getImageBandOffset(uint32_t band);
+        
         void createOverview(uint32_t band, uint32_t overview, uint64_t xSize, uint64_t ySize);
         void removeOverview(uint32_t band, uint32_t overview);
         uint32_t getOverviewBlockSize(uint32_t band, uint32_t overview);
@@ -112,24 +260,113 @@ namespace kealib{
         void getOverviewSize(uint32_t band, uint32_t overview, uint64_t *xSize, uint64_t *ySize);
                 
         KEAAttributeTable* getAttributeTable(KEAATTType type, uint32_t band);
-        void setAttributeTable(KEAAttributeTable* att, uint32_t band, uint32_t chunkSize=KEA_ATT_CHUNK_SIZE, uint32_t deflate=KEA_DEFLATE);
+        void setAttributeTable(KEAAttributeTable* att, uint32_t band, uint32_t chunkSize=KEA_ATT_CHUNK_SIZE_AUTO, uint32_t deflate=KEA_DEFLATE);
         bool attributeTablePresent(uint32_t band);
         uint32_t getAttributeTableChunkSize(uint32_t band);
+
+        /**
+         * Writes outBand of outIO (which may be this image) with the value
+         * of an attribute table column for each pixel's value in srcBand,
+         * e.g. to turn clumps into a classification. The column is loaded
+         * into a lookup table once and the image processed in parallel
+         * blocks. Pixels which are no data, negative or beyond the end of
+         * the table get the output band's no data value (or 0). Both images
+         * must be the same size. Only int, bool and float columns can be
+         * used.
+         */
+        void remapBandThroughAttribute(uint32_t srcBand, const std::string &column, KEAImageIO *outIO, uint32_t outBand, uint32_t numThreads=0);
+
+        /**
+         * Renders a window of a thematic band, or of one of its overviews
+         * (overview 0 is the band itself), to interleaved 8 bit RGBA using
+         * the Red, Green, Blue and Alpha columns of the attribute table
+         * (found by usage, then by name; Alpha is optional). rgba must hold
+         * xSize * ySize * 4 bytes. No data and negative pixels and values
+         * without a row are transparent. Strips of the window are rendered
+         * in parallel, looking the colours up with AVX2 gathers where the
+         * CPU has them.
+         *
+         * The colours are cached per band until setAttributeTable(),
+         * close() or clearColourTableCache() is called, so call the latter
+         * after editing the colour columns through a KEAAttributeTable.
+         */
+        void renderColourTable(uint32_t band, uint32_t overview, uint8_t *rgba, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSize, uint64_t ySize, uint32_t numThreads=0);
+        void clearColourTableCache();
         
         void close();
 
         /**
          * Adds a new image band to the file.
          */
-        virtual void addImageBand(const KEADataType dataType, const std::string &bandDescrip, const uint32_t imageBlockSize = KEA_IMAGE_CHUNK_SIZE, const uint32_t attBlockSize = KEA_ATT_CHUNK_SIZE, const uint32_t deflate = KEA_DEFLATE);
+        virtual void addImageBand(const KEADataType dataType, const std::string &bandDescrip, const uint32_t imageBlockSize = KEA_IMAGE_CHUNK_SIZE, const uint32_t attBlockSize = KEA_ATT_CHUNK_SIZE_AUTO, const uint32_t deflate = KEA_DEFLATE);
         
         // remove band from file
         virtual void removeImageBand(const uint32_t bandIndex);
+        
+        /**
+         * Appends a copy of band srcBand of srcIO, which must be the same
+         * size, to this image. The mask, overviews, metadata and attribute
+         * table come too. With the source block size and deflate level the
+         * compressed chunks are copied verbatim, otherwise the pixel data is
+         * re-encoded with the given layout.
+         */
+        virtual void copyBandFrom(KEAImageIO *srcIO, const uint32_t srcBand);
+        virtual void copyBandFrom(KEAImageIO *srcIO, const uint32_t srcBand, const uint32_t imageBlockSize, const uint32_t deflate);
 
-        static H5::H5File* createKEAImage(const std::string &fileName, KEADataType dataType, uint32_t xSize, uint32_t ySize, uint32_t numImgBands, std::vector<std::string> *bandDescrips=NULL, KEAImageSpatialInfo *spatialInfo=NULL, uint32_t imageBlockSize=KEA_IMAGE_CHUNK_SIZE, uint32_t attBlockSize=KEA_ATT_CHUNK_SIZE, int mdcElmts=KEA_MDC_NELMTS, hsize_t rdccNElmts=KEA_RDCC_NELMTS, hsize_t rdccNBytes=KEA_RDCC_NBYTES, double rdccW0=KEA_RDCC_W0, hsize_t sieveBuf=KEA_SIEVE_BUF, hsize_t metaBlockSize=KEA_META_BLOCKSIZE, uint32_t deflate=KEA_DEFLATE);
+        /**
+         * A fileSpacePageSize above 0 (e.g. 65536) turns on HDF5 paged
+         * aggregation so metadata and raw data are kept in aligned pages of
+         * that size. Such files need HDF5 1.10.1 or later to read and can be
+         * opened with a page buffer (pageBufSize in openKeaH5RW/RDOnly) so
+         * remote reads fetch whole pages. The page buffer is not used for
+         * files created without paged aggregation.
+         */
+        static H5::H5File* createKEAImage(const std::string &fileName, KEADataType dataType, uint32_t xSize, uint32_t ySize, uint32_t numImgBands, std::vector<std::string> *bandDescrips=NULL, KEAImageSpatialInfo *spatialInfo=NULL, uint32_t imageBlockSize=KEA_IMAGE_CHUNK_SIZE, uint32_t attBlockSize=KEA_ATT_CHUNK_SIZE_AUTO, int mdcElmts=KEA_MDC_NELMTS, hsize_t rdccNElmts=KEA_RDCC_NELMTS, hsize_t rdccNBytes=KEA_RDCC_NBYTES, double rdccW0=KEA_RDCC_W0, hsize_t sieveBuf=KEA_SIEVE_BUF, hsize_t metaBlockSize=KEA_META_BLOCKSIZE, uint32_t deflate=KEA_DEFLATE, KEAImageExtend extend=kea_extend_none, hsize_t fileSpacePageSize=KEA_FILE_SPACE_PAGE_SIZE);
+        /**
+         * Creates fileName as a copy of the open image srcIO without
+         * decompressing anything. Pass the returned file to openKEAImageHeader.
+         */
+        static H5::H5File* cloneKEAImage(KEAImageIO *srcIO, const std::string &fileName, int mdcElmts=KEA_MDC_NELMTS, hsize_t rdccNElmts=KEA_RDCC_NELMTS, hsize_t rdccNBytes=KEA_RDCC_NBYTES, double rdccW0=KEA_RDCC_W0, hsize_t sieveBuf=KEA_SIEVE_BUF, hsize_t metaBlockSize=KEA_META_BLOCKSIZE);
+        /**
+         * Creates fileName holding the xSize x ySize pixel window of srcIO
+         * starting at (xPxlOff, yPxlOff), for every band, mask and overview,
+         * with the spatial info and GCPs moved to match. The source block
+         * size and compression are kept, so when the window starts on a
+         * block boundary the interior chunks are copied without being
+         * decoded and only the edge chunks are re-encoded. Pass the returned
+         * file to openKEAImageHeader.
+         */
+        static H5::H5File* createKEAImageSubset(KEAImageIO *srcIO, const std::string &fileName, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSize, uint64_t ySize, int mdcElmts=KEA_MDC_NELMTS, hsize_t rdccNElmts=KEA_RDCC_NELMTS, hsize_t rdccNBytes=KEA_RDCC_NBYTES, double rdccW0=KEA_RDCC_W0, hsize_t sieveBuf=KEA_SIEVE_BUF, hsize_t metaBlockSize=KEA_META_BLOCKSIZE);
+        /**
+         * Rewrites the KEA file fileName to dstFileName without the unused
+         * space left behind by removed bands, overviews and rewritten
+         * attribute tables. With an empty dstFileName the file is replaced
+         * through a temporary file, so it must not be open elsewhere. The
+         * image block size, deflate level and attribute table chunk size
+         * can be changed on the way - KEA_REPACK_KEEP keeps the existing
+         * ones and an attBlockSize of KEA_ATT_CHUNK_SIZE_AUTO sizes the
+         * chunks from the number of rows, as KEA_REPACK_KEEP does for tables
+         * created with it. The file space strategy (e.g. paged aggregation)
+         * is kept. Returns the number of bytes reclaimed (negative if the
+         * new file is larger).
+         */
+        static int64_t repackKEAImage(const std::string &fileName, const std::string &dstFileName="", uint32_t imageBlockSize=KEA_REPACK_KEEP, uint32_t deflate=KEA_REPACK_KEEP, uint32_t attBlockSize=KEA_REPACK_KEEP);
         static bool isKEAImage(const std::string &fileName);
-        static H5::H5File* openKeaH5RW(const std::string &fileName, int mdcElmts=KEA_MDC_NELMTS, hsize_t rdccNElmts=KEA_RDCC_NELMTS, hsize_t rdccNBytes=KEA_RDCC_NBYTES, double rdccW0=KEA_RDCC_W0, hsize_t sieveBuf=KEA_SIEVE_BUF, hsize_t metaBlockSize=KEA_META_BLOCKSIZE);
-        static H5::H5File* openKeaH5RDOnly(const std::string &fileName, int mdcElmts=KEA_MDC_NELMTS, hsize_t rdccNElmts=KEA_RDCC_NELMTS, hsize_t rdccNBytes=KEA_RDCC_NBYTES, double rdccW0=KEA_RDCC_W0, hsize_t sieveBuf=KEA_SIEVE_BUF, hsize_t metaBlockSize=KEA_META_BLOCKSIZE);
+        /**
+         * Reads just the header of fileName into summary, for scanning
+         * large numbers of files. Returns false if it is not a KEA image.
+         * Files without the HDF5 signature are rejected without calling
+         * HDF5 and no chunk cache is allocated. Safe to call from several
+         * threads at once. The HDF5 part of each call is serialised
+         * with the open images only if HDF5 was not built thread safe.
+         */
+        static bool probeKEAImage(const std::string &fileName, KEAImageHeaderSummary &summary);
+        static H5::H5File* openKeaH5RW(const std::string &fileName, int mdcElmts=KEA_MDC_NELMTS, hsize_t rdccNElmts=KEA_RDCC_NELMTS, hsize_t rdccNBytes=KEA_RDCC_NBYTES, double rdccW0=KEA_RDCC_W0, hsize_t sieveBuf=KEA_SIEVE_BUF, hsize_t metaBlockSize=KEA_META_BLOCKSIZE, size_t pageBufSize=KEA_PAGE_BUF_SIZE);
+        /**
+         * fileDriver is an HDF5 file driver (e.g. GDAL's /vsi one) to read the
+         * file through, a negative value for the default one.
+         */
+        static H5::H5File* openKeaH5RDOnly(const std::string &fileName, int mdcElmts=KEA_MDC_NELMTS, hsize_t rdccNElmts=KEA_RDCC_NELMTS, hsize_t rdccNBytes=KEA_RDCC_NBYTES, double rdccW0=KEA_RDCC_W0, hsize_t sieveBuf=KEA_SIEVE_BUF, hsize_t metaBlockSize=KEA_META_BLOCKSIZE, size_t pageBufSize=KEA_PAGE_BUF_SIZE, hid_t fileDriver=-1);
         virtual ~KEAImageIO();
 
     protected:
@@ -149,7 +386,42 @@ namespace kealib{
          * buffer.
          *
          */
-        static void addImageBandToFile(H5::H5File *keaImgH5File, const KEADataType dataType, const uint32_t xSize, const uint32_t ySize, const uint32_t bandIndex, const std::string &bandDescrip, const uint32_t imageBlockSize, const uint32_t attBlockSize, const uint32_t deflate);
+        static void addImageBandToFile(H5::H5File *keaImgH5File, const KEADataType dataType, const uint32_t xSize, const uint32_t ySize, const uint32_t bandIndex, const std::string &bandDescrip, const uint32_t imageBlockSize, const uint32_t attBlockSize, const uint32_t deflate, const KEAImageExtend extend=kea_extend_none);
+        
+        /**
+         * Returns the maximum dimensions (y, x) to create a dataset of the
+         * given size with so that it can later be extended.
+         */
+        static void getExtendMaxDims(const KEAImageExtend extend, const hsize_t *dims, hsize_t *maxDims);
+        
+        /**
+         * Creates the empty attribute table groups and header for a band.
+         */
+        static void addATTGroupToBand(H5::H5File *keaImgH5File, const std::string &bandName, const uint32_t attBlockSize);
+        
+        /**
+         * Copies (with H5Ocopy) the members of a group into another group,
+         * replacing any already there. skipNames lists members to leave out.
+         */
+        static void copyGroupMembers(H5::H5File *srcH5File, const std::string &srcGroupPath, H5::H5File *dstH5File, const std::string &dstGroupPath, const std::vector<std::string> &skipNames);
+        
+        /**
+         * Fills dstDataset with the window of srcDataset starting at
+         * (xPxlOff, yPxlOff). Whole chunks are copied raw when the chunking
+         * and filters allow. Returns the number of chunks copied raw.
+         */
+        static uint64_t copyDatasetWindow(const H5::DataSet &srcDataset, H5::DataSet &dstDataset, uint64_t xPxlOff, uint64_t yPxlOff);
+        
+        /**
+         * Returns the deflate level of a dataset, 0 if it isn't compressed.
+         */
+        static uint32_t getDatasetDeflate(const H5::DataSet &dataset);
+        
+        /**
+         * Works out the extend mode of an existing image dataset from its
+         * maximum dimensions.
+         */
+        static KEAImageExtend getDatasetExtend(const H5::DataSet &dataset);
         
         /**
          * Remove and image band and rename higher bands so everything is contiguous. Does NOT flush the file
@@ -168,14 +440,245 @@ namespace kealib{
         
         static std::string readString(H5::DataSet& dataset, H5::DataType strDataType);
         
+        /**
+         * The per band values held in the consolidated header.
+         */
+        struct KEABandHeader
+        {
+            KEADataType dataType;
+            KEALayerType layerType;
+            KEABandClrInterp clrInterp;
+            uint32_t blockSize;
+            uint32_t numOverviews;
+            std::string description;
+            // 0 = no NO_DATA_VAL dataset, 1 = not defined, 2 = defined
+            uint8_t noDataState;
+            // the no data value as dataType
+            std::vector<char> noDataValue;
+            double scale;
+            double offset;
+        };
+        
+        /**
+         * Reads the image header from the individual header datasets.
+         */
+        static void readImageHeader(H5::H5File *keaImgH5File, std::string &keaVersion, uint32_t &numImgBands, KEAImageSpatialInfo *spatialInfo);
+        
+        /**
+         * Reads the header of a band from the individual band datasets.
+         */
+        static void readBandHeader(H5::H5File *keaImgH5File, const uint32_t band, KEABandHeader &bandHeader);
+        
+        /**
+         * Writes the consolidated header, replacing any already in the file.
+         * Does NOT flush the file buffer.
+         */
+        static void writeConsolidatedHeader(H5::H5File *keaImgH5File, const std::string &keaVersion, const KEAImageSpatialInfo *spatialInfo, const std::vector<KEABandHeader> &bandHeaders);
+        
+        /**
+         * Reads the consolidated header. Returns false if the file does not
+         * have one, it is not a version which can be read or it no longer
+         * matches the band count or the header generation, so the
+         * individual datasets have to be used.
+         */
+        static bool readConsolidatedHeader(H5::H5File *keaImgH5File, std::string &keaVersion, KEAImageSpatialInfo *spatialInfo, std::vector<KEABandHeader> &bandHeaders);
+        
+        /**
+         * Reads the header generation, which every header change made
+         * through this class bumps before writing the individual datasets
+         * and stores in the consolidated header once it has been rewritten.
+         * 0 if the file does not have one.
+         */
+        static uint64_t readHeaderGeneration(H5::H5File *keaImgH5File);
+        
+        /**
+         * Bumps the header generation, called by the header setters before
+         * they write the individual datasets.
+         */
+        void beginHeaderChange();
+        
+        /**
+         * Writes the consolidated header for a file from its individual
+         * header datasets. Does NOT flush the file buffer.
+         */
+        static void writeConsolidatedHeaderFromFile(H5::H5File *keaImgH5File);
+        
+        /**
+         * Returns the cached header of a band, nullptr if it has to be read
+         * from the file.
+         */
+        const KEABandHeader* getBandHeader(uint32_t band) const;
+        
+        /**
+         * Brings the consolidated header up to date after the header of band
+         * (0 for only the image header) has been changed in the file.
+         */
+        void updateConsolidatedHeader(uint32_t band);
+        
+        /**
+         * An open image dataset (band, mask or overview) and its layout.
+         */
+        struct KEAChunkedDataset
+        {
+            H5::DataSet dataset;
+            KEADataType dataType;
+            size_t typeSize;
+            hsize_t dims[2];
+            hsize_t chunkDims[2];
+            // true if the chunks can be read raw and decoded by libkea, i.e.,
+            // little endian data with only the shuffle and deflate filters.
+            bool directRead;
+            // index of the filters in the pipeline, -1 if not used
+            int shuffleFilter;
+            int deflateFilter;
+            std::vector<char> fillValue;
+        };
+        
+        /**
+         * Returns the cached dataset for the path, opening it if needed.
+         * The caller must hold the HDF5 mutex.
+         */
+        KEAChunkedDataset* getChunkedDataset(const std::string &datasetPath);
+        
+        /**
+         * Closes the cached datasets. Must be called when datasets are
+         * removed, renamed or resized.
+         */
+        void clearChunkedDatasets();
+        
+        /**
+         * Reads the chunk starting at chunkOffset into chunkData as a full
+         * chunkDims[0] x chunkDims[1] block of dataType values.
+         */
+        void readChunk(KEAChunkedDataset *chunkedDataset, const hsize_t *chunkOffset, std::vector<char> &chunkData);
+        
+        /**
+         * Thread safe equivalent of the hyperslab read used by
+         * readImageBlock2Band, readImageBlock2BandMask and readFromOverview.
+         */
+        void readChunkedDataset(const std::string &datasetPath, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType);
+        
+        /**
+         * As above but copyBlock moves the values out of each decoded
+         * chunk, given the chunk's data type and the row lengths (in values)
+         * of the chunk and the output buffer.
+         */
+        void readChunkedDataset(const std::string &datasetPath, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, size_t outTypeSize, const std::function<void(const char *in, KEADataType inType, size_t inStride, char *out, size_t outStride, size_t numRows, size_t numCols)> &copyBlock);
+        
+        /** The band's colour table as RGBA, cached until clearColourTableCache(). */
+        std::shared_ptr< const std::vector<uint32_t> > getColourTable(uint32_t band);
+        
+        /**
+         * Reads a band's scale or offset dataset, returning defaultValue
+         * if the band does not have one.
+         */
+        static double readBandScaleOffset(H5::H5File *keaImgH5File, const std::string &datasetPath, double defaultValue);
+        void writeBandScaleOffset(uint32_t band, const std::string &datasetName, double value);
+        
+        /**
+         * Writes anything queued, stops the writer thread and returns the
+         * first error it had.
+         */
+        std::exception_ptr stopAsyncWriter();
+        
+        /**
+         * Finishes any queued asynchronous reads and stops the I/O threads.
+         */
+        void stopAsyncReader();
+        
+        /**
+         * Returns the decoded chunk, sharing the fetch with any other thread
+         * reading the same chunk at the same time. A thread holding the HDF5
+         * mutex through a lock on the image reads the chunk itself.
+         */
+        std::shared_ptr< const std::vector<char> > readChunkShared(KEAChunkedDataset *chunkedDataset, const hsize_t *chunkOffset);
+        
         /********** PROTECTED MEMBERS **********/
         bool fileOpen;
         H5::H5File *keaImgFile;
         KEAImageSpatialInfo *spatialInfoFile;
         uint32_t numImgBands;
         std::string keaVersion;
+        std::vector<KEABandHeader> bandHeaders;
+        bool bandHeadersLoaded;
+        bool haveConsolidatedHeader;
+        bool threadSafe;
+        mutable std::shared_timed_mutex ioMutex;
+        std::map<std::string, KEAChunkedDataset*> chunkedDatasets;
+        KEAAsyncWriter *asyncWriter;
+        uint64_t asyncWriteQueueSize;
+        std::mutex asyncWriterMutex;
+        KEAThreadPool *asyncReader;
+        uint32_t asyncReadThreads;
+        std::mutex asyncReaderMutex;
+        // reused by samplePoints, shared so a call can keep it while
+        // another replaces it with a different number of threads
+        std::shared_ptr<KEAThreadPool> samplePool;
+        std::mutex samplePoolMutex;
+        // chunks being fetched by the thread safe read path
+        typedef std::tuple<KEAChunkedDataset*, hsize_t, hsize_t> KEAChunkKey;
+        std::map< KEAChunkKey, std::shared_future< std::shared_ptr< const std::vector<char> > > > inFlightChunks;
+        std::mutex inFlightMutex;
+        // RGBA of each row of the band's attribute table
+        std::map< uint32_t, std::shared_ptr< const std::vector<uint32_t> > > colourTables;
+        std::mutex colourTablesMutex;
+    };
+    
+#ifdef KEA_HAVE_COROUTINES
+    /**
+     * Awaitable returned by KEAImageIO::readImageBlock2BandAwaitable.
+     */
+    class KEAReadBlockAwaitable
+    {
+    public:
+        KEAReadBlockAwaitable(KEAImageIO *io, uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType):
+            io(io), band(band), data(data), xPxlOff(xPxlOff), yPxlOff(yPxlOff), xSizeIn(xSizeIn), ySizeIn(ySizeIn), xSizeBuf(xSizeBuf), ySizeBuf(ySizeBuf), inDataType(inDataType)
+        {
+        }
+        
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+        
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            this->io->readImageBlock2BandAsync(this->band, this->data, this->xPxlOff, this->yPxlOff, this->xSizeIn, this->ySizeIn, this->xSizeBuf, this->ySizeBuf, this->inDataType,
+                [this, handle](std::exception_ptr error)
+                {
+                    this->error = error;
+                    handle.resume();
+                });
+        }
+        
+        void await_resume()
+        {
+            if(this->error)
+            {
+                std::rethrow_exception(this->error);
+            }
+        }
+        
+    private:
+        KEAImageIO *io;
+        uint32_t band;
+        void *data;
+        uint64_t xPxlOff;
+        uint64_t yPxlOff;
+        uint64_t xSizeIn;
+        uint64_t ySizeIn;
+        uint64_t xSizeBuf;
+        uint64_t ySizeBuf;
+        KEADataType inDataType;
+        std::exception_ptr error;
     };
     
+    inline KEAReadBlockAwaitable KEAImageIO::readImageBlock2BandAwaitable(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType)
+    {
+        return KEAReadBlockAwaitable(this, band, data, xPxlOff, yPxlOff, xSizeIn, ySizeIn, xSizeBuf, ySizeBuf, inDataType);
+    }
+#endif
+    
 }
 
 // returns the current KEA version as a double
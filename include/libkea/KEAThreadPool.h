@@ -0,0 +1,94 @@
+/*
+ *  KEAThreadPool.h
+ *  LibKEA
+ *
+ *  Copyright 2026 LibKEA. All rights reserved.
+ *
+ *  This file is part of LibKEA.
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify,
+ *  merge, publish, distribute, sublicense, and/or sell copies of the
+ *  Software, and to permit persons to whom the Software is furnished
+ *  to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ *  ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *  CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef KEAThreadPool_H
+#define KEAThreadPool_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "libkea/KEACommon.h"
+#include "libkea/KEAException.h"
+
+namespace kealib{
+
+    /**
+     * A fixed size pool of worker threads. Used internally to spread
+     * chunk decoding and per block work across cores.
+     */
+    class KEA_EXPORT KEAThreadPool
+    {
+    public:
+        /**
+         * Creates the pool. A numThreads of 0 uses the number of
+         * hardware threads available.
+         */
+        KEAThreadPool(uint32_t numThreads=0);
+        KEAThreadPool(const KEAThreadPool&) = delete;
+        KEAThreadPool& operator=(const KEAThreadPool&) = delete;
+
+        /**
+         * Queues a task to be run by one of the workers. Tasks must not
+         * throw - catch and hand any error back to the submitter.
+         */
+        void submit(std::function<void()> task);
+
+        /**
+         * Calls func(i) for i in [0, numTasks) across the pool and blocks
+         * until all have completed. The calling thread also takes tasks
+         * so this is safe to call from within a worker. The first
+         * exception thrown by func is rethrown once all tasks are done.
+         */
+        void parallelFor(size_t numTasks, const std::function<void(size_t)> &func);
+
+        uint32_t getNumThreads() const;
+
+        /**
+         * Returns the number of threads to use when the caller asked for 0.
+         */
+        static uint32_t getDefaultNumThreads();
+
+        ~KEAThreadPool();
+    protected:
+        void workerLoop();
+
+        std::vector<std::thread> workers;
+        std::deque< std::function<void()> > tasks;
+        std::mutex tasksMutex;
+        std::condition_variable tasksCond;
+        bool stopping;
+    };
+
+}
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ *  KEATrace.h
+ *  LibKEA
+ *
+ *  Copyright 2026 LibKEA. All rights reserved.
+ *
+ *  This file is part of LibKEA.
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify,
+ *  merge, publish, distribute, sublicense, and/or sell copies of the
+ *  Software, and to permit persons to whom the Software is furnished
+ *  to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ *  ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *  CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef KEATrace_H
+#define KEATrace_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+
+#include "libkea/KEACommon.h"
+
+namespace kealib{
+
+    // categories used for the events libkea records
+    static const char KEA_TRACE_API[] = "kea";
+    static const char KEA_TRACE_HDF5[] = "hdf5";
+    static const char KEA_TRACE_CODEC[] = "codec";
+
+    /**
+     * A completed span of work. Times are in microseconds from when tracing
+     * was first switched on. threadId is a small number unique to each
+     * thread which has recorded an event.
+     */
+    struct KEATraceEvent
+    {
+        const char *name;
+        const char *category;
+        uint64_t startMicros;
+        uint64_t durationMicros;
+        uint64_t bytes;
+        uint32_t threadId;
+    };
+
+    typedef std::function<void(const KEATraceEvent&)> KEATraceCallback;
+
+    /**
+     * Records the public libkea calls and the HDF5 and decompression work
+     * they do. Off unless a callback is set or a trace file is open. When
+     * the KEA_TRACE environment variable names a file when the library is
+     * loaded, a trace is written to it until the process exits. Trace files
+     * are in the Chrome trace event format, which chrome://tracing and
+     * Perfetto both open.
+     */
+    class KEA_EXPORT KEATrace
+    {
+    public:
+        static bool isEnabled()
+        {
+            return enabled.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * The callback is called from whichever thread finished the work, so
+         * must be thread safe. Pass an empty callback to remove it.
+         */
+        static void setCallback(KEATraceCallback callback);
+
+        /**
+         * Starts writing events to fileName, closing any trace file already
+         * open. Returns false if the file could not be created.
+         */
+        static bool startTraceFile(const std::string &fileName);
+        static void stopTraceFile();
+
+        static uint64_t nowMicros();
+        static void record(const char *name, const char *category, uint64_t startMicros, uint64_t bytes);
+    private:
+        static void updateEnabled();
+        static std::atomic<bool> enabled;
+    };
+
+    /**
+     * Records the time from construction to destruction as one event. When
+     * tracing is off this costs a single relaxed atomic load.
+     */
+    class KEATraceScope
+    {
+    public:
+        KEATraceScope(const char *name, const char *category, uint64_t bytes=0):
+            name(name), category(category), bytes(bytes), startMicros(0), active(KEATrace::isEnabled())
+        {
+            if(this->active)
+            {
+                this->startMicros = KEATrace::nowMicros();
+            }
+        }
+        KEATraceScope(const KEATraceScope&) = delete;
+        KEATraceScope& operator=(const KEATraceScope&) = delete;
+
+        void addBytes(uint64_t numBytes)
+        {
+            this->bytes += numBytes;
+        }
+
+        ~KEATraceScope()
+        {
+            if(this->active)
+            {
+                KEATrace::record(this->name, this->category, this->startMicros, this->bytes);
+            }
+        }
+    private:
+        const char *name;
+        const char *category;
+        uint64_t bytes;
+        uint64_t startMicros;
+        bool active;
+    };
+
+}
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ *  KEAZonalStats.h
+ *  LibKEA
+ *
+ *  Copyright 2026 LibKEA. All rights reserved.
+ *
+ *  This file is part of LibKEA.
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify,
+ *  merge, publish, distribute, sublicense, and/or sell copies of the
+ *  Software, and to permit persons to whom the Software is furnished
+ *  to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ *  ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *  CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef KEAZonalStats_H
+#define KEAZonalStats_H
+
+#include <string>
+#include <vector>
+
+#include "libkea/KEACommon.h"
+#include "libkea/KEAException.h"
+
+namespace kealib{
+
+    class KEAImageIO;
+
+    /**
+     * A band to summarise per clump. The columns written are prefix
+     * followed by Mean, StdDev, Min, Max and Count.
+     */
+    struct KEAZonalStatsBand
+    {
+        KEAImageIO *io;
+        uint32_t band;
+        std::string prefix;
+    };
+
+    /**
+     * Calculates the mean, standard deviation (population), minimum,
+     * maximum and count of each value band for every clump in clumpBand
+     * and writes them as float columns to the clump band's attribute
+     * table. Existing columns of the same name are overwritten and the
+     * table is extended if there are clumps beyond its end. Pixels which
+     * are no data or negative in the clump band, or no data in a value
+     * band, are left out; clumps with no pixels get 0 in every column.
+     *
+     * The bands are read in tiles by a KEABlockProcessor. Each thread
+     * keeps its own accumulators, one per clump and value band, which are
+     * merged at the end so memory use grows with the number of clumps
+     * times the number of threads.
+     */
+    KEA_EXPORT void calcZonalStats(KEAImageIO *io, uint32_t clumpBand, const std::vector<KEAZonalStatsBand> &valueBands, uint32_t numThreads=0);
+
+    /**
+     * Counts the pixels of each value in a thematic band and writes the
+     * counts to the band's attribute table, adding rows if the largest
+     * value is beyond the end of the table. The column is created as an
+     * int column with usage PixelCount unless it already exists as a
+     * float column. No data and negative pixels are not counted.
+     *
+     * Threads count into their own arrays; values too large for an array
+     * are counted in a hash table instead so sparse clump ids don't need
+     * an entry for every id below them.
+     */
+    KEA_EXPORT void calcHistogramColumn(KEAImageIO *io, uint32_t band, const std::string &columnName="Histogram", uint32_t numThreads=0);
+
+    /**
+     * Finds the clumps touching each clump of a thematic band and writes
+     * them to the attribute table with setNeighbours. Pixels are joined
+     * to the four pixels sharing an edge, or all eight surrounding pixels
+     * if eightConnected. No data and negative pixels are not clumps.
+     *
+     * Tiles of blockSize pixels (0 for the band's block size) are read
+     * with a one pixel margin and searched in parallel. The results are
+     * merged in tile order; the pixels of each clump are counted first so
+     * a clump's neighbours can be written and freed as soon as its last
+     * tile has been merged rather than holding every clump until the end.
+     */
+    KEA_EXPORT void calcNeighbours(KEAImageIO *io, uint32_t band, bool eightConnected=false, uint64_t blockSize=0, uint32_t numThreads=0);
+
+}
+
+#endif
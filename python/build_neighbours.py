@@ -61,6 +61,8 @@ def getCmdargs():
         help="Use 8-way instead of 4-way")
     p.add_argument("--band", "-b", default=1, type=int, help="Band to use in "+
                 "input dataset (1-based) (default=%(default)s)")
+    p.add_argument("--threads", default=0, type=int, help="Number of threads "+
+                "to process tiles with, 0 for all cores (default=%(default)s)")
     cmdargs = p.parse_args()
     
     return cmdargs
@@ -87,45 +89,19 @@ def main():
     gdal.UseExceptions()
     ds = gdal.Open(cmdargs.infile, gdal.GA_Update)
     
-    buildNeighbours(ds, cmdargs.band, cmdargs.tilesize, cmdargs.eightway)
+    buildNeighbours(ds, cmdargs.band, cmdargs.tilesize, cmdargs.eightway,
+        cmdargs.threads)
     
-def buildNeighbours(ds, band, tilesize=DFLT_TILESIZE, eightway=False):
+def buildNeighbours(ds, band, tilesize=DFLT_TILESIZE, eightway=False,
+        numthreads=0):
     """
     Does the actual work or building the neighbours. 
     
-    ds should be a GDAL dataset object
+    ds should be a GDAL dataset object. The tiles are processed
+    in parallel by libkea, which also counts the pixels of each
+    clump itself so a Histogram column is no longer needed.
     """
-    fieldInfo = extrat.getFieldByName(ds, band, "Histogram")
-    size = extrat.getSize(ds, band)
-    histogram = extrat.getField(ds, band, fieldInfo, 0, size)
-    
-    # will through exception if not set, but we need a nodata otherwise
-    # we can't do a read with margin
-    nodata = extrat.getNoDataValue(ds, band)
-    
-    keaDataType = extrat.getImageBandDataType(ds, band)
-    dataType = KEA_TO_NUMPY[keaDataType]
-
-    imageInfo = extrat.getSpatialInfo(ds)
-
-    accumulator = extrat.NeighbourAccumulator(histogram, ds, 
-                        band, not eightway)    
-    
-    numXtiles = int(numpy.ceil(imageInfo.xSize / tilesize))
-    numYtiles = int(numpy.ceil(imageInfo.ySize / tilesize))
-
-    for tileRow in range(numYtiles):
-        ypos = tileRow * tilesize
-        ysize = min(tilesize, (imageInfo.ySize - ypos))
-        for tileCol in range(numXtiles):
-            xpos = tileCol * tilesize
-            xsize = min(tilesize, (imageInfo.xSize - xpos))
-
-            data = readBlockWithMargin(ds, band, xpos, ypos, 
-                        xsize, ysize, 1, dataType, nodata, 
-                        imageInfo.xSize, imageInfo.ySize)
-            accumulator.addArray(data)
-                        
+    extrat.buildNeighbours(ds, band, eightway, tilesize, numthreads)
     
 def readBlockWithMargin(ds, band, xoff, yoff, xsize, ysize, margin, datatype, 
         nodata, RasterXSize, RasterYSize):
@@ -40,6 +40,7 @@
 #include "awkward/LayoutBuilder.h"
 
 #include "libkea/KEAImageIO.h"
+#include "libkea/KEAZonalStats.h"
 
 #ifdef WIN32
     #include <Windows.h>
@@ -694,6 +695,9 @@ void setField(pybind11::object &dataset, uint32_t nBand, kealib::KEAATTField fie
         {
             throw PyKeaLibException("Unknown field type");
         }
+        
+        // short writes are held by the table, write them out now
+        pRAT->flush();
     }
     catch(const kealib::KEAException &e)
     {
@@ -846,6 +850,25 @@ pybind11::object getImageBlock(pybind11::object &dataset, uint32_t nBand,
 } 
 
 
+// Find the neighbours of every clump in the band and write them
+// to the RAT. Done by libkea in parallel tiles so nothing needs
+// to be passed in from Python.
+void buildNeighbours(pybind11::object &dataset, uint32_t nBand, 
+        bool eightConnected, uint64_t tileSize, uint32_t numThreads)
+{
+    kealib::KEAImageIO *pImageIO = getImageIOFromDataset(dataset);
+
+    try
+    {
+        pybind11::gil_scoped_release release;
+        kealib::calcNeighbours(pImageIO, nBand, eightConnected, tileSize, numThreads);
+    }
+    catch(const kealib::KEAException &e)
+    {
+        throw PyKeaLibException(e.what());
+    }
+}
+
 // class that holds the neighbours and accumulates new neighbours
 // from given 2d numpy arrays
 class NeighbourAccumulator
@@ -1219,6 +1242,13 @@ PYBIND11_MODULE(extrat, m) {
         "neighbours should be an awkward array",
         pybind11::arg("dataset"), pybind11::arg("band"), pybind11::arg("startfid"),
         pybind11::arg("neighbours"));
+    m.def("buildNeighbours", &buildNeighbours,
+        "Find the neighbours of every clump in the given dataset band and "
+        "write them to the RAT. tilesize of 0 uses the block size of the band "
+        "and numthreads of 0 uses all the cores",
+        pybind11::arg("dataset"), pybind11::arg("band"), 
+        pybind11::arg("eightway")=false, pybind11::arg("tilesize")=0,
+        pybind11::arg("numthreads")=0);
     m.def("addField", &addField,
         "Add a column for the given dataset band. "
         "GDAL doesn't support creation of boolean columns, but "
@@ -0,0 +1,198 @@
+/*
+ *  KEABench.cpp
+ *  LibKEA
+ *
+ *  Copyright 2026 LibKEA. All rights reserved.
+ *
+ *  This file is part of LibKEA.
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify,
+ *  merge, publish, distribute, sublicense, and/or sell copies of the
+ *  Software, and to permit persons to whom the Software is furnished
+ *  to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ *  ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *  CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "KEABench.h"
+
+#include "libkea/KEAImageIO.h"
+
+#include <string.h>
+#include <random>
+
+namespace kealib{ namespace bench{
+
+    void KEABenchReport::add(const KEABenchResult &result)
+    {
+        this->results.push_back(result);
+    }
+
+    size_t KEABenchReport::size() const
+    {
+        return this->results.size();
+    }
+
+    static std::string paramsString(const KEABenchResult &result)
+    {
+        std::string str;
+        for(const std::pair<std::string, std::string> &param : result.params)
+        {
+            if(!str.empty())
+            {
+                str += ";";
+            }
+            str += param.first + "=" + param.second;
+        }
+        return str;
+    }
+
+    static double perSecond(double value, double seconds)
+    {
+        return (seconds > 0) ? (value / seconds) : 0;
+    }
+
+    void KEABenchReport::writeCSV(std::ostream &out) const
+    {
+        out << "suite,name,params,items,bytes,seconds,items_per_sec,mbytes_per_sec\n";
+        for(const KEABenchResult &result : this->results)
+        {
+            out << result.suite << "," << result.name << "," << paramsString(result) << ","
+                << result.items << "," << result.bytes << "," << result.seconds << ","
+                << perSecond(result.items, result.seconds) << ","
+                << perSecond(result.bytes / 1048576.0, result.seconds) << "\n";
+        }
+    }
+
+    static std::string jsonString(const std::string &str)
+    {
+        std::string quoted = "\"";
+        for(char c : str)
+        {
+            if((c == '"') || (c == '\\'))
+            {
+                quoted += '\\';
+            }
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+
+    void KEABenchReport::writeJSON(std::ostream &out) const
+    {
+        unsigned majnum = 0, minnum = 0, relnum = 0;
+        H5get_libversion(&majnum, &minnum, &relnum);
+
+        out << "{\n  \"libkea\": " << get_kealibversion() << ",\n  \"hdf5\": \"" << majnum << "." << minnum << "." << relnum << "\",\n  \"results\": [";
+        for(size_t i = 0; i < this->results.size(); ++i)
+        {
+            const KEABenchResult &result = this->results[i];
+            out << ((i == 0) ? "\n" : ",\n") << "    {\"suite\": " << jsonString(result.suite) << ", \"name\": " << jsonString(result.name) << ", \"params\": {";
+            for(size_t p = 0; p < result.params.size(); ++p)
+            {
+                out << ((p == 0) ? "" : ", ") << jsonString(result.params[p].first) << ": " << jsonString(result.params[p].second);
+            }
+            out << "}, \"items\": " << result.items << ", \"bytes\": " << result.bytes << ", \"seconds\": " << result.seconds
+                << ", \"items_per_sec\": " << perSecond(result.items, result.seconds)
+                << ", \"mbytes_per_sec\": " << perSecond(result.bytes / 1048576.0, result.seconds) << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    KEABenchTimer::KEABenchTimer()
+    {
+        this->restart();
+    }
+
+    void KEABenchTimer::restart()
+    {
+        this->start = std::chrono::steady_clock::now();
+    }
+
+    double KEABenchTimer::elapsed() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - this->start).count();
+    }
+
+    std::string benchFileName(const KEABenchOptions &options, const std::string &name)
+    {
+        if(options.dir.empty())
+        {
+            return name;
+        }
+        return options.dir + "/" + name;
+    }
+
+    template <typename T>
+    static void fillBenchValues(T *values, size_t numValues, uint32_t seed)
+    {
+        // A SLOPE WITH A LITTLE NOISE ON IT
+        std::mt19937 rng(seed);
+        for(size_t i = 0; i < numValues; ++i)
+        {
+            values[i] = static_cast<T>(((i / 7) % 100) + (rng() % 8));
+        }
+    }
+
+    void fillBenchData(std::vector<char> &data, KEADataType dataType, size_t numValues, uint32_t seed)
+    {
+        data.resize(numValues * getDataTypeSize(dataType));
+        switch(dataType)
+        {
+            case kea_8int:
+                fillBenchValues(reinterpret_cast<int8_t*>(data.data()), numValues, seed); break;
+            case kea_16int:
+                fillBenchValues(reinterpret_cast<int16_t*>(data.data()), numValues, seed); break;
+            case kea_32int:
+                fillBenchValues(reinterpret_cast<int32_t*>(data.data()), numValues, seed); break;
+            case kea_64int:
+                fillBenchValues(reinterpret_cast<int64_t*>(data.data()), numValues, seed); break;
+            case kea_8uint:
+                fillBenchValues(reinterpret_cast<uint8_t*>(data.data()), numValues, seed); break;
+            case kea_16uint:
+                fillBenchValues(reinterpret_cast<uint16_t*>(data.data()), numValues, seed); break;
+            case kea_32uint:
+                fillBenchValues(reinterpret_cast<uint32_t*>(data.data()), numValues, seed); break;
+            case kea_64uint:
+                fillBenchValues(reinterpret_cast<uint64_t*>(data.data()), numValues, seed); break;
+            case kea_32float:
+                fillBenchValues(reinterpret_cast<float*>(data.data()), numValues, seed); break;
+            case kea_64float:
+                fillBenchValues(reinterpret_cast<double*>(data.data()), numValues, seed); break;
+            default:
+                memset(data.data(), 0, data.size()); break;
+        }
+    }
+
+    const char* dataTypeName(KEADataType dataType)
+    {
+        switch(dataType)
+        {
+            case kea_8int: return "8int";
+            case kea_16int: return "16int";
+            case kea_32int: return "32int";
+            case kea_64int: return "64int";
+            case kea_8uint: return "8uint";
+            case kea_16uint: return "16uint";
+            case kea_32uint: return "32uint";
+            case kea_64uint: return "64uint";
+            case kea_32float: return "32float";
+            case kea_64float: return "64float";
+            default: return "undefined";
+        }
+    }
+
+}}
@@ -0,0 +1,112 @@
+/*
+ *  KEABench.h
+ *  LibKEA
+ *
+ *  Copyright 2026 LibKEA. All rights reserved.
+ *
+ *  This file is part of LibKEA.
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify,
+ *  merge, publish, distribute, sublicense, and/or sell copies of the
+ *  Software, and to permit persons to whom the Software is furnished
+ *  to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ *  ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *  CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef KEABench_H
+#define KEABench_H
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "libkea/KEACommon.h"
+
+namespace kealib{ namespace bench{
+
+    struct KEABenchOptions
+    {
+        // where the scratch files are written
+        std::string dir;
+        // each timing is the best of this many runs
+        uint32_t repeats;
+        // edge length of the test images in pixels
+        uint64_t imageSize;
+        bool quick;
+    };
+
+    /**
+     * One measurement. items is what the benchmark counts (pixels, rows,
+     * opens...) and bytes the amount of data moved, 0 if not meaningful.
+     */
+    struct KEABenchResult
+    {
+        std::string suite;
+        std::string name;
+        std::vector< std::pair<std::string, std::string> > params;
+        uint64_t items;
+        uint64_t bytes;
+        double seconds;
+    };
+
+    class KEABenchReport
+    {
+    public:
+        void add(const KEABenchResult &result);
+        size_t size() const;
+
+        /**
+         * One row per result. The params are written as key=value pairs
+         * separated by ';' so every suite shares the same columns.
+         */
+        void writeCSV(std::ostream &out) const;
+        void writeJSON(std::ostream &out) const;
+    private:
+        std::vector<KEABenchResult> results;
+    };
+
+    class KEABenchTimer
+    {
+    public:
+        KEABenchTimer();
+        void restart();
+        double elapsed() const;
+    private:
+        std::chrono::steady_clock::time_point start;
+    };
+
+    /**
+     * Returns a path in the scratch directory.
+     */
+    std::string benchFileName(const KEABenchOptions &options, const std::string &name);
+
+    /**
+     * Fills data with numValues values of dataType which compress about as
+     * well as a typical image.
+     */
+    void fillBenchData(std::vector<char> &data, KEADataType dataType, size_t numValues, uint32_t seed);
+
+    const char* dataTypeName(KEADataType dataType);
+
+    void runRasterBenchmarks(const KEABenchOptions &options, KEABenchReport &report);
+    void runATTBenchmarks(const KEABenchOptions &options, KEABenchReport &report);
+
+}}
+
+#endif
@@ -0,0 +1,376 @@
+/*
+ *  KEABenchATT.cpp
+ *  LibKEA
+ *
+ *  Copyright 2026 LibKEA. All rights reserved.
+ *
+ *  This file is part of LibKEA.
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify,
+ *  merge, publish, distribute, sublicense, and/or sell copies of the
+ *  Software, and to permit persons to whom the Software is furnished
+ *  to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ *  ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *  CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// Attribute table operations for both table implementations at a range of
+// row counts. Most operations change the table so, unlike the raster suite,
+// each is timed once rather than taking the best of several runs.
+
+#include "KEABench.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <iostream>
+
+#include "libkea/KEAImageIO.h"
+#include "libkea/KEAAttributeTableInMem.h"
+#include "libkea/KEAAttributeTableFile.h"
+
+namespace kealib{ namespace bench{
+
+    // ROWS PER CALL FOR THE RFC40 STYLE BATCH FUNCTIONS, AS GDAL USES
+    static const size_t KEA_BENCH_ATT_BATCH( 10000 );
+
+    class KEABenchATTRun
+    {
+    public:
+        KEABenchATTRun(KEABenchReport &reportIn, KEAATTType typeIn, size_t numRowsIn):
+            report(reportIn), type(typeIn), numRows(numRowsIn)
+        {
+        }
+
+        void record(const std::string &name, uint64_t items, uint64_t bytes, double seconds)
+        {
+            KEABenchResult result;
+            result.suite = "att";
+            result.name = name;
+            result.params.push_back(std::make_pair("att", (this->type == kea_att_mem) ? "mem" : "file"));
+            result.params.push_back(std::make_pair("rows", std::to_string(this->numRows)));
+            result.items = items;
+            result.bytes = bytes;
+            result.seconds = seconds;
+            this->report.add(result);
+        }
+    private:
+        KEABenchReport &report;
+        KEAATTType type;
+        size_t numRows;
+    };
+
+    static std::string benchString(size_t fid)
+    {
+        return "class_" + std::to_string(fid % 1000);
+    }
+
+    /**
+     * Times the per row get and set functions on the first numPerRow rows
+     * of a column. The set timings include flushing the rows to the file.
+     */
+    static void benchPerRow(KEABenchATTRun &run, KEAAttributeTable *att, size_t numPerRow)
+    {
+        size_t intIdx = att->getFieldIndex("intcol");
+        size_t floatIdx = att->getFieldIndex("floatcol");
+        size_t strIdx = att->getFieldIndex("strcol");
+
+        KEABenchTimer timer;
+        for(size_t fid = 0; fid < numPerRow; ++fid)
+        {
+            att->setIntField(fid, intIdx, static_cast<int64_t>(fid));
+        }
+        att->flush();
+        run.record("set_int_row", numPerRow, numPerRow * sizeof(int64_t), timer.elapsed());
+
+        timer.restart();
+        int64_t intSum = 0;
+        for(size_t fid = 0; fid < numPerRow; ++fid)
+        {
+            intSum += att->getIntField(fid, intIdx);
+        }
+        run.record("get_int_row", numPerRow, numPerRow * sizeof(int64_t), timer.elapsed());
+
+        timer.restart();
+        for(size_t fid = 0; fid < numPerRow; ++fid)
+        {
+            att->setFloatField(fid, floatIdx, fid * 0.5);
+        }
+        att->flush();
+        run.record("set_float_row", numPerRow, numPerRow * sizeof(double), timer.elapsed());
+
+        timer.restart();
+        double floatSum = 0;
+        for(size_t fid = 0; fid < numPerRow; ++fid)
+        {
+            floatSum += att->getFloatField(fid, floatIdx);
+        }
+        run.record("get_float_row", numPerRow, numPerRow * sizeof(double), timer.elapsed());
+
+        timer.restart();
+        for(size_t fid = 0; fid < numPerRow; ++fid)
+        {
+            att->setStringField(fid, strIdx, benchString(fid));
+        }
+        att->flush();
+        run.record("set_string_row", numPerRow, 0, timer.elapsed());
+
+        timer.restart();
+        size_t strLen = 0;
+        for(size_t fid = 0; fid < numPerRow; ++fid)
+        {
+            strLen += att->getStringField(fid, strIdx).size();
+        }
+        run.record("get_string_row", numPerRow, strLen, timer.elapsed());
+
+        if((intSum < 0) || (floatSum < 0))
+        {
+            std::cerr << "att: unexpected values read back" << std::endl;
+        }
+    }
+
+    /**
+     * Times the batch get and set functions over every row of a column.
+     */
+    static void benchBatch(KEABenchATTRun &run, KEAAttributeTable *att, size_t numRows)
+    {
+        size_t intIdx = att->getFieldIndex("intcol");
+        size_t floatIdx = att->getFieldIndex("floatcol");
+        size_t strIdx = att->getFieldIndex("strcol");
+
+        std::vector<int64_t> intBuf(KEA_BENCH_ATT_BATCH);
+        std::vector<double> floatBuf(KEA_BENCH_ATT_BATCH);
+        std::vector<std::string> strBuf(KEA_BENCH_ATT_BATCH);
+
+        KEABenchTimer timer;
+        for(size_t start = 0; start < numRows; start += KEA_BENCH_ATT_BATCH)
+        {
+            size_t len = std::min(KEA_BENCH_ATT_BATCH, numRows - start);
+            for(size_t i = 0; i < len; ++i)
+            {
+                intBuf[i] = static_cast<int64_t>(start + i);
+            }
+            att->setIntFields(start, len, intIdx, intBuf.data());
+        }
+        run.record("set_int_batch", numRows, numRows * sizeof(int64_t), timer.elapsed());
+
+        timer.restart();
+        for(size_t start = 0; start < numRows; start += KEA_BENCH_ATT_BATCH)
+        {
+            att->getIntFields(start, std::min(KEA_BENCH_ATT_BATCH, numRows - start), intIdx, intBuf.data());
+        }
+        run.record("get_int_batch", numRows, numRows * sizeof(int64_t), timer.elapsed());
+
+        timer.restart();
+        for(size_t start = 0; start < numRows; start += KEA_BENCH_ATT_BATCH)
+        {
+            size_t len = std::min(KEA_BENCH_ATT_BATCH, numRows - start);
+            for(size_t i = 0; i < len; ++i)
+            {
+                floatBuf[i] = (start + i) * 0.5;
+            }
+            att->setFloatFields(start, len, floatIdx, floatBuf.data());
+        }
+        run.record("set_float_batch", numRows, numRows * sizeof(double), timer.elapsed());
+
+        timer.restart();
+        for(size_t start = 0; start < numRows; start += KEA_BENCH_ATT_BATCH)
+        {
+            att->getFloatFields(start, std::min(KEA_BENCH_ATT_BATCH, numRows - start), floatIdx, floatBuf.data());
+        }
+        run.record("get_float_batch", numRows, numRows * sizeof(double), timer.elapsed());
+
+        timer.restart();
+        for(size_t start = 0; start < numRows; start += KEA_BENCH_ATT_BATCH)
+        {
+            size_t len = std::min(KEA_BENCH_ATT_BATCH, numRows - start);
+            strBuf.resize(len);
+            for(size_t i = 0; i < len; ++i)
+            {
+                strBuf[i] = benchString(start + i);
+            }
+            att->setStringFields(start, len, strIdx, &strBuf);
+        }
+        run.record("set_string_batch", numRows, 0, timer.elapsed());
+
+        timer.restart();
+        size_t strLen = 0;
+        for(size_t start = 0; start < numRows; start += KEA_BENCH_ATT_BATCH)
+        {
+            strBuf.clear();
+            att->getStringFields(start, std::min(KEA_BENCH_ATT_BATCH, numRows - start), strIdx, &strBuf);
+            for(const std::string &str : strBuf)
+            {
+                strLen += str.size();
+            }
+        }
+        run.record("get_string_batch", numRows, strLen, timer.elapsed());
+    }
+
+    /**
+     * Gives every row four neighbours and reads them back. Only the file
+     * table implements neighbours.
+     */
+    static void benchNeighbours(KEABenchATTRun &run, KEAAttributeTable *att, size_t numRows)
+    {
+        std::vector<std::vector<size_t>* > neighbours;
+        for(size_t i = 0; i < KEA_BENCH_ATT_BATCH; ++i)
+        {
+            neighbours.push_back(new std::vector<size_t>(4));
+        }
+
+        KEABenchTimer timer;
+        for(size_t start = 0; start < numRows; start += KEA_BENCH_ATT_BATCH)
+        {
+            size_t len = std::min(KEA_BENCH_ATT_BATCH, numRows - start);
+            for(size_t i = 0; i < len; ++i)
+            {
+                size_t fid = start + i;
+                std::vector<size_t> &nbrs = *neighbours[i];
+                nbrs[0] = (fid + numRows - 1) % numRows;
+                nbrs[1] = (fid + 1) % numRows;
+                nbrs[2] = (fid + numRows - 1000) % numRows;
+                nbrs[3] = (fid + 1000) % numRows;
+            }
+            att->setNeighbours(start, len, &neighbours);
+        }
+        run.record("set_neighbours", numRows, numRows * 4 * sizeof(size_t), timer.elapsed());
+
+        for(std::vector<size_t> *nbrs : neighbours)
+        {
+            delete nbrs;
+        }
+        neighbours.clear();
+
+        timer.restart();
+        for(size_t start = 0; start < numRows; start += KEA_BENCH_ATT_BATCH)
+        {
+            att->getNeighbours(start, std::min(KEA_BENCH_ATT_BATCH, numRows - start), &neighbours);
+            for(std::vector<size_t> *nbrs : neighbours)
+            {
+                delete nbrs;
+            }
+            neighbours.clear();
+        }
+        run.record("get_neighbours", numRows, numRows * 4 * sizeof(size_t), timer.elapsed());
+    }
+
+    static void benchATTTable(const KEABenchOptions &options, KEABenchReport &report, KEAATTType type, size_t numRows)
+    {
+        const std::string fileName = benchFileName(options, "kea-bench-att.kea");
+        KEABenchATTRun run(report, type, numRows);
+
+        KEAImageIO imageIO;
+        imageIO.openKEAImageHeader(KEAImageIO::createKEAImage(fileName, kea_32uint, 64, 64, 1));
+        KEAAttributeTable *att = imageIO.getAttributeTable(type, 1);
+
+        // GROW THE TABLE IN STEPS, AS WHEN ROWS ARE ADDED WHILE SEGMENTING
+        const size_t numSteps = 10;
+        KEABenchTimer timer;
+        for(size_t step = 0; step < numSteps; ++step)
+        {
+            att->addRows((numRows / numSteps) + ((step < (numRows % numSteps)) ? 1 : 0));
+        }
+        run.record("add_rows", numRows, 0, timer.elapsed());
+
+        timer.restart();
+        att->addAttIntField("intcol", 0);
+        run.record("add_int_field", numRows, numRows * sizeof(int64_t), timer.elapsed());
+
+        timer.restart();
+        att->addAttFloatField("floatcol", 0);
+        run.record("add_float_field", numRows, numRows * sizeof(double), timer.elapsed());
+
+        timer.restart();
+        att->addAttBoolField("boolcol", false);
+        run.record("add_bool_field", numRows, numRows, timer.elapsed());
+
+        timer.restart();
+        att->addAttStringField("strcol", "");
+        run.record("add_string_field", numRows, 0, timer.elapsed());
+
+        size_t numPerRow = std::min<size_t>(numRows, options.quick ? 5000 : 20000);
+        benchPerRow(run, att, numPerRow);
+        benchBatch(run, att, numRows);
+        if(type == kea_att_file)
+        {
+            benchNeighbours(run, att, numRows);
+        }
+
+        if(type == kea_att_mem)
+        {
+            H5::H5File *keaImgH5File = KEAImageIO::openKeaH5RW(fileName);
+            timer.restart();
+            att->exportToKeaFile(keaImgH5File, 1);
+            keaImgH5File->flush(H5F_SCOPE_GLOBAL);
+            run.record("export", numRows, 0, timer.elapsed());
+            keaImgH5File->close();
+            delete keaImgH5File;
+        }
+        att->flush();
+        KEAAttributeTable::destroyAttributeTable(att);
+        imageIO.close();
+
+        // TIME LOADING THE TABLE FROM A FRESHLY OPENED FILE
+        H5::H5File *keaImgH5File = KEAImageIO::openKeaH5RDOnly(fileName);
+        timer.restart();
+        if(type == kea_att_mem)
+        {
+            att = KEAAttributeTableInMem::createKeaAtt(keaImgH5File, 1);
+        }
+        else
+        {
+            att = KEAAttributeTableFile::createKeaAtt(keaImgH5File, 1);
+        }
+        run.record("load", numRows, 0, timer.elapsed());
+        if(att->getSize() != numRows)
+        {
+            std::cerr << "att: loaded table has " << att->getSize() << " rows, expected " << numRows << std::endl;
+        }
+        
+        // A WHOLE COLUMN IN ONE CALL, AS WHEN A COLUMN IS LOADED FOR ANALYSIS
+        std::vector<int64_t> column(numRows);
+        timer.restart();
+        att->getIntFields(0, numRows, att->getFieldIndex("intcol"), column.data());
+        run.record("read_int_column", numRows, numRows * sizeof(int64_t), timer.elapsed());
+        KEAAttributeTable::destroyAttributeTable(att);
+        keaImgH5File->close();
+        delete keaImgH5File;
+
+        remove(fileName.c_str());
+    }
+
+    void runATTBenchmarks(const KEABenchOptions &options, KEABenchReport &report)
+    {
+        std::vector<size_t> rowCounts;
+        rowCounts.push_back(10000);
+        rowCounts.push_back(100000);
+        if(!options.quick)
+        {
+            rowCounts.push_back(1000000);
+        }
+
+        const KEAATTType types[] = {kea_att_mem, kea_att_file};
+        for(KEAATTType type : types)
+        {
+            for(size_t numRows : rowCounts)
+            {
+                std::cerr << "att: " << ((type == kea_att_mem) ? "mem " : "file ") << numRows << " rows" << std::endl;
+                benchATTTable(options, report, type, numRows);
+            }
+        }
+    }
+
+}}
@@ -0,0 +1,349 @@
+/*
+ *  KEABenchRaster.cpp
+ *  LibKEA
+ *
+ *  Copyright 2026 LibKEA. All rights reserved.
+ *
+ *  This file is part of LibKEA.
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify,
+ *  merge, publish, distribute, sublicense, and/or sell copies of the
+ *  Software, and to permit persons to whom the Software is furnished
+ *  to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ *  ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *  CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// Block throughput of the raster bands, overviews and masks, and the time
+// taken to open a file and read its header.
+
+#include "KEABench.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+#include "libkea/KEAImageIO.h"
+
+namespace kealib{ namespace bench{
+
+    enum KEABenchPattern
+    {
+        bench_sequential,
+        bench_random,
+        bench_column
+    };
+
+    static const char* patternName(KEABenchPattern pattern)
+    {
+        switch(pattern)
+        {
+            case bench_sequential: return "sequential";
+            case bench_random: return "random";
+            case bench_column: return "column";
+        }
+        return "unknown";
+    }
+
+    struct KEABenchBlock
+    {
+        uint64_t xOff;
+        uint64_t yOff;
+        uint64_t xSize;
+        uint64_t ySize;
+    };
+
+    /**
+     * The blocks covering an image in the order a given access pattern
+     * visits them.
+     */
+    static std::vector<KEABenchBlock> blockOrder(uint64_t xSize, uint64_t ySize, uint32_t blockSize, KEABenchPattern pattern)
+    {
+        std::vector<KEABenchBlock> blocks;
+        if(pattern == bench_column)
+        {
+            for(uint64_t xOff = 0; xOff < xSize; xOff += blockSize)
+            {
+                for(uint64_t yOff = 0; yOff < ySize; yOff += blockSize)
+                {
+                    blocks.push_back({xOff, yOff, std::min<uint64_t>(blockSize, xSize - xOff), std::min<uint64_t>(blockSize, ySize - yOff)});
+                }
+            }
+        }
+        else
+        {
+            for(uint64_t yOff = 0; yOff < ySize; yOff += blockSize)
+            {
+                for(uint64_t xOff = 0; xOff < xSize; xOff += blockSize)
+                {
+                    blocks.push_back({xOff, yOff, std::min<uint64_t>(blockSize, xSize - xOff), std::min<uint64_t>(blockSize, ySize - yOff)});
+                }
+            }
+            if(pattern == bench_random)
+            {
+                std::mt19937 rng(42);
+                std::shuffle(blocks.begin(), blocks.end(), rng);
+            }
+        }
+        return blocks;
+    }
+
+    static KEABenchResult rasterResult(const std::string &name, KEADataType dataType, uint32_t blockSize, uint32_t deflate, KEABenchPattern pattern, uint64_t imageSize)
+    {
+        KEABenchResult result;
+        result.suite = "raster";
+        result.name = name;
+        result.params.push_back(std::make_pair("dtype", dataTypeName(dataType)));
+        result.params.push_back(std::make_pair("block", std::to_string(blockSize)));
+        result.params.push_back(std::make_pair("deflate", std::to_string(deflate)));
+        result.params.push_back(std::make_pair("pattern", patternName(pattern)));
+        result.params.push_back(std::make_pair("size", std::to_string(imageSize)));
+        result.items = imageSize * imageSize;
+        result.bytes = result.items * getDataTypeSize(dataType);
+        result.seconds = 0;
+        return result;
+    }
+
+    /**
+     * Writes a single band image block by block and reads it back, the file
+     * being closed in between so the read starts from a cold chunk cache.
+     * The write includes closing the file, so everything has reached it.
+     */
+    static void benchBlockIO(const KEABenchOptions &options, KEABenchReport &report, KEADataType dataType, uint32_t blockSize, uint32_t deflate, KEABenchPattern pattern)
+    {
+        const std::string fileName = benchFileName(options, "kea-bench-raster.kea");
+        const uint64_t imageSize = options.imageSize;
+        std::vector<KEABenchBlock> blocks = blockOrder(imageSize, imageSize, blockSize, pattern);
+
+        std::vector<char> data;
+        fillBenchData(data, dataType, static_cast<size_t>(blockSize) * blockSize, 1);
+        std::vector<char> readBuf(data.size());
+
+        KEABenchResult writeResult = rasterResult("write", dataType, blockSize, deflate, pattern, imageSize);
+        KEABenchResult readResult = rasterResult("read", dataType, blockSize, deflate, pattern, imageSize);
+        for(uint32_t r = 0; r < options.repeats; ++r)
+        {
+            KEABenchTimer timer;
+            H5::H5File *keaImgH5File = KEAImageIO::createKEAImage(fileName, dataType, imageSize, imageSize, 1, NULL, NULL, blockSize, KEA_ATT_CHUNK_SIZE, KEA_MDC_NELMTS, KEA_RDCC_NELMTS, KEA_RDCC_NBYTES, KEA_RDCC_W0, KEA_SIEVE_BUF, KEA_META_BLOCKSIZE, deflate);
+            KEAImageIO imageIO;
+            imageIO.openKEAImageHeader(keaImgH5File);
+            for(const KEABenchBlock &block : blocks)
+            {
+                imageIO.writeImageBlock2Band(1, data.data(), block.xOff, block.yOff, block.xSize, block.ySize, block.xSize, block.ySize, dataType);
+            }
+            imageIO.close();
+            double seconds = timer.elapsed();
+            if((r == 0) || (seconds < writeResult.seconds))
+            {
+                writeResult.seconds = seconds;
+            }
+
+            timer.restart();
+            imageIO.openKEAImageHeader(KEAImageIO::openKeaH5RDOnly(fileName));
+            for(const KEABenchBlock &block : blocks)
+            {
+                imageIO.readImageBlock2Band(1, readBuf.data(), block.xOff, block.yOff, block.xSize, block.ySize, block.xSize, block.ySize, dataType);
+            }
+            imageIO.close();
+            seconds = timer.elapsed();
+            if((r == 0) || (seconds < readResult.seconds))
+            {
+                readResult.seconds = seconds;
+            }
+        }
+        report.add(writeResult);
+        report.add(readResult);
+        remove(fileName.c_str());
+    }
+
+    /**
+     * Reads an overview a quarter of the size of the image, and a mask the
+     * size of the image, block by block.
+     */
+    static void benchOverviewAndMask(const KEABenchOptions &options, KEABenchReport &report)
+    {
+        const std::string fileName = benchFileName(options, "kea-bench-ovmask.kea");
+        const KEADataType dataType = kea_32float;
+        const uint32_t blockSize = KEA_IMAGE_CHUNK_SIZE;
+        const uint64_t imageSize = options.imageSize;
+        const uint64_t ovSize = std::max<uint64_t>(imageSize / 4, 1);
+
+        std::vector<char> data;
+        fillBenchData(data, dataType, static_cast<size_t>(blockSize) * blockSize, 2);
+        std::vector<uint8_t> maskData(static_cast<size_t>(blockSize) * blockSize, 255);
+
+        KEAImageIO imageIO;
+        imageIO.openKEAImageHeader(KEAImageIO::createKEAImage(fileName, dataType, imageSize, imageSize, 1, NULL, NULL, blockSize));
+        imageIO.createOverview(1, 1, ovSize, ovSize);
+        for(const KEABenchBlock &block : blockOrder(ovSize, ovSize, blockSize, bench_sequential))
+        {
+            imageIO.writeToOverview(1, 1, data.data(), block.xOff, block.yOff, block.xSize, block.ySize, block.xSize, block.ySize, dataType);
+        }
+        imageIO.createMask(1);
+        std::vector<KEABenchBlock> blocks = blockOrder(imageSize, imageSize, blockSize, bench_sequential);
+        for(const KEABenchBlock &block : blocks)
+        {
+            imageIO.writeImageBlock2BandMask(1, maskData.data(), block.xOff, block.yOff, block.xSize, block.ySize, block.xSize, block.ySize, kea_8uint);
+        }
+        imageIO.close();
+
+        KEABenchResult ovResult = rasterResult("overview_read", dataType, blockSize, KEA_DEFLATE, bench_sequential, ovSize);
+        KEABenchResult maskResult = rasterResult("mask_read", kea_8uint, blockSize, KEA_DEFLATE, bench_sequential, imageSize);
+        std::vector<char> readBuf(data.size());
+        for(uint32_t r = 0; r < options.repeats; ++r)
+        {
+            KEABenchTimer timer;
+            imageIO.openKEAImageHeader(KEAImageIO::openKeaH5RDOnly(fileName));
+            for(const KEABenchBlock &block : blockOrder(ovSize, ovSize, blockSize, bench_sequential))
+            {
+                imageIO.readFromOverview(1, 1, readBuf.data(), block.xOff, block.yOff, block.xSize, block.ySize, block.xSize, block.ySize, dataType);
+            }
+            imageIO.close();
+            double seconds = timer.elapsed();
+            if((r == 0) || (seconds < ovResult.seconds))
+            {
+                ovResult.seconds = seconds;
+            }
+
+            timer.restart();
+            imageIO.openKEAImageHeader(KEAImageIO::openKeaH5RDOnly(fileName));
+            for(const KEABenchBlock &block : blocks)
+            {
+                imageIO.readImageBlock2BandMask(1, readBuf.data(), block.xOff, block.yOff, block.xSize, block.ySize, block.xSize, block.ySize, kea_8uint);
+            }
+            imageIO.close();
+            seconds = timer.elapsed();
+            if((r == 0) || (seconds < maskResult.seconds))
+            {
+                maskResult.seconds = seconds;
+            }
+        }
+        report.add(ovResult);
+        report.add(maskResult);
+        remove(fileName.c_str());
+    }
+
+    /**
+     * Opens a file and queries every band the way GDAL does when a dataset
+     * is opened. With legacy set the consolidated header is removed first
+     * so the individual header datasets are read instead.
+     */
+    static void benchOpen(const KEABenchOptions &options, KEABenchReport &report, uint32_t numBands, bool legacy)
+    {
+        const std::string fileName = benchFileName(options, "kea-bench-open.kea");
+        H5::H5File *keaImgH5File = KEAImageIO::createKEAImage(fileName, kea_8uint, 256, 256, numBands);
+        if(legacy && keaImgH5File->nameExists(KEA_DATASETNAME_HEADER_CONSOLIDATED))
+        {
+            keaImgH5File->unlink(KEA_DATASETNAME_HEADER_CONSOLIDATED);
+        }
+        keaImgH5File->close();
+        delete keaImgH5File;
+
+        const uint32_t numOpens = options.quick ? 10 : 50;
+        KEABenchResult result;
+        result.suite = "raster";
+        result.name = "open";
+        result.params.push_back(std::make_pair("bands", std::to_string(numBands)));
+        result.params.push_back(std::make_pair("header", legacy ? "legacy" : "consolidated"));
+        result.items = numOpens;
+        result.bytes = 0;
+        result.seconds = 0;
+        for(uint32_t r = 0; r < options.repeats; ++r)
+        {
+            KEABenchTimer timer;
+            for(uint32_t i = 0; i < numOpens; ++i)
+            {
+                KEAImageIO imageIO;
+                imageIO.openKEAImageHeader(KEAImageIO::openKeaH5RDOnly(fileName));
+                for(uint32_t band = 1; band <= numBands; ++band)
+                {
+                    imageIO.getImageBandDataType(band);
+                    imageIO.getImageBandDescription(band);
+                    imageIO.getImageBlockSize(band);
+                    imageIO.getImageBandLayerType(band);
+                    imageIO.getImageBandClrInterp(band);
+                    imageIO.getNumOfOverviews(band);
+                    try
+                    {
+                        double noData = 0;
+                        imageIO.getNoDataValue(band, &noData, kea_64float);
+                    }
+                    catch(KEAIOException &)
+                    {
+                        // NO DATA NOT SET
+                    }
+                }
+                imageIO.close();
+            }
+            double seconds = timer.elapsed();
+            if((r == 0) || (seconds < result.seconds))
+            {
+                result.seconds = seconds;
+            }
+        }
+        report.add(result);
+        remove(fileName.c_str());
+    }
+
+    void runRasterBenchmarks(const KEABenchOptions &options, KEABenchReport &report)
+    {
+        // VARY ONE THING AT A TIME AWAY FROM THE DEFAULTS
+        const KEADataType baseType = kea_32float;
+        const uint32_t baseBlock = KEA_IMAGE_CHUNK_SIZE;
+        const uint32_t baseDeflate = KEA_DEFLATE;
+
+        const KEADataType dataTypes[] = {kea_8int, kea_16int, kea_32int, kea_64int, kea_8uint, kea_16uint, kea_32uint, kea_64uint, kea_32float, kea_64float};
+        for(KEADataType dataType : dataTypes)
+        {
+            std::cerr << "raster: " << dataTypeName(dataType) << std::endl;
+            benchBlockIO(options, report, dataType, baseBlock, baseDeflate, bench_sequential);
+        }
+
+        const uint32_t blockSizes[] = {64, 512};
+        for(uint32_t blockSize : blockSizes)
+        {
+            std::cerr << "raster: block " << blockSize << std::endl;
+            benchBlockIO(options, report, baseType, blockSize, baseDeflate, bench_sequential);
+        }
+
+        const uint32_t deflates[] = {0, 6};
+        for(uint32_t deflate : deflates)
+        {
+            std::cerr << "raster: deflate " << deflate << std::endl;
+            benchBlockIO(options, report, baseType, baseBlock, deflate, bench_sequential);
+        }
+
+        const KEABenchPattern patterns[] = {bench_random, bench_column};
+        for(KEABenchPattern pattern : patterns)
+        {
+            std::cerr << "raster: " << patternName(pattern) << std::endl;
+            benchBlockIO(options, report, baseType, baseBlock, baseDeflate, pattern);
+        }
+
+        std::cerr << "raster: overview and mask" << std::endl;
+        benchOverviewAndMask(options, report);
+
+        const uint32_t bandCounts[] = {1, 16, 128};
+        for(uint32_t numBands : bandCounts)
+        {
+            std::cerr << "raster: open " << numBands << " bands" << std::endl;
+            benchOpen(options, report, numBands, false);
+            benchOpen(options, report, numBands, true);
+        }
+    }
+
+}}
@@ -0,0 +1,160 @@
+/*
+ *  kea-bench.cpp
+ *  LibKEA
+ *
+ *  Copyright 2026 LibKEA. All rights reserved.
+ *
+ *  This file is part of LibKEA.
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify,
+ *  merge, publish, distribute, sublicense, and/or sell copies of the
+ *  Software, and to permit persons to whom the Software is furnished
+ *  to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ *  ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *  CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// Runs the libkea benchmarks and prints the results as CSV or JSON on
+// stdout (or to --output). Progress goes to stderr.
+
+#include <stdlib.h>
+#include <fstream>
+#include <iostream>
+
+#include "KEABench.h"
+#include "libkea/KEAException.h"
+
+static void printUsage()
+{
+    std::cerr << "usage: kea-bench [--suite raster|att|all] [--format csv|json] [--output file]" << std::endl;
+    std::cerr << "                 [--dir scratchdir] [--repeats n] [--size pixels] [--quick]" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    kealib::bench::KEABenchOptions options;
+    options.dir = ".";
+    options.repeats = 3;
+    options.imageSize = 2048;
+    options.quick = false;
+
+    std::string suite = "all";
+    std::string format = "csv";
+    std::string outFileName;
+    bool sizeGiven = false;
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool haveValue = (i + 1) < argc;
+        if((arg == "--suite") && haveValue)
+        {
+            suite = argv[++i];
+        }
+        else if((arg == "--format") && haveValue)
+        {
+            format = argv[++i];
+        }
+        else if((arg == "--output") && haveValue)
+        {
+            outFileName = argv[++i];
+        }
+        else if((arg == "--dir") && haveValue)
+        {
+            options.dir = argv[++i];
+        }
+        else if((arg == "--repeats") && haveValue)
+        {
+            options.repeats = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+        else if((arg == "--size") && haveValue)
+        {
+            options.imageSize = strtoull(argv[++i], NULL, 10);
+            sizeGiven = true;
+        }
+        else if(arg == "--quick")
+        {
+            options.quick = true;
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if((suite != "raster") && (suite != "att") && (suite != "all"))
+    {
+        printUsage();
+        return 1;
+    }
+    if((format != "csv") && (format != "json"))
+    {
+        printUsage();
+        return 1;
+    }
+    if(options.quick)
+    {
+        if(!sizeGiven)
+        {
+            options.imageSize = 512;
+        }
+        options.repeats = 1;
+    }
+    if((options.repeats == 0) || (options.imageSize == 0))
+    {
+        printUsage();
+        return 1;
+    }
+
+    kealib::bench::KEABenchReport report;
+    try
+    {
+        if((suite == "raster") || (suite == "all"))
+        {
+            kealib::bench::runRasterBenchmarks(options, report);
+        }
+        if((suite == "att") || (suite == "all"))
+        {
+            kealib::bench::runATTBenchmarks(options, report);
+        }
+    }
+    catch(kealib::KEAException &e)
+    {
+        std::cerr << "kea-bench: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::ofstream outFile;
+    if(!outFileName.empty())
+    {
+        outFile.open(outFileName.c_str());
+        if(!outFile)
+        {
+            std::cerr << "kea-bench: could not open " << outFileName << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = outFileName.empty() ? std::cout : outFile;
+    if(format == "json")
+    {
+        report.writeJSON(out);
+    }
+    else
+    {
+        report.writeCSV(out);
+    }
+    return 0;
+}
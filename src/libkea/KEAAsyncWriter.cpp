@@ -0,0 +1,377 @@
+/*
+ *  KEAAsyncWriter.cpp
+ *  LibKEA
+ *
+ *  Copyright 2026 LibKEA. All rights reserved.
+ *
+ *  This file is part of LibKEA.
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify,
+ *  merge, publish, distribute, sublicense, and/or sell copies of the
+ *  Software, and to permit persons to whom the Software is furnished
+ *  to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ *  ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *  CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "libkea/KEAAsyncWriter.h"
+
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#include "libkea/KEAImageIO.h"
+
+namespace kealib{
+    
+    // how long a partial block is held back waiting to be merged
+    static const int KEA_WRITE_HOLD_MS = 50;
+    
+    KEAAsyncWriter::KEAAsyncWriter(KEAImageIO *io, uint64_t maxQueuedBytes)
+    {
+        this->io = io;
+        this->maxQueuedBytes = maxQueuedBytes;
+        this->queuedBytes = 0;
+        this->numWaiting = 0;
+        this->numBlockedProducers = 0;
+        this->busy = false;
+        this->stopping = false;
+        this->writer = std::thread(&KEAAsyncWriter::writerLoop, this);
+    }
+    
+    std::future<void> KEAAsyncWriter::submit(uint32_t band, const void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeOut, uint64_t ySizeOut, uint64_t xSizeBuf, KEADataType inDataType)
+    {
+        size_t dtSize = getDataTypeSize(inDataType);
+        if(dtSize == 0)
+        {
+            throw KEAIOException("The specified data type was not recognised.");
+        }
+        
+        KEAWriteRequest *request = new KEAWriteRequest();
+        request->band = band;
+        request->dataType = inDataType;
+        request->xOff = xPxlOff;
+        request->yOff = yPxlOff;
+        request->xSize = xSizeOut;
+        request->ySize = ySizeOut;
+        std::future<void> future = request->promise.get_future();
+        
+        uint64_t numBytes = xSizeOut * ySizeOut * dtSize;
+        if(numBytes == 0)
+        {
+            request->promise.set_value();
+            delete request;
+            return future;
+        }
+        
+        // COPY THE BLOCK SO THE CALLER CAN REUSE THEIR BUFFER
+        request->data.resize(numBytes);
+        for(uint64_t row = 0; row < ySizeOut; ++row)
+        {
+            memcpy(request->data.data() + (row * xSizeOut * dtSize), ((const char*)data) + (row * xSizeBuf * dtSize), xSizeOut * dtSize);
+        }
+        
+        {
+            std::unique_lock<std::mutex> lock(this->queueMutex);
+            if(this->stopping)
+            {
+                delete request;
+                throw KEAIOException("The asynchronous writer has been stopped.");
+            }
+            
+            // AN EMPTY QUEUE ALWAYS TAKES THE BLOCK SO ONE LARGER THAN THE
+            // QUEUE DOES NOT WAIT FOREVER
+            if((this->queuedBytes > 0) && ((this->queuedBytes + numBytes) > this->maxQueuedBytes))
+            {
+                // HELD BLOCKS NEED WRITING TO MAKE SPACE
+                ++this->numBlockedProducers;
+                this->queueCond.notify_one();
+                this->spaceCond.wait(lock, [this, numBytes](){ return (this->queuedBytes == 0) || ((this->queuedBytes + numBytes) <= this->maxQueuedBytes); });
+                --this->numBlockedProducers;
+            }
+            
+            this->queue.push_back(request);
+            this->queuedBytes += numBytes;
+        }
+        this->queueCond.notify_one();
+        
+        return future;
+    }
+    
+    void KEAAsyncWriter::wait()
+    {
+        std::unique_lock<std::mutex> lock(this->queueMutex);
+        ++this->numWaiting;
+        this->queueCond.notify_one();
+        this->idleCond.wait(lock, [this](){ return (this->queuedBytes == 0) && !this->busy; });
+        --this->numWaiting;
+        
+        if(this->firstError)
+        {
+            std::exception_ptr error = this->firstError;
+            this->firstError = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+    
+    void KEAAsyncWriter::setMaxQueuedBytes(uint64_t maxQueuedBytes)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->queueMutex);
+            this->maxQueuedBytes = maxQueuedBytes;
+        }
+        this->spaceCond.notify_all();
+    }
+    
+    uint64_t KEAAsyncWriter::getMaxQueuedBytes()
+    {
+        std::lock_guard<std::mutex> lock(this->queueMutex);
+        return this->maxQueuedBytes;
+    }
+    
+    void KEAAsyncWriter::writerLoop()
+    {
+        // HDF5 ERROR PRINTING IS PER THREAD
+        H5::Exception::dontPrint();
+        
+        std::unique_lock<std::mutex> lock(this->queueMutex);
+        while(true)
+        {
+            auto workToDo = [this](){ return !this->queue.empty() || this->stopping || (((this->numWaiting > 0) || (this->numBlockedProducers > 0)) && !this->held.empty()); };
+            bool timedOut = false;
+            if(this->held.empty())
+            {
+                this->queueCond.wait(lock, workToDo);
+            }
+            else
+            {
+                // HELD BLOCKS ONLY WAIT A SHORT TIME FOR THEIR NEIGHBOURS
+                timedOut = !this->queueCond.wait_for(lock, std::chrono::milliseconds(KEA_WRITE_HOLD_MS), workToDo);
+            }
+            if(this->stopping && this->queue.empty() && this->held.empty())
+            {
+                break;
+            }
+            
+            std::deque<KEAWriteRequest*> batch;
+            batch.swap(this->queue);
+            bool flush = timedOut || this->stopping || (this->numWaiting > 0) || (this->numBlockedProducers > 0) || (this->queuedBytes >= (this->maxQueuedBytes / 2));
+            this->busy = true;
+            lock.unlock();
+            
+            uint64_t writtenBytes = 0;
+            for(auto iterRequest = batch.begin(); iterRequest != batch.end(); ++iterRequest)
+            {
+                writtenBytes += this->addToHeld(*iterRequest);
+            }
+            
+            // WRITE THE GROUPS COVERING WHOLE CHUNKS, THE REST WAIT FOR
+            // THEIR NEIGHBOURS UNLESS WE ARE FLUSHING
+            for(auto iterGroup = this->held.begin(); iterGroup != this->held.end(); )
+            {
+                if(flush || this->chunkAligned(*iterGroup))
+                {
+                    writtenBytes += this->writeGroup(*iterGroup);
+                    iterGroup = this->held.erase(iterGroup);
+                }
+                else
+                {
+                    ++iterGroup;
+                }
+            }
+            
+            lock.lock();
+            this->busy = false;
+            this->queuedBytes -= writtenBytes;
+            this->spaceCond.notify_all();
+            this->idleCond.notify_all();
+        }
+    }
+    
+    uint64_t KEAAsyncWriter::addToHeld(KEAWriteRequest *request)
+    {
+        uint64_t writtenBytes = 0;
+        
+        // A HELD BLOCK OVERLAPPING THIS ONE MUST REACH THE FILE FIRST
+        bool overlaps = false;
+        for(auto iterGroup = this->held.begin(); iterGroup != this->held.end(); ++iterGroup)
+        {
+            if((iterGroup->band == request->band) &&
+               (iterGroup->xOff < (request->xOff + request->xSize)) && (request->xOff < (iterGroup->xOff + iterGroup->xSize)) &&
+               (iterGroup->yOff < (request->yOff + request->ySize)) && (request->yOff < (iterGroup->yOff + iterGroup->ySize)))
+            {
+                overlaps = true;
+                break;
+            }
+        }
+        if(overlaps)
+        {
+            for(auto iterGroup = this->held.begin(); iterGroup != this->held.end(); ++iterGroup)
+            {
+                writtenBytes += this->writeGroup(*iterGroup);
+            }
+            this->held.clear();
+        }
+        
+        KEAWriteGroup group;
+        group.band = request->band;
+        group.dataType = request->dataType;
+        group.xOff = request->xOff;
+        group.yOff = request->yOff;
+        group.xSize = request->xSize;
+        group.ySize = request->ySize;
+        group.parts.push_back(request);
+        
+        // MERGE WITH HELD GROUPS ALONG A SHARED EDGE
+        bool merged = true;
+        while(merged)
+        {
+            merged = false;
+            for(auto iterGroup = this->held.begin(); iterGroup != this->held.end(); ++iterGroup)
+            {
+                if((iterGroup->band != group.band) || (iterGroup->dataType != group.dataType))
+                {
+                    continue;
+                }
+                
+                if((iterGroup->xOff == group.xOff) && (iterGroup->xSize == group.xSize) &&
+                   (((iterGroup->yOff + iterGroup->ySize) == group.yOff) || ((group.yOff + group.ySize) == iterGroup->yOff)))
+                {
+                    group.yOff = std::min(group.yOff, iterGroup->yOff);
+                    group.ySize += iterGroup->ySize;
+                    merged = true;
+                }
+                else if((iterGroup->yOff == group.yOff) && (iterGroup->ySize == group.ySize) &&
+                        (((iterGroup->xOff + iterGroup->xSize) == group.xOff) || ((group.xOff + group.xSize) == iterGroup->xOff)))
+                {
+                    group.xOff = std::min(group.xOff, iterGroup->xOff);
+                    group.xSize += iterGroup->xSize;
+                    merged = true;
+                }
+                
+                if(merged)
+                {
+                    group.parts.insert(group.parts.end(), iterGroup->parts.begin(), iterGroup->parts.end());
+                    this->held.erase(iterGroup);
+                    break;
+                }
+            }
+        }
+        this->held.push_back(group);
+        
+        return writtenBytes;
+    }
+    
+    bool KEAAsyncWriter::chunkAligned(const KEAWriteGroup &group)
+    {
+        uint64_t blockSize = 0;
+        KEAImageSpatialInfo *spatialInfo = nullptr;
+        try
+        {
+            auto iterBlockSize = this->bandBlockSizes.find(group.band);
+            if(iterBlockSize == this->bandBlockSizes.end())
+            {
+                blockSize = this->io->getImageBlockSize(group.band);
+                this->bandBlockSizes[group.band] = blockSize;
+            }
+            else
+            {
+                blockSize = iterBlockSize->second;
+            }
+            spatialInfo = this->io->getSpatialInfo();
+        }
+        catch(const KEAException &e)
+        {
+            // LET THE WRITE REPORT THE PROBLEM
+            return true;
+        }
+        
+        if(blockSize == 0)
+        {
+            return true;
+        }
+        
+        bool xAligned = ((group.xOff % blockSize) == 0) && ((((group.xOff + group.xSize) % blockSize) == 0) || ((group.xOff + group.xSize) >= spatialInfo->xSize));
+        bool yAligned = ((group.yOff % blockSize) == 0) && ((((group.yOff + group.ySize) % blockSize) == 0) || ((group.yOff + group.ySize) >= spatialInfo->ySize));
+        return xAligned && yAligned;
+    }
+    
+    uint64_t KEAAsyncWriter::writeGroup(KEAWriteGroup &group)
+    {
+        size_t dtSize = getDataTypeSize(group.dataType);
+        uint64_t numBytes = group.xSize * group.ySize * dtSize;
+        try
+        {
+            if(group.parts.size() == 1)
+            {
+                this->io->writeImageBlock2Band(group.band, group.parts[0]->data.data(), group.xOff, group.yOff, group.xSize, group.ySize, group.xSize, group.ySize, group.dataType);
+            }
+            else
+            {
+                // ASSEMBLE THE PARTS INTO ONE BLOCK
+                std::vector<char> data(numBytes);
+                for(auto iterPart = group.parts.begin(); iterPart != group.parts.end(); ++iterPart)
+                {
+                    KEAWriteRequest *part = *iterPart;
+                    for(uint64_t row = 0; row < part->ySize; ++row)
+                    {
+                        uint64_t outPxl = ((part->yOff - group.yOff + row) * group.xSize) + (part->xOff - group.xOff);
+                        memcpy(data.data() + (outPxl * dtSize), part->data.data() + (row * part->xSize * dtSize), part->xSize * dtSize);
+                    }
+                }
+                this->io->writeImageBlock2Band(group.band, data.data(), group.xOff, group.yOff, group.xSize, group.ySize, group.xSize, group.ySize, group.dataType);
+            }
+            
+            for(auto iterPart = group.parts.begin(); iterPart != group.parts.end(); ++iterPart)
+            {
+                (*iterPart)->promise.set_value();
+            }
+        }
+        catch(...)
+        {
+            std::exception_ptr error = std::current_exception();
+            for(auto iterPart = group.parts.begin(); iterPart != group.parts.end(); ++iterPart)
+            {
+                (*iterPart)->promise.set_exception(error);
+            }
+            
+            std::lock_guard<std::mutex> lock(this->queueMutex);
+            if(!this->firstError)
+            {
+                this->firstError = error;
+            }
+        }
+        
+        for(auto iterPart = group.parts.begin(); iterPart != group.parts.end(); ++iterPart)
+        {
+            delete *iterPart;
+        }
+        group.parts.clear();
+        
+        return numBytes;
+    }
+    
+    KEAAsyncWriter::~KEAAsyncWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->queueMutex);
+            this->stopping = true;
+        }
+        this->queueCond.notify_one();
+        this->writer.join();
+    }
+    
+}
@@ -30,6 +30,8 @@
 
 #include "libkea/KEAAttributeTable.h"
 
+#include <algorithm>
+
 namespace kealib{
     
     KEAAttributeTable::KEAAttributeTable(KEAATTType keaAttType)
@@ -690,6 +692,227 @@ namespace kealib{
         }
     }
         
+    void KEAAttributeTable::flush()
+    {
+    }
+    
+    size_t KEAAttributeTable::getAutoChunkSize(size_t numRows, size_t elementSize)
+    {
+        size_t maxRows = KEA_ATT_CHUNK_BYTES / std::max(elementSize, static_cast<size_t>(1));
+        size_t chunkRows = KEA_ATT_CHUNK_SIZE;
+        while((chunkRows < numRows) && ((chunkRows * 2) <= maxRows))
+        {
+            chunkRows *= 2;
+        }
+        return chunkRows;
+    }
+    
+    bool KEAAttributeTable::getAutoChunkSizeFlag(H5::H5File *keaImg, const std::string &bandPathBase)
+    {
+        try
+        {
+            H5::DataSet chunkSizeDataset = keaImg->openDataSet(bandPathBase + KEA_ATT_CHUNKSIZE_HEADER);
+            if(!chunkSizeDataset.attrExists(KEA_ATTRIBUTENAME_AUTO_CHUNK_SIZE))
+            {
+                return false;
+            }
+            H5::Attribute autoAttribute = chunkSizeDataset.openAttribute(KEA_ATTRIBUTENAME_AUTO_CHUNK_SIZE);
+            int autoChunkSize = 0;
+            autoAttribute.read(H5::PredType::NATIVE_INT, &autoChunkSize);
+            return autoChunkSize != 0;
+        }
+        catch(const H5::Exception &e)
+        {
+            // TABLES WITHOUT THE HEADER OR THE FLAG HAVE A FIXED CHUNK SIZE
+            return false;
+        }
+    }
+    
+    void KEAAttributeTable::setAutoChunkSizeFlag(H5::H5File *keaImg, const std::string &bandPathBase, bool autoChunkSize)
+    {
+        try
+        {
+            H5::DataSet chunkSizeDataset = keaImg->openDataSet(bandPathBase + KEA_ATT_CHUNKSIZE_HEADER);
+            if(chunkSizeDataset.attrExists(KEA_ATTRIBUTENAME_AUTO_CHUNK_SIZE))
+            {
+                chunkSizeDataset.removeAttr(KEA_ATTRIBUTENAME_AUTO_CHUNK_SIZE);
+            }
+            if(autoChunkSize)
+            {
+                H5::DataSpace attrDataSpace(H5S_SCALAR);
+                H5::Attribute autoAttribute = chunkSizeDataset.createAttribute(KEA_ATTRIBUTENAME_AUTO_CHUNK_SIZE, H5::PredType::STD_U8LE, attrDataSpace);
+                int value = 1;
+                autoAttribute.write(H5::PredType::NATIVE_INT, &value);
+            }
+        }
+        catch(const H5::Exception &e)
+        {
+            throw KEAIOException(e.getDetailMsg());
+        }
+    }
+    
+    uint64_t KEAAttributeTable::getDataGeneration(H5::H5File *keaImg, const std::string &bandPathBase)
+    {
+        try
+        {
+            H5::DataSet chunkSizeDataset = keaImg->openDataSet(bandPathBase + KEA_ATT_CHUNKSIZE_HEADER);
+            if(!chunkSizeDataset.attrExists(KEA_ATTRIBUTENAME_DATA_GENERATION))
+            {
+                return 0;
+            }
+            H5::Attribute generationAttribute = chunkSizeDataset.openAttribute(KEA_ATTRIBUTENAME_DATA_GENERATION);
+            uint64_t generation = 0;
+            generationAttribute.read(H5::PredType::NATIVE_UINT64, &generation);
+            return generation;
+        }
+        catch(const H5::Exception &e)
+        {
+            return 0;
+        }
+    }
+    
+    void KEAAttributeTable::bumpDataGeneration(H5::H5File *keaImg, const std::string &bandPathBase)
+    {
+        try
+        {
+            uint64_t generation = KEAAttributeTable::getDataGeneration(keaImg, bandPathBase) + 1;
+            H5::DataSet chunkSizeDataset = keaImg->openDataSet(bandPathBase + KEA_ATT_CHUNKSIZE_HEADER);
+            H5::Attribute generationAttribute;
+            if(chunkSizeDataset.attrExists(KEA_ATTRIBUTENAME_DATA_GENERATION))
+            {
+                generationAttribute = chunkSizeDataset.openAttribute(KEA_ATTRIBUTENAME_DATA_GENERATION);
+            }
+            else
+            {
+                H5::DataSpace attrDataSpace(H5S_SCALAR);
+                generationAttribute = chunkSizeDataset.createAttribute(KEA_ATTRIBUTENAME_DATA_GENERATION, H5::PredType::STD_U64LE, attrDataSpace);
+            }
+            generationAttribute.write(H5::PredType::NATIVE_UINT64, &generation);
+        }
+        catch(const H5::Exception &e)
+        {
+            throw KEAIOException(e.getDetailMsg());
+        }
+    }
+    
+    bool KEAAttributeTable::rechunkDataset(H5::H5File *keaImg, const std::string &path, hsize_t chunkRows, uint32_t deflate)
+    {
+        hid_t memTypeId = -1;
+        std::string tmpPath = path + "_RECHUNK";
+        bool tmpCreated = false;
+        try
+        {
+            H5::DataSet srcDataset = keaImg->openDataSet(path);
+            H5::DataSpace srcDataspace = srcDataset.getSpace();
+            int nDims = srcDataspace.getSimpleExtentNdims();
+            if((nDims < 1) || (nDims > 2))
+            {
+                throw KEAATTException("Only 1 or 2 dimensional datasets can be rechunked.");
+            }
+            hsize_t dims[2] = {0, 1};
+            hsize_t maxDims[2] = {0, 1};
+            srcDataspace.getSimpleExtentDims(dims, maxDims);
+            
+            H5::DSetCreatPropList creationDSPList = srcDataset.getCreatePlist();
+            hsize_t chunkDims[2] = {0, 1};
+            creationDSPList.getChunk(nDims, chunkDims);
+            
+            bool hasDeflate = false;
+            uint32_t srcDeflate = 0;
+            int numFilters = creationDSPList.getNfilters();
+            for(int i = 0; i < numFilters; ++i)
+            {
+                unsigned int flags = 0;
+                size_t cdNElmts = 1;
+                unsigned int cdValues[1] = { 0 };
+                unsigned int filterConfig = 0;
+                char name[64];
+                if(creationDSPList.getFilter(i, flags, cdNElmts, cdValues, sizeof(name), name, filterConfig) == H5Z_FILTER_DEFLATE)
+                {
+                    hasDeflate = true;
+                    srcDeflate = (cdNElmts > 0) ? cdValues[0] : 0;
+                }
+            }
+            bool changeDeflate = (deflate != KEA_REPACK_KEEP) && ((deflate != srcDeflate) || (hasDeflate != (deflate > 0)));
+            if((chunkDims[0] == chunkRows) && !changeDeflate)
+            {
+                return false;
+            }
+            chunkDims[0] = chunkRows;
+            creationDSPList.setChunk(nDims, chunkDims);
+            if(changeDeflate)
+            {
+                if(hasDeflate)
+                {
+                    creationDSPList.removeFilter(H5Z_FILTER_DEFLATE);
+                }
+                if(deflate > 0)
+                {
+                    creationDSPList.setDeflate(deflate);
+                }
+            }
+            
+            // COPY TO A NEW DATASET A CHUNK OF ROWS AT A TIME
+            H5::DataType fileType = srcDataset.getDataType();
+            memTypeId = H5Tget_native_type(fileType.getId(), H5T_DIR_DEFAULT);
+            if(memTypeId < 0)
+            {
+                throw KEAATTException("Could not get the memory type of " + path);
+            }
+            H5::DataType memType(memTypeId);
+            // A COPY LEFT BY AN INTERRUPTED REWRITE IS INCOMPLETE
+            if(H5Lexists(keaImg->getId(), tmpPath.c_str(), H5P_DEFAULT) > 0)
+            {
+                H5Ldelete(keaImg->getId(), tmpPath.c_str(), H5P_DEFAULT);
+            }
+            H5::DataSpace dstDataspace(nDims, dims, maxDims);
+            H5::DataSet dstDataset = keaImg->createDataSet(tmpPath, fileType, dstDataspace, creationDSPList);
+            tmpCreated = true;
+            
+            std::vector<char> buffer(chunkRows * dims[1] * H5Tget_size(memTypeId));
+            for(hsize_t row = 0; row < dims[0]; row += chunkRows)
+            {
+                hsize_t offset[2] = {row, 0};
+                hsize_t count[2] = {std::min(chunkRows, dims[0] - row), dims[1]};
+                H5::DataSpace memDataspace(nDims, count);
+                srcDataspace.selectHyperslab(H5S_SELECT_SET, count, offset);
+                dstDataspace.selectHyperslab(H5S_SELECT_SET, count, offset);
+                srcDataset.read(buffer.data(), memType, memDataspace, srcDataspace);
+                dstDataset.write(buffer.data(), memType, memDataspace, dstDataspace);
+                // FREES THE STRINGS/NEIGHBOURS, NOTHING TO DO FOR NUMBERS
+                H5Dvlen_reclaim(memTypeId, memDataspace.getId(), H5P_DEFAULT, buffer.data());
+            }
+            dstDataset.close();
+            srcDataset.close();
+            H5Tclose(memTypeId);
+            memTypeId = -1;
+            
+            if(H5Ldelete(keaImg->getId(), path.c_str(), H5P_DEFAULT) < 0)
+            {
+                H5Ldelete(keaImg->getId(), tmpPath.c_str(), H5P_DEFAULT);
+                throw KEAATTException("Could not remove " + path);
+            }
+            tmpCreated = false;
+            if(H5Lmove(keaImg->getId(), tmpPath.c_str(), keaImg->getId(), path.c_str(), H5P_DEFAULT, H5P_DEFAULT) < 0)
+            {
+                throw KEAATTException("Could not rename " + tmpPath);
+            }
+        }
+        catch(const H5::Exception &e)
+        {
+            if(memTypeId >= 0)
+            {
+                H5Tclose(memTypeId);
+            }
+            if(tmpCreated)
+            {
+                H5Ldelete(keaImg->getId(), tmpPath.c_str(), H5P_DEFAULT);
+            }
+            throw KEAATTException(e.getDetailMsg());
+        }
+        return true;
+    }
+    
     KEAAttributeTable::~KEAAttributeTable()
     {
         delete fields;
@@ -33,6 +33,8 @@
 #include <string.h>
 #include <algorithm>
 
+#include "libkea/KEATrace.h"
+
 namespace kealib{
 
     static void* kealibmalloc(size_t nSize, void* ignored)
@@ -52,6 +54,604 @@ namespace kealib{
         deflate = deflateIn;
         keaImg = keaImgIn;
         bandPathBase = bandPathBaseIn;
+        boolData.open = false;
+        intData.open = false;
+        floatData.open = false;
+        stringData.open = false;
+        neighboursData.open = false;
+        dataGeneration = KEAAttributeTable::getDataGeneration(keaImgIn, bandPathBaseIn);
+        chunkCacheSize = KEA_ATT_CHUNK_CACHE_SIZE;
+        chunkCacheStats.hits = 0;
+        chunkCacheStats.misses = 0;
+        chunkCacheStats.evictions = 0;
+        chunkCacheStats.writeBacks = 0;
+        chunkCacheStats.numChunks = 0;
+        chunkCacheStats.bytes = 0;
+        writeBufferSize = KEA_ATT_WRITE_BUFFER_SIZE;
+        chunkCacheStats.bufferedWrites = 0;
+        chunkCacheStats.bufferFlushes = 0;
+        chunkCacheStats.bufferBytes = 0;
+    }
+    
+    KEAAttributeTableFile::KEAATTDataCache& KEAAttributeTableFile::getDataCache(KEAFieldDataType dataType) const
+    {
+        KEAATTDataCache *cache = nullptr;
+        std::string datasetName;
+        std::string typeName;
+        size_t numFields = 0;
+        switch(dataType)
+        {
+            case kea_att_bool:
+                cache = &boolData;
+                datasetName = KEA_ATT_BOOL_DATA;
+                typeName = "boolean";
+                numFields = numBoolFields;
+                break;
+            case kea_att_int:
+                cache = &intData;
+                datasetName = KEA_ATT_INT_DATA;
+                typeName = "integer";
+                numFields = numIntFields;
+                break;
+            case kea_att_float:
+                cache = &floatData;
+                datasetName = KEA_ATT_FLOAT_DATA;
+                typeName = "float";
+                numFields = numFloatFields;
+                break;
+            case kea_att_string:
+                cache = &stringData;
+                datasetName = KEA_ATT_STRING_DATA;
+                typeName = "str";
+                numFields = numStringFields;
+                break;
+            default:
+                throw KEAATTException("Unknown attribute table data type.");
+        }
+        
+        if(cache->open && this->dataCacheCurrent())
+        {
+            return *cache;
+        }
+        
+        cache->dataset = keaImg->openDataSet(bandPathBase + datasetName);
+        cache->dataspace = cache->dataset.getSpace();
+        
+        if(cache->dataspace.getSimpleExtentNdims() != 2)
+        {
+            throw KEAIOException("The " + typeName + " datasets needs to have 2 dimensions.");
+        }
+        
+        hsize_t dims[2];
+        cache->dataspace.getSimpleExtentDims(dims);
+        
+        if(numRows > dims[0])
+        {
+            throw KEAIOException("The number of features in " + typeName + " dataset is smaller than expected.");
+        }
+        
+        if(numFields > dims[1])
+        {
+            throw KEAIOException("The number of " + typeName + " fields is smaller than expected.");
+        }
+        
+        if(dataType == kea_att_string)
+        {
+            H5::CompType *strTypeMem = KEAAttributeTable::createKeaStringCompTypeMem();
+            cache->memType = *strTypeMem;
+            delete strTypeMem;
+        }
+        
+        cache->open = true;
+        return *cache;
+    }
+    
+    bool KEAAttributeTableFile::dataCacheCurrent() const
+    {
+        uint64_t generation = KEAAttributeTable::getDataGeneration(keaImg, bandPathBase);
+        if(generation == this->dataGeneration)
+        {
+            return true;
+        }
+        this->resetDataCache();
+        this->dataGeneration = generation;
+        return false;
+    }
+    
+    void KEAAttributeTableFile::resetDataCache() const
+    {
+        KEAATTDataCache *caches[] = {&boolData, &intData, &floatData, &stringData, &neighboursData};
+        for(KEAATTDataCache *cache : caches)
+        {
+            // THE HDF5 OBJECTS ARE RELEASED WHEN REPLACED
+            cache->dataset = H5::DataSet();
+            cache->dataspace = H5::DataSpace();
+            cache->memType = H5::DataType();
+            cache->open = false;
+        }
+    }
+    
+    static size_t keaATTValueSize(KEAFieldDataType dataType)
+    {
+        switch(dataType)
+        {
+            case kea_att_bool:
+                return sizeof(bool);
+            case kea_att_int:
+                return sizeof(int64_t);
+            case kea_att_float:
+                return sizeof(double);
+            case kea_att_string:
+                return sizeof(std::string);
+            default:
+                throw KEAATTException("Unknown attribute table data type.");
+        }
+    }
+    
+    // copies n values of the column type between buffers, offsets are in values
+    static void keaCopyATTValues(KEAFieldDataType dataType, void *dst, size_t dstOff, const void *src, size_t srcOff, size_t n)
+    {
+        if(dataType == kea_att_string)
+        {
+            const std::string *srcStrs = static_cast<const std::string*>(src) + srcOff;
+            std::copy(srcStrs, srcStrs + n, static_cast<std::string*>(dst) + dstOff);
+        }
+        else
+        {
+            size_t typeSize = keaATTValueSize(dataType);
+            memcpy(static_cast<char*>(dst) + (dstOff * typeSize), static_cast<const char*>(src) + (srcOff * typeSize), n * typeSize);
+        }
+    }
+    
+    void KEAAttributeTableFile::readFieldsH5(KEAFieldDataType dataType, size_t startfid, size_t len, size_t colIdx, void *buffer) const
+    {
+        switch(dataType)
+        {
+            case kea_att_bool:
+                this->readBoolFieldsH5(startfid, len, colIdx, static_cast<bool*>(buffer));
+                break;
+            case kea_att_int:
+                this->readIntFieldsH5(startfid, len, colIdx, static_cast<int64_t*>(buffer));
+                break;
+            case kea_att_float:
+                this->readFloatFieldsH5(startfid, len, colIdx, static_cast<double*>(buffer));
+                break;
+            case kea_att_string:
+            {
+                std::vector<std::string> strs;
+                this->readStringFieldsH5(startfid, len, colIdx, &strs);
+                std::move(strs.begin(), strs.end(), static_cast<std::string*>(buffer));
+                break;
+            }
+            default:
+                throw KEAATTException("Unknown attribute table data type.");
+        }
+    }
+    
+    void KEAAttributeTableFile::writeFieldsH5(KEAFieldDataType dataType, size_t startfid, size_t len, size_t colIdx, const void *buffer) const
+    {
+        switch(dataType)
+        {
+            case kea_att_bool:
+                this->writeBoolFieldsH5(startfid, len, colIdx, static_cast<bool*>(const_cast<void*>(buffer)));
+                break;
+            case kea_att_int:
+                this->writeIntFieldsH5(startfid, len, colIdx, static_cast<int64_t*>(const_cast<void*>(buffer)));
+                break;
+            case kea_att_float:
+                this->writeFloatFieldsH5(startfid, len, colIdx, static_cast<double*>(const_cast<void*>(buffer)));
+                break;
+            case kea_att_string:
+            {
+                const std::string *strs = static_cast<const std::string*>(buffer);
+                std::vector<std::string> strList(strs, strs + len);
+                this->writeStringFieldsH5(startfid, len, colIdx, &strList);
+                break;
+            }
+            default:
+                throw KEAATTException("Unknown attribute table data type.");
+        }
+    }
+    
+    size_t KEAAttributeTableFile::getChunkRows() const
+    {
+        return (chunkSize > 0) ? chunkSize : KEA_ATT_CHUNK_SIZE;
+    }
+    
+    bool KEAAttributeTableFile::useChunkCache(size_t len) const
+    {
+        return (chunkCacheSize > 0) && (len < this->getChunkRows());
+    }
+    
+    KEAAttributeTableFile::KEAATTChunk* KEAAttributeTableFile::findChunk(KEAFieldDataType dataType, size_t colIdx, size_t chunkIdx) const
+    {
+        auto iterIdx = chunkCacheIndex.find(KEAATTChunkKey(dataType, colIdx, chunkIdx));
+        if(iterIdx == chunkCacheIndex.end())
+        {
+            return nullptr;
+        }
+        chunkCache.splice(chunkCache.begin(), chunkCache, iterIdx->second);
+        return &chunkCache.front();
+    }
+    
+    KEAAttributeTableFile::KEAATTChunk& KEAAttributeTableFile::loadChunk(KEAFieldDataType dataType, size_t colIdx, size_t chunkIdx) const
+    {
+        KEAATTChunk *cached = this->findChunk(dataType, colIdx, chunkIdx);
+        if(cached != nullptr)
+        {
+            ++chunkCacheStats.hits;
+            return *cached;
+        }
+        ++chunkCacheStats.misses;
+        
+        size_t chunkRows = this->getChunkRows();
+        KEAATTChunk chunk;
+        chunk.dataType = dataType;
+        chunk.colIdx = colIdx;
+        chunk.startfid = chunkIdx * chunkRows;
+        chunk.len = std::min(chunkRows, numRows - chunk.startfid);
+        chunk.dirty = false;
+        if(dataType == kea_att_string)
+        {
+            chunk.strings.resize(chunk.len);
+            this->readFieldsH5(dataType, chunk.startfid, chunk.len, colIdx, chunk.strings.data());
+            chunk.bytes = 0;
+            for(auto iterStr = chunk.strings.begin(); iterStr != chunk.strings.end(); ++iterStr)
+            {
+                chunk.bytes += sizeof(std::string) + iterStr->capacity();
+            }
+        }
+        else
+        {
+            chunk.data.resize(chunk.len * keaATTValueSize(dataType));
+            this->readFieldsH5(dataType, chunk.startfid, chunk.len, colIdx, chunk.data.data());
+            chunk.bytes = chunk.data.size();
+        }
+        
+        // TAKE OVER ANY BUFFERED WRITES TO THE CHUNK
+        auto iterBuf = writeBuffer.find(KEAATTChunkKey(dataType, colIdx, chunkIdx));
+        if(iterBuf != writeBuffer.end())
+        {
+            copyChunkRows(iterBuf->second, chunk.startfid, chunk.len, chunk.values(), false);
+            chunk.dirty = true;
+            chunkCacheStats.bufferBytes -= iterBuf->second.bytes;
+            writeBuffer.erase(iterBuf);
+        }
+        
+        // MAKE ROOM FIRST SO THE NEW CHUNK IS NEVER EVICTED
+        size_t maxBytes = (chunkCacheSize > chunk.bytes) ? (chunkCacheSize - chunk.bytes) : 0;
+        this->evictChunks(maxBytes);
+        
+        chunkCache.push_front(std::move(chunk));
+        chunkCacheIndex[KEAATTChunkKey(dataType, colIdx, chunkIdx)] = chunkCache.begin();
+        chunkCacheStats.numChunks = chunkCache.size();
+        chunkCacheStats.bytes += chunkCache.front().bytes;
+        return chunkCache.front();
+    }
+    
+    void KEAAttributeTableFile::writeBackChunk(KEAATTChunk &chunk) const
+    {
+        if(chunk.dirty)
+        {
+            this->writeFieldsH5(chunk.dataType, chunk.startfid, chunk.len, chunk.colIdx, chunk.values());
+            chunk.dirty = false;
+            ++chunkCacheStats.writeBacks;
+        }
+    }
+    
+    void KEAAttributeTableFile::evictChunks(size_t maxBytes) const
+    {
+        while(!chunkCache.empty() && (chunkCacheStats.bytes > maxBytes))
+        {
+            KEAATTChunk &chunk = chunkCache.back();
+            this->writeBackChunk(chunk);
+            chunkCacheIndex.erase(KEAATTChunkKey(chunk.dataType, chunk.colIdx, chunk.startfid / this->getChunkRows()));
+            chunkCacheStats.bytes -= chunk.bytes;
+            chunkCache.pop_back();
+            ++chunkCacheStats.evictions;
+        }
+        chunkCacheStats.numChunks = chunkCache.size();
+    }
+    
+    void KEAAttributeTableFile::clearChunkCache()
+    {
+        std::lock_guard<std::recursive_mutex> cacheLock(cacheMutex);
+        this->flush();
+        chunkCache.clear();
+        chunkCacheIndex.clear();
+        chunkCacheStats.numChunks = 0;
+        chunkCacheStats.bytes = 0;
+    }
+    
+    void KEAAttributeTableFile::copyChunkRows(KEAATTChunk &chunk, size_t startfid, size_t len, void *buffer, bool toChunk)
+    {
+        size_t first = std::max(startfid, chunk.startfid);
+        size_t last = std::min(startfid + len, chunk.startfid + chunk.len);
+        auto copyRows = [&](size_t from, size_t to)
+        {
+            if(from >= to)
+            {
+                return;
+            }
+            if(toChunk)
+            {
+                keaCopyATTValues(chunk.dataType, chunk.values(), from - chunk.startfid, buffer, from - startfid, to - from);
+            }
+            else
+            {
+                keaCopyATTValues(chunk.dataType, buffer, from - startfid, chunk.values(), from - chunk.startfid, to - from);
+            }
+        };
+        
+        if(chunk.ranges.empty())
+        {
+            copyRows(first, last);
+        }
+        else
+        {
+            // A BUFFERED CHUNK ONLY HOLDS THE ROWS WHICH WERE WRITTEN
+            for(auto iterRange = chunk.ranges.begin(); iterRange != chunk.ranges.end(); ++iterRange)
+            {
+                copyRows(std::max(first, chunk.startfid + iterRange->first), std::min(last, chunk.startfid + iterRange->second));
+            }
+        }
+    }
+    
+    void KEAAttributeTableFile::bufferWrite(KEAFieldDataType dataType, size_t colIdx, size_t chunkIdx, size_t startfid, size_t len, const void *buffer)
+    {
+        KEAATTChunkKey key(dataType, colIdx, chunkIdx);
+        auto iterBuf = writeBuffer.find(key);
+        if(iterBuf == writeBuffer.end())
+        {
+            size_t chunkRows = this->getChunkRows();
+            KEAATTChunk chunk;
+            chunk.dataType = dataType;
+            chunk.colIdx = colIdx;
+            chunk.startfid = chunkIdx * chunkRows;
+            chunk.len = std::min(chunkRows, numRows - chunk.startfid);
+            chunk.dirty = true;
+            if(dataType == kea_att_string)
+            {
+                chunk.strings.resize(chunk.len);
+            }
+            else
+            {
+                chunk.data.resize(chunk.len * keaATTValueSize(dataType));
+            }
+            chunk.bytes = chunk.len * keaATTValueSize(dataType);
+            chunkCacheStats.bufferBytes += chunk.bytes;
+            iterBuf = writeBuffer.emplace(key, std::move(chunk)).first;
+        }
+        KEAATTChunk &chunk = iterBuf->second;
+        
+        size_t first = std::max(startfid, chunk.startfid) - chunk.startfid;
+        size_t last = std::min(startfid + len, chunk.startfid + chunk.len) - chunk.startfid;
+        if(dataType == kea_att_string)
+        {
+            // THE STRINGS BEING OVERWRITTEN NO LONGER COUNT
+            for(size_t i = first; i < last; ++i)
+            {
+                chunk.bytes -= chunk.strings[i].size();
+                chunkCacheStats.bufferBytes -= chunk.strings[i].size();
+            }
+        }
+        keaCopyATTValues(dataType, chunk.values(), first, buffer, (chunk.startfid + first) - startfid, last - first);
+        if(dataType == kea_att_string)
+        {
+            for(size_t i = first; i < last; ++i)
+            {
+                chunk.bytes += chunk.strings[i].size();
+                chunkCacheStats.bufferBytes += chunk.strings[i].size();
+            }
+        }
+        
+        // MERGE WITH THE RANGES THE NEW ONE OVERLAPS OR TOUCHES
+        auto iterRange = chunk.ranges.upper_bound(first);
+        if((iterRange != chunk.ranges.begin()) && (std::prev(iterRange)->second >= first))
+        {
+            --iterRange;
+        }
+        while((iterRange != chunk.ranges.end()) && (iterRange->first <= last))
+        {
+            first = std::min(first, iterRange->first);
+            last = std::max(last, iterRange->second);
+            iterRange = chunk.ranges.erase(iterRange);
+        }
+        chunk.ranges[first] = last;
+        ++chunkCacheStats.bufferedWrites;
+    }
+    
+    void KEAAttributeTableFile::flushWriteBuffer() const
+    {
+        if(writeBuffer.empty())
+        {
+            return;
+        }
+        
+        auto iterBuf = writeBuffer.begin();
+        while(iterBuf != writeBuffer.end())
+        {
+            KEAATTChunk &chunk = iterBuf->second;
+            size_t typeSize = keaATTValueSize(chunk.dataType);
+            if(chunk.ranges.size() == 1)
+            {
+                const char *values = static_cast<const char*>(chunk.values());
+                size_t first = chunk.ranges.begin()->first;
+                this->writeFieldsH5(chunk.dataType, chunk.startfid + first, chunk.ranges.begin()->second - first, chunk.colIdx, values + (first * typeSize));
+            }
+            else if(chunk.ranges.size() > 1)
+            {
+                // ONE READ AND ONE WRITE COVERING ALL THE RANGES OF THE CHUNK
+                size_t spanStart = chunk.startfid + chunk.ranges.begin()->first;
+                size_t spanLen = (chunk.startfid + chunk.ranges.rbegin()->second) - spanStart;
+                std::vector<char> spanData;
+                std::vector<std::string> spanStrings;
+                void *spanValues = nullptr;
+                if(chunk.dataType == kea_att_string)
+                {
+                    spanStrings.resize(spanLen);
+                    spanValues = spanStrings.data();
+                }
+                else
+                {
+                    spanData.resize(spanLen * typeSize);
+                    spanValues = spanData.data();
+                }
+                this->readFieldsH5(chunk.dataType, spanStart, spanLen, chunk.colIdx, spanValues);
+                copyChunkRows(chunk, spanStart, spanLen, spanValues, false);
+                this->writeFieldsH5(chunk.dataType, spanStart, spanLen, chunk.colIdx, spanValues);
+            }
+            chunkCacheStats.bufferBytes -= chunk.bytes;
+            iterBuf = writeBuffer.erase(iterBuf);
+        }
+        ++chunkCacheStats.bufferFlushes;
+    }
+    
+    void KEAAttributeTableFile::readFields(KEAFieldDataType dataType, size_t startfid, size_t len, size_t colIdx, void *buffer) const
+    {
+        std::lock_guard<std::recursive_mutex> cacheLock(cacheMutex);
+        if(len == 0)
+        {
+            return;
+        }
+        
+        size_t chunkRows = this->getChunkRows();
+        size_t firstChunk = startfid / chunkRows;
+        size_t lastChunk = (startfid + len - 1) / chunkRows;
+        if(this->useChunkCache(len))
+        {
+            for(size_t chunkIdx = firstChunk; chunkIdx <= lastChunk; ++chunkIdx)
+            {
+                copyChunkRows(this->loadChunk(dataType, colIdx, chunkIdx), startfid, len, buffer, false);
+            }
+            return;
+        }
+        
+        this->readFieldsH5(dataType, startfid, len, colIdx, buffer);
+        
+        // CHANGES NOT YET IN THE FILE
+        KEAATTChunkKey firstKey(dataType, colIdx, firstChunk);
+        KEAATTChunkKey lastKey(dataType, colIdx, lastChunk);
+        for(auto iterIdx = chunkCacheIndex.lower_bound(firstKey); (iterIdx != chunkCacheIndex.end()) && (iterIdx->first <= lastKey); ++iterIdx)
+        {
+            if(iterIdx->second->dirty)
+            {
+                copyChunkRows(*iterIdx->second, startfid, len, buffer, false);
+            }
+        }
+        for(auto iterBuf = writeBuffer.lower_bound(firstKey); (iterBuf != writeBuffer.end()) && (iterBuf->first <= lastKey); ++iterBuf)
+        {
+            copyChunkRows(iterBuf->second, startfid, len, buffer, false);
+        }
+    }
+    
+    void KEAAttributeTableFile::writeFields(KEAFieldDataType dataType, size_t startfid, size_t len, size_t colIdx, const void *buffer)
+    {
+        std::lock_guard<std::recursive_mutex> cacheLock(cacheMutex);
+        if(len == 0)
+        {
+            return;
+        }
+        
+        size_t chunkRows = this->getChunkRows();
+        size_t firstChunk = startfid / chunkRows;
+        size_t lastChunk = (startfid + len - 1) / chunkRows;
+        void *values = const_cast<void*>(buffer);
+        bool shortWrite = len < chunkRows;
+        if(shortWrite && ((chunkCacheSize > 0) || (writeBufferSize > 0)))
+        {
+            for(size_t chunkIdx = firstChunk; chunkIdx <= lastChunk; ++chunkIdx)
+            {
+                KEAATTChunk *chunk = this->findChunk(dataType, colIdx, chunkIdx);
+                if(chunk != nullptr)
+                {
+                    copyChunkRows(*chunk, startfid, len, values, true);
+                    chunk->dirty = true;
+                    ++chunkCacheStats.hits;
+                }
+                else if(writeBufferSize > 0)
+                {
+                    this->bufferWrite(dataType, colIdx, chunkIdx, startfid, len, buffer);
+                }
+                else
+                {
+                    ++chunkCacheStats.misses;
+                    size_t first = std::max(startfid, chunkIdx * chunkRows);
+                    size_t last = std::min(startfid + len, (chunkIdx + 1) * chunkRows);
+                    this->writeFieldsH5(dataType, first, last - first, colIdx, static_cast<const char*>(buffer) + ((first - startfid) * keaATTValueSize(dataType)));
+                }
+            }
+            if(chunkCacheStats.bufferBytes > writeBufferSize)
+            {
+                this->flushWriteBuffer();
+            }
+            return;
+        }
+        
+        this->writeFieldsH5(dataType, startfid, len, colIdx, buffer);
+        
+        // KEEP THE CACHED AND BUFFERED CHUNKS IN STEP WITH THE FILE
+        KEAATTChunkKey firstKey(dataType, colIdx, firstChunk);
+        KEAATTChunkKey lastKey(dataType, colIdx, lastChunk);
+        for(auto iterIdx = chunkCacheIndex.lower_bound(firstKey); (iterIdx != chunkCacheIndex.end()) && (iterIdx->first <= lastKey); ++iterIdx)
+        {
+            copyChunkRows(*iterIdx->second, startfid, len, values, true);
+        }
+        for(auto iterBuf = writeBuffer.lower_bound(firstKey); (iterBuf != writeBuffer.end()) && (iterBuf->first <= lastKey); ++iterBuf)
+        {
+            copyChunkRows(iterBuf->second, startfid, len, values, true);
+        }
+    }
+    
+    void KEAAttributeTableFile::setChunkCacheSize(size_t bytes)
+    {
+        std::lock_guard<std::recursive_mutex> cacheLock(cacheMutex);
+        chunkCacheSize = bytes;
+        if(chunkCacheSize == 0)
+        {
+            this->clearChunkCache();
+        }
+        else
+        {
+            this->evictChunks(chunkCacheSize);
+        }
+    }
+    
+    size_t KEAAttributeTableFile::getChunkCacheSize() const
+    {
+        return chunkCacheSize;
+    }
+    
+    KEAATTChunkCacheStats KEAAttributeTableFile::getChunkCacheStats() const
+    {
+        std::lock_guard<std::recursive_mutex> cacheLock(cacheMutex);
+        return chunkCacheStats;
+    }
+    
+    void KEAAttributeTableFile::setWriteBufferSize(size_t bytes)
+    {
+        std::lock_guard<std::recursive_mutex> cacheLock(cacheMutex);
+        writeBufferSize = bytes;
+        if(chunkCacheStats.bufferBytes > writeBufferSize)
+        {
+            this->flushWriteBuffer();
+        }
+    }
+    
+    size_t KEAAttributeTableFile::getWriteBufferSize() const
+    {
+        return writeBufferSize;
+    }
+    
+    void KEAAttributeTableFile::flush()
+    {
+        KEATraceScope trace("KEAAttributeTableFile::flush", KEA_TRACE_API);
+        std::lock_guard<std::recursive_mutex> cacheLock(cacheMutex);
+        for(auto iterChunk = chunkCache.begin(); iterChunk != chunkCache.end(); ++iterChunk)
+        {
+            this->writeBackChunk(*iterChunk);
+        }
+        this->flushWriteBuffer();
     }
     
     bool KEAAttributeTableFile::getBoolField(size_t fid, const std::string &name) const
@@ -216,6 +816,7 @@ namespace kealib{
     
     bool KEAAttributeTableFile::getBoolField(size_t fid, size_t colIdx) const
     {
+        KEATraceScope trace("KEAAttributeTableFile::getBoolField", KEA_TRACE_API);
         if(fid >= numRows)
         {
             std::string message = std::string("Requested feature (") + sizet2Str(fid) + std::string(") is not within the table.");
@@ -241,6 +842,7 @@ namespace kealib{
     
     int64_t KEAAttributeTableFile::getIntField(size_t fid, size_t colIdx) const
     {
+        KEATraceScope trace("KEAAttributeTableFile::getIntField", KEA_TRACE_API);
         if(fid >= numRows)
         {
             std::string message = std::string("Requested feature (") + sizet2Str(fid) + std::string(") is not within the table.");
@@ -266,6 +868,7 @@ namespace kealib{
     
     double KEAAttributeTableFile::getFloatField(size_t fid, size_t colIdx) const
     {
+        KEATraceScope trace("KEAAttributeTableFile::getFloatField", KEA_TRACE_API);
         if(fid >= numRows)
         {
             std::string message = std::string("Requested feature (") + sizet2Str(fid) + std::string(") is not within the table.");
@@ -291,6 +894,7 @@ namespace kealib{
     
     std::string KEAAttributeTableFile::getStringField(size_t fid, size_t colIdx) const
     {
+        KEATraceScope trace("KEAAttributeTableFile::getStringField", KEA_TRACE_API);
         if(fid >= numRows)
         {
             std::string message = std::string("Requested feature (") + sizet2Str(fid) + std::string(") is not within the table.");
@@ -320,6 +924,7 @@ namespace kealib{
     // RFC40
     void KEAAttributeTableFile::getBoolFields(size_t startfid, size_t len, size_t colIdx, bool *pbBuffer) const
     {
+        KEATraceScope trace("KEAAttributeTableFile::getBoolFields", KEA_TRACE_API, len * sizeof(bool));
         if((startfid+len) > numRows)
         {
             std::string message = std::string("Requested feature (") + sizet2Str(startfid+len) + std::string(") is not within the table.");
@@ -332,10 +937,13 @@ namespace kealib{
             throw KEAATTException(message);
         }
         
+        this->readFields(kea_att_bool, startfid, len, colIdx, pbBuffer);
+    }
+    
+    void KEAAttributeTableFile::readBoolFieldsH5(size_t startfid, size_t len, size_t colIdx, bool *pbBuffer) const
+    {
         try
         {
-            H5::DataSet boolDataset;
-            H5::DataSpace boolDataspace;
             H5::DataSpace boolFieldsMemspace;
             int *boolVals = new int[len];
             hsize_t boolFieldsOffset[2];
@@ -343,29 +951,9 @@ namespace kealib{
             hsize_t boolFieldsDimsRead[2];
             hsize_t boolFieldsOffset_out[2];
             hsize_t boolFieldsCount_out[2];
-            boolDataset = keaImg->openDataSet( (bandPathBase + KEA_ATT_BOOL_DATA) );
-            boolDataspace = boolDataset.getSpace();
-            
-            int boolNDims = boolDataspace.getSimpleExtentNdims();
-            
-            if(boolNDims != 2)
-            {
-                throw KEAIOException("The boolean datasets needs to have 2 dimensions.");
-            }
-            
-            hsize_t *boolDims = new hsize_t[boolNDims];
-            boolDataspace.getSimpleExtentDims(boolDims);
-            
-            if(numRows > boolDims[0])
-            {
-                throw KEAIOException("The number of features in boolean dataset is smaller than expected.");
-            }
-            
-            if(numBoolFields > boolDims[1])
-            {
-                throw KEAIOException("The number of boolean fields is smaller than expected.");
-            }
-            delete[] boolDims;
+            KEAATTDataCache &boolCache = this->getDataCache(kea_att_bool);
+            H5::DataSet &boolDataset = boolCache.dataset;
+            H5::DataSpace &boolDataspace = boolCache.dataspace;
             
             boolFieldsOffset[0] = startfid;
             boolFieldsOffset[1] = colIdx;
@@ -391,8 +979,6 @@ namespace kealib{
                 pbBuffer[i] = (boolVals[i] != 0);
             }
             
-            boolDataset.close();
-            boolDataspace.close();
             boolFieldsMemspace.close();
             
             delete[] boolVals;
@@ -417,6 +1003,7 @@ namespace kealib{
     
     void KEAAttributeTableFile::getIntFields(size_t startfid, size_t len, size_t colIdx, int64_t *pnBuffer) const
     {
+        KEATraceScope trace("KEAAttributeTableFile::getIntFields", KEA_TRACE_API, len * sizeof(int64_t));
         if((startfid+len) > numRows)
         {
             std::string message = std::string("Requested feature (") + sizet2Str(startfid+len) + std::string(") is not within the table.");
@@ -429,39 +1016,22 @@ namespace kealib{
             throw KEAATTException(message);
         }
         
+        this->readFields(kea_att_int, startfid, len, colIdx, pnBuffer);
+    }
+    
+    void KEAAttributeTableFile::readIntFieldsH5(size_t startfid, size_t len, size_t colIdx, int64_t *pnBuffer) const
+    {
         try
         {
-            H5::DataSet intDataset;
-            H5::DataSpace intDataspace;
             H5::DataSpace intFieldsMemspace;
             hsize_t intFieldsOffset[2];
             hsize_t intFieldsCount[2];
             hsize_t intFieldsDimsRead[2];
             hsize_t intFieldsOffset_out[2];
             hsize_t intFieldsCount_out[2];
-            intDataset = keaImg->openDataSet( (bandPathBase + KEA_ATT_INT_DATA) );
-            intDataspace = intDataset.getSpace();
-            
-            int intNDims = intDataspace.getSimpleExtentNdims();
-            
-            if(intNDims != 2)
-            {
-                throw KEAIOException("The integer datasets needs to have 2 dimensions.");
-            }
-            
-            hsize_t *intDims = new hsize_t[intNDims];
-            intDataspace.getSimpleExtentDims(intDims);
-            
-            if(numRows > intDims[0])
-            {
-                throw KEAIOException("The number of features in integer dataset is smaller than expected.");
-            }
-            
-            if(numIntFields > intDims[1])
-            {
-                throw KEAIOException("The number of integer fields is smaller than expected.");
-            }
-            delete[] intDims;
+            KEAATTDataCache &intCache = this->getDataCache(kea_att_int);
+            H5::DataSet &intDataset = intCache.dataset;
+            H5::DataSpace &intDataspace = intCache.dataspace;
             
             intFieldsOffset[0] = startfid;
             intFieldsOffset[1] = colIdx;
@@ -483,8 +1053,6 @@ namespace kealib{
             
             intDataset.read(pnBuffer, H5::PredType::NATIVE_INT64, intFieldsMemspace, intDataspace);
             
-            intDataset.close();
-            intDataspace.close();
             intFieldsMemspace.close();
         }
         catch(const H5::Exception &e)
@@ -507,6 +1075,7 @@ namespace kealib{
     
     void KEAAttributeTableFile::getFloatFields(size_t startfid, size_t len, size_t colIdx, double *pfBuffer) const
     {
+        KEATraceScope trace("KEAAttributeTableFile::getFloatFields", KEA_TRACE_API, len * sizeof(double));
         if((startfid+len) > numRows)
         {
             std::string message = std::string("Requested feature (") + sizet2Str(startfid+len) + std::string(") is not within the table.");
@@ -519,39 +1088,22 @@ namespace kealib{
             throw KEAATTException(message);
         }
         
+        this->readFields(kea_att_float, startfid, len, colIdx, pfBuffer);
+    }
+    
+    void KEAAttributeTableFile::readFloatFieldsH5(size_t startfid, size_t len, size_t colIdx, double *pfBuffer) const
+    {
         try
         {
-            H5::DataSet floatDataset;
-            H5::DataSpace floatDataspace;
             H5::DataSpace floatFieldsMemspace;
             hsize_t floatFieldsOffset[2];
             hsize_t floatFieldsCount[2];
             hsize_t floatFieldsDimsRead[2];
             hsize_t floatFieldsOffset_out[2];
             hsize_t floatFieldsCount_out[2];
-            floatDataset = keaImg->openDataSet( (bandPathBase + KEA_ATT_FLOAT_DATA) );
-            floatDataspace = floatDataset.getSpace();
-            
-            int floatNDims = floatDataspace.getSimpleExtentNdims();
-            
-            if(floatNDims != 2)
-            {
-                throw KEAIOException("The float datasets needs to have 2 dimensions.");
-            }
-            
-            hsize_t *floatDims = new hsize_t[floatNDims];
-            floatDataspace.getSimpleExtentDims(floatDims);
-            
-            if(numRows > floatDims[0])
-            {
-                throw KEAIOException("The number of features in float dataset is smaller than expected.");
-            }
-            
-            if(numFloatFields > floatDims[1])
-            {
-                throw KEAIOException("The number of float fields is smaller than expected.");
-            }
-            delete[] floatDims;
+            KEAATTDataCache &floatCache = this->getDataCache(kea_att_float);
+            H5::DataSet &floatDataset = floatCache.dataset;
+            H5::DataSpace &floatDataspace = floatCache.dataspace;
             
             floatFieldsOffset[0] = startfid;
             floatFieldsOffset[1] = colIdx;
@@ -573,8 +1125,6 @@ namespace kealib{
             
             floatDataset.read(pfBuffer, H5::PredType::NATIVE_DOUBLE, floatFieldsMemspace, floatDataspace);
             
-            floatDataset.close();
-            floatDataspace.close();
             floatFieldsMemspace.close();
         }
         catch(const H5::Exception &e)
@@ -597,6 +1147,7 @@ namespace kealib{
     
     void KEAAttributeTableFile::getStringFields(size_t startfid, size_t len, size_t colIdx, std::vector<std::string> *psBuffer) const
     {
+        KEATraceScope trace("KEAAttributeTableFile::getStringFields", KEA_TRACE_API);
         if((startfid+len) > numRows)
         {
             std::string message = std::string("Requested feature (") + sizet2Str(startfid+len) + std::string(") is not within the table.");
@@ -609,42 +1160,26 @@ namespace kealib{
             throw KEAATTException(message);
         }
         
+        psBuffer->clear();
+        psBuffer->resize(len);
+        this->readFields(kea_att_string, startfid, len, colIdx, psBuffer->data());
+    }
+    
+    void KEAAttributeTableFile::readStringFieldsH5(size_t startfid, size_t len, size_t colIdx, std::vector<std::string> *psBuffer) const
+    {
         try
         {
-            H5::DataSet strDataset;
-            H5::DataSpace strDataspace;
             H5::DataSpace strFieldsMemspace;
-            H5::CompType *strTypeMem = KEAAttributeTable::createKeaStringCompTypeMem();
             hsize_t strFieldsOffset[2];
             hsize_t strFieldsCount[2];
             hsize_t strFieldsDimsRead[2];
             hsize_t strFieldsOffset_out[2];
             hsize_t strFieldsCount_out[2];
-            strDataset = keaImg->openDataSet( (bandPathBase + KEA_ATT_STRING_DATA) );
-            strDataspace = strDataset.getSpace();
+            KEAATTDataCache &strCache = this->getDataCache(kea_att_string);
+            H5::DataSet &strDataset = strCache.dataset;
+            H5::DataSpace &strDataspace = strCache.dataspace;
             KEAString *stringVals = new KEAString[len];
             
-            int strNDims = strDataspace.getSimpleExtentNdims();
-            
-            if(strNDims != 2)
-            {
-                throw KEAIOException("The str datasets needs to have 2 dimensions.");
-            }
-            
-            hsize_t *strDims = new hsize_t[strNDims];
-            strDataspace.getSimpleExtentDims(strDims);
-            
-            if(numRows > strDims[0])
-            {
-                throw KEAIOException("The number of features in str dataset is smaller than expected.");
-            }
-            
-            if(numStringFields > strDims[1])
-            {
-                throw KEAIOException("The number of str fields is smaller than expected.");
-            }
-            delete[] strDims;
-            
             strFieldsOffset[0] = startfid;
             strFieldsOffset[1] = colIdx;
             
@@ -663,7 +1198,7 @@ namespace kealib{
             strFieldsCount_out[1] = 1;
             strFieldsMemspace.selectHyperslab( H5S_SELECT_SET, strFieldsCount_out, strFieldsOffset_out );
             
-            strDataset.read(stringVals, *strTypeMem, strFieldsMemspace, strDataspace);
+            strDataset.read(stringVals, strCache.memType, strFieldsMemspace, strDataspace);
             psBuffer->clear();
             psBuffer->reserve(len);
             for( size_t i = 0; i < len; i++ )
@@ -672,10 +1207,7 @@ namespace kealib{
                 free(stringVals[i].str);
             }
 
-            strDataset.close();
-            strDataspace.close();
             strFieldsMemspace.close();
-            delete strTypeMem;
             delete[] stringVals;
         }
         catch(const H5::Exception &e)
@@ -698,6 +1230,8 @@ namespace kealib{
     
     void KEAAttributeTableFile::getNeighbours(size_t startfid, size_t len, std::vector<std::vector<size_t>* > *neighbours) const
     {
+        KEATraceScope trace("KEAAttributeTableFile::getNeighbours", KEA_TRACE_API);
+        std::lock_guard<std::recursive_mutex> cacheLock(cacheMutex);
         try
         {
             if(!neighbours->empty())
@@ -710,25 +1244,31 @@ namespace kealib{
             }
             neighbours->reserve(len);
             
-            H5::DataSet neighboursDataset = keaImg->openDataSet( (bandPathBase + KEA_ATT_NEIGHBOURS_DATA) );
-            H5::DataSpace neighboursDataspace = neighboursDataset.getSpace();
-            
-            int neighboursNDims = neighboursDataspace.getSimpleExtentNdims();
-            if(neighboursNDims != 1)
+            if(!neighboursData.open || !this->dataCacheCurrent())
             {
-                throw KEAIOException("The neighbours datasets needs to have 1 dimension.");
-            }
-            
-            hsize_t *neighboursDims = new hsize_t[neighboursNDims];
-            neighboursDataspace.getSimpleExtentDims(neighboursDims);
-            if(this->getSize() > neighboursDims[0])
-            {
-                throw KEAIOException("The number of features in neighbours dataset smaller than expected.");
+                neighboursData.dataset = keaImg->openDataSet( (bandPathBase + KEA_ATT_NEIGHBOURS_DATA) );
+                neighboursData.dataspace = neighboursData.dataset.getSpace();
+                
+                int neighboursNDims = neighboursData.dataspace.getSimpleExtentNdims();
+                if(neighboursNDims != 1)
+                {
+                    throw KEAIOException("The neighbours datasets needs to have 1 dimension.");
+                }
+                
+                hsize_t neighboursDims[1];
+                neighboursData.dataspace.getSimpleExtentDims(neighboursDims);
+                if(this->getSize() > neighboursDims[0])
+                {
+                    throw KEAIOException("The number of features in neighbours dataset smaller than expected.");
+                }
+                neighboursData.memType = H5::VarLenType(&H5::PredType::NATIVE_HSIZE);
+                neighboursData.open = true;
             }
-            delete[] neighboursDims;
+            H5::DataSet &neighboursDataset = neighboursData.dataset;
+            H5::DataSpace &neighboursDataspace = neighboursData.dataspace;
             
             VarLenFieldHDF *neighbourVals = new VarLenFieldHDF[len];
-            H5::DataType intVarLenMemDT = H5::VarLenType(&H5::PredType::NATIVE_HSIZE);
+            H5::DataType &intVarLenMemDT = neighboursData.memType;
             hsize_t neighboursOffset[1];
             neighboursOffset[0] = 0;
             hsize_t neighboursCount[1];
@@ -782,6 +1322,7 @@ namespace kealib{
     
     void KEAAttributeTableFile::setBoolField(size_t fid, size_t colIdx, bool value)
     {
+        KEATraceScope trace("KEAAttributeTableFile::setBoolField", KEA_TRACE_API);
         if(fid >= numRows)
         {
             std::string message = std::string("Requested feature (") + sizet2Str(fid) + std::string(") is not within the table.");
@@ -798,6 +1339,7 @@ namespace kealib{
     
     void KEAAttributeTableFile::setIntField(size_t fid, size_t colIdx, int64_t value)
     {
+        KEATraceScope trace("KEAAttributeTableFile::setIntField", KEA_TRACE_API);
         if(fid >= numRows)
         {
             std::string message = std::string("Requested feature (") + sizet2Str(fid) + std::string(") is not within the table.");
@@ -815,6 +1357,7 @@ namespace kealib{
     
     void KEAAttributeTableFile::setFloatField(size_t fid, size_t colIdx, double value)
     {
+        KEATraceScope trace("KEAAttributeTableFile::setFloatField", KEA_TRACE_API);
         if(fid >= numRows)
         {
             std::string message = std::string("Requested feature (") + sizet2Str(fid) + std::string(") is not within the table.");
@@ -832,6 +1375,7 @@ namespace kealib{
     
     void KEAAttributeTableFile::setStringField(size_t fid, size_t colIdx, const std::string &value)
     {
+        KEATraceScope trace("KEAAttributeTableFile::setStringField", KEA_TRACE_API);
         if(fid >= numRows)
         {
             std::string message = std::string("Requested feature (") + sizet2Str(fid) + std::string(") is not within the table.");
@@ -852,6 +1396,7 @@ namespace kealib{
     // RFC40
     void KEAAttributeTableFile::setBoolFields(size_t startfid, size_t len, size_t colIdx, bool *pbBuffer)
     {
+        KEATraceScope trace("KEAAttributeTableFile::setBoolFields", KEA_TRACE_API, len * sizeof(bool));
         if((startfid+len) > numRows)
         {
             std::string message = std::string("Requested feature (") + sizet2Str(startfid+len) + std::string(") is not within the table.");
@@ -864,10 +1409,13 @@ namespace kealib{
             throw KEAATTException(message);
         }
         
+        this->writeFields(kea_att_bool, startfid, len, colIdx, pbBuffer);
+    }
+    
+    void KEAAttributeTableFile::writeBoolFieldsH5(size_t startfid, size_t len, size_t colIdx, bool *pbBuffer) const
+    {
         try
         {
-            H5::DataSet boolDataset;
-            H5::DataSpace boolDataspace;
             H5::DataSpace boolFieldsMemspace;
             int *boolVals = new int[len];
             hsize_t boolFieldsOffset[2];
@@ -875,29 +1423,9 @@ namespace kealib{
             hsize_t boolFieldsDimsRead[2];
             hsize_t boolFieldsOffset_out[2];
             hsize_t boolFieldsCount_out[2];
-            boolDataset = keaImg->openDataSet( (bandPathBase + KEA_ATT_BOOL_DATA) );
-            boolDataspace = boolDataset.getSpace();
-            
-            int boolNDims = boolDataspace.getSimpleExtentNdims();
-            
-            if(boolNDims != 2)
-            {
-                throw KEAIOException("The boolean datasets needs to have 2 dimensions.");
-            }
-            
-            hsize_t *boolDims = new hsize_t[boolNDims];
-            boolDataspace.getSimpleExtentDims(boolDims);
-            
-            if(numRows > boolDims[0])
-            {
-                throw KEAIOException("The number of features in boolean dataset is smaller than expected.");
-            }
-            
-            if(numBoolFields > boolDims[1])
-            {
-                throw KEAIOException("The number of boolean fields is smaller than expected.");
-            }
-            delete[] boolDims;
+            KEAATTDataCache &boolCache = this->getDataCache(kea_att_bool);
+            H5::DataSet &boolDataset = boolCache.dataset;
+            H5::DataSpace &boolDataspace = boolCache.dataspace;
             
             boolFieldsOffset[0] = startfid;
             boolFieldsOffset[1] = colIdx;
@@ -924,8 +1452,6 @@ namespace kealib{
             
             boolDataset.write(boolVals, H5::PredType::NATIVE_INT, boolFieldsMemspace, boolDataspace);
             
-            boolDataset.close();
-            boolDataspace.close();
             boolFieldsMemspace.close();
             
             delete[] boolVals;
@@ -950,6 +1476,7 @@ namespace kealib{
     
     void KEAAttributeTableFile::setIntFields(size_t startfid, size_t len, size_t colIdx, int64_t *pnBuffer)
     {
+        KEATraceScope trace("KEAAttributeTableFile::setIntFields", KEA_TRACE_API, len * sizeof(int64_t));
         if((startfid+len) > numRows)
         {
             std::string message = std::string("Requested feature (") + sizet2Str(startfid+len) + std::string(") is not within the table.");
@@ -962,39 +1489,22 @@ namespace kealib{
             throw KEAATTException(message);
         }
         
+        this->writeFields(kea_att_int, startfid, len, colIdx, pnBuffer);
+    }
+    
+    void KEAAttributeTableFile::writeIntFieldsH5(size_t startfid, size_t len, size_t colIdx, int64_t *pnBuffer) const
+    {
         try
         {
-            H5::DataSet intDataset;
-            H5::DataSpace intDataspace;
             H5::DataSpace intFieldsMemspace;
             hsize_t intFieldsOffset[2];
             hsize_t intFieldsCount[2];
             hsize_t intFieldsDimsRead[2];
             hsize_t intFieldsOffset_out[2];
             hsize_t intFieldsCount_out[2];
-            intDataset = keaImg->openDataSet( (bandPathBase + KEA_ATT_INT_DATA) );
-            intDataspace = intDataset.getSpace();
-            
-            int intNDims = intDataspace.getSimpleExtentNdims();
-            
-            if(intNDims != 2)
-            {
-                throw KEAIOException("The integer datasets needs to have 2 dimensions.");
-            }
-            
-            hsize_t *intDims = new hsize_t[intNDims];
-            intDataspace.getSimpleExtentDims(intDims);
-            
-            if(numRows > intDims[0])
-            {
-                throw KEAIOException("The number of features in integer dataset is smaller than expected.");
-            }
-            
-            if(numIntFields > intDims[1])
-            {
-                throw KEAIOException("The number of integer fields is smaller than expected.");
-            }
-            delete[] intDims;
+            KEAATTDataCache &intCache = this->getDataCache(kea_att_int);
+            H5::DataSet &intDataset = intCache.dataset;
+            H5::DataSpace &intDataspace = intCache.dataspace;
             
             intFieldsOffset[0] = startfid;
             intFieldsOffset[1] = colIdx;
@@ -1016,8 +1526,6 @@ namespace kealib{
             
             intDataset.write(pnBuffer, H5::PredType::NATIVE_INT64, intFieldsMemspace, intDataspace);
             
-            intDataset.close();
-            intDataspace.close();
             intFieldsMemspace.close();
         }
         catch(const H5::Exception &e)
@@ -1040,6 +1548,7 @@ namespace kealib{
     
     void KEAAttributeTableFile::setFloatFields(size_t startfid, size_t len, size_t colIdx, double *pfBuffer)
     {
+        KEATraceScope trace("KEAAttributeTableFile::setFloatFields", KEA_TRACE_API, len * sizeof(double));
         if((startfid+len) > numRows)
         {
             std::string message = std::string("Requested feature (") + sizet2Str(startfid+len) + std::string(") is not within the table.");
@@ -1052,39 +1561,22 @@ namespace kealib{
             throw KEAATTException(message);
         }
         
+        this->writeFields(kea_att_float, startfid, len, colIdx, pfBuffer);
+    }
+    
+    void KEAAttributeTableFile::writeFloatFieldsH5(size_t startfid, size_t len, size_t colIdx, double *pfBuffer) const
+    {
         try
         {
-            H5::DataSet floatDataset;
-            H5::DataSpace floatDataspace;
             H5::DataSpace floatFieldsMemspace;
             hsize_t floatFieldsOffset[2];
             hsize_t floatFieldsCount[2];
             hsize_t floatFieldsDimsRead[2];
             hsize_t floatFieldsOffset_out[2];
             hsize_t floatFieldsCount_out[2];
-            floatDataset = keaImg->openDataSet( (bandPathBase + KEA_ATT_FLOAT_DATA) );
-            floatDataspace = floatDataset.getSpace();
-            
-            int floatNDims = floatDataspace.getSimpleExtentNdims();
-            
-            if(floatNDims != 2)
-            {
-                throw KEAIOException("The float datasets needs to have 2 dimensions.");
-            }
-            
-            hsize_t *floatDims = new hsize_t[floatNDims];
-            floatDataspace.getSimpleExtentDims(floatDims);
-            
-            if(numRows > floatDims[0])
-            {
-                throw KEAIOException("The number of features in float dataset is smaller than expected.");
-            }
-            
-            if(numFloatFields > floatDims[1])
-            {
-                throw KEAIOException("The number of float fields is smaller than expected.");
-            }
-            delete[] floatDims;
+            KEAATTDataCache &floatCache = this->getDataCache(kea_att_float);
+            H5::DataSet &floatDataset = floatCache.dataset;
+            H5::DataSpace &floatDataspace = floatCache.dataspace;
             
             floatFieldsOffset[0] = startfid;
             floatFieldsOffset[1] = colIdx;
@@ -1106,8 +1598,6 @@ namespace kealib{
             
             floatDataset.write(pfBuffer, H5::PredType::NATIVE_DOUBLE, floatFieldsMemspace, floatDataspace);
             
-            floatDataset.close();
-            floatDataspace.close();
             floatFieldsMemspace.close();
         }
         catch(const H5::Exception &e)
@@ -1130,6 +1620,7 @@ namespace kealib{
     
     void KEAAttributeTableFile::setStringFields(size_t startfid, size_t len, size_t colIdx, std::vector<std::string> *papszStrList)
     {
+        KEATraceScope trace("KEAAttributeTableFile::setStringFields", KEA_TRACE_API);
         if((startfid+len) > numRows)
         {
             std::string message = std::string("Requested feature (") + sizet2Str(startfid+len) + std::string(") is not within the table.");
@@ -1142,47 +1633,29 @@ namespace kealib{
             throw KEAATTException(message);
         }
         
+        if(papszStrList->size() != len)
+        {
+            throw KEAATTException("The number of items in the vector<std::string> passed was not equal to the length specified.");
+        }
+        
+        this->writeFields(kea_att_string, startfid, len, colIdx, papszStrList->data());
+    }
+    
+    void KEAAttributeTableFile::writeStringFieldsH5(size_t startfid, size_t len, size_t colIdx, std::vector<std::string> *papszStrList) const
+    {
         try
         {
-            if(papszStrList->size() != len)
-            {
-                throw KEAATTException("The number of items in the vector<std::string> passed was not equal to the length specified.");
-            }
-            
-            H5::DataSet strDataset;
-            H5::DataSpace strDataspace;
             H5::DataSpace strFieldsMemspace;
-            H5::CompType *strTypeMem = KEAAttributeTable::createKeaStringCompTypeMem();
             hsize_t strFieldsOffset[2];
             hsize_t strFieldsCount[2];
             hsize_t strFieldsDimsRead[2];
             hsize_t strFieldsOffset_out[2];
             hsize_t strFieldsCount_out[2];
-            strDataset = keaImg->openDataSet( (bandPathBase + KEA_ATT_STRING_DATA) );
-            strDataspace = strDataset.getSpace();
+            KEAATTDataCache &strCache = this->getDataCache(kea_att_string);
+            H5::DataSet &strDataset = strCache.dataset;
+            H5::DataSpace &strDataspace = strCache.dataspace;
             KEAString *stringVals = new KEAString[len];
             
-            int strNDims = strDataspace.getSimpleExtentNdims();
-            
-            if(strNDims != 2)
-            {
-                throw KEAIOException("The str datasets needs to have 2 dimensions.");
-            }
-            
-            hsize_t *strDims = new hsize_t[strNDims];
-            strDataspace.getSimpleExtentDims(strDims);
-            
-            if(numRows > strDims[0])
-            {
-                throw KEAIOException("The number of features in str dataset is smaller than expected.");
-            }
-            
-            if(numStringFields > strDims[1])
-            {
-                throw KEAIOException("The number of str fields is smaller than expected.");
-            }
-            delete[] strDims;
-            
             strFieldsOffset[0] = startfid;
             strFieldsOffset[1] = colIdx;
             
@@ -1207,12 +1680,9 @@ namespace kealib{
                 stringVals[i].str = const_cast<char*>(papszStrList->at(i).c_str());
             }
             
-            strDataset.write(stringVals, *strTypeMem, strFieldsMemspace, strDataspace);
+            strDataset.write(stringVals, strCache.memType, strFieldsMemspace, strDataspace);
             
-            strDataset.close();
-            strDataspace.close();
             strFieldsMemspace.close();
-            delete strTypeMem;
             delete[] stringVals;
         }
         catch(const H5::Exception &e)
@@ -1235,8 +1705,13 @@ namespace kealib{
     
     void KEAAttributeTableFile::setNeighbours(size_t startfid, size_t len, std::vector<std::vector<size_t>* > *neighbours)
     {
+        KEATraceScope trace("KEAAttributeTableFile::setNeighbours", KEA_TRACE_API);
+        std::lock_guard<std::recursive_mutex> cacheLock(cacheMutex);
         //throw KEAATTException("KEAAttributeTableFile::setNeighbours(size_t startfid, size_t len, std::vector<size_t> neighbours) is not implemented.");
         
+        // THE DATASET MAY BE EXTENDED OR CREATED BELOW
+        this->resetDataCache();
+        
         try
         {
             H5::DataSet *neighboursDataset = nullptr;
@@ -1409,7 +1884,10 @@ namespace kealib{
     
     void KEAAttributeTableFile::addAttBoolField(KEAATTField field, bool val)
     {
+        std::lock_guard<std::recursive_mutex> cacheLock(cacheMutex);
         // field already been inserted into this->fields by base class
+        this->flush();
+        this->resetDataCache();
         updateSizeHeader(numBoolFields+1, numIntFields, numFloatFields, numStringFields);
         
         // update BOOL_FIELDS
@@ -1473,8 +1951,9 @@ namespace kealib{
             maxDimsboolFieldsDS[0] = H5S_UNLIMITED;
             H5::DataSpace boolFieldsDataSpace = H5::DataSpace(1, initDimsboolFieldsDS, maxDimsboolFieldsDS);
             
+            // FIELD HEADERS ONLY HAVE A FEW ENTRIES SO NEVER NEED LARGE CHUNKS
             hsize_t dimsboolFieldsChunk[1];
-            dimsboolFieldsChunk[0] = chunkSize;
+            dimsboolFieldsChunk[0] = std::min<hsize_t>(chunkSize, KEA_ATT_CHUNK_SIZE);
             
             H5::DSetCreatPropList creationboolFieldsDSPList;
             creationboolFieldsDSPList.setChunk(1, dimsboolFieldsChunk);
@@ -1545,7 +2024,10 @@ namespace kealib{
     
     void KEAAttributeTableFile::addAttIntField(KEAATTField field, int64_t val)
     {
+        std::lock_guard<std::recursive_mutex> cacheLock(cacheMutex);
         // field already been inserted into this->fields by base class
+        this->flush();
+        this->resetDataCache();
         updateSizeHeader(numBoolFields, numIntFields+1, numFloatFields, numStringFields);
         
         // update INT_FIELDS
@@ -1610,7 +2092,7 @@ namespace kealib{
             H5::DataSpace intFieldsDataSpace = H5::DataSpace(1, initDimsIntFieldsDS, maxDimsIntFieldsDS);
             
             hsize_t dimsIntFieldsChunk[1];
-            dimsIntFieldsChunk[0] = chunkSize;
+            dimsIntFieldsChunk[0] = std::min<hsize_t>(chunkSize, KEA_ATT_CHUNK_SIZE);
             
             H5::DSetCreatPropList creationIntFieldsDSPList;
             creationIntFieldsDSPList.setChunk(1, dimsIntFieldsChunk);
@@ -1680,7 +2162,10 @@ namespace kealib{
     
     void KEAAttributeTableFile::addAttFloatField(KEAATTField field, float val)
     {
+        std::lock_guard<std::recursive_mutex> cacheLock(cacheMutex);
         // field already been inserted into this->fields by base class
+        this->flush();
+        this->resetDataCache();
         updateSizeHeader(numBoolFields, numIntFields, numFloatFields+1, numStringFields);
         
         // update FLOAT_FIELDS
@@ -1745,7 +2230,7 @@ namespace kealib{
             H5::DataSpace floatFieldsDataSpace = H5::DataSpace(1, initDimsfloatFieldsDS, maxDimsfloatFieldsDS);
             
             hsize_t dimsfloatFieldsChunk[1];
-            dimsfloatFieldsChunk[0] = chunkSize;
+            dimsfloatFieldsChunk[0] = std::min<hsize_t>(chunkSize, KEA_ATT_CHUNK_SIZE);
             
             H5::DSetCreatPropList creationfloatFieldsDSPList;
             creationfloatFieldsDSPList.setChunk(1, dimsfloatFieldsChunk);
@@ -1815,7 +2300,10 @@ namespace kealib{
     
     void KEAAttributeTableFile::addAttStringField(KEAATTField field, const std::string &val)
     {
+        std::lock_guard<std::recursive_mutex> cacheLock(cacheMutex);
         // field already been inserted into this->fields by base class
+        this->flush();
+        this->resetDataCache();
         updateSizeHeader(numBoolFields, numIntFields, numFloatFields, numStringFields+1);
         
         // update string_FIELDS
@@ -1880,7 +2368,7 @@ namespace kealib{
             H5::DataSpace stringFieldsDataSpace = H5::DataSpace(1, initDimsstringFieldsDS, maxDimsstringFieldsDS);
             
             hsize_t dimsstringFieldsChunk[1];
-            dimsstringFieldsChunk[0] = chunkSize;
+            dimsstringFieldsChunk[0] = std::min<hsize_t>(chunkSize, KEA_ATT_CHUNK_SIZE);
             
             H5::DSetCreatPropList creationstringFieldsDSPList;
             creationstringFieldsDSPList.setChunk(1, dimsstringFieldsChunk);
@@ -1955,8 +2443,14 @@ namespace kealib{
     
     void KEAAttributeTableFile::addRows(size_t numRowsIn)
     {
+        KEATraceScope trace("KEAAttributeTableFile::addRows", KEA_TRACE_API);
+        std::lock_guard<std::recursive_mutex> cacheLock(cacheMutex);
         if( numRowsIn > 0 )
         {
+            // THE LAST CHUNK GROWS SO IS RELOADED WHEN NEXT USED
+            this->clearChunkCache();
+            this->resetDataCache();
+            
             // update header
             numRows += numRowsIn;
             updateSizeHeader(numBoolFields, numIntFields, numFloatFields, numStringFields);
@@ -2018,8 +2512,35 @@ namespace kealib{
         }
     }
     
+    void KEAAttributeTableFile::rechunkData(size_t chunkRows, uint32_t deflateIn)
+    {
+        std::lock_guard<std::recursive_mutex> cacheLock(cacheMutex);
+        const std::string dataPaths[] = {KEA_ATT_BOOL_DATA, KEA_ATT_INT_DATA, KEA_ATT_FLOAT_DATA, KEA_ATT_STRING_DATA, KEA_ATT_NEIGHBOURS_DATA};
+        bool replaced = false;
+        for(const std::string &dataPath : dataPaths)
+        {
+            if(H5Lexists(keaImg->getId(), (bandPathBase + dataPath).c_str(), H5P_DEFAULT) > 0)
+            {
+                replaced = KEAAttributeTable::rechunkDataset(keaImg, bandPathBase + dataPath, chunkRows, deflateIn) || replaced;
+            }
+        }
+        if(replaced)
+        {
+            // OTHER TABLES ON THE BAND STILL HOLD THE OLD DATASETS
+            KEAAttributeTable::bumpDataGeneration(keaImg, bandPathBase);
+            this->dataGeneration = KEAAttributeTable::getDataGeneration(keaImg, bandPathBase);
+        }
+        this->chunkSize = chunkRows;
+        if(deflateIn != KEA_REPACK_KEEP)
+        {
+            // COLUMNS ADDED FROM NOW ON MATCH THE REST
+            this->deflate = deflateIn;
+        }
+    }
+    
     KEAAttributeTable* KEAAttributeTableFile::createKeaAtt(H5::H5File *keaImg, unsigned int band, unsigned int chunkSizeIn, unsigned int deflate)
     {
+        KEATraceScope trace("KEAAttributeTableFile::createKeaAtt", KEA_TRACE_API);
         // Create instance of class to populate and return.
         std::string bandPathBase = KEA_DATASETNAME_BAND + uint2Str(band);
         KEAAttributeTableFile *att = nullptr;
@@ -2371,13 +2892,46 @@ namespace kealib{
         return att;
     }
     
-    void KEAAttributeTableFile::exportToKeaFile(H5::H5File *keaImg, unsigned int band, unsigned int chunkSize, unsigned int deflate)
+    void KEAAttributeTableFile::exportToKeaFile(H5::H5File *keaImgOut, unsigned int band, unsigned int chunkSizeIn, unsigned int deflateIn)
     {
-        throw KEAIOException("KEAAttributeTableFile does not support exporting to file");
+        KEATraceScope trace("KEAAttributeTableFile::exportToKeaFile", KEA_TRACE_API);
+        std::lock_guard<std::recursive_mutex> cacheLock(cacheMutex);
+        // ONLY THE TABLE ITSELF CAN BE WRITTEN, WHICH CHANGES ITS CHUNKING
+        if((keaImgOut->getFileName() != keaImg->getFileName()) || ((KEA_DATASETNAME_BAND + uint2Str(band)) != bandPathBase))
+        {
+            throw KEAIOException("KEAAttributeTableFile can only be exported to its own band");
+        }
+        
+        try
+        {
+            this->flush();
+            this->clearChunkCache();
+            this->resetDataCache();
+            
+            bool autoChunkSizeIn = (chunkSizeIn == KEA_ATT_CHUNK_SIZE_AUTO);
+            size_t chunkRows = autoChunkSizeIn ? KEAAttributeTable::getAutoChunkSize(numRows) : chunkSizeIn;
+            this->rechunkData(chunkRows, deflateIn);
+            updateSizeHeader(numBoolFields, numIntFields, numFloatFields, numStringFields);
+            KEAAttributeTable::setAutoChunkSizeFlag(keaImg, bandPathBase, autoChunkSizeIn);
+        }
+        catch(const H5::Exception &e)
+        {
+            throw KEAIOException(e.getDetailMsg());
+        }
     }
     
     KEAAttributeTableFile::~KEAAttributeTableFile()
     {
+        try
+        {
+            this->flush();
+        }
+        catch(const std::exception &e)
+        {
+            // NOTHING CAN BE DONE ABOUT A FAILED WRITE HERE, CALLERS WHICH
+            // NEED TO KNOW CALL flush() FIRST
+        }
+        this->resetDataCache();
     }
     
 }
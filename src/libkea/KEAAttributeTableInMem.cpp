@@ -30,6 +30,9 @@
 
 #include "libkea/KEAAttributeTableInMem.h"
 #include <string.h>
+#include <algorithm>
+
+#include "libkea/KEATrace.h"
 
 namespace kealib{
     
@@ -575,6 +578,7 @@ namespace kealib{
     
     void KEAAttributeTableInMem::exportToKeaFile(H5::H5File *keaImg, unsigned int band, unsigned int chunkSize, unsigned int deflate)
     {        
+        KEATraceScope trace("KEAAttributeTableInMem::exportToKeaFile", KEA_TRACE_API);
         try
         {
             if(attRows->size() == 0)
@@ -582,6 +586,12 @@ namespace kealib{
                 throw KEAATTException("There is no attribute table to be saved to the file.");
             }
             
+            bool autoChunkSize = (chunkSize == KEA_ATT_CHUNK_SIZE_AUTO);
+            if(autoChunkSize)
+            {
+                chunkSize = KEAAttributeTable::getAutoChunkSize(attRows->size());
+            }
+            
             std::string bandPathBase = KEA_DATASETNAME_BAND + uint2Str(band);
             
             // Read header size.
@@ -677,6 +687,22 @@ namespace kealib{
             
             if(attSize[0] > 0)
             {
+                // THE EXISTING DATA IS MOVED TO THE NEW CHUNKING (IF DIFFERENT) BEFORE IT IS OVERWRITTEN
+                const std::string dataPaths[] = {KEA_ATT_BOOL_DATA, KEA_ATT_INT_DATA, KEA_ATT_FLOAT_DATA, KEA_ATT_STRING_DATA, KEA_ATT_NEIGHBOURS_DATA};
+                bool replaced = false;
+                for(const std::string &dataPath : dataPaths)
+                {
+                    if(H5Lexists(keaImg->getId(), (bandPathBase + dataPath).c_str(), H5P_DEFAULT) > 0)
+                    {
+                        replaced = KEAAttributeTable::rechunkDataset(keaImg, bandPathBase + dataPath, chunkSize, deflate) || replaced;
+                    }
+                }
+                if(replaced)
+                {
+                    // FILE BACKED TABLES OPEN ON THE BAND REOPEN THE DATASETS
+                    KEAAttributeTable::bumpDataGeneration(keaImg, bandPathBase);
+                }
+                
                 // THERE IS AN EXISTING TABLE AND YOU NEED TO MAKE SURE THEY ARE BUG ENOUGH.
                 H5::CompType *fieldDtMem = this->createAttibuteIdxCompTypeMem();
                 H5::CompType *fieldDtDisk = this->createAttibuteIdxCompTypeDisk();
@@ -723,7 +749,7 @@ namespace kealib{
                         H5::DataSpace boolFieldsDataSpace = H5::DataSpace(1, initDimsBoolFieldsDS, maxDimsBoolFieldsDS);
                         
                         hsize_t dimsBoolFieldsChunk[1];
-                        dimsBoolFieldsChunk[0] = chunkSize;
+                        dimsBoolFieldsChunk[0] = std::min<hsize_t>(chunkSize, KEA_ATT_CHUNK_SIZE);
                         
                         H5::DSetCreatPropList creationBoolFieldsDSPList;
                         creationBoolFieldsDSPList.setChunk(1, dimsBoolFieldsChunk);
@@ -795,7 +821,7 @@ namespace kealib{
                         H5::DataSpace intFieldsDataSpace = H5::DataSpace(1, initDimsIntFieldsDS, maxDimsIntFieldsDS);
                         
                         hsize_t dimsIntFieldsChunk[1];
-                        dimsIntFieldsChunk[0] = chunkSize;
+                        dimsIntFieldsChunk[0] = std::min<hsize_t>(chunkSize, KEA_ATT_CHUNK_SIZE);
                         
                         H5::DSetCreatPropList creationIntFieldsDSPList;
                         creationIntFieldsDSPList.setChunk(1, dimsIntFieldsChunk);
@@ -866,7 +892,7 @@ namespace kealib{
                         H5::DataSpace floatFieldsDataSpace = H5::DataSpace(1, initDimsFloatFieldsDS, maxDimsFloatFieldsDS);
                         
                         hsize_t dimsFloatFieldsChunk[1];
-                        dimsFloatFieldsChunk[0] = chunkSize;
+                        dimsFloatFieldsChunk[0] = std::min<hsize_t>(chunkSize, KEA_ATT_CHUNK_SIZE);
                         
                         H5::DSetCreatPropList creationFloatFieldsDSPList;
                         creationFloatFieldsDSPList.setChunk(1, dimsFloatFieldsChunk);
@@ -937,7 +963,7 @@ namespace kealib{
                         H5::DataSpace stringFieldsDataSpace = H5::DataSpace(1, initDimsStringFieldsDS, maxDimsStringFieldsDS);
                         
                         hsize_t dimsStringFieldsChunk[1];
-                        dimsStringFieldsChunk[0] = chunkSize;
+                        dimsStringFieldsChunk[0] = std::min<hsize_t>(chunkSize, KEA_ATT_CHUNK_SIZE);
                         
                         H5::DSetCreatPropList creationStringFieldsDSPList;
                         creationStringFieldsDSPList.setChunk(1, dimsStringFieldsChunk);
@@ -1268,7 +1294,7 @@ namespace kealib{
                     H5::DataSpace boolFieldsDataSpace = H5::DataSpace(1, initDimsBoolFieldsDS, maxDimsBoolFieldsDS);
                     
                     hsize_t dimsBoolFieldsChunk[1];
-                    dimsBoolFieldsChunk[0] = chunkSize;
+                    dimsBoolFieldsChunk[0] = std::min<hsize_t>(chunkSize, KEA_ATT_CHUNK_SIZE);
                     
                     H5::DSetCreatPropList creationBoolFieldsDSPList;
                     creationBoolFieldsDSPList.setChunk(1, dimsBoolFieldsChunk);
@@ -1304,7 +1330,7 @@ namespace kealib{
                     H5::DataSpace intFieldsDataSpace = H5::DataSpace(1, initDimsIntFieldsDS, maxDimsIntFieldsDS);
                     
                     hsize_t dimsIntFieldsChunk[1];
-                    dimsIntFieldsChunk[0] = chunkSize;
+                    dimsIntFieldsChunk[0] = std::min<hsize_t>(chunkSize, KEA_ATT_CHUNK_SIZE);
                     
                     H5::DSetCreatPropList creationIntFieldsDSPList;
                     creationIntFieldsDSPList.setChunk(1, dimsIntFieldsChunk);
@@ -1340,7 +1366,7 @@ namespace kealib{
                     H5::DataSpace floatFieldsDataSpace = H5::DataSpace(1, initDimsFloatFieldsDS, maxDimsFloatFieldsDS);
                     
                     hsize_t dimsFloatFieldsChunk[1];
-                    dimsFloatFieldsChunk[0] = chunkSize;
+                    dimsFloatFieldsChunk[0] = std::min<hsize_t>(chunkSize, KEA_ATT_CHUNK_SIZE);
                     
                     H5::DSetCreatPropList creationFloatFieldsDSPList;
                     creationFloatFieldsDSPList.setChunk(1, dimsFloatFieldsChunk);
@@ -1376,7 +1402,7 @@ namespace kealib{
                     H5::DataSpace stringFieldsDataSpace = H5::DataSpace(1, initDimsStringFieldsDS, maxDimsStringFieldsDS);
                     
                     hsize_t dimsStringFieldsChunk[1];
-                    dimsStringFieldsChunk[0] = chunkSize;
+                    dimsStringFieldsChunk[0] = std::min<hsize_t>(chunkSize, KEA_ATT_CHUNK_SIZE);
                     
                     H5::DSetCreatPropList creationStringFieldsDSPList;
                     creationStringFieldsDSPList.setChunk(1, dimsStringFieldsChunk);
@@ -1856,6 +1882,7 @@ namespace kealib{
             chunkSizeDataset.close();
             chunkSizeWriteDataSpace.close();
             newChunkSizeDataspace.close();
+            KEAAttributeTable::setAutoChunkSizeFlag(keaImg, bandPathBase, autoChunkSize);
             
             // WRITE THE ATT SIZE USED TO THE FILE.
             hsize_t sizeDataOffset[1];
@@ -1932,6 +1959,7 @@ namespace kealib{
     
     KEAAttributeTable* KEAAttributeTableInMem::createKeaAtt(H5::H5File *keaImg, unsigned int band)
     {
+        KEATraceScope trace("KEAAttributeTableInMem::createKeaAtt", KEA_TRACE_API);
         // Create instance of class to populate and return.
         KEAAttributeTableInMem *att = new KEAAttributeTableInMem();
         
@@ -2490,31 +2518,46 @@ namespace kealib{
                     strFieldsMemspace.selectHyperslab( H5S_SELECT_SET, strFieldsCount_out, strFieldsOffset_out );
                 }
                 
-                H5::DataSet neighboursDataset = keaImg->openDataSet( (bandPathBase + KEA_ATT_NEIGHBOURS_DATA) );
-                H5::DataSpace neighboursDataspace = neighboursDataset.getSpace();
-                
-                int neighboursNDims = neighboursDataspace.getSimpleExtentNdims();
-                if(neighboursNDims != 1)
+                // TABLES WRITTEN WITHOUT NEIGHBOURS DON'T HAVE THE DATASET
+                bool haveNeighbours = H5Lexists(keaImg->getId(), (bandPathBase + KEA_ATT_NEIGHBOURS_DATA).c_str(), H5P_DEFAULT) > 0;
+                H5::DataSet neighboursDataset;
+                H5::DataSpace neighboursDataspace;
+                if(haveNeighbours)
                 {
-                    throw KEAIOException("The neighbours datasets needs to have 1 dimension.");
+                    neighboursDataset = keaImg->openDataSet( (bandPathBase + KEA_ATT_NEIGHBOURS_DATA) );
+                    neighboursDataspace = neighboursDataset.getSpace();
+                    
+                    int neighboursNDims = neighboursDataspace.getSimpleExtentNdims();
+                    if(neighboursNDims != 1)
+                    {
+                        throw KEAIOException("The neighbours datasets needs to have 1 dimension.");
+                    }
+                    
+                    /* Neighbours */
+                    hsize_t *neighboursDims = new hsize_t[neighboursNDims];
+                    neighboursDataspace.getSimpleExtentDims(neighboursDims);
+                    if(attSize[0] > neighboursDims[0])
+                    {
+                        throw KEAIOException("The number of features in neighbours dataset smaller than expected.");
+                    }
+                    delete[] neighboursDims;
                 }
                 
-                /* Neighbours */
-                hsize_t *neighboursDims = new hsize_t[neighboursNDims];
-                neighboursDataspace.getSimpleExtentDims(neighboursDims);
-                if(attSize[0] > neighboursDims[0])
+                VarLenFieldHDF *neighbourVals = new VarLenFieldHDF[chunkSize];
+                for(size_t i = 0; i < chunkSize; ++i)
                 {
-                    throw KEAIOException("The number of features in neighbours dataset smaller than expected.");
+                    neighbourVals[i].length = 0;
+                    neighbourVals[i].p = nullptr;
                 }
-                delete[] neighboursDims;
-                
-                VarLenFieldHDF *neighbourVals = new VarLenFieldHDF[chunkSize];
                 H5::DataType intVarLenMemDT = H5::VarLenType(&H5::PredType::NATIVE_HSIZE);
                 hsize_t neighboursOffset[1];
                 neighboursOffset[0] = 0;
                 hsize_t neighboursCount[1];
                 neighboursCount[0] = chunkSize;
-                neighboursDataspace.selectHyperslab( H5S_SELECT_SET, neighboursCount, neighboursOffset );
+                if(haveNeighbours)
+                {
+                    neighboursDataspace.selectHyperslab( H5S_SELECT_SET, neighboursCount, neighboursOffset );
+                }
                 
                 hsize_t neighboursDimsRead[1]; 
                 neighboursDimsRead[0] = chunkSize;
@@ -2533,8 +2576,11 @@ namespace kealib{
                         rowOff = (n*chunkSize);
                         // Read data.
                         neighboursOffset[0] = rowOff;
-                        neighboursDataspace.selectHyperslab( H5S_SELECT_SET, neighboursCount, neighboursOffset );
-                        neighboursDataset.read(neighbourVals, intVarLenMemDT, neighboursMemspace, neighboursDataspace);
+                        if(haveNeighbours)
+                        {
+                            neighboursDataspace.selectHyperslab( H5S_SELECT_SET, neighboursCount, neighboursOffset );
+                            neighboursDataset.read(neighbourVals, intVarLenMemDT, neighboursMemspace, neighboursDataspace);
+                        }
                         
                         if(att->numBoolFields > 0)
                         {
@@ -2627,11 +2673,13 @@ namespace kealib{
                     // Read data.
                     neighboursOffset[0] = rowOff;
                     neighboursCount[0] = remainRows;
-                    neighboursDataspace.selectHyperslab( H5S_SELECT_SET, neighboursCount, neighboursOffset );
-                    
                     neighboursDimsRead[0] = remainRows;
                     neighboursMemspace = H5::DataSpace( 1, neighboursDimsRead );
-                    neighboursDataset.read(neighbourVals, intVarLenMemDT, neighboursMemspace, neighboursDataspace);
+                    if(haveNeighbours)
+                    {
+                        neighboursDataspace.selectHyperslab( H5S_SELECT_SET, neighboursCount, neighboursOffset );
+                        neighboursDataset.read(neighbourVals, intVarLenMemDT, neighboursMemspace, neighboursDataspace);
+                    }
                     
                     if(att->numBoolFields > 0)
                     {
@@ -2789,8 +2837,11 @@ namespace kealib{
                 strDataspace.close();
                 strFieldsMemspace.close();
                 
-                neighboursDataset.close();
-                neighboursDataspace.close();
+                if(haveNeighbours)
+                {
+                    neighboursDataset.close();
+                    neighboursDataspace.close();
+                }
                 neighboursMemspace.close();
                 
                 delete[] neighbourVals;
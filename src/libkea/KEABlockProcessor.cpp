@@ -0,0 +1,372 @@
+/*
+ *  KEABlockProcessor.cpp
+ *  LibKEA
+ *
+ *  Copyright 2026 LibKEA. All rights reserved.
+ *
+ *  This file is part of LibKEA.
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify,
+ *  merge, publish, distribute, sublicense, and/or sell copies of the
+ *  Software, and to permit persons to whom the Software is furnished
+ *  to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ *  ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *  CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "libkea/KEABlockProcessor.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+
+#include "libkea/KEAImageIO.h"
+#include "libkea/KEAThreadPool.h"
+#include "libkea/KEATrace.h"
+
+namespace kealib{
+
+    // shared by the threads working on one call to run()
+    struct KEABlockRunState
+    {
+        std::mutex mutex;
+        std::condition_variable cond;
+        // blocks before this one have been written
+        uint64_t nextToWrite;
+        // a thread is writing blocks out
+        bool writing;
+        bool failed;
+        // processed blocks waiting for the ones before them
+        std::map< uint64_t, std::unique_ptr<KEABlock> > done;
+        // images which are not thread safe, only used under the HDF5 mutex
+        std::set<KEAImageIO*> unsafeIOs;
+    };
+
+    template <typename T>
+    static void keaFillValues(char *data, uint64_t numValues, double value)
+    {
+        std::fill(reinterpret_cast<T*>(data), reinterpret_cast<T*>(data) + numValues, static_cast<T>(value));
+    }
+
+    static void keaFillBuffer(KEABlockBuffer &buffer, uint64_t numValues)
+    {
+        buffer.data.resize(numValues * getDataTypeSize(buffer.dataType));
+        switch(buffer.dataType)
+        {
+            case kea_8int:
+                keaFillValues<int8_t>(buffer.data.data(), numValues, buffer.noData); break;
+            case kea_16int:
+                keaFillValues<int16_t>(buffer.data.data(), numValues, buffer.noData); break;
+            case kea_32int:
+                keaFillValues<int32_t>(buffer.data.data(), numValues, buffer.noData); break;
+            case kea_64int:
+                keaFillValues<int64_t>(buffer.data.data(), numValues, buffer.noData); break;
+            case kea_8uint:
+                keaFillValues<uint8_t>(buffer.data.data(), numValues, buffer.noData); break;
+            case kea_16uint:
+                keaFillValues<uint16_t>(buffer.data.data(), numValues, buffer.noData); break;
+            case kea_32uint:
+                keaFillValues<uint32_t>(buffer.data.data(), numValues, buffer.noData); break;
+            case kea_64uint:
+                keaFillValues<uint64_t>(buffer.data.data(), numValues, buffer.noData); break;
+            case kea_32float:
+                keaFillValues<float>(buffer.data.data(), numValues, buffer.noData); break;
+            case kea_64float:
+                keaFillValues<double>(buffer.data.data(), numValues, buffer.noData); break;
+            default:
+                throw KEAIOException("Data type not recognised by the block processor.");
+        }
+    }
+
+    // an empty buffer holding the band's no data value
+    static KEABlockBuffer keaMakeBuffer(KEAImageIO *io, uint32_t band, KEADataType dataType)
+    {
+        KEABlockBuffer buffer;
+        buffer.dataType = dataType;
+        buffer.hasNoData = false;
+        buffer.noData = 0;
+        try
+        {
+            io->getNoDataValue(band, &buffer.noData, kea_64float);
+            buffer.hasNoData = true;
+        }
+        catch(KEAIOException &)
+        {
+            buffer.noData = 0;
+        }
+        return buffer;
+    }
+
+    // ONE LOCK FOR ALL OF THEM AS THEY MAY BE OPEN IN THE SAME HDF5 LIBRARY
+    static std::unique_lock<std::recursive_mutex> keaLockIO(KEABlockRunState &state, KEAImageIO *io)
+    {
+        std::unique_lock<std::recursive_mutex> ioLock(KEAImageIO::getH5Mutex(), std::defer_lock);
+        if(state.unsafeIOs.count(io) > 0)
+        {
+            ioLock.lock();
+        }
+        return ioLock;
+    }
+
+    KEABlockProcessor::KEABlockProcessor(uint32_t numThreads)
+    {
+        if(numThreads == 0)
+        {
+            numThreads = KEAThreadPool::getDefaultNumThreads();
+        }
+        this->numThreads = numThreads;
+        this->blockSize = 0;
+        this->maxBlocksInFlight = 2 * numThreads;
+        this->margin = 0;
+    }
+
+    size_t KEABlockProcessor::addInput(KEAImageIO *io, uint32_t band, KEADataType dataType)
+    {
+        KEABlockBand blockBand;
+        blockBand.io = io;
+        blockBand.band = band;
+        blockBand.dataType = dataType;
+        this->inputs.push_back(blockBand);
+        return this->inputs.size() - 1;
+    }
+
+    size_t KEABlockProcessor::addOutput(KEAImageIO *io, uint32_t band, KEADataType dataType)
+    {
+        KEABlockBand blockBand;
+        blockBand.io = io;
+        blockBand.band = band;
+        blockBand.dataType = dataType;
+        this->outputs.push_back(blockBand);
+        return this->outputs.size() - 1;
+    }
+
+    void KEABlockProcessor::setBlockSize(uint64_t blockSize)
+    {
+        this->blockSize = blockSize;
+    }
+
+    uint64_t KEABlockProcessor::getBlockSize() const
+    {
+        return this->blockSize;
+    }
+
+    void KEABlockProcessor::setMaxBlocksInFlight(uint32_t maxBlocks)
+    {
+        this->maxBlocksInFlight = std::max<uint32_t>(maxBlocks, 1);
+    }
+
+    uint32_t KEABlockProcessor::getMaxBlocksInFlight() const
+    {
+        return this->maxBlocksInFlight;
+    }
+
+    void KEABlockProcessor::setMargin(uint64_t margin)
+    {
+        this->margin = margin;
+    }
+
+    uint64_t KEABlockProcessor::getMargin() const
+    {
+        return this->margin;
+    }
+
+    uint32_t KEABlockProcessor::getNumThreads() const
+    {
+        return this->numThreads;
+    }
+
+    void KEABlockProcessor::run(const KEABlockFunction &func, const KEABlockFunction &commitFunc)
+    {
+        KEATraceScope trace("KEABlockProcessor::run", KEA_TRACE_API);
+
+        if(this->inputs.empty() && this->outputs.empty())
+        {
+            throw KEAIOException("No bands were given to the block processor.");
+        }
+
+        // ALL THE BANDS MUST COVER THE SAME AREA
+        const KEABlockBand &firstBand = this->outputs.empty() ? this->inputs.front() : this->outputs.front();
+        uint64_t xSize = firstBand.io->getSpatialInfo()->xSize;
+        uint64_t ySize = firstBand.io->getSpatialInfo()->ySize;
+        KEABlockRunState state;
+        std::vector<KEABlockBuffer> inputBuffers;
+        std::vector<KEABlockBuffer> outputBuffers;
+        for(int o = 0; o < 2; ++o)
+        {
+            const std::vector<KEABlockBand> &bands = (o == 0) ? this->inputs : this->outputs;
+            std::vector<KEABlockBuffer> &buffers = (o == 0) ? inputBuffers : outputBuffers;
+            for(const KEABlockBand &band : bands)
+            {
+                if((band.io->getSpatialInfo()->xSize != xSize) || (band.io->getSpatialInfo()->ySize != ySize))
+                {
+                    throw KEAIOException("The bands given to the block processor are not all the same size.");
+                }
+                if((band.band == 0) || (band.band > band.io->getNumOfImageBands()))
+                {
+                    throw KEAIOException("The block processor was given a band which does not exist.");
+                }
+                buffers.push_back(keaMakeBuffer(band.io, band.band, band.dataType));
+                if(!band.io->isThreadSafe())
+                {
+                    state.unsafeIOs.insert(band.io);
+                }
+            }
+        }
+
+        uint64_t blockSize = this->blockSize;
+        if(blockSize == 0)
+        {
+            blockSize = firstBand.io->getImageBlockSize(firstBand.band);
+        }
+        uint64_t xBlocks = (xSize + blockSize - 1) / blockSize;
+        uint64_t yBlocks = (ySize + blockSize - 1) / blockSize;
+        uint64_t numBlocks = xBlocks * yBlocks;
+        state.nextToWrite = 0;
+        state.writing = false;
+        state.failed = false;
+
+        auto processBlock = [&](size_t blockIdx)
+        {
+            {
+                // BOUND THE NUMBER OF BLOCKS HELD IN MEMORY
+                std::unique_lock<std::mutex> lock(state.mutex);
+                state.cond.wait(lock, [&](){ return state.failed || (blockIdx < (state.nextToWrite + this->maxBlocksInFlight)); });
+                if(state.failed)
+                {
+                    return;
+                }
+            }
+
+            std::unique_ptr<KEABlock> block(new KEABlock());
+            try
+            {
+                block->blockIndex = blockIdx;
+                block->xOff = (blockIdx % xBlocks) * blockSize;
+                block->yOff = (blockIdx / xBlocks) * blockSize;
+                block->xSize = std::min(blockSize, xSize - block->xOff);
+                block->ySize = std::min(blockSize, ySize - block->yOff);
+                block->margin = this->margin;
+                block->inputs = inputBuffers;
+                block->outputs = outputBuffers;
+
+                // THE PART OF THE BLOCK AND MARGIN WHICH IS ON THE IMAGE
+                uint64_t xStart = (block->xOff > this->margin) ? (block->xOff - this->margin) : 0;
+                uint64_t yStart = (block->yOff > this->margin) ? (block->yOff - this->margin) : 0;
+                uint64_t xEnd = std::min(block->xOff + block->xSize + this->margin, xSize);
+                uint64_t yEnd = std::min(block->yOff + block->ySize + this->margin, ySize);
+                uint64_t bufXOff = xStart + this->margin - block->xOff;
+                uint64_t bufYOff = yStart + this->margin - block->yOff;
+                for(size_t i = 0; i < this->inputs.size(); ++i)
+                {
+                    const KEABlockBand &band = this->inputs[i];
+                    KEABlockBuffer &buffer = block->inputs[i];
+                    size_t dataTypeSize = getDataTypeSize(band.dataType);
+                    char *readStart = nullptr;
+                    if(this->margin == 0)
+                    {
+                        buffer.data.resize(block->getNumPixels() * dataTypeSize);
+                        readStart = buffer.data.data();
+                    }
+                    else
+                    {
+                        keaFillBuffer(buffer, block->getInputXSize() * block->getInputYSize());
+                        readStart = buffer.data.data() + (((bufYOff * block->getInputXSize()) + bufXOff) * dataTypeSize);
+                    }
+                    std::unique_lock<std::recursive_mutex> ioLock = keaLockIO(state, band.io);
+                    band.io->readImageBlock2Band(band.band, readStart, xStart, yStart, xEnd - xStart, yEnd - yStart,
+                                                 block->getInputXSize(), yEnd - yStart, band.dataType);
+                }
+                for(KEABlockBuffer &buffer : block->outputs)
+                {
+                    keaFillBuffer(buffer, block->getNumPixels());
+                }
+
+                func(*block);
+            }
+            catch(...)
+            {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                state.failed = true;
+                state.cond.notify_all();
+                throw;
+            }
+
+            // WRITE IN BLOCK ORDER FROM ONE THREAD AT A TIME. WHOEVER FINDS
+            // NOBODY WRITING TAKES OVER UNTIL THE NEXT BLOCK ISN'T READY.
+            std::unique_lock<std::mutex> lock(state.mutex);
+            state.done[blockIdx] = std::move(block);
+            if(state.writing)
+            {
+                return;
+            }
+            state.writing = true;
+            while(!state.failed)
+            {
+                auto iterDone = state.done.find(state.nextToWrite);
+                if(iterDone == state.done.end())
+                {
+                    break;
+                }
+                std::unique_ptr<KEABlock> writeBlock = std::move(iterDone->second);
+                state.done.erase(iterDone);
+                lock.unlock();
+                try
+                {
+                    for(size_t i = 0; i < this->outputs.size(); ++i)
+                    {
+                        const KEABlockBand &band = this->outputs[i];
+                        std::unique_lock<std::recursive_mutex> ioLock = keaLockIO(state, band.io);
+                        band.io->writeImageBlock2Band(band.band, writeBlock->outputs[i].data.data(), writeBlock->xOff, writeBlock->yOff,
+                                                      writeBlock->xSize, writeBlock->ySize, writeBlock->xSize, writeBlock->ySize, band.dataType);
+                    }
+                    if(commitFunc)
+                    {
+                        commitFunc(*writeBlock);
+                    }
+                }
+                catch(...)
+                {
+                    lock.lock();
+                    state.failed = true;
+                    state.writing = false;
+                    state.cond.notify_all();
+                    throw;
+                }
+                lock.lock();
+                state.nextToWrite++;
+                state.cond.notify_all();
+            }
+            state.writing = false;
+        };
+
+        if(this->numThreads > 1)
+        {
+            KEAThreadPool threadPool(this->numThreads - 1);
+            threadPool.parallelFor(numBlocks, processBlock);
+        }
+        else
+        {
+            for(uint64_t blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
+            {
+                processBlock(blockIdx);
+            }
+        }
+    }
+
+}
@@ -30,11 +30,111 @@
 
 #include "libkea/KEAImageIO.h"
 
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+#ifdef KEA_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "libkea/KEAAsyncWriter.h"
+#include "libkea/KEABlockProcessor.h"
+#include "libkea/KEAThreadPool.h"
+#include "libkea/KEATrace.h"
+
+// reading raw chunks needs H5Dread_chunk and H5Dget_chunk_info_by_coord
+#if defined(KEA_HAVE_ZLIB) && H5_VERSION_GE(1,10,5)
+#define KEA_DIRECT_CHUNK_READ 1
+#endif
+
+// copying raw chunks between datasets also needs H5Dwrite_chunk
+#if H5_VERSION_GE(1,10,5)
+#define KEA_DIRECT_CHUNK_COPY 1
+#endif
+
+// colour tables can be looked up with AVX2 gathers, chosen at run time
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define KEA_AVX2_GATHER 1
+#endif
 
 namespace kealib{
 
+    // PAGE BUFFERING CAN ONLY BE USED WITH FILES CREATED WITH PAGED
+    // AGGREGATION SO OTHER FILES ARE OPENED WITHOUT IT
+    static H5::H5File* keaOpenH5File(const std::string &fileName, unsigned int flags, const H5::FileAccPropList &accessPlist, size_t pageBufSize)
+    {
+#if H5_VERSION_GE(1,10,1)
+        if(pageBufSize > 0)
+        {
+            H5::FileAccPropList pagedAccessPlist(accessPlist.getId());
+            if(H5Pset_page_buffer_size(pagedAccessPlist.getId(), pageBufSize, 0, 0) >= 0)
+            {
+                try
+                {
+                    return new H5::H5File(fileName, flags, H5::FileCreatPropList::DEFAULT, pagedAccessPlist);
+                }
+                catch(const H5::Exception &e)
+                {
+                    // NOT PAGED OR THE BUFFER IS SMALLER THAN A PAGE
+                }
+            }
+        }
+#endif
+        return new H5::H5File(fileName, flags, H5::FileCreatPropList::DEFAULT, accessPlist);
+    }
+
+    static void keaFlushFile(H5::H5File *keaImgH5File)
+    {
+        KEATraceScope trace("H5Fflush", KEA_TRACE_HDF5);
+        keaImgH5File->flush(H5F_SCOPE_GLOBAL);
+    }
+
+    // LOOKS FOR THE HDF5 SIGNATURE WHERE THE SUPERBLOCK CAN BE, I.E., AT
+    // 0, 512, 1024, 2048... BYTES, WITHOUT GOING THROUGH HDF5
+    static bool keaHasHDF5Signature(const std::string &fileName)
+    {
+        static const unsigned char signature[8] = { 0x89, 'H', 'D', 'F', '\r', '\n', 0x1a, '\n' };
+        FILE *file = fopen(fileName.c_str(), "rb");
+        if(file == nullptr)
+        {
+            return false;
+        }
+        
+        bool found = false;
+        unsigned char buffer[8];
+        for(long offset = 0; !found && (offset < (1L << 30)); offset = (offset == 0) ? 512 : (offset * 2))
+        {
+            if((fseek(file, offset, SEEK_SET) != 0) || (fread(buffer, 1, sizeof(buffer), file) != sizeof(buffer)))
+            {
+                break;
+            }
+            found = (memcmp(buffer, signature, sizeof(signature)) == 0);
+        }
+        fclose(file);
+        
+        return found;
+    }
+    
+    // WHETHER THE HDF5 LIBRARY SERIALISES ITS OWN CALLS
+    static bool keaH5LibraryThreadSafe()
+    {
+        static const bool threadSafe = []()
+        {
+            hbool_t isThreadSafe = false;
+            return (H5is_library_threadsafe(&isThreadSafe) >= 0) && isThreadSafe;
+        }();
+        return threadSafe;
+    }
+
     static void* kealibmalloc(size_t nSize, void* ignored)
     {
         return malloc(nSize);
@@ -44,834 +144,3503 @@ namespace kealib{
     {
         free(ptr);
     }
-
-    KEAImageIO::KEAImageIO()
+    
+    // THE CONSOLIDATED HEADER IS A LITTLE ENDIAN BYTE STREAM STARTING WITH
+    // A MAGIC NUMBER AND THE LAYOUT VERSION. READERS IGNORE NEWER LAYOUTS.
+    static const char KEA_CONSOLIDATED_MAGIC[4] = { 'K', 'E', 'A', 'H' };
+    static const uint32_t KEA_CONSOLIDATED_LAYOUT( 1 );
+    // LARGER HEADERS DO NOT FIT IN THE OBJECT HEADER SO ARE CONTIGUOUS
+    static const size_t KEA_CONSOLIDATED_COMPACT_MAX( 60000 );
+    
+    static void keaPutUInt(std::vector<uint8_t> &buffer, uint64_t value, size_t numBytes)
     {
-        this->fileOpen = false;
+        for(size_t i = 0; i < numBytes; ++i)
+        {
+            buffer.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
     }
     
-    std::string KEAImageIO::readString(H5::DataSet& dataset, H5::DataType strDataType)
+    static void keaPutDouble(std::vector<uint8_t> &buffer, double value)
     {
-        hid_t nativeVerStrType;
-        if((nativeVerStrType=H5Tget_native_type(strDataType.getId(), H5T_DIR_DEFAULT))<0)
+        uint64_t bits = 0;
+        memcpy(&bits, &value, sizeof(bits));
+        keaPutUInt(buffer, bits, sizeof(bits));
+    }
+    
+    static void keaPutString(std::vector<uint8_t> &buffer, const std::string &value)
+    {
+        keaPutUInt(buffer, value.size(), 4);
+        buffer.insert(buffer.end(), value.begin(), value.end());
+    }
+    
+    // puts a single value of valueSize bytes, e.g., a no data value
+    static void keaPutValue(std::vector<uint8_t> &buffer, const char *value, size_t valueSize)
+    {
+        uint64_t bits = 0;
+        switch(valueSize)
         {
-            throw KEAIOException("Could not define a native string type");
+            case 1: { uint8_t v; memcpy(&v, value, 1); bits = v; break; }
+            case 2: { uint16_t v; memcpy(&v, value, 2); bits = v; break; }
+            case 4: { uint32_t v; memcpy(&v, value, 4); bits = v; break; }
+            case 8: { uint64_t v; memcpy(&v, value, 8); bits = v; break; }
+            default:
+                throw KEAIOException("The specified data type was not recognised.");
         }
-        H5::DSetMemXferPropList xfer;
-        /* Ensures that malloc()/free() are from the same C runtime */
-        xfer.setVlenMemManager(kealibmalloc, nullptr, kealibfree, nullptr);
-        char* strData[1];
-        dataset.read((void*)strData, strDataType, H5::DataSpace::ALL, H5::DataSpace::ALL, xfer);
-        std::string ret = strData[0];
-        free(strData[0]);
-        H5Tclose(nativeVerStrType);
-        return ret;
+        keaPutUInt(buffer, bits, valueSize);
     }
     
-    void KEAImageIO::openKEAImageHeader(H5::H5File *keaImgH5File)
+    class KEAHeaderReader
     {
-        try 
+    public:
+        KEAHeaderReader(const std::vector<uint8_t> &buffer): buffer(buffer), pos(0)
         {
-            this->keaImgFile = keaImgH5File;
-            this->spatialInfoFile = new KEAImageSpatialInfo();
-            
-            // READ KEA VERSION NUMBER
-            try
+        }
+        
+        uint64_t getUInt(size_t numBytes)
+        {
+            this->check(numBytes);
+            uint64_t value = 0;
+            for(size_t i = 0; i < numBytes; ++i)
             {
-                H5::DataSet datasetFileVersion = keaImgH5File->openDataSet( KEA_DATASETNAME_HEADER_VERSION );
-                H5::DataType strVerDataType = datasetFileVersion.getDataType();
-                keaVersion = readString(datasetFileVersion, strVerDataType);
-                datasetFileVersion.close();
+                value |= static_cast<uint64_t>(this->buffer[this->pos++]) << (8 * i);
             }
-            catch ( const H5::Exception &e)
+            return value;
+        }
+        
+        double getDouble()
+        {
+            uint64_t bits = this->getUInt(8);
+            double value = 0;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+        
+        std::string getString()
+        {
+            size_t length = this->getUInt(4);
+            this->check(length);
+            std::string value(reinterpret_cast<const char*>(this->buffer.data()) + this->pos, length);
+            this->pos += length;
+            return value;
+        }
+        
+        void getValue(char *value, size_t valueSize)
+        {
+            uint64_t bits = this->getUInt(valueSize);
+            switch(valueSize)
             {
-                throw KEAIOException("The number of image bands was not specified.");
+                case 1: { uint8_t v = bits; memcpy(value, &v, 1); break; }
+                case 2: { uint16_t v = bits; memcpy(value, &v, 2); break; }
+                case 4: { uint32_t v = bits; memcpy(value, &v, 4); break; }
+                case 8: { memcpy(value, &bits, 8); break; }
+                default:
+                    throw KEAIOException("The consolidated header is corrupt.");
             }
-            
-            
-            // READ NUMBER OF IMAGE BANDS
-            try 
+        }
+        
+        bool atEnd() const
+        {
+            return this->pos == this->buffer.size();
+        }
+        
+    private:
+        void check(size_t numBytes)
+        {
+            if(numBytes > (this->buffer.size() - this->pos))
             {
-                hsize_t dimsValue[1];
-                dimsValue[0] = 1;
-                H5::DataSpace valueDataSpace(1, dimsValue);
-                uint32_t value[1];
-                H5::DataSet datasetNumImgBands = this->keaImgFile->openDataSet( KEA_DATASETNAME_HEADER_NUMBANDS );
-                datasetNumImgBands.read(value, H5::PredType::NATIVE_UINT32, valueDataSpace);
-                this->numImgBands = value[0];
-                datasetNumImgBands.close();
-                valueDataSpace.close();
-            } 
-            catch ( const H5::Exception &e) 
+                throw KEAIOException("The consolidated header is corrupt.");
+            }
+        }
+        
+        const std::vector<uint8_t> &buffer;
+        size_t pos;
+    };
+    
+    // how a public method locks the object in thread safe mode
+    enum KEAImageIOLockType
+    {
+        kea_lock_pixels, // shared, HDF5 only locked around the calls into it
+        kea_lock_read, // shared, HDF5 locked for the whole call
+        kea_lock_write // exclusive
+    };
+    
+    // the KEAImageIO objects locked by this thread and whether exclusively.
+    // The public methods call each other so the lock is only taken by the
+    // outermost call.
+    static thread_local std::vector< std::pair<const std::shared_timed_mutex*, bool> > keaHeldIOLocks;
+    
+    static std::vector< std::pair<const std::shared_timed_mutex*, bool> >::iterator keaFindHeldIOLock(const std::shared_timed_mutex *ioMutex)
+    {
+        return std::find_if(keaHeldIOLocks.begin(), keaHeldIOLocks.end(), [ioMutex](const std::pair<const std::shared_timed_mutex*, bool> &held){ return held.first == ioMutex; });
+    }
+    
+    // how many of the locks below hold the HDF5 mutex for this thread. A
+    // thread holding it must not wait for another thread to read a chunk.
+    static thread_local uint32_t keaHeldH5Locks = 0;
+    
+    class KEAImageIOLock
+    {
+    public:
+        KEAImageIOLock(std::shared_timed_mutex &ioMutex, bool threadSafe, KEAImageIOLockType lockType, bool lockH5 = true)
+        {
+            this->ioMutex = &ioMutex;
+            this->exclusive = (lockType == kea_lock_write);
+            this->ownsIOLock = false;
+            this->ownsH5Lock = false;
+            if(!threadSafe)
             {
-                throw KEAIOException("The number of image bands was not specified.");
+                return;
             }
-                        
-            // READ TL COORDINATES
-            try 
+            
+            auto iterHeld = keaFindHeldIOLock(this->ioMutex);
+            if(iterHeld == keaHeldIOLocks.end())
             {
-                hsize_t dimsValue[1];
-                dimsValue[0] = 2;
-                H5::DataSpace valueDataSpace(1, dimsValue);
-                double values[2];
-                H5::DataSet datasetSpatialTL = this->keaImgFile->openDataSet( KEA_DATASETNAME_HEADER_TL );
-                datasetSpatialTL.read(values, H5::PredType::NATIVE_DOUBLE, valueDataSpace);
-                this->spatialInfoFile->tlX = values[0];
-                this->spatialInfoFile->tlY = values[1];
-                datasetSpatialTL.close();
-                valueDataSpace.close();
-            } 
-            catch ( const H5::Exception &e) 
+                if(this->exclusive)
+                {
+                    this->ioMutex->lock();
+                }
+                else
+                {
+                    this->ioMutex->lock_shared();
+                }
+                keaHeldIOLocks.push_back(std::make_pair(this->ioMutex, this->exclusive));
+                this->ownsIOLock = true;
+            }
+            else if(this->exclusive && !iterHeld->second)
             {
-                throw KEAIOException("The TL coordinate is not specified.");
+                // THE SHARED LOCK CAN'T BE UPGRADED WITHOUT LETTING OTHER
+                // READERS IN BETWEEN, OR DEADLOCKING WITH ANOTHER UPGRADE
+                throw KEAIOException("The image can't be changed from a call which only holds its shared lock.");
             }
             
-            // READ RESOLUTION
-            try 
+            if(lockH5 && (lockType != kea_lock_pixels))
             {
-                hsize_t dimsValue[1];
-                dimsValue[0] = 2;
-                H5::DataSpace valueDataSpace(1, dimsValue);
-                double values[2];
-                H5::DataSet spatialResDataset = this->keaImgFile->openDataSet( KEA_DATASETNAME_HEADER_RES );
-                spatialResDataset.read(values, H5::PredType::NATIVE_DOUBLE, valueDataSpace);
-                this->spatialInfoFile->xRes = values[0];
-                this->spatialInfoFile->yRes = values[1];
-                spatialResDataset.close();
-                valueDataSpace.close();
-            } 
-            catch ( const H5::Exception &e) 
+                KEAImageIOLock::h5Mutex().lock();
+                ++keaHeldH5Locks;
+                this->ownsH5Lock = true;
+            }
+        }
+        
+        ~KEAImageIOLock()
+        {
+            if(this->ownsH5Lock)
             {
-                throw KEAIOException("The pixel resolution was not specified.");
+                --keaHeldH5Locks;
+                KEAImageIOLock::h5Mutex().unlock();
             }
-            
-            // READ ROTATION
-            try 
+            if(this->ownsIOLock)
             {
-                hsize_t dimsValue[1];
-                dimsValue[0] = 2;
-                H5::DataSpace valueDataSpace(1, dimsValue);
-                double values[2];
-                H5::DataSet spatialRotDataset = this->keaImgFile->openDataSet( KEA_DATASETNAME_HEADER_ROT );
-                spatialRotDataset.read(values, H5::PredType::NATIVE_DOUBLE, valueDataSpace);
-                this->spatialInfoFile->xRot = values[0];
-                this->spatialInfoFile->yRot = values[1];
-                spatialRotDataset.close();
-                valueDataSpace.close();
-            } 
-            catch ( const H5::Exception &e) 
+                keaHeldIOLocks.erase(keaFindHeldIOLock(this->ioMutex));
+                if(this->exclusive)
+                {
+                    this->ioMutex->unlock();
+                }
+                else
+                {
+                    this->ioMutex->unlock_shared();
+                }
+            }
+        }
+        
+        static std::recursive_mutex& h5Mutex()
+        {
+            static std::recursive_mutex mutex;
+            return mutex;
+        }
+        
+    private:
+        std::shared_timed_mutex *ioMutex;
+        bool exclusive;
+        bool ownsIOLock;
+        bool ownsH5Lock;
+    };
+    
+    // locks two objects, e.g. the source and destination of a copy. Both
+    // objects are locked in address order before HDF5 is, so threads copying
+    // between the same objects in opposite directions can't deadlock.
+    class KEAImageIOPairLock
+    {
+    public:
+        KEAImageIOPairLock(std::shared_timed_mutex &ioMutex, bool threadSafe, KEAImageIOLockType lockType, std::shared_timed_mutex &otherIOMutex, bool otherThreadSafe, KEAImageIOLockType otherLockType)
+        {
+            if(&ioMutex == &otherIOMutex)
             {
-                throw KEAIOException("The image resolution was not specified.");
+                // THE SAME OBJECT - ONE LOCK STRONG ENOUGH FOR BOTH
+                this->first.reset(new KEAImageIOLock(ioMutex, threadSafe, std::max(lockType, otherLockType), false));
             }
-            
-            // READ IMAGE SIZE
-            try 
+            else if(std::less<std::shared_timed_mutex*>()(&ioMutex, &otherIOMutex))
             {
-                hsize_t dimsValue[1];
-                dimsValue[0] = 2;
-                H5::DataSpace valueDataSpace(1, dimsValue);
-                uint64_t values[2];
-                H5::DataSet spatialSizeDataset = this->keaImgFile->openDataSet( KEA_DATASETNAME_HEADER_SIZE );
-                spatialSizeDataset.read(values, H5::PredType::NATIVE_UINT64, valueDataSpace);
-                this->spatialInfoFile->xSize = values[0];
-                this->spatialInfoFile->ySize = values[1];
-                spatialSizeDataset.close();
-                valueDataSpace.close();
-            } 
-            catch ( const H5::Exception &e) 
+                this->first.reset(new KEAImageIOLock(ioMutex, threadSafe, lockType, false));
+                this->second.reset(new KEAImageIOLock(otherIOMutex, otherThreadSafe, otherLockType, false));
+            }
+            else
             {
-                throw KEAIOException("The image resolution was not specified.");
+                this->first.reset(new KEAImageIOLock(otherIOMutex, otherThreadSafe, otherLockType, false));
+                this->second.reset(new KEAImageIOLock(ioMutex, threadSafe, lockType, false));
             }
             
-            // READ WKT STRING
-            try 
-            {
-                H5::DataSet datasetSpatialReference = this->keaImgFile->openDataSet( KEA_DATASETNAME_HEADER_WKT );
-                H5::DataType strDataType = datasetSpatialReference.getDataType();
-                this->spatialInfoFile->wktString = readString(datasetSpatialReference, strDataType);
-                datasetSpatialReference.close();
-            } 
-            catch ( const H5::Exception &e) 
+            this->ownsH5Lock = (threadSafe && (lockType != kea_lock_pixels)) || (otherThreadSafe && (otherLockType != kea_lock_pixels));
+            if(this->ownsH5Lock)
             {
-                throw KEAIOException("The spatial reference was not specified.");
+                KEAImageIOLock::h5Mutex().lock();
+                ++keaHeldH5Locks;
             }
-        } 
-        catch ( const KEAIOException &e)
-        {
-            throw e;
         }
-        catch ( const std::exception &e)
+        
+        ~KEAImageIOPairLock()
         {
-            throw KEAIOException(e.what());
+            if(this->ownsH5Lock)
+            {
+                --keaHeldH5Locks;
+                KEAImageIOLock::h5Mutex().unlock();
+            }
+            this->second.reset();
+            this->first.reset();
         }
         
-        this->fileOpen = true;
+    private:
+        std::unique_ptr<KEAImageIOLock> first;
+        std::unique_ptr<KEAImageIOLock> second;
+        bool ownsH5Lock;
+    };
+    
+    // converts a value the same way HDF5 does, i.e., out of range
+    // values are clamped to the limits of the output type.
+    template <typename TOut, typename TIn>
+    inline TOut keaConvertValue(TIn value, std::true_type)
+    {
+        return static_cast<TOut>(value);
     }
     
-    void KEAImageIO::writeImageBlock2Band(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeOut, uint64_t ySizeOut, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType)
+    template <typename TOut, typename TIn>
+    inline TOut keaConvertValue(TIn value, std::false_type)
     {
-        if(!this->fileOpen)
-        {
-            throw KEAIOException("Image was not open.");
-        }
-        
-        try 
+        if(std::is_floating_point<TIn>::value)
         {
-            // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
-            if(band == 0)
+            double dValue = static_cast<double>(value);
+            if(dValue != dValue)
             {
-                throw KEAIOException("KEA Image Bands start at 1.");
+                return 0;
             }
-            else if(band > this->numImgBands)
+            else if(dValue <= static_cast<double>(std::numeric_limits<TOut>::lowest()))
             {
-               throw KEAIOException("Band is not present within image."); 
+                return std::numeric_limits<TOut>::lowest();
             }
-            
-            uint64_t endXPxl = xPxlOff + xSizeOut;
-            uint64_t endYPxl = yPxlOff + ySizeOut;
-            
-            if(xPxlOff > this->spatialInfoFile->xSize)
+            else if(dValue >= static_cast<double>(std::numeric_limits<TOut>::max()))
             {
-               throw KEAIOException("Start X Pixel is not within image.");  
+                return std::numeric_limits<TOut>::max();
             }
-            
-            if(endXPxl > this->spatialInfoFile->xSize)
+            return static_cast<TOut>(dValue);
+        }
+        else if(std::is_signed<TIn>::value && (static_cast<int64_t>(value) < 0))
+        {
+            int64_t iValue = static_cast<int64_t>(value);
+            if(!std::is_signed<TOut>::value)
             {
-                throw KEAIOException("End X Pixel is not within image.");  
+                return 0;
             }
-            
-            if(yPxlOff > this->spatialInfoFile->ySize)
+            else if(iValue < static_cast<int64_t>(std::numeric_limits<TOut>::lowest()))
             {
-                throw KEAIOException("Start Y Pixel is not within image.");  
+                return std::numeric_limits<TOut>::lowest();
             }
-            
-            if(endYPxl > this->spatialInfoFile->ySize)
+            return static_cast<TOut>(iValue);
+        }
+        
+        uint64_t uValue = static_cast<uint64_t>(value);
+        if(uValue > static_cast<uint64_t>(std::numeric_limits<TOut>::max()))
+        {
+            return std::numeric_limits<TOut>::max();
+        }
+        return static_cast<TOut>(uValue);
+    }
+    
+    template <typename TIn, typename TOut>
+    static void keaConvertBlock(const char *in, size_t inStride, char *out, size_t outStride, size_t numRows, size_t numCols)
+    {
+        for(size_t row = 0; row < numRows; ++row)
+        {
+            const TIn *inRow = reinterpret_cast<const TIn*>(in) + (row * inStride);
+            TOut *outRow = reinterpret_cast<TOut*>(out) + (row * outStride);
+            if(std::is_same<TIn, TOut>::value)
             {
-                throw KEAIOException("End Y Pixel is not within image.");  
+                memcpy(outRow, inRow, numCols * sizeof(TIn));
             }
-            
-            // GET NATIVE DATASET
-            H5::DataType imgBandDT = convertDatatypeKeaToH5Native(inDataType);
-
-            // OPEN BAND DATASET AND WRITE IMAGE DATA
-            try 
+            else
             {
-                std::string imageBandPath = KEA_DATASETNAME_BAND + uint2Str(band);
-                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( imageBandPath + KEA_BANDNAME_DATA );
-                H5::DataSpace imgBandDataspace = imgBandDataset.getSpace();                
-                
-                hsize_t imgOffset[2];
-                imgOffset[0] = yPxlOff;
-                imgOffset[1] = xPxlOff;
-                hsize_t dataDims[2];
-                dataDims[0] = ySizeBuf;
-                dataDims[1] = xSizeBuf;
-                H5::DataSpace write2BandDataspace = H5::DataSpace(2, dataDims);
-                
-                if((ySizeOut != ySizeBuf) | (xSizeOut != xSizeBuf))
-                {                    
-                    hsize_t dataSelectMemDims[2];
-                    dataSelectMemDims[0] = ySizeOut;
-                    dataSelectMemDims[1] = 1;
-
-                    hsize_t dataOffDims[2];
-                    dataOffDims[0] = 0;
-                    dataOffDims[1] = 0;
-
-                    hsize_t dataSelectStrideDims[2];
-                    dataSelectStrideDims[0] = 1;
-                    if(xSizeBuf == xSizeOut)
-                    {
-                        dataSelectStrideDims[1] = 1;
-                    }
-                    else
-                    {
-                        dataSelectStrideDims[1] = xSizeBuf - xSizeOut;
-                    }
-
-                    hsize_t dataSelectBlockSizeDims[2];
-                    dataSelectBlockSizeDims[0] = 1;
-                    dataSelectBlockSizeDims[1] = xSizeOut;
-                    write2BandDataspace.selectHyperslab(H5S_SELECT_SET, dataSelectMemDims, dataOffDims, dataSelectStrideDims, dataSelectBlockSizeDims);
-                    
-                    hsize_t dataOutDims[2];
-                    dataOutDims[0] = ySizeOut;
-                    dataOutDims[1] = xSizeOut;
-                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataOutDims, imgOffset);
-                }
-                else
+                for(size_t col = 0; col < numCols; ++col)
                 {
-                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataDims, imgOffset);
+                    outRow[col] = keaConvertValue<TOut>(inRow[col], std::is_floating_point<TOut>());
                 }
-                
-                imgBandDataset.write( data, imgBandDT, write2BandDataspace, imgBandDataspace);
-                                
-                imgBandDataset.close();
-                imgBandDataspace.close();
-                write2BandDataspace.close();
-                
-                this->keaImgFile->flush(H5F_SCOPE_GLOBAL);
-            } 
-            catch ( const H5::Exception &e) 
-            {
-                throw KEAIOException("Could not write image data.");
-            }            
+            }
         }
-        catch(const KEAIOException &e)
+    }
+    
+    template <typename TIn>
+    static void keaConvertBlock(const char *in, size_t inStride, char *out, KEADataType outType, size_t outStride, size_t numRows, size_t numCols)
+    {
+        switch(outType)
         {
-            throw e;
+            case kea_8int:
+                keaConvertBlock<TIn, int8_t>(in, inStride, out, outStride, numRows, numCols); break;
+            case kea_16int:
+                keaConvertBlock<TIn, int16_t>(in, inStride, out, outStride, numRows, numCols); break;
+            case kea_32int:
+                keaConvertBlock<TIn, int32_t>(in, inStride, out, outStride, numRows, numCols); break;
+            case kea_64int:
+                keaConvertBlock<TIn, int64_t>(in, inStride, out, outStride, numRows, numCols); break;
+            case kea_8uint:
+                keaConvertBlock<TIn, uint8_t>(in, inStride, out, outStride, numRows, numCols); break;
+            case kea_16uint:
+                keaConvertBlock<TIn, uint16_t>(in, inStride, out, outStride, numRows, numCols); break;
+            case kea_32uint:
+                keaConvertBlock<TIn, uint32_t>(in, inStride, out, outStride, numRows, numCols); break;
+            case kea_64uint:
+                keaConvertBlock<TIn, uint64_t>(in, inStride, out, outStride, numRows, numCols); break;
+            case kea_32float:
+                keaConvertBlock<TIn, float>(in, inStride, out, outStride, numRows, numCols); break;
+            case kea_64float:
+                keaConvertBlock<TIn, double>(in, inStride, out, outStride, numRows, numCols); break;
+            default:
+                throw KEAIOException("The specified data type was not recognised.");
         }
-        catch( const H5::FileIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataSetIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataSpaceIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataTypeIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-        catch ( const std::exception &e)
+    }
+    
+    // copies a block of numRows x numCols values converting from inType to
+    // outType. The strides are the row lengths of the buffers in values.
+    static void keaConvertBlock(const char *in, KEADataType inType, size_t inStride, char *out, KEADataType outType, size_t outStride, size_t numRows, size_t numCols)
+    {
+        switch(inType)
         {
-            throw KEAIOException(e.what());
+            case kea_8int:
+                keaConvertBlock<int8_t>(in, inStride, out, outType, outStride, numRows, numCols); break;
+            case kea_16int:
+                keaConvertBlock<int16_t>(in, inStride, out, outType, outStride, numRows, numCols); break;
+            case kea_32int:
+                keaConvertBlock<int32_t>(in, inStride, out, outType, outStride, numRows, numCols); break;
+            case kea_64int:
+                keaConvertBlock<int64_t>(in, inStride, out, outType, outStride, numRows, numCols); break;
+            case kea_8uint:
+                keaConvertBlock<uint8_t>(in, inStride, out, outType, outStride, numRows, numCols); break;
+            case kea_16uint:
+                keaConvertBlock<uint16_t>(in, inStride, out, outType, outStride, numRows, numCols); break;
+            case kea_32uint:
+                keaConvertBlock<uint32_t>(in, inStride, out, outType, outStride, numRows, numCols); break;
+            case kea_64uint:
+                keaConvertBlock<uint64_t>(in, inStride, out, outType, outStride, numRows, numCols); break;
+            case kea_32float:
+                keaConvertBlock<float>(in, inStride, out, outType, outStride, numRows, numCols); break;
+            case kea_64float:
+                keaConvertBlock<double>(in, inStride, out, outType, outStride, numRows, numCols); break;
+            default:
+                throw KEAIOException("The specified data type was not recognised.");
         }
     }
     
-    void KEAImageIO::readImageBlock2Band(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType)
+    template <typename TIn, typename TOut>
+    static void keaScaleBlock(const char *in, size_t inStride, char *out, size_t outStride, size_t numRows, size_t numCols, double scale, double offset, const char *noData)
     {
-        if(!this->fileOpen)
+        const TOut noDataOut = std::numeric_limits<TOut>::quiet_NaN();
+        TIn noDataIn = 0;
+        if(noData != nullptr)
         {
-            throw KEAIOException("Image was not open.");
+            memcpy(&noDataIn, noData, sizeof(TIn));
         }
         
-        try 
+        for(size_t row = 0; row < numRows; ++row)
         {
-            // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
-            if(band == 0)
+            const TIn *inRow = reinterpret_cast<const TIn*>(in) + (row * inStride);
+            TOut *outRow = reinterpret_cast<TOut*>(out) + (row * outStride);
+            if(noData == nullptr)
             {
-                throw KEAIOException("KEA Image Bands start at 1.");
+                for(size_t col = 0; col < numCols; ++col)
+                {
+                    outRow[col] = static_cast<TOut>((inRow[col] * scale) + offset);
+                }
             }
-            else if(band > this->numImgBands)
+            else
             {
-                throw KEAIOException("Band is not present within image."); 
+                for(size_t col = 0; col < numCols; ++col)
+                {
+                    outRow[col] = (inRow[col] == noDataIn) ? noDataOut : static_cast<TOut>((inRow[col] * scale) + offset);
+                }
             }
-            
-            uint64_t endXPxl = xPxlOff + xSizeIn;
-            uint64_t endYPxl = yPxlOff + ySizeIn;
-            
-            if(xPxlOff > this->spatialInfoFile->xSize)
+        }
+    }
+    
+    template <typename TIn>
+    static void keaScaleBlock(const char *in, size_t inStride, char *out, KEADataType outType, size_t outStride, size_t numRows, size_t numCols, double scale, double offset, const char *noData)
+    {
+        switch(outType)
+        {
+            case kea_32float:
+                keaScaleBlock<TIn, float>(in, inStride, out, outStride, numRows, numCols, scale, offset, noData); break;
+            case kea_64float:
+                keaScaleBlock<TIn, double>(in, inStride, out, outStride, numRows, numCols, scale, offset, noData); break;
+            default:
+                throw KEAIOException("Scaled values can only be read as kea_32float or kea_64float.");
+        }
+    }
+    
+    // AS keaConvertBlock BUT OUTPUTS value * scale + offset, AND NaN FOR
+    // VALUES EQUAL TO noData (IN THE INPUT TYPE) IF IT IS NOT NULL
+    static void keaScaleBlock(const char *in, KEADataType inType, size_t inStride, char *out, KEADataType outType, size_t outStride, size_t numRows, size_t numCols, double scale, double offset, const char *noData)
+    {
+        switch(inType)
+        {
+            case kea_8int:
+                keaScaleBlock<int8_t>(in, inStride, out, outType, outStride, numRows, numCols, scale, offset, noData); break;
+            case kea_16int:
+                keaScaleBlock<int16_t>(in, inStride, out, outType, outStride, numRows, numCols, scale, offset, noData); break;
+            case kea_32int:
+                keaScaleBlock<int32_t>(in, inStride, out, outType, outStride, numRows, numCols, scale, offset, noData); break;
+            case kea_64int:
+                keaScaleBlock<int64_t>(in, inStride, out, outType, outStride, numRows, numCols, scale, offset, noData); break;
+            case kea_8uint:
+                keaScaleBlock<uint8_t>(in, inStride, out, outType, outStride, numRows, numCols, scale, offset, noData); break;
+            case kea_16uint:
+                keaScaleBlock<uint16_t>(in, inStride, out, outType, outStride, numRows, numCols, scale, offset, noData); break;
+            case kea_32uint:
+                keaScaleBlock<uint32_t>(in, inStride, out, outType, outStride, numRows, numCols, scale, offset, noData); break;
+            case kea_64uint:
+                keaScaleBlock<uint64_t>(in, inStride, out, outType, outStride, numRows, numCols, scale, offset, noData); break;
+            case kea_32float:
+                keaScaleBlock<float>(in, inStride, out, outType, outStride, numRows, numCols, scale, offset, noData); break;
+            case kea_64float:
+                keaScaleBlock<double>(in, inStride, out, outType, outStride, numRows, numCols, scale, offset, noData); break;
+            default:
+                throw KEAIOException("The specified data type was not recognised.");
+        }
+    }
+
+    KEAImageIO::KEAImageIO()
+    {
+        this->fileOpen = false;
+        this->bandHeadersLoaded = false;
+        this->haveConsolidatedHeader = false;
+        this->threadSafe = false;
+        this->asyncWriter = nullptr;
+        this->asyncWriteQueueSize = KEA_WRITE_QUEUE_SIZE;
+        this->asyncReader = nullptr;
+        this->asyncReadThreads = 0;
+    }
+    
+    void KEAImageIO::setThreadSafe(bool threadSafe)
+    {
+        if(!threadSafe)
+        {
+            std::lock_guard<std::mutex> lock(this->asyncWriterMutex);
+            if(this->asyncWriter != nullptr)
             {
-                throw KEAIOException("Start X Pixel is not within image.");  
+                throw KEAIOException("Thread safe mode can't be switched off while the asynchronous writer is running.");
             }
-            
-            if(endXPxl > this->spatialInfoFile->xSize)
+            std::lock_guard<std::mutex> readerLock(this->asyncReaderMutex);
+            if(this->asyncReader != nullptr)
             {
-                throw KEAIOException("End X Pixel is not within image.");  
+                throw KEAIOException("Thread safe mode can't be switched off while the asynchronous reader is running, call stopAsyncReader() first.");
             }
+        }
+        this->threadSafe = threadSafe;
+    }
+    
+    bool KEAImageIO::isThreadSafe() const
+    {
+        return this->threadSafe;
+    }
+    
+    std::recursive_mutex& KEAImageIO::getH5Mutex()
+    {
+        return KEAImageIOLock::h5Mutex();
+    }
+    
+    std::string KEAImageIO::readString(H5::DataSet& dataset, H5::DataType strDataType)
+    {
+        hid_t nativeVerStrType;
+        if((nativeVerStrType=H5Tget_native_type(strDataType.getId(), H5T_DIR_DEFAULT))<0)
+        {
+            throw KEAIOException("Could not define a native string type");
+        }
+        H5::DSetMemXferPropList xfer;
+        /* Ensures that malloc()/free() are from the same C runtime */
+        xfer.setVlenMemManager(kealibmalloc, nullptr, kealibfree, nullptr);
+        char* strData[1];
+        dataset.read((void*)strData, strDataType, H5::DataSpace::ALL, H5::DataSpace::ALL, xfer);
+        std::string ret = strData[0];
+        free(strData[0]);
+        H5Tclose(nativeVerStrType);
+        return ret;
+    }
+    
+    void KEAImageIO::openKEAImageHeader(H5::H5File *keaImgH5File)
+    {
+        KEATraceScope trace("KEAImageIO::openKEAImageHeader", KEA_TRACE_API);
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
+        try 
+        {
+            this->clearChunkedDatasets();
+            this->keaImgFile = keaImgH5File;
+            this->spatialInfoFile = new KEAImageSpatialInfo();
             
-            if(yPxlOff > this->spatialInfoFile->ySize)
+            // ONLY THE CONSOLIDATED HEADER IS READ IF THE FILE HAS ONE
+            this->bandHeaders.clear();
+            this->bandHeadersLoaded = false;
+            this->haveConsolidatedHeader = readConsolidatedHeader(keaImgH5File, this->keaVersion, this->spatialInfoFile, this->bandHeaders);
+            if(this->haveConsolidatedHeader)
             {
-                throw KEAIOException("Start Y Pixel is not within image.");  
+                this->numImgBands = this->bandHeaders.size();
+                this->bandHeadersLoaded = true;
             }
-            
-            if(endYPxl > this->spatialInfoFile->ySize)
+            else
             {
-                throw KEAIOException("End Y Pixel is not within image.");  
+                readImageHeader(keaImgH5File, this->keaVersion, this->numImgBands, this->spatialInfoFile);
             }
-            
-            // GET NATIVE DATASET
-            H5::DataType imgBandDT = convertDatatypeKeaToH5Native(inDataType);
-
-            // OPEN BAND DATASET AND READ IMAGE DATA
-            try 
-            {
-                std::string imageBandPath = KEA_DATASETNAME_BAND + uint2Str(band);
-                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( imageBandPath + KEA_BANDNAME_DATA );
-                H5::DataSpace imgBandDataspace = imgBandDataset.getSpace();                
-                
-                hsize_t dataOffset[2];
-                dataOffset[0] = yPxlOff;
-                dataOffset[1] = xPxlOff;
-                hsize_t dataDims[2];
-                dataDims[0] = ySizeBuf;
-                dataDims[1] = xSizeBuf;
-                H5::DataSpace read2BandDataspace = H5::DataSpace(2, dataDims);
-                
-                if((ySizeBuf != ySizeIn) | (xSizeBuf != xSizeIn))
-                {
-                    hsize_t dataSelectMemDims[2];
-                    dataSelectMemDims[0] = ySizeIn;
-                    dataSelectMemDims[1] = 1;
-
-                    hsize_t dataOffDims[2];
-                    dataOffDims[0] = 0;
-                    dataOffDims[1] = 0;
-
-                    hsize_t dataSelectStrideDims[2];
-                    dataSelectStrideDims[0] = 1;
-                    if(xSizeBuf == xSizeIn)
-                    {
-                        dataSelectStrideDims[1] = 1;
-                    }
-                    else
-                    {
-                        dataSelectStrideDims[1] = xSizeBuf - xSizeIn;
-                    }
-
-                    hsize_t dataSelectBlockSizeDims[2];
-                    dataSelectBlockSizeDims[0] = 1;
-                    dataSelectBlockSizeDims[1] = xSizeIn;
-                    read2BandDataspace.selectHyperslab(H5S_SELECT_SET, dataSelectMemDims, dataOffDims, dataSelectStrideDims, dataSelectBlockSizeDims);
-                    
-                    hsize_t dataInDims[2];
-                    dataInDims[0] = ySizeIn;
-                    dataInDims[1] = xSizeIn;
-                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataInDims, dataOffset);
-                }
-                else
-                {
-                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataDims, dataOffset);
-                }
-                
-                imgBandDataset.read( data, imgBandDT, read2BandDataspace, imgBandDataspace);
-                
-                imgBandDataset.close();
-                imgBandDataspace.close();
-                read2BandDataspace.close();
-            } 
-            catch ( const H5::Exception &e) 
-            {
-                throw KEAIOException("Could not read image data.");
-            }            
-        }
-        catch(const KEAIOException &e)
+        } 
+        catch ( const KEAIOException &e)
         {
             throw e;
         }
-        catch( const H5::FileIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataSetIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataSpaceIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataTypeIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+        
+        this->fileOpen = true;
+    }
+    
+    void KEAImageIO::readImageHeader(H5::H5File *keaImgH5File, std::string &keaVersion, uint32_t &numImgBands, KEAImageSpatialInfo *spatialInfo)
+    {
+        // READ KEA VERSION NUMBER
+        try
+        {
+            H5::DataSet datasetFileVersion = keaImgH5File->openDataSet( KEA_DATASETNAME_HEADER_VERSION );
+            H5::DataType strVerDataType = datasetFileVersion.getDataType();
+            keaVersion = readString(datasetFileVersion, strVerDataType);
+            datasetFileVersion.close();
+        }
+        catch ( const H5::Exception &e)
+        {
+            throw KEAIOException("The number of image bands was not specified.");
+        }
+        
+        
+        // READ NUMBER OF IMAGE BANDS
+        try 
+        {
+            hsize_t dimsValue[1];
+            dimsValue[0] = 1;
+            H5::DataSpace valueDataSpace(1, dimsValue);
+            uint32_t value[1];
+            H5::DataSet datasetNumImgBands = keaImgH5File->openDataSet( KEA_DATASETNAME_HEADER_NUMBANDS );
+            datasetNumImgBands.read(value, H5::PredType::NATIVE_UINT32, valueDataSpace);
+            numImgBands = value[0];
+            datasetNumImgBands.close();
+            valueDataSpace.close();
+        } 
+        catch ( const H5::Exception &e) 
+        {
+            throw KEAIOException("The number of image bands was not specified.");
+        }
+                    
+        // READ TL COORDINATES
+        try 
+        {
+            hsize_t dimsValue[1];
+            dimsValue[0] = 2;
+            H5::DataSpace valueDataSpace(1, dimsValue);
+            double values[2];
+            H5::DataSet datasetSpatialTL = keaImgH5File->openDataSet( KEA_DATASETNAME_HEADER_TL );
+            datasetSpatialTL.read(values, H5::PredType::NATIVE_DOUBLE, valueDataSpace);
+            spatialInfo->tlX = values[0];
+            spatialInfo->tlY = values[1];
+            datasetSpatialTL.close();
+            valueDataSpace.close();
+        } 
+        catch ( const H5::Exception &e) 
+        {
+            throw KEAIOException("The TL coordinate is not specified.");
+        }
+        
+        // READ RESOLUTION
+        try 
+        {
+            hsize_t dimsValue[1];
+            dimsValue[0] = 2;
+            H5::DataSpace valueDataSpace(1, dimsValue);
+            double values[2];
+            H5::DataSet spatialResDataset = keaImgH5File->openDataSet( KEA_DATASETNAME_HEADER_RES );
+            spatialResDataset.read(values, H5::PredType::NATIVE_DOUBLE, valueDataSpace);
+            spatialInfo->xRes = values[0];
+            spatialInfo->yRes = values[1];
+            spatialResDataset.close();
+            valueDataSpace.close();
+        } 
+        catch ( const H5::Exception &e) 
+        {
+            throw KEAIOException("The pixel resolution was not specified.");
+        }
+        
+        // READ ROTATION
+        try 
+        {
+            hsize_t dimsValue[1];
+            dimsValue[0] = 2;
+            H5::DataSpace valueDataSpace(1, dimsValue);
+            double values[2];
+            H5::DataSet spatialRotDataset = keaImgH5File->openDataSet( KEA_DATASETNAME_HEADER_ROT );
+            spatialRotDataset.read(values, H5::PredType::NATIVE_DOUBLE, valueDataSpace);
+            spatialInfo->xRot = values[0];
+            spatialInfo->yRot = values[1];
+            spatialRotDataset.close();
+            valueDataSpace.close();
+        } 
+        catch ( const H5::Exception &e) 
+        {
+            throw KEAIOException("The image resolution was not specified.");
+        }
+        
+        // READ IMAGE SIZE
+        try 
+        {
+            hsize_t dimsValue[1];
+            dimsValue[0] = 2;
+            H5::DataSpace valueDataSpace(1, dimsValue);
+            uint64_t values[2];
+            H5::DataSet spatialSizeDataset = keaImgH5File->openDataSet( KEA_DATASETNAME_HEADER_SIZE );
+            spatialSizeDataset.read(values, H5::PredType::NATIVE_UINT64, valueDataSpace);
+            spatialInfo->xSize = values[0];
+            spatialInfo->ySize = values[1];
+            spatialSizeDataset.close();
+            valueDataSpace.close();
+        } 
+        catch ( const H5::Exception &e) 
+        {
+            throw KEAIOException("The image resolution was not specified.");
+        }
+        
+        // READ WKT STRING
+        try 
+        {
+            H5::DataSet datasetSpatialReference = keaImgH5File->openDataSet( KEA_DATASETNAME_HEADER_WKT );
+            H5::DataType strDataType = datasetSpatialReference.getDataType();
+            spatialInfo->wktString = readString(datasetSpatialReference, strDataType);
+            datasetSpatialReference.close();
+        } 
+        catch ( const H5::Exception &e) 
+        {
+            throw KEAIOException("The spatial reference was not specified.");
+        }
+    }
+    
+    bool KEAImageIO::consolidatedHeaderPresent()
+    {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        return this->haveConsolidatedHeader;
+    }
+    
+    void KEAImageIO::rebuildConsolidatedHeader()
+    {
+        KEATraceScope trace("KEAImageIO::rebuildConsolidatedHeader", KEA_TRACE_API);
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        try
+        {
+            this->bandHeadersLoaded = false;
+            readImageHeader(this->keaImgFile, this->keaVersion, this->numImgBands, this->spatialInfoFile);
+            this->bandHeaders.resize(this->numImgBands);
+            for(uint32_t band = 1; band <= this->numImgBands; ++band)
+            {
+                readBandHeader(this->keaImgFile, band, this->bandHeaders[band-1]);
+            }
+            this->bandHeadersLoaded = true;
+            
+            writeConsolidatedHeader(this->keaImgFile, this->keaVersion, this->spatialInfoFile, this->bandHeaders);
+            this->haveConsolidatedHeader = true;
+            keaFlushFile(this->keaImgFile);
+        }
+        catch ( const H5::Exception &e)
+        {
+            throw KEAIOException(e.getCDetailMsg());
+        }
+        catch ( const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+    }
+    
+    const KEAImageIO::KEABandHeader* KEAImageIO::getBandHeader(uint32_t band) const
+    {
+        if(!this->bandHeadersLoaded || (band == 0) || (band > this->bandHeaders.size()) || (this->bandHeaders.size() != this->numImgBands))
+        {
+            return nullptr;
+        }
+        return &this->bandHeaders[band-1];
+    }
+    
+    void KEAImageIO::updateConsolidatedHeader(uint32_t band)
+    {
+        try
+        {
+            if(this->bandHeadersLoaded && (band > 0))
+            {
+                if((band == this->numImgBands) && ((this->bandHeaders.size() + 1) == this->numImgBands))
+                {
+                    // A BAND HAS BEEN APPENDED
+                    this->bandHeaders.push_back(KEABandHeader());
+                }
+                if(this->bandHeaders.size() == this->numImgBands)
+                {
+                    readBandHeader(this->keaImgFile, band, this->bandHeaders[band-1]);
+                }
+            }
+            
+            // FILES WITHOUT A CONSOLIDATED HEADER GET ONE ON THE FIRST CHANGE
+            if(!this->bandHeadersLoaded || (this->bandHeaders.size() != this->numImgBands))
+            {
+                this->bandHeadersLoaded = false;
+                this->bandHeaders.resize(this->numImgBands);
+                for(uint32_t i = 1; i <= this->numImgBands; ++i)
+                {
+                    readBandHeader(this->keaImgFile, i, this->bandHeaders[i-1]);
+                }
+                this->bandHeadersLoaded = true;
+            }
+            
+            writeConsolidatedHeader(this->keaImgFile, this->keaVersion, this->spatialInfoFile, this->bandHeaders);
+            this->haveConsolidatedHeader = true;
+        }
+        catch(...)
+        {
+            // NO CONSOLIDATED HEADER IS BETTER THAN AN OUT OF DATE ONE
+            this->bandHeaders.clear();
+            this->bandHeadersLoaded = false;
+            this->haveConsolidatedHeader = false;
+            if(H5Lexists(this->keaImgFile->getId(), KEA_DATASETNAME_HEADER_CONSOLIDATED.c_str(), H5P_DEFAULT) > 0)
+            {
+                H5Ldelete(this->keaImgFile->getId(), KEA_DATASETNAME_HEADER_CONSOLIDATED.c_str(), H5P_DEFAULT);
+            }
+        }
+    }
+    
+    void KEAImageIO::readBandHeader(H5::H5File *keaImgH5File, const uint32_t band, KEABandHeader &bandHeader)
+    {
+        std::string bandPath = KEA_DATASETNAME_BAND + uint2Str(band);
+        try
+        {
+            uint32_t value = 0;
+            H5::DataSet datasetImgDT = keaImgH5File->openDataSet( bandPath + KEA_BANDNAME_DT );
+            datasetImgDT.read(&value, H5::PredType::NATIVE_UINT32);
+            datasetImgDT.close();
+            bandHeader.dataType = (KEADataType)value;
+            
+            H5::DataSet datasetImgLT = keaImgH5File->openDataSet( bandPath + KEA_BANDNAME_TYPE );
+            datasetImgLT.read(&value, H5::PredType::NATIVE_UINT32);
+            datasetImgLT.close();
+            bandHeader.layerType = (KEALayerType)value;
+            
+            H5::DataSet datasetDescrip = keaImgH5File->openDataSet( bandPath + KEA_BANDNAME_DESCRIP );
+            bandHeader.description = readString(datasetDescrip, datasetDescrip.getDataType());
+            datasetDescrip.close();
+        }
+        catch ( const H5::Exception &e)
+        {
+            throw KEAIOException("The header of band " + uint2Str(band) + " could not be read.");
+        }
+        
+        // THE REST ARE NOT IN ALL FILES
+        bandHeader.clrInterp = kea_generic;
+        try
+        {
+            uint32_t value = 0;
+            H5::DataSet datasetImgLU = keaImgH5File->openDataSet( bandPath + KEA_BANDNAME_USAGE );
+            datasetImgLU.read(&value, H5::PredType::NATIVE_UINT32);
+            datasetImgLU.close();
+            bandHeader.clrInterp = (KEABandClrInterp)value;
+        }
+        catch ( const H5::Exception &e)
+        {
+            bandHeader.clrInterp = kea_generic;
+        }
+        
+        // 0 IS NEVER A VALID BLOCK SIZE SO MEANS IT IS MISSING
+        bandHeader.blockSize = 0;
+        try
+        {
+            H5::DataSet imgBandDataset = keaImgH5File->openDataSet( bandPath + KEA_BANDNAME_DATA );
+            H5::Attribute blockSizeAtt = imgBandDataset.openAttribute(KEA_ATTRIBUTENAME_BLOCK_SIZE);
+            blockSizeAtt.read(H5::PredType::NATIVE_UINT32, &bandHeader.blockSize);
+            blockSizeAtt.close();
+            imgBandDataset.close();
+        }
+        catch ( const H5::Exception &e)
+        {
+            bandHeader.blockSize = 0;
+        }
+        
+        bandHeader.numOverviews = 0;
+        std::string overviewGroupName = bandPath + KEA_BANDNAME_OVERVIEWS;
+        H5G_info_t overviewsInfo;
+        if((H5Lexists(keaImgH5File->getId(), overviewGroupName.c_str(), H5P_DEFAULT) > 0) &&
+           (H5Gget_info_by_name(keaImgH5File->getId(), overviewGroupName.c_str(), &overviewsInfo, H5P_DEFAULT) >= 0))
+        {
+            bandHeader.numOverviews = overviewsInfo.nlinks;
+        }
+        
+        bandHeader.noDataState = 0;
+        bandHeader.noDataValue.clear();
+        try
+        {
+            H5::DataSet datasetImgNDV = keaImgH5File->openDataSet( bandPath + KEA_BANDNAME_NO_DATA_VAL );
+            bandHeader.noDataState = 2;
+            try
+            {
+                H5::Attribute noDataDefAttribute = datasetImgNDV.openAttribute(KEA_NODATA_DEFINED);
+                int val = 1;
+                noDataDefAttribute.read(H5::PredType::NATIVE_INT, &val);
+                noDataDefAttribute.close();
+                if(val == 0)
+                {
+                    bandHeader.noDataState = 1;
+                }
+            }
+            catch ( const H5::Exception &e)
+            {
+                // NOT HAVING THE ATTRIBUTE MEANS IT IS DEFINED
+            }
+            
+            if(bandHeader.noDataState == 2)
+            {
+                bandHeader.noDataValue.resize(getDataTypeSize(bandHeader.dataType));
+                datasetImgNDV.read(bandHeader.noDataValue.data(), convertDatatypeKeaToH5Native(bandHeader.dataType));
+            }
+            datasetImgNDV.close();
+        }
+        catch ( const H5::Exception &e)
+        {
+            bandHeader.noDataState = 0;
+            bandHeader.noDataValue.clear();
+        }
+        
+        bandHeader.scale = readBandScaleOffset(keaImgH5File, bandPath + KEA_BANDNAME_SCALE, 1);
+        bandHeader.offset = readBandScaleOffset(keaImgH5File, bandPath + KEA_BANDNAME_OFFSET, 0);
+    }
+    
+    uint64_t KEAImageIO::readHeaderGeneration(H5::H5File *keaImgH5File)
+    {
+        uint64_t generation = 0;
+        H5::Group headerGroup = keaImgH5File->openGroup( KEA_DATASETNAME_HEADER );
+        if(headerGroup.attrExists(KEA_ATTRIBUTENAME_HEADER_GENERATION))
+        {
+            H5::Attribute generationAttribute = headerGroup.openAttribute(KEA_ATTRIBUTENAME_HEADER_GENERATION);
+            generationAttribute.read(H5::PredType::NATIVE_UINT64, &generation);
+            generationAttribute.close();
+        }
+        headerGroup.close();
+        return generation;
+    }
+    
+    void KEAImageIO::beginHeaderChange()
+    {
+        // BUMPED BEFORE THE INDIVIDUAL DATASETS ARE WRITTEN SO THE CONSOLIDATED
+        // HEADER ONLY MATCHES AGAIN ONCE IT HAS BEEN REWRITTEN AFTER THEM
+        try
+        {
+            uint64_t generation = readHeaderGeneration(this->keaImgFile) + 1;
+            H5::Group headerGroup = this->keaImgFile->openGroup( KEA_DATASETNAME_HEADER );
+            H5::Attribute generationAttribute;
+            if(headerGroup.attrExists(KEA_ATTRIBUTENAME_HEADER_GENERATION))
+            {
+                generationAttribute = headerGroup.openAttribute(KEA_ATTRIBUTENAME_HEADER_GENERATION);
+            }
+            else
+            {
+                H5::DataSpace attrDataSpace(H5S_SCALAR);
+                generationAttribute = headerGroup.createAttribute(KEA_ATTRIBUTENAME_HEADER_GENERATION, H5::PredType::STD_U64LE, attrDataSpace);
+            }
+            generationAttribute.write(H5::PredType::NATIVE_UINT64, &generation);
+            generationAttribute.close();
+            headerGroup.close();
+        }
+        catch ( const H5::Exception &e)
+        {
+            throw KEAIOException("Could not update the header generation.");
+        }
+    }
+    
+    void KEAImageIO::writeConsolidatedHeader(H5::H5File *keaImgH5File, const std::string &keaVersion, const KEAImageSpatialInfo *spatialInfo, const std::vector<KEABandHeader> &bandHeaders)
+    {
+        uint64_t generation = 0;
+        try
+        {
+            generation = readHeaderGeneration(keaImgH5File);
+        }
+        catch ( const H5::Exception &e)
+        {
+            throw KEAIOException("Could not write the consolidated header.");
+        }
+        
+        std::vector<uint8_t> buffer(KEA_CONSOLIDATED_MAGIC, KEA_CONSOLIDATED_MAGIC + sizeof(KEA_CONSOLIDATED_MAGIC));
+        keaPutUInt(buffer, KEA_CONSOLIDATED_LAYOUT, 4);
+        keaPutUInt(buffer, generation, 8);
+        keaPutString(buffer, keaVersion);
+        keaPutUInt(buffer, bandHeaders.size(), 4);
+        keaPutDouble(buffer, spatialInfo->tlX);
+        keaPutDouble(buffer, spatialInfo->tlY);
+        keaPutDouble(buffer, spatialInfo->xRes);
+        keaPutDouble(buffer, spatialInfo->yRes);
+        keaPutDouble(buffer, spatialInfo->xRot);
+        keaPutDouble(buffer, spatialInfo->yRot);
+        keaPutUInt(buffer, spatialInfo->xSize, 8);
+        keaPutUInt(buffer, spatialInfo->ySize, 8);
+        keaPutString(buffer, spatialInfo->wktString);
+        for(const KEABandHeader &bandHeader : bandHeaders)
+        {
+            keaPutUInt(buffer, bandHeader.dataType, 4);
+            keaPutUInt(buffer, bandHeader.layerType, 4);
+            keaPutUInt(buffer, bandHeader.clrInterp, 4);
+            keaPutUInt(buffer, bandHeader.blockSize, 4);
+            keaPutUInt(buffer, bandHeader.numOverviews, 4);
+            keaPutString(buffer, bandHeader.description);
+            keaPutUInt(buffer, bandHeader.noDataState, 1);
+            keaPutUInt(buffer, bandHeader.noDataValue.size(), 1);
+            if(!bandHeader.noDataValue.empty())
+            {
+                keaPutValue(buffer, bandHeader.noDataValue.data(), bandHeader.noDataValue.size());
+            }
+            keaPutDouble(buffer, bandHeader.scale);
+            keaPutDouble(buffer, bandHeader.offset);
+        }
+        
+        try
+        {
+            hsize_t dimsHeader[1];
+            dimsHeader[0] = buffer.size();
+            
+            // OVERWRITE IN PLACE IF THE SIZE HASN'T CHANGED
+            if(H5Lexists(keaImgH5File->getId(), KEA_DATASETNAME_HEADER_CONSOLIDATED.c_str(), H5P_DEFAULT) > 0)
+            {
+                H5::DataSet datasetHeader = keaImgH5File->openDataSet( KEA_DATASETNAME_HEADER_CONSOLIDATED );
+                if(datasetHeader.getSpace().getSimpleExtentNpoints() == (hssize_t)buffer.size())
+                {
+                    datasetHeader.write(buffer.data(), H5::PredType::NATIVE_UINT8);
+                    datasetHeader.close();
+                    return;
+                }
+                datasetHeader.close();
+                keaImgH5File->unlink( KEA_DATASETNAME_HEADER_CONSOLIDATED );
+            }
+            
+            // COMPACT DATASETS ARE READ ALONG WITH THEIR OBJECT HEADER
+            H5::DSetCreatPropList creationHeaderDSPList;
+            if(buffer.size() <= KEA_CONSOLIDATED_COMPACT_MAX)
+            {
+                creationHeaderDSPList.setLayout(H5D_COMPACT);
+            }
+            H5::DataSpace headerDataSpace(1, dimsHeader);
+            H5::DataSet datasetHeader = keaImgH5File->createDataSet(KEA_DATASETNAME_HEADER_CONSOLIDATED, H5::PredType::STD_U8LE, headerDataSpace, creationHeaderDSPList);
+            datasetHeader.write(buffer.data(), H5::PredType::NATIVE_UINT8);
+            datasetHeader.close();
+            headerDataSpace.close();
+        }
+        catch ( const H5::Exception &e)
+        {
+            throw KEAIOException("Could not write the consolidated header.");
+        }
+    }
+    
+    bool KEAImageIO::readConsolidatedHeader(H5::H5File *keaImgH5File, std::string &keaVersion, KEAImageSpatialInfo *spatialInfo, std::vector<KEABandHeader> &bandHeaders)
+    {
+        hid_t fileId = keaImgH5File->getId();
+        if((H5Lexists(fileId, KEA_DATASETNAME_HEADER.c_str(), H5P_DEFAULT) <= 0) || (H5Lexists(fileId, KEA_DATASETNAME_HEADER_CONSOLIDATED.c_str(), H5P_DEFAULT) <= 0))
+        {
+            return false;
+        }
+        
+        try
+        {
+            H5::DataSet datasetHeader = keaImgH5File->openDataSet( KEA_DATASETNAME_HEADER_CONSOLIDATED );
+            std::vector<uint8_t> buffer(datasetHeader.getSpace().getSimpleExtentNpoints());
+            datasetHeader.read(buffer.data(), H5::PredType::NATIVE_UINT8);
+            datasetHeader.close();
+            
+            KEAHeaderReader reader(buffer);
+            for(size_t i = 0; i < sizeof(KEA_CONSOLIDATED_MAGIC); ++i)
+            {
+                if(reader.getUInt(1) != (uint8_t)KEA_CONSOLIDATED_MAGIC[i])
+                {
+                    return false;
+                }
+            }
+            if(reader.getUInt(4) != KEA_CONSOLIDATED_LAYOUT)
+            {
+                return false;
+            }
+            uint64_t generation = reader.getUInt(8);
+            
+            std::string version = reader.getString();
+            uint32_t numImgBands = reader.getUInt(4);
+            KEAImageSpatialInfo info;
+            info.tlX = reader.getDouble();
+            info.tlY = reader.getDouble();
+            info.xRes = reader.getDouble();
+            info.yRes = reader.getDouble();
+            info.xRot = reader.getDouble();
+            info.yRot = reader.getDouble();
+            info.xSize = reader.getUInt(8);
+            info.ySize = reader.getUInt(8);
+            info.wktString = reader.getString();
+            
+            std::vector<KEABandHeader> headers;
+            for(uint32_t band = 0; band < numImgBands; ++band)
+            {
+                KEABandHeader bandHeader;
+                bandHeader.dataType = (KEADataType)reader.getUInt(4);
+                bandHeader.layerType = (KEALayerType)reader.getUInt(4);
+                bandHeader.clrInterp = (KEABandClrInterp)reader.getUInt(4);
+                bandHeader.blockSize = reader.getUInt(4);
+                bandHeader.numOverviews = reader.getUInt(4);
+                bandHeader.description = reader.getString();
+                bandHeader.noDataState = reader.getUInt(1);
+                bandHeader.noDataValue.resize(reader.getUInt(1));
+                if(!bandHeader.noDataValue.empty())
+                {
+                    reader.getValue(bandHeader.noDataValue.data(), bandHeader.noDataValue.size());
+                }
+                bandHeader.scale = reader.getDouble();
+                bandHeader.offset = reader.getDouble();
+                headers.push_back(bandHeader);
+            }
+            if(!reader.atEnd())
+            {
+                return false;
+            }
+            
+            // A VERSION OF LIBKEA WITHOUT THE CONSOLIDATED HEADER MAY HAVE
+            // ADDED OR REMOVED BANDS SINCE IT WAS WRITTEN
+            uint32_t fileNumImgBands = 0;
+            H5::DataSet datasetNumImgBands = keaImgH5File->openDataSet( KEA_DATASETNAME_HEADER_NUMBANDS );
+            datasetNumImgBands.read(&fileNumImgBands, H5::PredType::NATIVE_UINT32);
+            datasetNumImgBands.close();
+            if(fileNumImgBands != numImgBands)
+            {
+                return false;
+            }
+            
+            // OR A CHANGE TO THE INDIVIDUAL DATASETS DID NOT GET AS FAR AS
+            // REWRITING IT
+            if(readHeaderGeneration(keaImgH5File) != generation)
+            {
+                return false;
+            }
+            
+            keaVersion = version;
+            *spatialInfo = info;
+            bandHeaders.swap(headers);
+        }
+        catch ( const H5::Exception &e)
+        {
+            return false;
+        }
+        catch ( const KEAIOException &e)
+        {
+            // CORRUPT - THE INDIVIDUAL DATASETS ARE STILL THERE
+            return false;
+        }
+        
+        return true;
+    }
+    
+    void KEAImageIO::writeConsolidatedHeaderFromFile(H5::H5File *keaImgH5File)
+    {
+        std::string keaVersion;
+        uint32_t numImgBands = 0;
+        KEAImageSpatialInfo spatialInfo;
+        readImageHeader(keaImgH5File, keaVersion, numImgBands, &spatialInfo);
+        std::vector<KEABandHeader> bandHeaders(numImgBands);
+        for(uint32_t band = 1; band <= numImgBands; ++band)
+        {
+            readBandHeader(keaImgH5File, band, bandHeaders[band-1]);
+        }
+        writeConsolidatedHeader(keaImgH5File, keaVersion, &spatialInfo, bandHeaders);
+    }
+    
+    void KEAImageIO::writeImageBlock2Band(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeOut, uint64_t ySizeOut, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType)
+    {
+        KEATraceScope trace("KEAImageIO::writeImageBlock2Band", KEA_TRACE_API, xSizeOut * ySizeOut * getDataTypeSize(inDataType));
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        try 
+        {
+            // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
+            if(band == 0)
+            {
+                throw KEAIOException("KEA Image Bands start at 1.");
+            }
+            else if(band > this->numImgBands)
+            {
+               throw KEAIOException("Band is not present within image."); 
+            }
+            
+            uint64_t endXPxl = xPxlOff + xSizeOut;
+            uint64_t endYPxl = yPxlOff + ySizeOut;
+            
+            if(xPxlOff > this->spatialInfoFile->xSize)
+            {
+               throw KEAIOException("Start X Pixel is not within image.");  
+            }
+            
+            if(endXPxl > this->spatialInfoFile->xSize)
+            {
+                throw KEAIOException("End X Pixel is not within image.");  
+            }
+            
+            if(yPxlOff > this->spatialInfoFile->ySize)
+            {
+                throw KEAIOException("Start Y Pixel is not within image.");  
+            }
+            
+            if(endYPxl > this->spatialInfoFile->ySize)
+            {
+                throw KEAIOException("End Y Pixel is not within image.");  
+            }
+            
+            // GET NATIVE DATASET
+            H5::DataType imgBandDT = convertDatatypeKeaToH5Native(inDataType);
+
+            // OPEN BAND DATASET AND WRITE IMAGE DATA
+            try 
+            {
+                std::string imageBandPath = KEA_DATASETNAME_BAND + uint2Str(band);
+                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( imageBandPath + KEA_BANDNAME_DATA );
+                H5::DataSpace imgBandDataspace = imgBandDataset.getSpace();                
+                
+                hsize_t imgOffset[2];
+                imgOffset[0] = yPxlOff;
+                imgOffset[1] = xPxlOff;
+                hsize_t dataDims[2];
+                dataDims[0] = ySizeBuf;
+                dataDims[1] = xSizeBuf;
+                H5::DataSpace write2BandDataspace = H5::DataSpace(2, dataDims);
+                
+                if((ySizeOut != ySizeBuf) | (xSizeOut != xSizeBuf))
+                {                    
+                    hsize_t dataSelectMemDims[2];
+                    dataSelectMemDims[0] = ySizeOut;
+                    dataSelectMemDims[1] = 1;
+
+                    hsize_t dataOffDims[2];
+                    dataOffDims[0] = 0;
+                    dataOffDims[1] = 0;
+
+                    hsize_t dataSelectStrideDims[2];
+                    dataSelectStrideDims[0] = 1;
+                    if(xSizeBuf == xSizeOut)
+                    {
+                        dataSelectStrideDims[1] = 1;
+                    }
+                    else
+                    {
+                        dataSelectStrideDims[1] = xSizeBuf - xSizeOut;
+                    }
+
+                    hsize_t dataSelectBlockSizeDims[2];
+                    dataSelectBlockSizeDims[0] = 1;
+                    dataSelectBlockSizeDims[1] = xSizeOut;
+                    write2BandDataspace.selectHyperslab(H5S_SELECT_SET, dataSelectMemDims, dataOffDims, dataSelectStrideDims, dataSelectBlockSizeDims);
+                    
+                    hsize_t dataOutDims[2];
+                    dataOutDims[0] = ySizeOut;
+                    dataOutDims[1] = xSizeOut;
+                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataOutDims, imgOffset);
+                }
+                else
+                {
+                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataDims, imgOffset);
+                }
+                
+                {
+                    KEATraceScope h5Trace("H5Dwrite", KEA_TRACE_HDF5, xSizeOut * ySizeOut * getDataTypeSize(inDataType));
+                    imgBandDataset.write( data, imgBandDT, write2BandDataspace, imgBandDataspace);
+                }
+                                
+                imgBandDataset.close();
+                imgBandDataspace.close();
+                write2BandDataspace.close();
+                
+                keaFlushFile(this->keaImgFile);
+            } 
+            catch ( const H5::Exception &e) 
+            {
+                throw KEAIOException("Could not write image data.");
+            }            
+        }
+        catch(const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch( const H5::FileIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataSetIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataSpaceIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataTypeIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+    }
+    
+    void KEAImageIO::readImageBlock2Band(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType)
+    {
+        KEATraceScope trace("KEAImageIO::readImageBlock2Band", KEA_TRACE_API, xSizeIn * ySizeIn * getDataTypeSize(inDataType));
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_pixels);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        try 
+        {
+            // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
+            if(band == 0)
+            {
+                throw KEAIOException("KEA Image Bands start at 1.");
+            }
+            else if(band > this->numImgBands)
+            {
+                throw KEAIOException("Band is not present within image."); 
+            }
+            
+            uint64_t endXPxl = xPxlOff + xSizeIn;
+            uint64_t endYPxl = yPxlOff + ySizeIn;
+            
+            if(xPxlOff > this->spatialInfoFile->xSize)
+            {
+                throw KEAIOException("Start X Pixel is not within image.");  
+            }
+            
+            if(endXPxl > this->spatialInfoFile->xSize)
+            {
+                throw KEAIOException("End X Pixel is not within image.");  
+            }
+            
+            if(yPxlOff > this->spatialInfoFile->ySize)
+            {
+                throw KEAIOException("Start Y Pixel is not within image.");  
+            }
+            
+            if(endYPxl > this->spatialInfoFile->ySize)
+            {
+                throw KEAIOException("End Y Pixel is not within image.");  
+            }
+            
+            if(this->threadSafe)
+            {
+                this->readChunkedDataset(KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_DATA, data, xPxlOff, yPxlOff, xSizeIn, ySizeIn, xSizeBuf, ySizeBuf, inDataType);
+                return;
+            }
+            
+            // GET NATIVE DATASET
+            H5::DataType imgBandDT = convertDatatypeKeaToH5Native(inDataType);
+
+            // OPEN BAND DATASET AND READ IMAGE DATA
+            try 
+            {
+                std::string imageBandPath = KEA_DATASETNAME_BAND + uint2Str(band);
+                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( imageBandPath + KEA_BANDNAME_DATA );
+                H5::DataSpace imgBandDataspace = imgBandDataset.getSpace();                
+                
+                hsize_t dataOffset[2];
+                dataOffset[0] = yPxlOff;
+                dataOffset[1] = xPxlOff;
+                hsize_t dataDims[2];
+                dataDims[0] = ySizeBuf;
+                dataDims[1] = xSizeBuf;
+                H5::DataSpace read2BandDataspace = H5::DataSpace(2, dataDims);
+                
+                if((ySizeBuf != ySizeIn) | (xSizeBuf != xSizeIn))
+                {
+                    hsize_t dataSelectMemDims[2];
+                    dataSelectMemDims[0] = ySizeIn;
+                    dataSelectMemDims[1] = 1;
+
+                    hsize_t dataOffDims[2];
+                    dataOffDims[0] = 0;
+                    dataOffDims[1] = 0;
+
+                    hsize_t dataSelectStrideDims[2];
+                    dataSelectStrideDims[0] = 1;
+                    if(xSizeBuf == xSizeIn)
+                    {
+                        dataSelectStrideDims[1] = 1;
+                    }
+                    else
+                    {
+                        dataSelectStrideDims[1] = xSizeBuf - xSizeIn;
+                    }
+
+                    hsize_t dataSelectBlockSizeDims[2];
+                    dataSelectBlockSizeDims[0] = 1;
+                    dataSelectBlockSizeDims[1] = xSizeIn;
+                    read2BandDataspace.selectHyperslab(H5S_SELECT_SET, dataSelectMemDims, dataOffDims, dataSelectStrideDims, dataSelectBlockSizeDims);
+                    
+                    hsize_t dataInDims[2];
+                    dataInDims[0] = ySizeIn;
+                    dataInDims[1] = xSizeIn;
+                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataInDims, dataOffset);
+                }
+                else
+                {
+                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataDims, dataOffset);
+                }
+                
+                {
+                    KEATraceScope h5Trace("H5Dread", KEA_TRACE_HDF5, xSizeIn * ySizeIn * getDataTypeSize(inDataType));
+                    imgBandDataset.read( data, imgBandDT, read2BandDataspace, imgBandDataspace);
+                }
+                
+                imgBandDataset.close();
+                imgBandDataspace.close();
+                read2BandDataspace.close();
+            } 
+            catch ( const H5::Exception &e) 
+            {
+                throw KEAIOException("Could not read image data.");
+            }            
+        }
+        catch(const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch( const H5::FileIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataSetIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataSpaceIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataTypeIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+    }
+    
+    void KEAImageIO::readImageBlock2BandScaled(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType outDataType)
+    {
+        KEATraceScope trace("KEAImageIO::readImageBlock2BandScaled", KEA_TRACE_API, xSizeIn * ySizeIn * getDataTypeSize(outDataType));
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_pixels);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        if(band == 0)
+        {
+            throw KEAIOException("KEA Image Bands start at 1.");
+        }
+        else if(band > this->numImgBands)
+        {
+            throw KEAIOException("Band is not present within image.");
+        }
+        
+        if((outDataType != kea_32float) && (outDataType != kea_64float))
+        {
+            throw KEAIOException("Scaled values can only be read as kea_32float or kea_64float.");
+        }
+        
+        if(((xPxlOff + xSizeIn) > this->spatialInfoFile->xSize) || ((yPxlOff + ySizeIn) > this->spatialInfoFile->ySize))
+        {
+            throw KEAIOException("Block is not within image.");
+        }
+        
+        // THE NO DATA VALUE IS COMPARED IN THE BAND'S OWN TYPE
+        KEADataType bandDataType = this->getImageBandDataType(band);
+        double scale = this->getImageBandScale(band);
+        double offset = this->getImageBandOffset(band);
+        std::vector<char> noData(getDataTypeSize(bandDataType));
+        bool haveNoData = true;
+        try
+        {
+            this->getNoDataValue(band, noData.data(), bandDataType);
+        }
+        catch(const KEAIOException &e)
+        {
+            haveNoData = false;
+        }
+        const char *noDataPtr = haveNoData ? noData.data() : nullptr;
+        
+        this->readChunkedDataset(KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_DATA, data, xPxlOff, yPxlOff, xSizeIn, ySizeIn, xSizeBuf, ySizeBuf, getDataTypeSize(outDataType),
+                                 [outDataType, scale, offset, noDataPtr](const char *in, KEADataType inType, size_t inStride, char *out, size_t outStride, size_t numRows, size_t numCols)
+        {
+            keaScaleBlock(in, inType, inStride, out, outDataType, outStride, numRows, numCols, scale, offset, noDataPtr);
+        });
+    }
+    
+    std::future<void> KEAImageIO::readImageBlock2BandAsync(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType)
+    {
+        auto promise = std::make_shared< std::promise<void> >();
+        std::future<void> future = promise->get_future();
+        this->readImageBlock2BandAsync(band, data, xPxlOff, yPxlOff, xSizeIn, ySizeIn, xSizeBuf, ySizeBuf, inDataType, [promise](std::exception_ptr error)
+        {
+            if(error)
+            {
+                promise->set_exception(error);
+            }
+            else
+            {
+                promise->set_value();
+            }
+        });
+        return future;
+    }
+    
+    void KEAImageIO::readImageBlock2BandAsync(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType, std::function<void(std::exception_ptr)> callback)
+    {
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        if(!this->threadSafe)
+        {
+            throw KEAIOException("Asynchronous reads need thread safe mode, call setThreadSafe(true) first.");
+        }
+        
+        std::lock_guard<std::mutex> lock(this->asyncReaderMutex);
+        if(this->asyncReader == nullptr)
+        {
+            this->asyncReader = new KEAThreadPool(this->asyncReadThreads);
+        }
+        
+        this->asyncReader->submit([=]()
+        {
+            // HDF5 ERROR PRINTING IS PER THREAD
+            H5::Exception::dontPrint();
+            std::exception_ptr error;
+            try
+            {
+                this->readImageBlock2Band(band, data, xPxlOff, yPxlOff, xSizeIn, ySizeIn, xSizeBuf, ySizeBuf, inDataType);
+            }
+            catch(...)
+            {
+                error = std::current_exception();
+            }
+            callback(error);
+        });
+    }
+    
+    void KEAImageIO::setAsyncReadThreads(uint32_t numThreads)
+    {
+        std::lock_guard<std::mutex> lock(this->asyncReaderMutex);
+        this->asyncReadThreads = numThreads;
+    }
+    
+    void KEAImageIO::stopAsyncReader()
+    {
+        std::lock_guard<std::mutex> lock(this->asyncReaderMutex);
+        // THE POOL RUNS ANY QUEUED READS BEFORE ITS THREADS EXIT
+        delete this->asyncReader;
+        this->asyncReader = nullptr;
+    }
+    
+    std::shared_ptr< const std::vector<char> > KEAImageIO::readChunkShared(KEAChunkedDataset *chunkedDataset, const hsize_t *chunkOffset)
+    {
+        if(keaHeldH5Locks > 0)
+        {
+            // THE THREAD FETCHING AN IN FLIGHT CHUNK MAY BE WAITING FOR THE
+            // HDF5 MUTEX THIS THREAD HOLDS (E.G. copyBandFrom) SO READ IT HERE
+            auto chunkData = std::make_shared< std::vector<char> >();
+            this->readChunk(chunkedDataset, chunkOffset, *chunkData);
+            return chunkData;
+        }
+        
+        KEAChunkKey key(chunkedDataset, chunkOffset[0], chunkOffset[1]);
+        std::shared_ptr< std::promise< std::shared_ptr< const std::vector<char> > > > promise;
+        std::shared_future< std::shared_ptr< const std::vector<char> > > chunkFuture;
+        {
+            std::lock_guard<std::mutex> lock(this->inFlightMutex);
+            auto iterChunk = this->inFlightChunks.find(key);
+            if(iterChunk != this->inFlightChunks.end())
+            {
+                chunkFuture = iterChunk->second;
+            }
+            else
+            {
+                promise = std::make_shared< std::promise< std::shared_ptr< const std::vector<char> > > >();
+                chunkFuture = promise->get_future().share();
+                this->inFlightChunks[key] = chunkFuture;
+            }
+        }
+        
+        if(promise)
+        {
+            // THIS THREAD FETCHES THE CHUNK FOR EVERYONE
+            try
+            {
+                auto chunkData = std::make_shared< std::vector<char> >();
+                this->readChunk(chunkedDataset, chunkOffset, *chunkData);
+                promise->set_value(chunkData);
+            }
+            catch(...)
+            {
+                promise->set_exception(std::current_exception());
+            }
+            
+            std::lock_guard<std::mutex> lock(this->inFlightMutex);
+            this->inFlightChunks.erase(key);
+        }
+        
+        return chunkFuture.get();
+    }
+    
+    std::future<void> KEAImageIO::writeImageBlock2BandAsync(uint32_t band, const void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeOut, uint64_t ySizeOut, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType)
+    {
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        if(!this->threadSafe)
+        {
+            throw KEAIOException("Asynchronous writes need thread safe mode, call setThreadSafe(true) first.");
+        }
+        if((xSizeBuf < xSizeOut) || (ySizeBuf < ySizeOut))
+        {
+            throw KEAIOException("The buffer is smaller than the block to be written.");
+        }
+        
+        KEAAsyncWriter *writer = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(this->asyncWriterMutex);
+            if(this->asyncWriter == nullptr)
+            {
+                this->asyncWriter = new KEAAsyncWriter(this, this->asyncWriteQueueSize);
+            }
+            writer = this->asyncWriter;
+        }
+        
+        return writer->submit(band, data, xPxlOff, yPxlOff, xSizeOut, ySizeOut, xSizeBuf, inDataType);
+    }
+    
+    void KEAImageIO::waitForAsyncWrites()
+    {
+        KEAAsyncWriter *writer = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(this->asyncWriterMutex);
+            writer = this->asyncWriter;
+        }
+        
+        if(writer != nullptr)
+        {
+            writer->wait();
+        }
+    }
+    
+    void KEAImageIO::setAsyncWriteQueueSize(uint64_t maxQueuedBytes)
+    {
+        std::lock_guard<std::mutex> lock(this->asyncWriterMutex);
+        this->asyncWriteQueueSize = maxQueuedBytes;
+        if(this->asyncWriter != nullptr)
+        {
+            this->asyncWriter->setMaxQueuedBytes(maxQueuedBytes);
+        }
+    }
+    
+    uint64_t KEAImageIO::getAsyncWriteQueueSize()
+    {
+        std::lock_guard<std::mutex> lock(this->asyncWriterMutex);
+        return this->asyncWriteQueueSize;
+    }
+    
+    std::exception_ptr KEAImageIO::stopAsyncWriter()
+    {
+        std::lock_guard<std::mutex> lock(this->asyncWriterMutex);
+        std::exception_ptr error;
+        if(this->asyncWriter != nullptr)
+        {
+            try
+            {
+                this->asyncWriter->wait();
+            }
+            catch(...)
+            {
+                error = std::current_exception();
+            }
+            delete this->asyncWriter;
+            this->asyncWriter = nullptr;
+        }
+        return error;
+    }
+    
+    void KEAImageIO::samplePoints(const std::vector<uint32_t> &bands, const uint64_t *xPxls, const uint64_t *yPxls, size_t numPoints, void *data, KEADataType inDataType, uint32_t numThreads)
+    {
+        KEATraceScope trace("KEAImageIO::samplePoints", KEA_TRACE_API);
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_pixels);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        if((bands.empty()) || (numPoints == 0))
+        {
+            return;
+        }
+        
+        try
+        {
+            // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
+            for(auto iterBand = bands.begin(); iterBand != bands.end(); ++iterBand)
+            {
+                if(*iterBand == 0)
+                {
+                    throw KEAIOException("KEA Image Bands start at 1.");
+                }
+                else if(*iterBand > this->numImgBands)
+                {
+                    throw KEAIOException("Band is not present within image.");
+                }
+            }
+            
+            for(size_t i = 0; i < numPoints; ++i)
+            {
+                if((xPxls[i] >= this->spatialInfoFile->xSize) || (yPxls[i] >= this->spatialInfoFile->ySize))
+                {
+                    throw KEAIOException("Point (" + ulong2Str(xPxls[i]) + ", " + ulong2Str(yPxls[i]) + ") is not within image.");
+                }
+            }
+            
+            size_t dtSize = getDataTypeSize(inDataType);
+            if(dtSize == 0)
+            {
+                throw KEAIOException("The specified data type was not recognised.");
+            }
+            
+            // OPEN THE BAND DATASETS AND FIND THEIR CHUNKING
+            std::vector<KEAChunkedDataset*> bandDatasets;
+            std::vector< std::pair<hsize_t, hsize_t> > bandChunks;
+            try
+            {
+                std::lock_guard<std::recursive_mutex> h5Lock(getH5Mutex());
+                for(auto iterBand = bands.begin(); iterBand != bands.end(); ++iterBand)
+                {
+                    std::string imageBandPath = KEA_DATASETNAME_BAND + uint2Str(*iterBand);
+                    KEAChunkedDataset *chunkedDataset = this->getChunkedDataset( imageBandPath + KEA_BANDNAME_DATA );
+                    bandDatasets.push_back(chunkedDataset);
+                    bandChunks.push_back(std::pair<hsize_t, hsize_t>(chunkedDataset->chunkDims[0], chunkedDataset->chunkDims[1]));
+                }
+            }
+            catch ( const H5::Exception &e)
+            {
+                throw KEAIOException("Could not read image data.");
+            }
+            
+            // GROUP THE POINTS BY CHUNK - BANDS USUALLY SHARE THE SAME CHUNKING
+            // SO THE ORDERING IS ONLY CALCULATED ONCE FOR EACH CHUNK SIZE.
+            std::map< std::pair<hsize_t, hsize_t>, std::vector<size_t> > pointOrders;
+            // band index, index of first point and number of points in chunk
+            struct KEASampleChunk
+            {
+                size_t bandIdx;
+                size_t start;
+                size_t end;
+            };
+            std::vector<KEASampleChunk> sampleChunks;
+            for(size_t b = 0; b < bands.size(); ++b)
+            {
+                hsize_t chunkY = bandChunks[b].first;
+                hsize_t chunkX = bandChunks[b].second;
+                std::vector<size_t> &order = pointOrders[bandChunks[b]];
+                if(order.empty())
+                {
+                    uint64_t numChunksX = (this->spatialInfoFile->xSize + chunkX - 1) / chunkX;
+                    std::vector<uint64_t> chunkIdx(numPoints);
+                    order.resize(numPoints);
+                    for(size_t i = 0; i < numPoints; ++i)
+                    {
+                        order[i] = i;
+                        chunkIdx[i] = ((yPxls[i] / chunkY) * numChunksX) + (xPxls[i] / chunkX);
+                    }
+                    std::stable_sort(order.begin(), order.end(), [&chunkIdx](size_t a, size_t b){ return chunkIdx[a] < chunkIdx[b]; });
+                }
+                
+                size_t start = 0;
+                while(start < numPoints)
+                {
+                    uint64_t chunkXIdx = xPxls[order[start]] / chunkX;
+                    uint64_t chunkYIdx = yPxls[order[start]] / chunkY;
+                    size_t end = start + 1;
+                    while((end < numPoints) && ((xPxls[order[end]] / chunkX) == chunkXIdx) && ((yPxls[order[end]] / chunkY) == chunkYIdx))
+                    {
+                        ++end;
+                    }
+                    KEASampleChunk sampleChunk;
+                    sampleChunk.bandIdx = b;
+                    sampleChunk.start = start;
+                    sampleChunk.end = end;
+                    sampleChunks.push_back(sampleChunk);
+                    start = end;
+                }
+            }
+            
+            // READ EACH CHUNK ONCE AND GATHER THE VALUES FOR ITS POINTS.
+            // ONLY FETCHING THE RAW CHUNK IS SERIALISED.
+            auto sampleChunkFunc = [&](size_t c)
+            {
+                const KEASampleChunk &sampleChunk = sampleChunks[c];
+                const std::vector<size_t> &order = pointOrders.at(bandChunks[sampleChunk.bandIdx]);
+                KEAChunkedDataset *chunkedDataset = bandDatasets[sampleChunk.bandIdx];
+                hsize_t chunkY = bandChunks[sampleChunk.bandIdx].first;
+                hsize_t chunkX = bandChunks[sampleChunk.bandIdx].second;
+                
+                hsize_t chunkOffset[2];
+                chunkOffset[0] = (yPxls[order[sampleChunk.start]] / chunkY) * chunkY;
+                chunkOffset[1] = (xPxls[order[sampleChunk.start]] / chunkX) * chunkX;
+                
+                std::vector<char> chunkData;
+                this->readChunk(chunkedDataset, chunkOffset, chunkData);
+                
+                char *outData = ((char*)data) + (sampleChunk.bandIdx * numPoints * dtSize);
+                for(size_t i = sampleChunk.start; i < sampleChunk.end; ++i)
+                {
+                    size_t pointIdx = order[i];
+                    size_t chunkPxl = ((yPxls[pointIdx] - chunkOffset[0]) * chunkX) + (xPxls[pointIdx] - chunkOffset[1]);
+                    keaConvertBlock(chunkData.data() + (chunkPxl * chunkedDataset->typeSize), chunkedDataset->dataType, 1, outData + (pointIdx * dtSize), inDataType, 1, 1, 1);
+                }
+            };
+            
+            // CHUNKS HDF5 DECODES ARE READ ONE AT A TIME UNDER THE HDF5 LOCK
+            // SO THREADS ONLY HELP WHEN A BAND IS READ DIRECTLY
+            bool anyDirectRead = false;
+            for(auto iterDataset = bandDatasets.begin(); iterDataset != bandDatasets.end(); ++iterDataset)
+            {
+                anyDirectRead = anyDirectRead || (*iterDataset)->directRead;
+            }
+            if(numThreads == 0)
+            {
+                numThreads = KEAThreadPool::getDefaultNumThreads();
+            }
+            if(!anyDirectRead || (numThreads <= 1) || (sampleChunks.size() <= 1))
+            {
+                for(size_t c = 0; c < sampleChunks.size(); ++c)
+                {
+                    sampleChunkFunc(c);
+                }
+            }
+            else
+            {
+                // THE CALLING THREAD TAKES CHUNKS TOO
+                std::shared_ptr<KEAThreadPool> threadPool;
+                {
+                    std::lock_guard<std::mutex> poolLock(this->samplePoolMutex);
+                    if((this->samplePool == nullptr) || (this->samplePool->getNumThreads() != (numThreads - 1)))
+                    {
+                        this->samplePool = std::make_shared<KEAThreadPool>(numThreads - 1);
+                    }
+                    threadPool = this->samplePool;
+                }
+                threadPool->parallelFor(sampleChunks.size(), sampleChunkFunc);
+            }
+        }
+        catch(const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch( const H5::Exception &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+    }
+    
+    KEAImageIO::KEAChunkedDataset* KEAImageIO::getChunkedDataset(const std::string &datasetPath)
+    {
+        auto iterDataset = this->chunkedDatasets.find(datasetPath);
+        if(iterDataset != this->chunkedDatasets.end())
+        {
+            return iterDataset->second;
+        }
+        
+        KEAChunkedDataset *chunkedDataset = new KEAChunkedDataset();
+        try
+        {
+            chunkedDataset->dataset = this->keaImgFile->openDataSet(datasetPath);
+            H5::DataSpace dataspace = chunkedDataset->dataset.getSpace();
+            if(dataspace.getSimpleExtentNdims() != 2)
+            {
+                throw KEAIOException("Image dataset '" + datasetPath + "' is not 2 dimensional.");
+            }
+            dataspace.getSimpleExtentDims(chunkedDataset->dims);
+            dataspace.close();
+            
+            // FIND THE TYPE OF THE VALUES IN THE FILE
+            H5::DataType fileDataType = chunkedDataset->dataset.getDataType();
+            hid_t fileTypeId = fileDataType.getId();
+            size_t fileTypeSize = H5Tget_size(fileTypeId);
+            chunkedDataset->dataType = kea_undefined;
+            if(H5Tget_class(fileTypeId) == H5T_INTEGER)
+            {
+                bool isSigned = (H5Tget_sign(fileTypeId) == H5T_SGN_2);
+                switch(fileTypeSize)
+                {
+                    case 1:
+                        chunkedDataset->dataType = isSigned ? kea_8int : kea_8uint; break;
+                    case 2:
+                        chunkedDataset->dataType = isSigned ? kea_16int : kea_16uint; break;
+                    case 4:
+                        chunkedDataset->dataType = isSigned ? kea_32int : kea_32uint; break;
+                    case 8:
+                        chunkedDataset->dataType = isSigned ? kea_64int : kea_64uint; break;
+                }
+            }
+            else if(H5Tget_class(fileTypeId) == H5T_FLOAT)
+            {
+                if(fileTypeSize == 4)
+                {
+                    chunkedDataset->dataType = kea_32float;
+                }
+                else if(fileTypeSize == 8)
+                {
+                    chunkedDataset->dataType = kea_64float;
+                }
+            }
+            if(chunkedDataset->dataType == kea_undefined)
+            {
+                throw KEAIOException("Image dataset '" + datasetPath + "' has an unsupported data type.");
+            }
+            chunkedDataset->typeSize = fileTypeSize;
+            
+            uint16_t endianTest = 1;
+            bool littleEndian = (*reinterpret_cast<uint8_t*>(&endianTest) == 1) && (H5Tget_order(fileTypeId) == H5T_ORDER_LE);
+            fileDataType.close();
+            
+            // FIND THE CHUNKING AND FILTERS
+            H5::DSetCreatPropList creationPList = chunkedDataset->dataset.getCreatePlist();
+            chunkedDataset->shuffleFilter = -1;
+            chunkedDataset->deflateFilter = -1;
+            if(creationPList.getLayout() == H5D_CHUNKED)
+            {
+                creationPList.getChunk(2, chunkedDataset->chunkDims);
+#ifdef KEA_DIRECT_CHUNK_READ
+                chunkedDataset->directRead = littleEndian;
+#else
+                chunkedDataset->directRead = false;
+#endif
+                int numFilters = H5Pget_nfilters(creationPList.getId());
+                for(int i = 0; i < numFilters; ++i)
+                {
+                    unsigned int flags = 0;
+                    size_t numValues = 0;
+                    H5Z_filter_t filter = H5Pget_filter2(creationPList.getId(), i, &flags, &numValues, NULL, 0, NULL, NULL);
+                    if(filter == H5Z_FILTER_SHUFFLE)
+                    {
+                        chunkedDataset->shuffleFilter = i;
+                    }
+                    else if(filter == H5Z_FILTER_DEFLATE)
+                    {
+                        chunkedDataset->deflateFilter = i;
+                    }
+                    else
+                    {
+                        chunkedDataset->directRead = false;
+                    }
+                }
+                // THE SHUFFLE HAS TO BE APPLIED BEFORE COMPRESSING
+                if((chunkedDataset->shuffleFilter >= 0) && (chunkedDataset->shuffleFilter > chunkedDataset->deflateFilter) && (chunkedDataset->deflateFilter >= 0))
+                {
+                    chunkedDataset->directRead = false;
+                }
+            }
+            else
+            {
+                // READ CONTIGUOUS DATASETS IN BLOCKS OF THE DEFAULT SIZE
+                chunkedDataset->chunkDims[0] = KEA_IMAGE_CHUNK_SIZE;
+                chunkedDataset->chunkDims[1] = KEA_IMAGE_CHUNK_SIZE;
+                chunkedDataset->directRead = false;
+            }
+            
+            chunkedDataset->fillValue.assign(fileTypeSize, 0);
+            H5::DataType nativeDataType = convertDatatypeKeaToH5Native(chunkedDataset->dataType);
+            if(creationPList.isFillValueDefined() != H5D_FILL_VALUE_UNDEFINED)
+            {
+                creationPList.getFillValue(nativeDataType, chunkedDataset->fillValue.data());
+            }
+            creationPList.close();
+        }
+        catch(...)
+        {
+            delete chunkedDataset;
+            throw;
+        }
+        
+        this->chunkedDatasets[datasetPath] = chunkedDataset;
+        return chunkedDataset;
+    }
+    
+    void KEAImageIO::clearChunkedDatasets()
+    {
+        std::lock_guard<std::recursive_mutex> h5Lock(getH5Mutex());
+        for(auto iterDataset = this->chunkedDatasets.begin(); iterDataset != this->chunkedDatasets.end(); ++iterDataset)
+        {
+            delete iterDataset->second;
+        }
+        this->chunkedDatasets.clear();
+    }
+    
+    void KEAImageIO::readChunk(KEAChunkedDataset *chunkedDataset, const hsize_t *chunkOffset, std::vector<char> &chunkData)
+    {
+        const hsize_t *chunkDims = chunkedDataset->chunkDims;
+        size_t numChunkVals = chunkDims[0] * chunkDims[1];
+        size_t numChunkBytes = numChunkVals * chunkedDataset->typeSize;
+        chunkData.resize(numChunkBytes);
+        
+        if(!chunkedDataset->directRead)
+        {
+            // LET HDF5 DECODE THE CHUNK
+            try
+            {
+                std::lock_guard<std::recursive_mutex> h5Lock(getH5Mutex());
+                KEATraceScope trace("H5Dread", KEA_TRACE_HDF5, numChunkBytes);
+                hsize_t readDims[2];
+                readDims[0] = std::min<hsize_t>(chunkDims[0], chunkedDataset->dims[0] - chunkOffset[0]);
+                readDims[1] = std::min<hsize_t>(chunkDims[1], chunkedDataset->dims[1] - chunkOffset[1]);
+                hsize_t memOffset[2] = {0, 0};
+                
+                H5::DataSpace fileDataspace = chunkedDataset->dataset.getSpace();
+                fileDataspace.selectHyperslab(H5S_SELECT_SET, readDims, chunkOffset);
+                H5::DataSpace memDataspace = H5::DataSpace(2, chunkDims);
+                memDataspace.selectHyperslab(H5S_SELECT_SET, readDims, memOffset);
+                chunkedDataset->dataset.read(chunkData.data(), convertDatatypeKeaToH5Native(chunkedDataset->dataType), memDataspace, fileDataspace);
+                memDataspace.close();
+                fileDataspace.close();
+            }
+            catch ( const H5::Exception &e)
+            {
+                throw KEAIOException("Could not read image data.");
+            }
+            return;
+        }
+        
+#ifdef KEA_DIRECT_CHUNK_READ
+        // FETCH THE RAW CHUNK
+        std::vector<char> rawData;
+        uint32_t filterMask = 0;
+        {
+            std::lock_guard<std::recursive_mutex> h5Lock(getH5Mutex());
+            hid_t datasetId = chunkedDataset->dataset.getId();
+            unsigned int chunkFilterMask = 0;
+            haddr_t chunkAddr = HADDR_UNDEF;
+            hsize_t chunkStorageSize = 0;
+            if(H5Dget_chunk_info_by_coord(datasetId, chunkOffset, &chunkFilterMask, &chunkAddr, &chunkStorageSize) < 0)
+            {
+                throw KEAIOException("Could not read image data.");
+            }
+            
+            if((chunkAddr == HADDR_UNDEF) || (chunkStorageSize == 0))
+            {
+                // CHUNK HAS NEVER BEEN WRITTEN
+                for(size_t i = 0; i < numChunkVals; ++i)
+                {
+                    memcpy(chunkData.data() + (i * chunkedDataset->typeSize), chunkedDataset->fillValue.data(), chunkedDataset->typeSize);
+                }
+                return;
+            }
+            
+            KEATraceScope trace("H5Dread_chunk", KEA_TRACE_HDF5, chunkStorageSize);
+            rawData.resize(chunkStorageSize);
+            if(H5Dread_chunk(datasetId, H5P_DEFAULT, chunkOffset, &filterMask, rawData.data()) < 0)
+            {
+                throw KEAIOException("Could not read image data.");
+            }
+        }
+        
+        // DECODE IT - A SET BIT IN THE MASK MEANS THE FILTER WAS SKIPPED
+        if((chunkedDataset->deflateFilter >= 0) && !(filterMask & (1u << chunkedDataset->deflateFilter)))
+        {
+            KEATraceScope trace("inflate", KEA_TRACE_CODEC, numChunkBytes);
+            uLongf decodedSize = numChunkBytes;
+            int zStatus = uncompress(reinterpret_cast<Bytef*>(chunkData.data()), &decodedSize, reinterpret_cast<const Bytef*>(rawData.data()), rawData.size());
+            if((zStatus != Z_OK) || (decodedSize != numChunkBytes))
+            {
+                throw KEAIOException("Could not decompress image chunk.");
+            }
+        }
+        else if(rawData.size() == numChunkBytes)
+        {
+            chunkData.swap(rawData);
+        }
+        else
+        {
+            throw KEAIOException("Image chunk is not the expected size.");
+        }
+        
+        size_t typeSize = chunkedDataset->typeSize;
+        if((chunkedDataset->shuffleFilter >= 0) && (typeSize > 1) && !(filterMask & (1u << chunkedDataset->shuffleFilter)))
+        {
+            // THE SHUFFLE STORES BYTE b OF EACH VALUE TOGETHER
+            rawData.resize(numChunkBytes);
+            for(size_t b = 0; b < typeSize; ++b)
+            {
+                const char *inBytes = chunkData.data() + (b * numChunkVals);
+                char *outBytes = rawData.data() + b;
+                for(size_t i = 0; i < numChunkVals; ++i)
+                {
+                    outBytes[i * typeSize] = inBytes[i];
+                }
+            }
+            chunkData.swap(rawData);
+        }
+#endif
+    }
+    
+    void KEAImageIO::readChunkedDataset(const std::string &datasetPath, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType)
+    {
+        size_t outTypeSize = getDataTypeSize(inDataType);
+        if(outTypeSize == 0)
+        {
+            throw KEAIOException("The specified data type was not recognised.");
+        }
+        
+        this->readChunkedDataset(datasetPath, data, xPxlOff, yPxlOff, xSizeIn, ySizeIn, xSizeBuf, ySizeBuf, outTypeSize, [inDataType](const char *in, KEADataType inType, size_t inStride, char *out, size_t outStride, size_t numRows, size_t numCols)
+        {
+            keaConvertBlock(in, inType, inStride, out, inDataType, outStride, numRows, numCols);
+        });
+    }
+    
+    void KEAImageIO::readChunkedDataset(const std::string &datasetPath, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, size_t outTypeSize, const std::function<void(const char *in, KEADataType inType, size_t inStride, char *out, size_t outStride, size_t numRows, size_t numCols)> &copyBlock)
+    {
+        // ROWS ARE xSizeBuf APART SO THE WHOLE BLOCK HAS TO FIT
+        if((xSizeBuf < xSizeIn) || (ySizeBuf < ySizeIn))
+        {
+            throw KEAIOException("The buffer is smaller than the block to be read.");
+        }
+        
+        KEAChunkedDataset *chunkedDataset = nullptr;
+        try
+        {
+            std::lock_guard<std::recursive_mutex> h5Lock(getH5Mutex());
+            chunkedDataset = this->getChunkedDataset(datasetPath);
+        }
+        catch ( const H5::Exception &e)
+        {
+            throw KEAIOException("Could not read image data.");
+        }
+        
+        if(((xPxlOff + xSizeIn) > chunkedDataset->dims[1]) || ((yPxlOff + ySizeIn) > chunkedDataset->dims[0]))
+        {
+            throw KEAIOException("Could not read image data.");
+        }
+        
+        const hsize_t *chunkDims = chunkedDataset->chunkDims;
+        uint64_t endXPxl = xPxlOff + xSizeIn;
+        uint64_t endYPxl = yPxlOff + ySizeIn;
+        hsize_t chunkOffset[2];
+        for(chunkOffset[0] = (yPxlOff / chunkDims[0]) * chunkDims[0]; chunkOffset[0] < endYPxl; chunkOffset[0] += chunkDims[0])
+        {
+            for(chunkOffset[1] = (xPxlOff / chunkDims[1]) * chunkDims[1]; chunkOffset[1] < endXPxl; chunkOffset[1] += chunkDims[1])
+            {
+                std::shared_ptr< const std::vector<char> > chunkData = this->readChunkShared(chunkedDataset, chunkOffset);
+                
+                // COPY THE PART OF THE CHUNK WITHIN THE BLOCK
+                uint64_t startY = std::max<uint64_t>(chunkOffset[0], yPxlOff);
+                uint64_t endY = std::min<uint64_t>(chunkOffset[0] + chunkDims[0], endYPxl);
+                uint64_t startX = std::max<uint64_t>(chunkOffset[1], xPxlOff);
+                uint64_t endX = std::min<uint64_t>(chunkOffset[1] + chunkDims[1], endXPxl);
+                
+                const char *inData = chunkData->data() + ((((startY - chunkOffset[0]) * chunkDims[1]) + (startX - chunkOffset[1])) * chunkedDataset->typeSize);
+                char *outData = ((char*)data) + ((((startY - yPxlOff) * xSizeBuf) + (startX - xPxlOff)) * outTypeSize);
+                copyBlock(inData, chunkedDataset->dataType, chunkDims[1], outData, xSizeBuf, endY - startY, endX - startX);
+            }
+        }
+    }
+    
+    void KEAImageIO::createMask(uint32_t band, uint32_t deflate)
+    {
+        KEATraceScope trace("KEAImageIO::createMask", KEA_TRACE_API);
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        if(!this->maskCreated(band))
+        {
+            uint32_t blockSize2Use = getImageBlockSize(band);
+            int initFillVal = 255;
+            hsize_t dimsImageBandChunk[] = { blockSize2Use, blockSize2Use };
+            H5::DSetCreatPropList initParamsImgBand;
+            initParamsImgBand.setChunk(2, dimsImageBandChunk);
+            initParamsImgBand.setShuffle();
+            initParamsImgBand.setDeflate(deflate);
+            initParamsImgBand.setFillValue( H5::PredType::NATIVE_INT, &initFillVal);
+            
+            H5::StrType strdatatypeLen6(H5::PredType::C_S1, 6);
+            H5::StrType strdatatypeLen4(H5::PredType::C_S1, 4);
+            const H5std_string strClassVal ("IMAGE");
+            const H5std_string strImgVerVal ("1.2");
+            H5::DataSpace attr_dataspace = H5::DataSpace(H5S_SCALAR);
+            
+            std::string imageBandPath = KEA_DATASETNAME_BAND + uint2Str(band);
+            
+            // THE MASK MUST BE ABLE TO GROW WITH THE BAND
+            H5::DataSet bandDataSet = this->keaImgFile->openDataSet(imageBandPath + KEA_BANDNAME_DATA);
+            KEAImageExtend extend = getDatasetExtend(bandDataSet);
+            bandDataSet.close();
+            
+            hsize_t imageBandDims[] = { spatialInfoFile->ySize, spatialInfoFile->xSize };
+            hsize_t imageBandMaxDims[2];
+            getExtendMaxDims(extend, imageBandDims, imageBandMaxDims);
+            H5::DataSpace imgBandDataSpace(2, imageBandDims, imageBandMaxDims);
+            H5::DataSet imgBandDataSet = this->keaImgFile->createDataSet((imageBandPath+KEA_BANDNAME_MASK), H5::PredType::STD_U8LE, imgBandDataSpace, initParamsImgBand);
+            H5::Attribute classAttribute = imgBandDataSet.createAttribute(KEA_ATTRIBUTENAME_CLASS, strdatatypeLen6, attr_dataspace);
+            classAttribute.write(strdatatypeLen6, strClassVal);
+            classAttribute.close();
+            
+            H5::Attribute imgVerAttribute = imgBandDataSet.createAttribute(KEA_ATTRIBUTENAME_IMAGE_VERSION, strdatatypeLen4, attr_dataspace);
+            imgVerAttribute.write(strdatatypeLen4, strImgVerVal);
+            imgVerAttribute.close();
+            
+            imgBandDataSet.close();
+            imgBandDataSpace.close();
+        }
+    }
+    
+    void KEAImageIO::writeImageBlock2BandMask(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeOut, uint64_t ySizeOut, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType)
+    {
+        KEATraceScope trace("KEAImageIO::writeImageBlock2BandMask", KEA_TRACE_API, xSizeOut * ySizeOut * getDataTypeSize(inDataType));
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        try
+        {
+            // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
+            if(band == 0)
+            {
+                throw KEAIOException("KEA Image Bands start at 1.");
+            }
+            else if(band > this->numImgBands)
+            {
+                throw KEAIOException("Band is not present within image.");
+            }
+            
+            uint64_t endXPxl = xPxlOff + xSizeOut;
+            uint64_t endYPxl = yPxlOff + ySizeOut;
+            
+            if(xPxlOff > this->spatialInfoFile->xSize)
+            {
+                throw KEAIOException("Start X Pixel is not within image.");
+            }
+            
+            if(endXPxl > this->spatialInfoFile->xSize)
+            {
+                throw KEAIOException("End X Pixel is not within image.");
+            }
+            
+            if(yPxlOff > this->spatialInfoFile->ySize)
+            {
+                throw KEAIOException("Start Y Pixel is not within image.");
+            }
+            
+            if(endYPxl > this->spatialInfoFile->ySize)
+            {
+                throw KEAIOException("End Y Pixel is not within image.");
+            }
+            
+            // GET NATIVE DATASET
+            H5::DataType imgBandDT = convertDatatypeKeaToH5Native(inDataType);
+            
+            // OPEN BAND DATASET AND WRITE IMAGE DATA
+            try
+            {
+                std::string imageBandPath = KEA_DATASETNAME_BAND + uint2Str(band);
+                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( imageBandPath + KEA_BANDNAME_MASK );
+                H5::DataSpace imgBandDataspace = imgBandDataset.getSpace();
+                
+                hsize_t imgOffset[2];
+                imgOffset[0] = yPxlOff;
+                imgOffset[1] = xPxlOff;
+                hsize_t dataDims[2];
+                dataDims[0] = ySizeBuf;
+                dataDims[1] = xSizeBuf;
+                H5::DataSpace write2BandDataspace = H5::DataSpace(2, dataDims);
+                
+                if((ySizeOut != ySizeBuf) | (xSizeOut != xSizeBuf))
+                {
+                    hsize_t dataSelectMemDims[2];
+                    dataSelectMemDims[0] = ySizeOut;
+                    dataSelectMemDims[1] = 1;
+                    
+                    hsize_t dataOffDims[2];
+                    dataOffDims[0] = 0;
+                    dataOffDims[1] = 0;
+                    
+                    hsize_t dataSelectStrideDims[2];
+                    dataSelectStrideDims[0] = 1;
+                    if(xSizeBuf == xSizeOut)
+                    {
+                        dataSelectStrideDims[1] = 1;
+                    }
+                    else
+                    {
+                        dataSelectStrideDims[1] = xSizeBuf - xSizeOut;
+                    }
+                    
+                    hsize_t dataSelectBlockSizeDims[2];
+                    dataSelectBlockSizeDims[0] = 1;
+                    dataSelectBlockSizeDims[1] = xSizeOut;
+                    write2BandDataspace.selectHyperslab(H5S_SELECT_SET, dataSelectMemDims, dataOffDims, dataSelectStrideDims, dataSelectBlockSizeDims);
+                    
+                    hsize_t dataOutDims[2];
+                    dataOutDims[0] = ySizeOut;
+                    dataOutDims[1] = xSizeOut;
+                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataOutDims, imgOffset);
+                }
+                else
+                {
+                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataDims, imgOffset);
+                }
+                
+                {
+                    KEATraceScope h5Trace("H5Dwrite", KEA_TRACE_HDF5, xSizeOut * ySizeOut * getDataTypeSize(inDataType));
+                    imgBandDataset.write( data, imgBandDT, write2BandDataspace, imgBandDataspace);
+                }
+                
+                imgBandDataset.close();
+                imgBandDataspace.close();
+                write2BandDataspace.close();
+                
+                keaFlushFile(this->keaImgFile);
+            }
+            catch ( const H5::Exception &e)
+            {
+                throw KEAIOException("Could not write image data.");
+            }
+        }
+        catch(const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch( const H5::FileIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataSetIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataSpaceIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataTypeIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+    }
+    
+    void KEAImageIO::readImageBlock2BandMask(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType)
+    {
+        KEATraceScope trace("KEAImageIO::readImageBlock2BandMask", KEA_TRACE_API, xSizeIn * ySizeIn * getDataTypeSize(inDataType));
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_pixels);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        try
+        {
+            // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
+            if(band == 0)
+            {
+                throw KEAIOException("KEA Image Bands start at 1.");
+            }
+            else if(band > this->numImgBands)
+            {
+                throw KEAIOException("Band is not present within image.");
+            }
+            
+            uint64_t endXPxl = xPxlOff + xSizeIn;
+            uint64_t endYPxl = yPxlOff + ySizeIn;
+            
+            if(xPxlOff > this->spatialInfoFile->xSize)
+            {
+                throw KEAIOException("Start X Pixel is not within image.");
+            }
+            
+            if(endXPxl > this->spatialInfoFile->xSize)
+            {
+                throw KEAIOException("End X Pixel is not within image.");
+            }
+            
+            if(yPxlOff > this->spatialInfoFile->ySize)
+            {
+                throw KEAIOException("Start Y Pixel is not within image.");
+            }
+            
+            if(endYPxl > this->spatialInfoFile->ySize)
+            {
+                throw KEAIOException("End Y Pixel is not within image.");
+            }
+            
+            if(this->threadSafe)
+            {
+                this->readChunkedDataset(KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_MASK, data, xPxlOff, yPxlOff, xSizeIn, ySizeIn, xSizeBuf, ySizeBuf, inDataType);
+                return;
+            }
+            
+            // GET NATIVE DATASET
+            H5::DataType imgBandDT = convertDatatypeKeaToH5Native(inDataType);
+            
+            // OPEN BAND DATASET AND READ IMAGE DATA
+            try
+            {
+                std::string imageBandPath = KEA_DATASETNAME_BAND + uint2Str(band);
+                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( imageBandPath + KEA_BANDNAME_MASK );
+                H5::DataSpace imgBandDataspace = imgBandDataset.getSpace();
+                
+                hsize_t dataOffset[2];
+                dataOffset[0] = yPxlOff;
+                dataOffset[1] = xPxlOff;
+                hsize_t dataDims[2];
+                dataDims[0] = ySizeBuf;
+                dataDims[1] = xSizeBuf;
+                H5::DataSpace read2BandDataspace = H5::DataSpace(2, dataDims);
+                
+                if((ySizeBuf != ySizeIn) | (xSizeBuf != xSizeIn))
+                {
+                    hsize_t dataSelectMemDims[2];
+                    dataSelectMemDims[0] = ySizeIn;
+                    dataSelectMemDims[1] = 1;
+                    
+                    hsize_t dataOffDims[2];
+                    dataOffDims[0] = 0;
+                    dataOffDims[1] = 0;
+                    
+                    hsize_t dataSelectStrideDims[2];
+                    dataSelectStrideDims[0] = 1;
+                    if(xSizeBuf == xSizeIn)
+                    {
+                        dataSelectStrideDims[1] = 1;
+                    }
+                    else
+                    {
+                        dataSelectStrideDims[1] = xSizeBuf - xSizeIn;
+                    }
+                    
+                    hsize_t dataSelectBlockSizeDims[2];
+                    dataSelectBlockSizeDims[0] = 1;
+                    dataSelectBlockSizeDims[1] = xSizeIn;
+                    read2BandDataspace.selectHyperslab(H5S_SELECT_SET, dataSelectMemDims, dataOffDims, dataSelectStrideDims, dataSelectBlockSizeDims);
+                    
+                    hsize_t dataInDims[2];
+                    dataInDims[0] = ySizeIn;
+                    dataInDims[1] = xSizeIn;
+                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataInDims, dataOffset);
+                }
+                else
+                {
+                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataDims, dataOffset);
+                }
+                
+                {
+                    KEATraceScope h5Trace("H5Dread", KEA_TRACE_HDF5, xSizeIn * ySizeIn * getDataTypeSize(inDataType));
+                    imgBandDataset.read( data, imgBandDT, read2BandDataspace, imgBandDataspace);
+                }
+                
+                imgBandDataset.close();
+                imgBandDataspace.close();
+                read2BandDataspace.close();
+            }
+            catch ( const H5::Exception &e)
+            {
+                throw KEAIOException("Could not read image data.");
+            }
+        }
+        catch(const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch( const H5::FileIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataSetIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataSpaceIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataTypeIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
 		}
         catch ( const std::exception &e)
         {
             throw KEAIOException(e.what());
         }
     }
-  
+    
+    bool KEAImageIO::maskCreated(uint32_t band)
+    {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
+        if(band == 0)
+        {
+            throw KEAIOException("KEA Image Bands start at 1.");
+        }
+        else if(band > this->numImgBands)
+        {
+            throw KEAIOException("Band is not present within image.");
+        }
+        
+        bool maskPresent = false;
+        std::string imageBandPath = KEA_DATASETNAME_BAND + uint2Str(band);
+        try
+        {
+            H5::Group imgBandGrp = this->keaImgFile->openGroup(imageBandPath);
+            hsize_t numItems = imgBandGrp.getNumObjs();
+            for(hsize_t i = 0; i < numItems; ++i)
+            {
+                //std::cout << "Item: " << imgBandGrp.getObjnameByIdx(i) << std::endl;
+                if(imgBandGrp.getObjnameByIdx(i) == "MASK")
+                {
+                    maskPresent = true;
+                    break;
+                }
+            }
+            imgBandGrp.close();
+            //H5::DataSet imgBandDataset = this->keaImgFile->openDataSet(imageBandPath+KEA_BANDNAME_MASK);
+            //imgBandDataset.close();
+            
+        }
+        catch (const H5::Exception &e)
+        {
+            maskPresent = false;
+        }
+        
+        return maskPresent;
+    }
+    
+    
+    void KEAImageIO::setImageMetaData(const std::string &name, const std::string &value)
+    {
+        KEATraceScope trace("KEAImageIO::setImageMetaData", KEA_TRACE_API);
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        // FORM META-DATA PATH WITHIN THE H5 FILE 
+        std::string metaDataH5Path = KEA_DATASETNAME_METADATA + std::string("/") + name;
+        
+        // WRITE IMAGE META DATA
+        try 
+        {
+            // OPEN DATASET OR CREATE NEW DATASET IF IT DOES NOT EXIST
+            H5::StrType strTypeAll(0, H5T_VARIABLE);
+            H5::DataSet datasetMetaData;
+            try 
+            {
+                datasetMetaData = this->keaImgFile->openDataSet( metaDataH5Path );
+            }
+            catch (const H5::Exception &e)
+            {
+                hsize_t	dimsForStr[1];
+                dimsForStr[0] = 1; // number of lines;
+                H5::DataSpace dataspaceStrAll(1, dimsForStr);
+                datasetMetaData = this->keaImgFile->createDataSet(metaDataH5Path, strTypeAll, dataspaceStrAll);
+
+            }
+            // WRITE DATA INTO THE DATASET
+            const char *wStrdata[1];
+            wStrdata[0] = value.c_str();			
+            datasetMetaData.write((void*)wStrdata, strTypeAll);
+            datasetMetaData.close();
+            
+            keaFlushFile(this->keaImgFile);
+        }
+        catch (const H5::Exception &e) 
+        {
+            throw KEAIOException("Could not set image meta-data.");
+        }
+        catch ( const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+    }
+    
+    std::string KEAImageIO::getImageMetaData(const std::string &name)
+    {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        std::string metaDataH5Path = KEA_DATASETNAME_METADATA + std::string("/") + name;
+        std::string value = "";
+        // READ IMAGE META-DATA
+        try 
+        {
+            H5::DataSet datasetMetaData = this->keaImgFile->openDataSet( metaDataH5Path );
+            H5::DataType strDataType = datasetMetaData.getDataType();
+            value = readString(datasetMetaData, strDataType);
+            datasetMetaData.close();
+        } 
+        catch ( const H5::Exception &e) 
+        {
+            throw KEAIOException("Meta-data variable was not accessable.");
+        }
+        catch ( const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+        
+        return value;
+    }
+    
+    std::vector<std::string> KEAImageIO::getImageMetaDataNames()
+    {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        std::vector<std::string> metaDataNames;
+        
+        try 
+        {
+            // Try to open dataset with overviewName
+            H5::Group imgBandMetaDataGrp = this->keaImgFile->openGroup(KEA_DATASETNAME_METADATA);
+            hsize_t numMetaDataItems = imgBandMetaDataGrp.getNumObjs();
+            
+            for(hsize_t i = 0; i < numMetaDataItems; ++i)
+            {
+                metaDataNames.push_back(imgBandMetaDataGrp.getObjnameByIdx(i));
+            }
+        }
+        catch (const H5::Exception &e)
+        {
+            throw KEAIOException("Could not retrieve image meta data.");
+        }
+        catch ( const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+        
+        return metaDataNames;
+    }
+    
+    std::vector< std::pair<std::string, std::string> > KEAImageIO::getImageMetaData()
+    {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        std::vector< std::pair<std::string, std::string> > metaData;
+        
+        try 
+        {
+            // Try to open dataset with overviewName
+            H5::Group imgBandMetaDataGrp = this->keaImgFile->openGroup(KEA_DATASETNAME_METADATA);
+            hsize_t numMetaDataItems = imgBandMetaDataGrp.getNumObjs();
+            std::string name = "";
+            std::string value = "";
+            
+            for(hsize_t i = 0; i < numMetaDataItems; ++i)
+            {
+                name = imgBandMetaDataGrp.getObjnameByIdx(i);
+                value = this->getImageMetaData(name);
+                metaData.push_back(std::pair<std::string, std::string>(name,value));
+            }
+        }
+        catch (const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch (const H5::Exception &e)
+        {
+            throw KEAIOException("Could not retrieve image meta data.");
+        }
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+        
+        return metaData;
+    }
+    
+    void KEAImageIO::setImageMetaData(const std::vector< std::pair<std::string, std::string> > &data)
+    {
+        KEATraceScope trace("KEAImageIO::setImageMetaData", KEA_TRACE_API);
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        try 
+        {
+            for(auto iterMetaData = data.begin(); iterMetaData != data.end(); ++iterMetaData)
+            {
+                this->setImageMetaData(iterMetaData->first, iterMetaData->second);
+            }
+            
+            keaFlushFile(this->keaImgFile);
+        }
+        catch (const H5::Exception &e)
+        {
+            throw KEAIOException("Could not set image band meta data.");
+        }
+        catch ( const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+    }
+    
+    void KEAImageIO::setImageBandMetaData(uint32_t band, const std::string &name, const std::string &value)
+    {
+        KEATraceScope trace("KEAImageIO::setImageBandMetaData", KEA_TRACE_API);
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        // FORM META-DATA PATH WITHIN THE H5 FILE 
+        std::string metaDataH5Path = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_METADATA + std::string("/") + name;
+        
+        // WRITE IMAGE BAND META DATA
+        try 
+        {
+            // OPEN DATASET OR CREATE NEW DATASET IF IT DOES NOT EXIST
+            H5::StrType strTypeAll(0, H5T_VARIABLE);
+            H5::DataSet datasetMetaData;
+            try 
+            {
+                datasetMetaData = this->keaImgFile->openDataSet( metaDataH5Path );
+            }
+            catch (const H5::Exception &e)
+            {
+                hsize_t	dimsForStr[1];
+                dimsForStr[0] = 1; // number of lines;
+                H5::DataSpace dataspaceStrAll(1, dimsForStr);
+                datasetMetaData = this->keaImgFile->createDataSet(metaDataH5Path, strTypeAll, dataspaceStrAll);
+                
+            }
+            // WRITE DATA INTO THE DATASET
+            const char *wStrdata[1];
+            wStrdata[0] = value.c_str();			
+            datasetMetaData.write((void*)wStrdata, strTypeAll);
+            datasetMetaData.close();
+            
+            keaFlushFile(this->keaImgFile);
+        }
+        catch (const H5::Exception &e) 
+        {
+            throw KEAIOException("Could not set image band meta-data.");
+        }
+        catch ( const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+    }
+    
+    std::string KEAImageIO::getImageBandMetaData(uint32_t band, const std::string &name)
+    {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        std::string metaDataH5Path = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_METADATA + std::string("/") + name;
+        std::string value = "";
+        // READ IMAGE BAND META-DATA
+        try 
+        {
+            H5::DataSet datasetMetaData = this->keaImgFile->openDataSet( metaDataH5Path );
+            H5::DataType strDataType = datasetMetaData.getDataType();
+            value = readString(datasetMetaData, strDataType);
+            datasetMetaData.close();
+        } 
+        catch ( const H5::Exception &e) 
+        {
+            throw KEAIOException("Meta-data variable was not accessable.");
+        }
+        catch ( const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+        
+        return value;
+    }
+    
+    std::vector<std::string> KEAImageIO::getImageBandMetaDataNames(uint32_t band)
+    {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        std::vector<std::string> metaDataNames;
+        
+        std::string metaDataGroupName = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_METADATA;
+        try 
+        {
+            // Try to open dataset with overviewName
+            H5::Group imgBandMetaDataGrp = this->keaImgFile->openGroup(metaDataGroupName);
+            hsize_t numMetaDataItems = imgBandMetaDataGrp.getNumObjs();
+            
+            for(hsize_t i = 0; i < numMetaDataItems; ++i)
+            {
+                metaDataNames.push_back(imgBandMetaDataGrp.getObjnameByIdx(i));
+            }
+        }
+        catch (const H5::Exception &e)
+        {
+            throw KEAIOException("Could not retrieve image band meta data.");
+        }
+        catch ( const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+        
+        return metaDataNames;
+    }
+    
+    std::vector< std::pair<std::string, std::string> > KEAImageIO::getImageBandMetaData(uint32_t band)
+    {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        std::vector< std::pair<std::string, std::string> > metaData;
+        
+        std::string metaDataGroupName = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_METADATA;
+        try 
+        {
+            // Try to open dataset with overviewName
+            H5::Group imgBandMetaDataGrp = this->keaImgFile->openGroup(metaDataGroupName);
+            hsize_t numMetaDataItems = imgBandMetaDataGrp.getNumObjs();
+            std::string name = "";
+            std::string value = "";
+            
+            for(hsize_t i = 0; i < numMetaDataItems; ++i)
+            {
+                name = imgBandMetaDataGrp.getObjnameByIdx(i);
+                value = this->getImageBandMetaData(band, name);
+                metaData.push_back(std::pair<std::string, std::string>(name,value));
+            }
+        }
+        catch (const H5::Exception &e)
+        {
+            throw KEAIOException("Could not retrieve image band meta data.");
+        }
+        catch ( const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+        
+        return metaData;
+    }
+    
+    void KEAImageIO::setImageBandMetaData(uint32_t band, const std::vector< std::pair<std::string, std::string> > &data)
+    {
+        KEATraceScope trace("KEAImageIO::setImageBandMetaData", KEA_TRACE_API);
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        try 
+        {
+            for(auto iterMetaData = data.begin(); iterMetaData != data.end(); ++iterMetaData)
+            {
+                this->setImageBandMetaData(band, iterMetaData->first, iterMetaData->second);
+            }
+            
+            keaFlushFile(this->keaImgFile);
+        }
+        catch (const H5::Exception &e)
+        {
+            throw KEAIOException("Could not set image band meta data.");
+        }
+        catch ( const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+    }
+    
+    void KEAImageIO::setImageBandDescription(uint32_t band, const std::string &description)
+    {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        std::string bandName = KEA_DATASETNAME_BAND + uint2Str(band);
+        
+        // WRITE IMAGE BAND DESCRIPTION
+        try 
+        {
+            this->beginHeaderChange();
+            H5::StrType strTypeAll(0, H5T_VARIABLE);
+            H5::DataSet datasetBandDescription = this->keaImgFile->openDataSet( bandName+KEA_BANDNAME_DESCRIP );
+            const char *wStrdata[1];
+            wStrdata[0] = description.c_str();			
+            datasetBandDescription.write((void*)wStrdata, strTypeAll);
+            datasetBandDescription.close();
+            this->updateConsolidatedHeader(band);
+            keaFlushFile(this->keaImgFile);
+        }
+        catch (const H5::Exception &e) 
+        {
+            throw KEAIOException("Could not set image band description.");
+        }
+        catch ( const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+    }
+    
+    std::string KEAImageIO::getImageBandDescription(uint32_t band)
+    {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        const KEABandHeader *bandHeader = this->getBandHeader(band);
+        if(bandHeader != nullptr)
+        {
+            return bandHeader->description;
+        }
+        
+        std::string bandName = KEA_DATASETNAME_BAND + uint2Str(band) + std::string("/") + KEA_BANDNAME_DESCRIP;
+        std::string description = "";
+        // READ IMAGE BAND DESCRIPTION
+        try 
+        {
+            H5::DataSet datasetBandDescription = this->keaImgFile->openDataSet( bandName );
+            H5::DataType strDataType = datasetBandDescription.getDataType();
+            description = readString(datasetBandDescription, strDataType);
+            datasetBandDescription.close();
+        } 
+        catch ( const H5::Exception &e) 
+        {
+            throw KEAIOException("Could not read band description.");
+        }
+        catch ( const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+        
+        return description;
+    }
     
     
-    void KEAImageIO::createMask(uint32_t band, uint32_t deflate)
+    
+    void KEAImageIO::setNoDataValue(uint32_t band, const void *data, KEADataType inDataType)
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        if(!this->maskCreated(band))
-        {
-            uint32_t blockSize2Use = getImageBlockSize(band);
-            int initFillVal = 255;
-            hsize_t dimsImageBandChunk[] = { blockSize2Use, blockSize2Use };
-            H5::DSetCreatPropList initParamsImgBand;
-            initParamsImgBand.setChunk(2, dimsImageBandChunk);
-            initParamsImgBand.setShuffle();
-            initParamsImgBand.setDeflate(deflate);
-            initParamsImgBand.setFillValue( H5::PredType::NATIVE_INT, &initFillVal);
+        // READ IMAGE DATA TYPE
+        try 
+        {    
+            this->beginHeaderChange();
+            std::string noDataValPath = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_NO_DATA_VAL;
+            H5::DataSet datasetImgNDV;
+            H5::Attribute noDataDefAttribute;
             
-            H5::StrType strdatatypeLen6(H5::PredType::C_S1, 6);
-            H5::StrType strdatatypeLen4(H5::PredType::C_S1, 4);
-            const H5std_string strClassVal ("IMAGE");
-            const H5std_string strImgVerVal ("1.2");
-            H5::DataSpace attr_dataspace = H5::DataSpace(H5S_SCALAR);
+            try 
+            {
+                datasetImgNDV = this->keaImgFile->openDataSet( noDataValPath );
+            }
+            catch (const H5::Exception &e)
+            {
+                hsize_t	dimsForNDV[1];
+                dimsForNDV[0] = 1; // number of lines;
+                H5::DataSpace dataspaceNDV(1, dimsForNDV);
+                
+                KEADataType imgDataType = this->getImageBandDataType(band);
+                H5::DataType imgBandDT = convertDatatypeKeaToH5STD(imgDataType);
+
+                datasetImgNDV = this->keaImgFile->createDataSet(noDataValPath, imgBandDT, dataspaceNDV);
+            }
             
-            std::string imageBandPath = KEA_DATASETNAME_BAND + uint2Str(band);
-            hsize_t imageBandDims[] = { spatialInfoFile->ySize, spatialInfoFile->xSize };
-            H5::DataSpace imgBandDataSpace(2, imageBandDims);
-            H5::DataSet imgBandDataSet = this->keaImgFile->createDataSet((imageBandPath+KEA_BANDNAME_MASK), H5::PredType::STD_U8LE, imgBandDataSpace, initParamsImgBand);
-            H5::Attribute classAttribute = imgBandDataSet.createAttribute(KEA_ATTRIBUTENAME_CLASS, strdatatypeLen6, attr_dataspace);
-            classAttribute.write(strdatatypeLen6, strClassVal);
-            classAttribute.close();
+            try
+            {
+                noDataDefAttribute = datasetImgNDV.openAttribute(KEA_NODATA_DEFINED);
+            }
+            catch (const H5::Exception &e)
+            {
+                H5::DataSpace attr_dataspace = H5::DataSpace(H5S_SCALAR);
+                noDataDefAttribute = datasetImgNDV.createAttribute(KEA_NODATA_DEFINED, H5::PredType::STD_I8LE, attr_dataspace);
+            }
             
-            H5::Attribute imgVerAttribute = imgBandDataSet.createAttribute(KEA_ATTRIBUTENAME_IMAGE_VERSION, strdatatypeLen4, attr_dataspace);
-            imgVerAttribute.write(strdatatypeLen4, strImgVerVal);
-            imgVerAttribute.close();
+            int val = 1;
+            noDataDefAttribute.write(H5::PredType::NATIVE_INT, &val);
+            noDataDefAttribute.close();
             
-            imgBandDataSet.close();
-            imgBandDataSpace.close();
+            H5::DataType dataDT = convertDatatypeKeaToH5Native(inDataType);
+            datasetImgNDV.write( data, dataDT );
+            datasetImgNDV.close();
+            this->updateConsolidatedHeader(band);
+            keaFlushFile(this->keaImgFile);
+        } 
+        catch ( const H5::Exception &e) 
+        {
+            throw KEAIOException("The image data type was not specified.");
+        }
+        catch ( const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
         }
     }
     
-    void KEAImageIO::writeImageBlock2BandMask(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeOut, uint64_t ySizeOut, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType)
+    void KEAImageIO::getNoDataValue(uint32_t band, void *data, KEADataType inDataType)
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        try
+        
+        const KEABandHeader *bandHeader = this->getBandHeader(band);
+        if(bandHeader != nullptr)
         {
-            // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
-            if(band == 0)
-            {
-                throw KEAIOException("KEA Image Bands start at 1.");
-            }
-            else if(band > this->numImgBands)
-            {
-                throw KEAIOException("Band is not present within image.");
-            }
-            
-            uint64_t endXPxl = xPxlOff + xSizeOut;
-            uint64_t endYPxl = yPxlOff + ySizeOut;
-            
-            if(xPxlOff > this->spatialInfoFile->xSize)
-            {
-                throw KEAIOException("Start X Pixel is not within image.");
-            }
-            
-            if(endXPxl > this->spatialInfoFile->xSize)
-            {
-                throw KEAIOException("End X Pixel is not within image.");
-            }
-            
-            if(yPxlOff > this->spatialInfoFile->ySize)
+            if(bandHeader->noDataState == 0)
             {
-                throw KEAIOException("Start Y Pixel is not within image.");
+                throw KEAIOException("The image band no data value was not specified.");
             }
-            
-            if(endYPxl > this->spatialInfoFile->ySize)
+            else if(bandHeader->noDataState == 1)
             {
-                throw KEAIOException("End Y Pixel is not within image.");
+                throw KEAIOException("The image band no data value was not defined.");
             }
-            
-            // GET NATIVE DATASET
+            keaConvertBlock(bandHeader->noDataValue.data(), bandHeader->dataType, 1, (char*)data, inDataType, 1, 1, 1);
+            return;
+        }
+        
+        // READ IMAGE BAND NO DATA VALUE
+        try 
+        {            
             H5::DataType imgBandDT = convertDatatypeKeaToH5Native(inDataType);
+            hsize_t dimsValue[1];
+            dimsValue[0] = 1;
+            H5::DataSpace valueDataSpace(1, dimsValue);
+            H5::DataSet datasetImgNDV = this->keaImgFile->openDataSet( KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_NO_DATA_VAL );
             
-            // OPEN BAND DATASET AND WRITE IMAGE DATA
+            bool noDataDefined = true;
             try
             {
-                std::string imageBandPath = KEA_DATASETNAME_BAND + uint2Str(band);
-                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( imageBandPath + KEA_BANDNAME_MASK );
-                H5::DataSpace imgBandDataspace = imgBandDataset.getSpace();
-                
-                hsize_t imgOffset[2];
-                imgOffset[0] = yPxlOff;
-                imgOffset[1] = xPxlOff;
-                hsize_t dataDims[2];
-                dataDims[0] = ySizeBuf;
-                dataDims[1] = xSizeBuf;
-                H5::DataSpace write2BandDataspace = H5::DataSpace(2, dataDims);
+                H5::Attribute noDataDefAttribute = datasetImgNDV.openAttribute(KEA_NODATA_DEFINED);
+                int val = 1;
+                noDataDefAttribute.read(H5::PredType::NATIVE_INT, &val);
+                noDataDefAttribute.close();
                 
-                if((ySizeOut != ySizeBuf) | (xSizeOut != xSizeBuf))
-                {
-                    hsize_t dataSelectMemDims[2];
-                    dataSelectMemDims[0] = ySizeOut;
-                    dataSelectMemDims[1] = 1;
-                    
-                    hsize_t dataOffDims[2];
-                    dataOffDims[0] = 0;
-                    dataOffDims[1] = 0;
-                    
-                    hsize_t dataSelectStrideDims[2];
-                    dataSelectStrideDims[0] = 1;
-                    if(xSizeBuf == xSizeOut)
-                    {
-                        dataSelectStrideDims[1] = 1;
-                    }
-                    else
-                    {
-                        dataSelectStrideDims[1] = xSizeBuf - xSizeOut;
-                    }
-                    
-                    hsize_t dataSelectBlockSizeDims[2];
-                    dataSelectBlockSizeDims[0] = 1;
-                    dataSelectBlockSizeDims[1] = xSizeOut;
-                    write2BandDataspace.selectHyperslab(H5S_SELECT_SET, dataSelectMemDims, dataOffDims, dataSelectStrideDims, dataSelectBlockSizeDims);
-                    
-                    hsize_t dataOutDims[2];
-                    dataOutDims[0] = ySizeOut;
-                    dataOutDims[1] = xSizeOut;
-                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataOutDims, imgOffset);
-                }
-                else
+                if(val == 0)
                 {
-                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataDims, imgOffset);
+                    noDataDefined = false;
                 }
-                
-                imgBandDataset.write( data, imgBandDT, write2BandDataspace, imgBandDataspace);
-                
-                imgBandDataset.close();
-                imgBandDataspace.close();
-                write2BandDataspace.close();
-                
-                this->keaImgFile->flush(H5F_SCOPE_GLOBAL);
             }
             catch ( const H5::Exception &e)
             {
-                throw KEAIOException("Could not write image data.");
+                noDataDefined = true;
+            }
+            
+            if(noDataDefined)
+            {
+                datasetImgNDV.read(data, imgBandDT, valueDataSpace);
+            }
+            else
+            {
+                throw KEAIOException("The image band no data value was not defined.");
             }
+            datasetImgNDV.close();
+            valueDataSpace.close();
+        } 
+        catch ( const H5::Exception &e) 
+        {
+            throw KEAIOException("The image band no data value was not specified.");
         }
-        catch(const KEAIOException &e)
+        catch ( const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+    }
+    
+    void KEAImageIO::undefineNoDataValue(uint32_t band)
+    {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        
+        // UNDEFINE THE NO DATA VALUE
+        try
+        {
+            this->beginHeaderChange();
+            H5::DataSet datasetImgNDV = this->keaImgFile->openDataSet( KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_NO_DATA_VAL );
+            try
+            {
+                H5::Attribute noDataDefAttribute = datasetImgNDV.openAttribute(KEA_NODATA_DEFINED);
+                int val = 0;
+                noDataDefAttribute.write(H5::PredType::NATIVE_INT, &val);
+                noDataDefAttribute.close();
+            }
+            catch ( const H5::Exception &e)
+            {
+                H5::DataSpace attr_dataspace = H5::DataSpace(H5S_SCALAR);
+                H5::Attribute noDataDefAttribute = datasetImgNDV.createAttribute(KEA_NODATA_DEFINED, H5::PredType::STD_I8LE, attr_dataspace);
+                int val = 0;
+                noDataDefAttribute.write(H5::PredType::NATIVE_INT, &val);
+                noDataDefAttribute.close();
+            }
+            
+            datasetImgNDV.close();
+            this->updateConsolidatedHeader(band);
+        }
+        catch ( const H5::Exception &e)
+        {
+            throw KEAIOException("The image band no data value had not been created.");
+        }
+        catch ( const KEAIOException &e)
         {
             throw e;
         }
-        catch( const H5::FileIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataSetIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataSpaceIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataTypeIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
         catch ( const std::exception &e)
         {
             throw KEAIOException(e.what());
         }
     }
     
-    void KEAImageIO::readImageBlock2BandMask(uint32_t band, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType)
+    std::vector<KEAImageGCP*>* KEAImageIO::getGCPs()
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
+        std::vector<KEAImageGCP*> *gcps = new std::vector<KEAImageGCP*>();
+        
+        
         try
-        {
-            // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
-            if(band == 0)
+        {            
+            uint32_t numGCPs = 0;
+            // Get the number of GCPs
+            try
             {
-                throw KEAIOException("KEA Image Bands start at 1.");
+                hsize_t dimsValue[1];
+                dimsValue[0] = 1;
+                H5::DataSpace valueDataSpace(1, dimsValue);
+                uint32_t value[1];
+                H5::DataSet datasetNumGCPs = this->keaImgFile->openDataSet( KEA_GCPS_NUM );
+                datasetNumGCPs.read(value, H5::PredType::NATIVE_UINT32, valueDataSpace);
+                numGCPs = value[0];
+                datasetNumGCPs.close();
+                valueDataSpace.close();
             }
-            else if(band > this->numImgBands)
+            catch (const H5::Exception &e)
             {
-                throw KEAIOException("Band is not present within image.");
+                throw KEAIOException("Could not read the number of GCPs.");
             }
-            
-            uint64_t endXPxl = xPxlOff + xSizeIn;
-            uint64_t endYPxl = yPxlOff + ySizeIn;
-            
-            if(xPxlOff > this->spatialInfoFile->xSize)
+            catch ( const KEAIOException &e)
             {
-                throw KEAIOException("Start X Pixel is not within image.");
+                throw e;
             }
-            
-            if(endXPxl > this->spatialInfoFile->xSize)
+            catch ( const std::exception &e)
             {
-                throw KEAIOException("End X Pixel is not within image.");
+                throw KEAIOException(e.what());
             }
+
+            KEAImageGCP_HDF5 *gcpsHDF = new KEAImageGCP_HDF5[numGCPs];
             
-            if(yPxlOff > this->spatialInfoFile->ySize)
+            try
             {
-                throw KEAIOException("Start Y Pixel is not within image.");
+                H5::CompType *fieldDtMem = this->createGCPCompTypeMem();
+                H5::DataSet gcpsDataset = this->keaImgFile->openDataSet( KEA_GCPS_DATA );
+                
+                H5::DataSpace gcpsDataspace = gcpsDataset.getSpace();
+                hsize_t boolFieldOff[1];
+                boolFieldOff[0] = 0;
+                
+                hsize_t boolFieldsDims[1];
+                boolFieldsDims[0] = numGCPs;
+                H5::DataSpace gcpsMemspace(1, boolFieldsDims);
+                
+                gcpsDataspace.selectHyperslab( H5S_SELECT_SET, boolFieldsDims, boolFieldOff );
+                H5::DSetMemXferPropList xfer;
+                /* Ensures that malloc()/free() are from the same C runtime */
+                xfer.setVlenMemManager(kealibmalloc, nullptr, kealibfree, nullptr);
+                gcpsDataset.read(gcpsHDF, *fieldDtMem, gcpsMemspace, gcpsDataspace, xfer);
+                
+                gcpsDataset.close();
+                gcpsDataspace.close();
+                gcpsMemspace.close();
+                
+                delete fieldDtMem;
+            }
+            catch( const H5::Exception &e )
+            {
+                throw KEAIOException(e.getDetailMsg());
             }
             
-            if(endYPxl > this->spatialInfoFile->ySize)
+            KEAImageGCP *tmpGCP = nullptr;
+            for(uint32_t i = 0; i < numGCPs; ++i)
             {
-                throw KEAIOException("End Y Pixel is not within image.");
+                tmpGCP = new KEAImageGCP();
+                tmpGCP->pszId = std::string(gcpsHDF[i].pszId);
+                free(gcpsHDF[i].pszId);
+                tmpGCP->pszInfo = std::string(gcpsHDF[i].pszInfo);
+                free(gcpsHDF[i].pszInfo);
+                tmpGCP->dfGCPLine = gcpsHDF[i].dfGCPLine;
+                tmpGCP->dfGCPPixel = gcpsHDF[i].dfGCPPixel;
+                tmpGCP->dfGCPX = gcpsHDF[i].dfGCPX;
+                tmpGCP->dfGCPY = gcpsHDF[i].dfGCPY;
+                tmpGCP->dfGCPZ = gcpsHDF[i].dfGCPZ;
+                gcps->push_back(tmpGCP);
             }
             
-            // GET NATIVE DATASET
-            H5::DataType imgBandDT = convertDatatypeKeaToH5Native(inDataType);
+            delete[] gcpsHDF;
+        }
+        catch (const H5::Exception &e)
+        {
+            throw KEAIOException(e.getCDetailMsg());
+        }
+        catch ( const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+        
+        return gcps;
+    }
+    
+    void KEAImageIO::setGCPs(std::vector<KEAImageGCP*> *gcps, const std::string &projWKT)
+    {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        uint32_t numGCPs = gcps->size();
+        
+        KEAImageGCP_HDF5 *gcpsHDF = new KEAImageGCP_HDF5[numGCPs];
+        
+        uint32_t i = 0;
+        for(auto iterGCP = gcps->begin(); iterGCP != gcps->end(); ++iterGCP)
+        {
+            // Copy the char from one to the other for PSZ ID.
+            const size_t lenPSZId = strlen((*iterGCP)->pszId.c_str());
+            gcpsHDF[i].pszId = new char[lenPSZId + 1];
+            strncpy(gcpsHDF[i].pszId, (*iterGCP)->pszId.c_str(), lenPSZId);
+            gcpsHDF[i].pszId[lenPSZId] = '\0';
             
-            // OPEN BAND DATASET AND READ IMAGE DATA
+            // Copy the char from one to the other for PSZ INFO.
+            const size_t lenPSZInfo = strlen((*iterGCP)->pszInfo.c_str());
+            gcpsHDF[i].pszInfo = new char[lenPSZInfo + 1];
+            strncpy(gcpsHDF[i].pszInfo, (*iterGCP)->pszInfo.c_str(), lenPSZInfo);
+            gcpsHDF[i].pszInfo[lenPSZInfo] = '\0';
+            
+            gcpsHDF[i].dfGCPPixel = (*iterGCP)->dfGCPPixel;
+            gcpsHDF[i].dfGCPLine = (*iterGCP)->dfGCPLine;
+            gcpsHDF[i].dfGCPX = (*iterGCP)->dfGCPX;
+            gcpsHDF[i].dfGCPY = (*iterGCP)->dfGCPY;
+            gcpsHDF[i].dfGCPZ = (*iterGCP)->dfGCPZ;            
+            
+            ++i;
+        }
+        
+        try
+        {
+            // Open or create the GCPs dataset 
             try
             {
-                std::string imageBandPath = KEA_DATASETNAME_BAND + uint2Str(band);
-                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( imageBandPath + KEA_BANDNAME_MASK );
-                H5::DataSpace imgBandDataspace = imgBandDataset.getSpace();
+                H5::DataSet gcpsDataset = this->keaImgFile->openDataSet(KEA_GCPS_DATA);
+                H5::DataSpace gcpsWriteDataSpace = gcpsDataset.getSpace();
                 
-                hsize_t dataOffset[2];
-                dataOffset[0] = yPxlOff;
-                dataOffset[1] = xPxlOff;
-                hsize_t dataDims[2];
-                dataDims[0] = ySizeBuf;
-                dataDims[1] = xSizeBuf;
-                H5::DataSpace read2BandDataspace = H5::DataSpace(2, dataDims);
+                H5::CompType *fieldDtMem = this->createGCPCompTypeMem();
                 
-                if((ySizeBuf != ySizeIn) | (xSizeBuf != xSizeIn))
+                hsize_t gcpsDataDims[1];
+                gcpsWriteDataSpace.getSimpleExtentDims(gcpsDataDims);
+                
+                if(numGCPs > gcpsDataDims[0])
                 {
-                    hsize_t dataSelectMemDims[2];
-                    dataSelectMemDims[0] = ySizeIn;
-                    dataSelectMemDims[1] = 1;
-                    
-                    hsize_t dataOffDims[2];
-                    dataOffDims[0] = 0;
-                    dataOffDims[1] = 0;
-                    
-                    hsize_t dataSelectStrideDims[2];
-                    dataSelectStrideDims[0] = 1;
-                    if(xSizeBuf == xSizeIn)
-                    {
-                        dataSelectStrideDims[1] = 1;
-                    }
-                    else
-                    {
-                        dataSelectStrideDims[1] = xSizeBuf - xSizeIn;
-                    }
-                    
-                    hsize_t dataSelectBlockSizeDims[2];
-                    dataSelectBlockSizeDims[0] = 1;
-                    dataSelectBlockSizeDims[1] = xSizeIn;
-                    read2BandDataspace.selectHyperslab(H5S_SELECT_SET, dataSelectMemDims, dataOffDims, dataSelectStrideDims, dataSelectBlockSizeDims);
-                    
-                    hsize_t dataInDims[2];
-                    dataInDims[0] = ySizeIn;
-                    dataInDims[1] = xSizeIn;
-                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataInDims, dataOffset);
+                    hsize_t extendGCPsDatasetTo[1];
+                    extendGCPsDatasetTo[0] = numGCPs;
+                    gcpsDataset.extend( extendGCPsDatasetTo );
+                }
+                
+                hsize_t gcpsOffset[1];
+                gcpsOffset[0] = 0;
+                gcpsDataDims[0] = numGCPs;
+                
+                gcpsWriteDataSpace.close();
+                gcpsWriteDataSpace = gcpsDataset.getSpace();
+                gcpsWriteDataSpace.selectHyperslab(H5S_SELECT_SET, gcpsDataDims, gcpsOffset);
+                H5::DataSpace newGCPsDataspace = H5::DataSpace(1, gcpsDataDims);
+                
+                gcpsDataset.write(gcpsHDF, *fieldDtMem, newGCPsDataspace, gcpsWriteDataSpace);
+                
+                gcpsWriteDataSpace.close();
+                newGCPsDataspace.close();
+                gcpsDataset.close();
+                
+                delete fieldDtMem;
+            }
+            catch ( const H5::Exception &e)
+            {
+                H5::CompType *fieldDtDisk = this->createGCPCompTypeDisk();
+                H5::CompType *fieldDtMem = this->createGCPCompTypeMem();
+                
+                hsize_t initDimsGCPsDS[1];
+                initDimsGCPsDS[0] = numGCPs;
+                hsize_t maxDimsGCPsDS[1];
+                maxDimsGCPsDS[0] = H5S_UNLIMITED;
+                H5::DataSpace gcpsDataSpace = H5::DataSpace(1, initDimsGCPsDS, maxDimsGCPsDS);
+                
+                hsize_t dimsGCPsChunk[1];
+                dimsGCPsChunk[0] = numGCPs;
+                
+                H5::DSetCreatPropList creationGCPsDSPList;
+                creationGCPsDSPList.setChunk(1, dimsGCPsChunk);
+                creationGCPsDSPList.setShuffle();
+                creationGCPsDSPList.setDeflate(1);
+                H5::DataSet gcpsDataset = this->keaImgFile->createDataSet(KEA_GCPS_DATA, *fieldDtDisk, gcpsDataSpace, creationGCPsDSPList);
+                
+                hsize_t gcpsOffset[1];
+                gcpsOffset[0] = 0;
+                hsize_t gcpsDataDims[1];
+                gcpsDataDims[0] = numGCPs;
+                
+                H5::DataSpace gcpsWriteDataSpace = gcpsDataset.getSpace();
+                gcpsWriteDataSpace.selectHyperslab(H5S_SELECT_SET, gcpsDataDims, gcpsOffset);
+                H5::DataSpace newGCPsDataspace = H5::DataSpace(1, gcpsDataDims);
+                
+                gcpsDataset.write(gcpsHDF, *fieldDtMem, newGCPsDataspace, gcpsWriteDataSpace);
+                
+                gcpsDataSpace.close();
+                gcpsWriteDataSpace.close();
+                newGCPsDataspace.close();
+                gcpsDataset.close();                
+                
+                delete fieldDtDisk;
+                delete fieldDtMem;
+            }
+            
+            
+            // Set the number of GCPs
+            try
+            {
+                H5::DataSet numBandsDataset;
+                try
+                {
+                    // open the dataset
+                    numBandsDataset = this->keaImgFile->openDataSet(KEA_GCPS_NUM);
                 }
-                else
+                catch (const H5::Exception &e)
                 {
-                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataDims, dataOffset);
+                    // create the dataset if it does not exist
+                    hsize_t dimsNumBands[] = { 1 };
+                    H5::DataSpace numBandsDataSpace(1, dimsNumBands);
+                    numBandsDataset = this->keaImgFile->createDataSet(KEA_GCPS_NUM, H5::PredType::STD_U32LE, numBandsDataSpace);
+                    numBandsDataSpace.close();
                 }
-                
-                imgBandDataset.read( data, imgBandDT, read2BandDataspace, imgBandDataspace);
-                
-                imgBandDataset.close();
-                imgBandDataspace.close();
-                read2BandDataspace.close();
+                numBandsDataset.write(&numGCPs, H5::PredType::NATIVE_UINT32);
+                numBandsDataset.close();
             }
-            catch ( const H5::Exception &e)
+            catch (const H5::Exception &e)
             {
-                throw KEAIOException("Could not read image data.");
+                throw KEAIOException("Could not write the number of GCPs.");
+            }
+            catch ( const KEAIOException &e)
+            {
+                throw e;
+            }
+            catch ( const std::exception &e)
+            {
+                throw KEAIOException(e.what());
             }
         }
-        catch(const KEAIOException &e)
+        catch (const H5::Exception &e)
+        {
+            throw KEAIOException(e.getCDetailMsg());
+        }
+        catch ( const KEAIOException &e)
         {
             throw e;
         }
-        catch( const H5::FileIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataSetIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataSpaceIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataTypeIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
         catch ( const std::exception &e)
         {
             throw KEAIOException(e.what());
         }
-    }
-    
-    bool KEAImageIO::maskCreated(uint32_t band)
-    {
-        if(!this->fileOpen)
-        {
-            throw KEAIOException("Image was not open.");
-        }
-        
-        // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
-        if(band == 0)
-        {
-            throw KEAIOException("KEA Image Bands start at 1.");
-        }
-        else if(band > this->numImgBands)
-        {
-            throw KEAIOException("Band is not present within image.");
-        }
         
-        bool maskPresent = false;
-        std::string imageBandPath = KEA_DATASETNAME_BAND + uint2Str(band);
-        try
-        {
-            H5::Group imgBandGrp = this->keaImgFile->openGroup(imageBandPath);
-            hsize_t numItems = imgBandGrp.getNumObjs();
-            for(hsize_t i = 0; i < numItems; ++i)
-            {
-                //std::cout << "Item: " << imgBandGrp.getObjnameByIdx(i) << std::endl;
-                if(imgBandGrp.getObjnameByIdx(i) == "MASK")
-                {
-                    maskPresent = true;
-                    break;
-                }
-            }
-            imgBandGrp.close();
-            //H5::DataSet imgBandDataset = this->keaImgFile->openDataSet(imageBandPath+KEA_BANDNAME_MASK);
-            //imgBandDataset.close();
-            
-        }
-        catch (const H5::Exception &e)
+        for(uint32_t j = 0; j < i; j++)
         {
-            maskPresent = false;
+            delete[] gcpsHDF[j].pszId;
+            delete[] gcpsHDF[j].pszInfo;
         }
         
-        return maskPresent;
-    }
-    
-    
-    void KEAImageIO::setImageMetaData(const std::string &name, const std::string &value)
-    {
-        if(!this->fileOpen)
-        {
-            throw KEAIOException("Image was not open.");
-        }
+        delete[] gcpsHDF;
         
-        // FORM META-DATA PATH WITHIN THE H5 FILE 
-        std::string metaDataH5Path = KEA_DATASETNAME_METADATA + std::string("/") + name;
         
-        // WRITE IMAGE META DATA
-        try 
-        {
-            // OPEN DATASET OR CREATE NEW DATASET IF IT DOES NOT EXIST
-            H5::StrType strTypeAll(0, H5T_VARIABLE);
-            H5::DataSet datasetMetaData;
-            try 
-            {
-                datasetMetaData = this->keaImgFile->openDataSet( metaDataH5Path );
-            }
-            catch (const H5::Exception &e)
-            {
-                hsize_t	dimsForStr[1];
-                dimsForStr[0] = 1; // number of lines;
-                H5::DataSpace dataspaceStrAll(1, dimsForStr);
-                datasetMetaData = this->keaImgFile->createDataSet(metaDataH5Path, strTypeAll, dataspaceStrAll);
-
-            }
-            // WRITE DATA INTO THE DATASET
-            const char *wStrdata[1];
-            wStrdata[0] = value.c_str();			
-            datasetMetaData.write((void*)wStrdata, strTypeAll);
-            datasetMetaData.close();
-            
-            this->keaImgFile->flush(H5F_SCOPE_GLOBAL);
-        }
-        catch (const H5::Exception &e) 
+        // Set the projection string
+        try
         {
-            throw KEAIOException("Could not set image meta-data.");
+            this->setGCPProjection(projWKT);
         }
         catch ( const KEAIOException &e)
         {
@@ -881,119 +3650,113 @@ namespace kealib{
         {
             throw KEAIOException(e.what());
         }
+        
     }
     
-    std::string KEAImageIO::getImageMetaData(const std::string &name)
+    uint32_t KEAImageIO::getGCPCount()
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        std::string metaDataH5Path = KEA_DATASETNAME_METADATA + std::string("/") + name;
-        std::string value = "";
-        // READ IMAGE META-DATA
-        try 
-        {
-            H5::DataSet datasetMetaData = this->keaImgFile->openDataSet( metaDataH5Path );
-            H5::DataType strDataType = datasetMetaData.getDataType();
-            value = readString(datasetMetaData, strDataType);
-            datasetMetaData.close();
-        } 
-        catch ( const H5::Exception &e) 
-        {
-            throw KEAIOException("Meta-data variable was not accessable.");
-        }
-        catch ( const KEAIOException &e)
+        // READ NUMBER OF GCPs
+        uint32_t numGCPs = 0;
+        try
         {
-            throw e;
+            hsize_t dimsValue[1];
+            dimsValue[0] = 1;
+            H5::DataSpace valueDataSpace(1, dimsValue);
+            uint32_t value[1];
+            H5::DataSet datasetNumGCPs = this->keaImgFile->openDataSet( KEA_GCPS_NUM );
+            datasetNumGCPs.read(value, H5::PredType::NATIVE_UINT32, valueDataSpace);
+            numGCPs = value[0];
+            datasetNumGCPs.close();
+            valueDataSpace.close();
         }
-        catch ( const std::exception &e)
+        catch ( const H5::Exception &e)
         {
-            throw KEAIOException(e.what());
+            throw KEAIOException("The number of image bands was not specified.");
         }
         
-        return value;
+        return numGCPs;
     }
     
-    std::vector<std::string> KEAImageIO::getImageMetaDataNames()
+    std::string KEAImageIO::getGCPProjection()
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        std::vector<std::string> metaDataNames;
-        
-        try 
-        {
-            // Try to open dataset with overviewName
-            H5::Group imgBandMetaDataGrp = this->keaImgFile->openGroup(KEA_DATASETNAME_METADATA);
-            hsize_t numMetaDataItems = imgBandMetaDataGrp.getNumObjs();
-            
-            for(hsize_t i = 0; i < numMetaDataItems; ++i)
-            {
-                metaDataNames.push_back(imgBandMetaDataGrp.getObjnameByIdx(i));
-            }
-        }
-        catch (const H5::Exception &e)
-        {
-            throw KEAIOException("Could not retrieve image meta data.");
-        }
-        catch ( const KEAIOException &e)
+        // READ WKT STRING
+        std::string gcpProj = "";
+        try
         {
-            throw e;
+            H5::DataSet datasetGCPSpatialReference = this->keaImgFile->openDataSet( KEA_GCPS_PROJ );
+            H5::DataType strDataType = datasetGCPSpatialReference.getDataType();
+            gcpProj = readString(datasetGCPSpatialReference, strDataType);
+            datasetGCPSpatialReference.close();
         }
-        catch ( const std::exception &e)
+        catch ( const H5::Exception &e)
         {
-            throw KEAIOException(e.what());
+            throw KEAIOException("The spatial reference was not specified.");
         }
         
-        return metaDataNames;
+        return gcpProj;
     }
     
-    std::vector< std::pair<std::string, std::string> > KEAImageIO::getImageMetaData()
+    void KEAImageIO::setGCPProjection(const std::string &projWKT)
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        std::vector< std::pair<std::string, std::string> > metaData;
-        
-        try 
-        {
-            // Try to open dataset with overviewName
-            H5::Group imgBandMetaDataGrp = this->keaImgFile->openGroup(KEA_DATASETNAME_METADATA);
-            hsize_t numMetaDataItems = imgBandMetaDataGrp.getNumObjs();
-            std::string name = "";
-            std::string value = "";
-            
-            for(hsize_t i = 0; i < numMetaDataItems; ++i)
-            {
-                name = imgBandMetaDataGrp.getObjnameByIdx(i);
-                value = this->getImageMetaData(name);
-                metaData.push_back(std::pair<std::string, std::string>(name,value));
-            }
-        }
-        catch (const KEAIOException &e)
+        // SET THE WKT STRING SPATAIL REFERENCE IN GLOBAL HEADER
+        try
         {
-            throw e;
+            const char *wStrdata[1];
+            H5::DataSet datasetSpatialReference = this->keaImgFile->openDataSet(KEA_GCPS_PROJ);
+            H5::DataType strDataType = datasetSpatialReference.getDataType();
+            wStrdata[0] = projWKT.c_str();
+            datasetSpatialReference.write((void*)wStrdata, strDataType);
+            datasetSpatialReference.close();
+            keaFlushFile(this->keaImgFile);
         }
         catch (const H5::Exception &e)
         {
-            throw KEAIOException("Could not retrieve image meta data.");
+            const char *wStrdata[1];
+			hsize_t	dimsForStr[1];
+			dimsForStr[0] = 1; // number of lines;
+            H5::DataSpace dataspaceStrAll(1, dimsForStr);
+            H5::StrType strTypeAll(0, H5T_VARIABLE);
+            H5::DataSet datasetSpatialReference = this->keaImgFile->createDataSet(KEA_GCPS_PROJ, strTypeAll, dataspaceStrAll);
+			wStrdata[0] = projWKT.c_str();
+			datasetSpatialReference.write((void*)wStrdata, strTypeAll);
+			datasetSpatialReference.close();
+        }
+        catch ( const KEAIOException &e)
+        {
+            throw e;
         }
         catch ( const std::exception &e)
         {
             throw KEAIOException(e.what());
         }
-        
-        return metaData;
     }
     
-    void KEAImageIO::setImageMetaData(const std::vector< std::pair<std::string, std::string> > &data)
+    void KEAImageIO::setSpatialInfo(KEAImageSpatialInfo *inSpatialInfo)
     {
+        KEATraceScope trace("KEAImageIO::setSpatialInfo", KEA_TRACE_API);
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
@@ -1001,16 +3764,52 @@ namespace kealib{
         
         try 
         {
-            for(auto iterMetaData = data.begin(); iterMetaData != data.end(); ++iterMetaData)
-            {
-                this->setImageMetaData(iterMetaData->first, iterMetaData->second);
-            }
+            this->beginHeaderChange();
+            // SET X AND Y TL IN GLOBAL HEADER
+            double doubleVals[2];
+            doubleVals[0] = inSpatialInfo->tlX;
+            doubleVals[1] = inSpatialInfo->tlY;
+            H5::DataSet spatialTLDataset = this->keaImgFile->openDataSet(KEA_DATASETNAME_HEADER_TL);
+			spatialTLDataset.write( doubleVals, H5::PredType::NATIVE_DOUBLE );
+            spatialTLDataset.close();
             
-            this->keaImgFile->flush(H5F_SCOPE_GLOBAL);
-        }
+            // SET X AND Y RESOLUTION IN GLOBAL HEADER
+            doubleVals[0] = inSpatialInfo->xRes;
+            doubleVals[1] = inSpatialInfo->yRes;
+            H5::DataSet spatialResDataset = this->keaImgFile->openDataSet(KEA_DATASETNAME_HEADER_RES);
+			spatialResDataset.write( doubleVals, H5::PredType::NATIVE_DOUBLE );
+            spatialResDataset.close();
+            
+            // SET X AND Y ROTATION IN GLOBAL HEADER
+            doubleVals[0] = inSpatialInfo->xRot;
+            doubleVals[1] = inSpatialInfo->yRot;
+            H5::DataSet spatialRotDataset = this->keaImgFile->openDataSet(KEA_DATASETNAME_HEADER_ROT);
+			spatialRotDataset.write( doubleVals, H5::PredType::NATIVE_DOUBLE );
+            spatialRotDataset.close();
+            
+            // SET THE WKT STRING SPATAIL REFERENCE IN GLOBAL HEADER
+			const char *wStrdata[1];
+            H5::DataSet datasetSpatialReference = this->keaImgFile->openDataSet(KEA_DATASETNAME_HEADER_WKT);
+            H5::DataType strDataType = datasetSpatialReference.getDataType();
+			wStrdata[0] = inSpatialInfo->wktString.c_str();			
+			datasetSpatialReference.write((void*)wStrdata, strDataType);
+			datasetSpatialReference.close();
+            
+            // THE IMAGE SIZE IS NOT CHANGED
+            this->spatialInfoFile->tlX = inSpatialInfo->tlX;
+            this->spatialInfoFile->tlY = inSpatialInfo->tlY;
+            this->spatialInfoFile->xRes = inSpatialInfo->xRes;
+            this->spatialInfoFile->yRes = inSpatialInfo->yRes;
+            this->spatialInfoFile->xRot = inSpatialInfo->xRot;
+            this->spatialInfoFile->yRot = inSpatialInfo->yRot;
+            this->spatialInfoFile->wktString = inSpatialInfo->wktString;
+            this->updateConsolidatedHeader(0);
+            
+            keaFlushFile(this->keaImgFile);
+        } 
         catch (const H5::Exception &e)
         {
-            throw KEAIOException("Could not set image band meta data.");
+            throw KEAIOException(e.getCDetailMsg());
         }
         catch ( const KEAIOException &e)
         {
@@ -1022,154 +3821,202 @@ namespace kealib{
         }
     }
     
-    void KEAImageIO::setImageBandMetaData(uint32_t band, const std::string &name, const std::string &value)
+    KEAImageSpatialInfo* KEAImageIO::getSpatialInfo()
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        // FORM META-DATA PATH WITHIN THE H5 FILE 
-        std::string metaDataH5Path = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_METADATA + std::string("/") + name;
+        return spatialInfoFile;
+    }
+    
+    uint32_t KEAImageIO::getNumOfImageBands()
+    {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
         
-        // WRITE IMAGE BAND META DATA
-        try 
-        {
-            // OPEN DATASET OR CREATE NEW DATASET IF IT DOES NOT EXIST
-            H5::StrType strTypeAll(0, H5T_VARIABLE);
-            H5::DataSet datasetMetaData;
-            try 
-            {
-                datasetMetaData = this->keaImgFile->openDataSet( metaDataH5Path );
-            }
-            catch (const H5::Exception &e)
-            {
-                hsize_t	dimsForStr[1];
-                dimsForStr[0] = 1; // number of lines;
-                H5::DataSpace dataspaceStrAll(1, dimsForStr);
-                datasetMetaData = this->keaImgFile->createDataSet(metaDataH5Path, strTypeAll, dataspaceStrAll);
-                
-            }
-            // WRITE DATA INTO THE DATASET
-            const char *wStrdata[1];
-            wStrdata[0] = value.c_str();			
-            datasetMetaData.write((void*)wStrdata, strTypeAll);
-            datasetMetaData.close();
-            
-            this->keaImgFile->flush(H5F_SCOPE_GLOBAL);
-        }
-        catch (const H5::Exception &e) 
-        {
-            throw KEAIOException("Could not set image band meta-data.");
-        }
-        catch ( const KEAIOException &e)
-        {
-            throw e;
-        }
-        catch ( const std::exception &e)
+        if(!this->fileOpen)
         {
-            throw KEAIOException(e.what());
+            throw KEAIOException("Image was not open.");
         }
+        
+        return this->numImgBands;
     }
     
-    std::string KEAImageIO::getImageBandMetaData(uint32_t band, const std::string &name)
+    uint32_t KEAImageIO::getImageBlockSize(uint32_t band)
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        std::string metaDataH5Path = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_METADATA + std::string("/") + name;
-        std::string value = "";
-        // READ IMAGE BAND META-DATA
+        uint32_t imgBlockSize = 0;
+        
         try 
         {
-            H5::DataSet datasetMetaData = this->keaImgFile->openDataSet( metaDataH5Path );
-            H5::DataType strDataType = datasetMetaData.getDataType();
-            value = readString(datasetMetaData, strDataType);
-            datasetMetaData.close();
-        } 
-        catch ( const H5::Exception &e) 
-        {
-            throw KEAIOException("Meta-data variable was not accessable.");
+            // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
+            if(band == 0)
+            {
+                throw KEAIOException("KEA Image Bands start at 1.");
+            }
+            else if(band > this->numImgBands)
+            {
+                throw KEAIOException("Band is not present within image."); 
+            }
+            
+            const KEABandHeader *bandHeader = this->getBandHeader(band);
+            if((bandHeader != nullptr) && (bandHeader->blockSize > 0))
+            {
+                return bandHeader->blockSize;
+            }
+            
+            // OPEN BAND DATASET
+            try 
+            {
+                std::string imageBandPath = KEA_DATASETNAME_BAND + uint2Str(band);
+                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( imageBandPath + KEA_BANDNAME_DATA );
+                H5::Attribute blockSizeAtt = imgBandDataset.openAttribute(KEA_ATTRIBUTENAME_BLOCK_SIZE);
+                blockSizeAtt.read(H5::PredType::NATIVE_UINT32, &imgBlockSize);
+                imgBandDataset.close();
+                blockSizeAtt.close();
+            } 
+            catch ( const H5::Exception &e) 
+            {
+                throw KEAIOException("Could not get image block size.");
+            }            
         }
-        catch ( const KEAIOException &e)
+        catch(const KEAIOException &e)
         {
             throw e;
         }
+        catch( const H5::FileIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataSetIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataSpaceIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataTypeIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
         catch ( const std::exception &e)
         {
             throw KEAIOException(e.what());
         }
         
-        return value;
+        return imgBlockSize;
     }
-    
-    std::vector<std::string> KEAImageIO::getImageBandMetaDataNames(uint32_t band)
+
+    uint32_t KEAImageIO::getAttributeTableChunkSize(uint32_t band)
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        std::vector<std::string> metaDataNames;
+        uint32_t attChunkSize = 0;
         
-        std::string metaDataGroupName = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_METADATA;
         try 
         {
-            // Try to open dataset with overviewName
-            H5::Group imgBandMetaDataGrp = this->keaImgFile->openGroup(metaDataGroupName);
-            hsize_t numMetaDataItems = imgBandMetaDataGrp.getNumObjs();
-            
-            for(hsize_t i = 0; i < numMetaDataItems; ++i)
+            // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
+            if(band == 0)
             {
-                metaDataNames.push_back(imgBandMetaDataGrp.getObjnameByIdx(i));
+                throw KEAIOException("KEA Image Bands start at 1.");
             }
+            else if(band > this->numImgBands)
+            {
+                throw KEAIOException("Band is not present within image."); 
+            }
+            
+            // OPEN BAND DATASET
+            try 
+            {
+                hsize_t dimsValue[1];
+                dimsValue[0] = 1;
+                H5::DataSpace valueDataSpace(1, dimsValue);
+                std::string imageBandPath = KEA_DATASETNAME_BAND + uint2Str(band);
+                H5::DataSet datasetAttSize = this->keaImgFile->openDataSet( imageBandPath + KEA_ATT_CHUNKSIZE_HEADER);
+                datasetAttSize.read(&attChunkSize, H5::PredType::NATIVE_UINT32, valueDataSpace);
+                datasetAttSize.close();
+                valueDataSpace.close();
+            } 
+            catch ( const H5::Exception &e) 
+            {
+                throw KEAIOException("Could not get image block size.");
+            }            
         }
-        catch (const H5::Exception &e)
-        {
-            throw KEAIOException("Could not retrieve image band meta data.");
-        }
-        catch ( const KEAIOException &e)
+        catch(const KEAIOException &e)
         {
             throw e;
         }
+        catch( const H5::FileIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataSetIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataSpaceIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataTypeIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
         catch ( const std::exception &e)
         {
             throw KEAIOException(e.what());
         }
         
-        return metaDataNames;
+        return attChunkSize;
     }
     
-    std::vector< std::pair<std::string, std::string> > KEAImageIO::getImageBandMetaData(uint32_t band)
+    KEADataType KEAImageIO::getImageBandDataType(uint32_t band)
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
+        KEADataType imgDataType = kealib::kea_undefined;
         
-        std::vector< std::pair<std::string, std::string> > metaData;
-        
-        std::string metaDataGroupName = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_METADATA;
-        try 
+        const KEABandHeader *bandHeader = this->getBandHeader(band);
+        if(bandHeader != nullptr)
         {
-            // Try to open dataset with overviewName
-            H5::Group imgBandMetaDataGrp = this->keaImgFile->openGroup(metaDataGroupName);
-            hsize_t numMetaDataItems = imgBandMetaDataGrp.getNumObjs();
-            std::string name = "";
-            std::string value = "";
-            
-            for(hsize_t i = 0; i < numMetaDataItems; ++i)
-            {
-                name = imgBandMetaDataGrp.getObjnameByIdx(i);
-                value = this->getImageBandMetaData(band, name);
-                metaData.push_back(std::pair<std::string, std::string>(name,value));
-            }
+            return bandHeader->dataType;
         }
-        catch (const H5::Exception &e)
+        
+        // READ IMAGE DATA TYPE
+        try 
         {
-            throw KEAIOException("Could not retrieve image band meta data.");
+            hsize_t dimsValue[1];
+            dimsValue[0] = 1;
+            H5::DataSpace valueDataSpace(1, dimsValue);
+            uint32_t value[1];
+            H5::DataSet datasetImgDT = this->keaImgFile->openDataSet( KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_DT );
+            datasetImgDT.read(value, H5::PredType::NATIVE_UINT32, valueDataSpace);
+            imgDataType = (KEADataType)value[0];
+            datasetImgDT.close();
+            valueDataSpace.close();
+        } 
+        catch ( const H5::Exception &e) 
+        {
+            throw KEAIOException("The image band data type was not specified.");
         }
         catch ( const KEAIOException &e)
         {
@@ -1180,28 +4027,33 @@ namespace kealib{
             throw KEAIOException(e.what());
         }
         
-        return metaData;
+        return imgDataType;
     }
     
-    void KEAImageIO::setImageBandMetaData(uint32_t band, const std::vector< std::pair<std::string, std::string> > &data)
+    KEAImageExtend KEAImageIO::getImageExtend()
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        try 
+        if(this->numImgBands == 0)
         {
-            for(auto iterMetaData = data.begin(); iterMetaData != data.end(); ++iterMetaData)
-            {
-                this->setImageBandMetaData(band, iterMetaData->first, iterMetaData->second);
-            }
-            
-            this->keaImgFile->flush(H5F_SCOPE_GLOBAL);
+            return kea_extend_none;
         }
-        catch (const H5::Exception &e)
+        
+        KEAImageExtend extend = kea_extend_none;
+        try
         {
-            throw KEAIOException("Could not set image band meta data.");
+            H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( KEA_DATASETNAME_BAND + uint2Str(1) + KEA_BANDNAME_DATA );
+            extend = getDatasetExtend(imgBandDataset);
+            imgBandDataset.close();
+        }
+        catch ( const H5::Exception &e)
+        {
+            throw KEAIOException(e.getCDetailMsg());
         }
         catch ( const KEAIOException &e)
         {
@@ -1211,31 +4063,81 @@ namespace kealib{
         {
             throw KEAIOException(e.what());
         }
+        
+        return extend;
     }
     
-    void KEAImageIO::setImageBandDescription(uint32_t band, const std::string &description)
+    void KEAImageIO::extendImage(uint64_t newXSize, uint64_t newYSize)
     {
+        KEATraceScope trace("KEAImageIO::extendImage", KEA_TRACE_API);
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        std::string bandName = KEA_DATASETNAME_BAND + uint2Str(band);
-        
-        // WRITE IMAGE BAND DESCRIPTION
-        try 
+        try
         {
-            H5::StrType strTypeAll(0, H5T_VARIABLE);
-            H5::DataSet datasetBandDescription = this->keaImgFile->openDataSet( bandName+KEA_BANDNAME_DESCRIP );
-            const char *wStrdata[1];
-            wStrdata[0] = description.c_str();			
-            datasetBandDescription.write((void*)wStrdata, strTypeAll);
-            datasetBandDescription.close();
-            this->keaImgFile->flush(H5F_SCOPE_GLOBAL);
+            if((newXSize < this->spatialInfoFile->xSize) || (newYSize < this->spatialInfoFile->ySize))
+            {
+                throw KEAIOException("An image cannot be shrunk.");
+            }
+            bool growX = newXSize > this->spatialInfoFile->xSize;
+            bool growY = newYSize > this->spatialInfoFile->ySize;
+            if(!growX && !growY)
+            {
+                return;
+            }
+            
+            // CHECK ALL THE BANDS CAN GROW BEFORE CHANGING ANY OF THEM
+            std::vector<H5::DataSet> datasets;
+            for(uint32_t band = 1; band <= this->numImgBands; ++band)
+            {
+                std::string imageBandPath = KEA_DATASETNAME_BAND + uint2Str(band);
+                datasets.push_back(this->keaImgFile->openDataSet(imageBandPath + KEA_BANDNAME_DATA));
+                if(this->maskCreated(band))
+                {
+                    datasets.push_back(this->keaImgFile->openDataSet(imageBandPath + KEA_BANDNAME_MASK));
+                }
+            }
+            for(const H5::DataSet &dataset : datasets)
+            {
+                KEAImageExtend extend = getDatasetExtend(dataset);
+                if((extend == kea_extend_none) || (growX && (extend != kea_extend_xy)))
+                {
+                    throw KEAIOException("The image was not created extendable in the dimension(s) requested.");
+                }
+            }
+            
+            // THE CACHED CHUNK INFO HOLDS THE OLD DIMENSIONS
+            this->clearChunkedDatasets();
+            this->beginHeaderChange();
+            
+            hsize_t newDims[] = { newYSize, newXSize };
+            for(H5::DataSet &dataset : datasets)
+            {
+                dataset.extend(newDims);
+                dataset.close();
+            }
+            
+            // UPDATE THE IMAGE SIZE IN THE GLOBAL HEADER
+            uint64_t uLongVals[2];
+            uLongVals[0] = newXSize;
+            uLongVals[1] = newYSize;
+            H5::DataSet spatialSizeDataset = this->keaImgFile->openDataSet(KEA_DATASETNAME_HEADER_SIZE);
+            spatialSizeDataset.write( uLongVals, H5::PredType::NATIVE_UINT64 );
+            spatialSizeDataset.close();
+            
+            this->spatialInfoFile->xSize = newXSize;
+            this->spatialInfoFile->ySize = newYSize;
+            this->updateConsolidatedHeader(0);
+            
+            keaFlushFile(this->keaImgFile);
         }
-        catch (const H5::Exception &e) 
+        catch ( const H5::Exception &e)
         {
-            throw KEAIOException("Could not set image band description.");
+            throw KEAIOException(e.getCDetailMsg());
         }
         catch ( const KEAIOException &e)
         {
@@ -1247,26 +4149,41 @@ namespace kealib{
         }
     }
     
-    std::string KEAImageIO::getImageBandDescription(uint32_t band)
+    std::string KEAImageIO::getKEAImageVersion() 
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        std::string bandName = KEA_DATASETNAME_BAND + uint2Str(band) + std::string("/") + KEA_BANDNAME_DESCRIP;
-        std::string description = "";
-        // READ IMAGE BAND DESCRIPTION
+        return this->keaVersion;
+    }
+    
+    void KEAImageIO::setImageBandLayerType(uint32_t band, KEALayerType imgLayerType)
+    {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+                
+        // WRITE IMAGE LAYER TYPE
         try 
         {
-            H5::DataSet datasetBandDescription = this->keaImgFile->openDataSet( bandName );
-            H5::DataType strDataType = datasetBandDescription.getDataType();
-            description = readString(datasetBandDescription, strDataType);
-            datasetBandDescription.close();
+            this->beginHeaderChange();
+            uint32_t value = (uint32_t)imgLayerType;
+            H5::DataSet datasetImgLT = this->keaImgFile->openDataSet( KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_TYPE );
+            datasetImgLT.write(&value, H5::PredType::NATIVE_UINT32);
+            datasetImgLT.close();
+            this->updateConsolidatedHeader(band);
+            keaFlushFile(this->keaImgFile);
         } 
         catch ( const H5::Exception &e) 
         {
-            throw KEAIOException("Could not read band description.");
+            throw KEAIOException("The image band data type was not specified.");
         }
         catch ( const KEAIOException &e)
         {
@@ -1276,64 +4193,41 @@ namespace kealib{
         {
             throw KEAIOException(e.what());
         }
-        
-        return description;
     }
     
-    
-    
-    void KEAImageIO::setNoDataValue(uint32_t band, const void *data, KEADataType inDataType)
+    KEALayerType KEAImageIO::getImageBandLayerType(uint32_t band)
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        // READ IMAGE DATA TYPE
+        KEALayerType imgLayerType = kea_continuous;
+        
+        const KEABandHeader *bandHeader = this->getBandHeader(band);
+        if(bandHeader != nullptr)
+        {
+            return bandHeader->layerType;
+        }
+        
+        // READ IMAGE LAYER TYPE
         try 
-        {    
-            std::string noDataValPath = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_NO_DATA_VAL;
-            H5::DataSet datasetImgNDV;
-            H5::Attribute noDataDefAttribute;
-            
-            try 
-            {
-                datasetImgNDV = this->keaImgFile->openDataSet( noDataValPath );
-            }
-            catch (const H5::Exception &e)
-            {
-                hsize_t	dimsForNDV[1];
-                dimsForNDV[0] = 1; // number of lines;
-                H5::DataSpace dataspaceNDV(1, dimsForNDV);
-                
-                KEADataType imgDataType = this->getImageBandDataType(band);
-                H5::DataType imgBandDT = convertDatatypeKeaToH5STD(imgDataType);
-
-                datasetImgNDV = this->keaImgFile->createDataSet(noDataValPath, imgBandDT, dataspaceNDV);
-            }
-            
-            try
-            {
-                noDataDefAttribute = datasetImgNDV.openAttribute(KEA_NODATA_DEFINED);
-            }
-            catch (const H5::Exception &e)
-            {
-                H5::DataSpace attr_dataspace = H5::DataSpace(H5S_SCALAR);
-                noDataDefAttribute = datasetImgNDV.createAttribute(KEA_NODATA_DEFINED, H5::PredType::STD_I8LE, attr_dataspace);
-            }
-            
-            int val = 1;
-            noDataDefAttribute.write(H5::PredType::NATIVE_INT, &val);
-            noDataDefAttribute.close();
-            
-            H5::DataType dataDT = convertDatatypeKeaToH5Native(inDataType);
-            datasetImgNDV.write( data, dataDT );
-            datasetImgNDV.close();
-            this->keaImgFile->flush(H5F_SCOPE_GLOBAL);
+        {
+            hsize_t dimsValue[1];
+            dimsValue[0] = 1;
+            H5::DataSpace valueDataSpace(1, dimsValue);
+            uint32_t value[1];
+            H5::DataSet datasetImgLT = this->keaImgFile->openDataSet( KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_TYPE );
+            datasetImgLT.read(value, H5::PredType::NATIVE_UINT32, valueDataSpace);
+            imgLayerType = (KEALayerType)value[0];
+            datasetImgLT.close();
+            valueDataSpace.close();
         } 
         catch ( const H5::Exception &e) 
         {
-            throw KEAIOException("The image data type was not specified.");
+            throw KEAIOException("The image band data type was not specified.");
         }
         catch ( const KEAIOException &e)
         {
@@ -1343,57 +4237,37 @@ namespace kealib{
         {
             throw KEAIOException(e.what());
         }
+        
+        return imgLayerType;
     }
     
-    void KEAImageIO::getNoDataValue(uint32_t band, void *data, KEADataType inDataType)
+    void KEAImageIO::setImageBandClrInterp(uint32_t band, KEABandClrInterp imgLayerClrInterp)
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        
-        // READ IMAGE BAND NO DATA VALUE
+        // WRITE IMAGE LAYER USAGE
+        uint32_t value = (uint32_t) imgLayerClrInterp;
         try 
-        {            
-            H5::DataType imgBandDT = convertDatatypeKeaToH5Native(inDataType);
-            hsize_t dimsValue[1];
-            dimsValue[0] = 1;
-            H5::DataSpace valueDataSpace(1, dimsValue);
-            H5::DataSet datasetImgNDV = this->keaImgFile->openDataSet( KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_NO_DATA_VAL );
-            
-            bool noDataDefined = true;
-            try
-            {
-                H5::Attribute noDataDefAttribute = datasetImgNDV.openAttribute(KEA_NODATA_DEFINED);
-                int val = 1;
-                noDataDefAttribute.read(H5::PredType::NATIVE_INT, &val);
-                noDataDefAttribute.close();
-                
-                if(val == 0)
-                {
-                    noDataDefined = false;
-                }
-            }
-            catch ( const H5::Exception &e)
-            {
-                noDataDefined = true;
-            }
-            
-            if(noDataDefined)
-            {
-                datasetImgNDV.read(data, imgBandDT, valueDataSpace);
-            }
-            else
-            {
-                throw KEAIOException("The image band no data value was not defined.");
-            }
-            datasetImgNDV.close();
-            valueDataSpace.close();
+        {
+            this->beginHeaderChange();
+            H5::DataSet datasetImgLU = this->keaImgFile->openDataSet( KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_USAGE );
+            datasetImgLU.write(&value, H5::PredType::NATIVE_UINT32);
+            datasetImgLU.close();
+            keaFlushFile(this->keaImgFile);
         } 
         catch ( const H5::Exception &e) 
         {
-            throw KEAIOException("The image band no data value was not specified.");
+            hsize_t dimsUsage[1];
+            dimsUsage[0] = 1;
+            H5::DataSpace usageDataSpace(1, dimsUsage);
+            H5::DataSet usageDataset = this->keaImgFile->createDataSet((KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_USAGE), H5::PredType::STD_U8LE, usageDataSpace);
+            usageDataset.write( &value, H5::PredType::NATIVE_UINT32 );
+            usageDataset.close();
         }
         catch ( const KEAIOException &e)
         {
@@ -1403,41 +4277,45 @@ namespace kealib{
         {
             throw KEAIOException(e.what());
         }
+        
+        this->updateConsolidatedHeader(band);
+        keaFlushFile(this->keaImgFile);
     }
     
-    void KEAImageIO::undefineNoDataValue(uint32_t band)
+    KEABandClrInterp KEAImageIO::getImageBandClrInterp(uint32_t band)
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
+        KEABandClrInterp imgLayerClrInterp = kea_generic;
         
-        // UNDEFINE THE NO DATA VALUE
-        try
+        const KEABandHeader *bandHeader = this->getBandHeader(band);
+        if(bandHeader != nullptr)
         {
-            H5::DataSet datasetImgNDV = this->keaImgFile->openDataSet( KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_NO_DATA_VAL );
-            try
-            {
-                H5::Attribute noDataDefAttribute = datasetImgNDV.openAttribute(KEA_NODATA_DEFINED);
-                int val = 0;
-                noDataDefAttribute.write(H5::PredType::NATIVE_INT, &val);
-                noDataDefAttribute.close();
-            }
-            catch ( const H5::Exception &e)
-            {
-                H5::DataSpace attr_dataspace = H5::DataSpace(H5S_SCALAR);
-                H5::Attribute noDataDefAttribute = datasetImgNDV.createAttribute(KEA_NODATA_DEFINED, H5::PredType::STD_I8LE, attr_dataspace);
-                int val = 0;
-                noDataDefAttribute.write(H5::PredType::NATIVE_INT, &val);
-                noDataDefAttribute.close();
-            }
-            
-            datasetImgNDV.close();
+            return bandHeader->clrInterp;
         }
-        catch ( const H5::Exception &e)
+        
+        // READ IMAGE LAYER USAGE
+        try 
+        {
+            hsize_t dimsValue[1];
+            dimsValue[0] = 1;
+            H5::DataSpace valueDataSpace(1, dimsValue);
+            uint32_t value[1];
+            H5::DataSet datasetImgLU = this->keaImgFile->openDataSet( KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_USAGE );
+            datasetImgLU.read(value, H5::PredType::NATIVE_UINT32, valueDataSpace);
+            imgLayerClrInterp = (KEABandClrInterp)value[0];
+            datasetImgLU.close();
+            valueDataSpace.close();
+        } 
+        catch ( const H5::Exception &e) 
         {
-            throw KEAIOException("The image band no data value had not been created.");
+            //throw KEAIOException("The image band data type was not specified.");
+            imgLayerClrInterp = kea_generic; // Field was not present within the file.
         }
         catch ( const KEAIOException &e)
         {
@@ -1447,379 +4325,270 @@ namespace kealib{
         {
             throw KEAIOException(e.what());
         }
+        
+        return imgLayerClrInterp;
     }
     
-    std::vector<KEAImageGCP*>* KEAImageIO::getGCPs()
+    double KEAImageIO::readBandScaleOffset(H5::H5File *keaImgH5File, const std::string &datasetPath, double defaultValue)
     {
-        if(!this->fileOpen)
+        if(H5Lexists(keaImgH5File->getId(), datasetPath.c_str(), H5P_DEFAULT) <= 0)
         {
-            throw KEAIOException("Image was not open.");
+            return defaultValue;
         }
         
-        std::vector<KEAImageGCP*> *gcps = new std::vector<KEAImageGCP*>();
-        
-        
+        double value = defaultValue;
         try
-        {            
-            uint32_t numGCPs = 0;
-            // Get the number of GCPs
-            try
-            {
-                hsize_t dimsValue[1];
-                dimsValue[0] = 1;
-                H5::DataSpace valueDataSpace(1, dimsValue);
-                uint32_t value[1];
-                H5::DataSet datasetNumGCPs = this->keaImgFile->openDataSet( KEA_GCPS_NUM );
-                datasetNumGCPs.read(value, H5::PredType::NATIVE_UINT32, valueDataSpace);
-                numGCPs = value[0];
-                datasetNumGCPs.close();
-                valueDataSpace.close();
-            }
-            catch (const H5::Exception &e)
-            {
-                throw KEAIOException("Could not read the number of GCPs.");
-            }
-            catch ( const KEAIOException &e)
-            {
-                throw e;
-            }
-            catch ( const std::exception &e)
-            {
-                throw KEAIOException(e.what());
-            }
-
-            KEAImageGCP_HDF5 *gcpsHDF = new KEAImageGCP_HDF5[numGCPs];
-            
-            try
-            {
-                H5::CompType *fieldDtMem = this->createGCPCompTypeMem();
-                H5::DataSet gcpsDataset = this->keaImgFile->openDataSet( KEA_GCPS_DATA );
-                
-                H5::DataSpace gcpsDataspace = gcpsDataset.getSpace();
-                hsize_t boolFieldOff[1];
-                boolFieldOff[0] = 0;
-                
-                hsize_t boolFieldsDims[1];
-                boolFieldsDims[0] = numGCPs;
-                H5::DataSpace gcpsMemspace(1, boolFieldsDims);
-                
-                gcpsDataspace.selectHyperslab( H5S_SELECT_SET, boolFieldsDims, boolFieldOff );
-                H5::DSetMemXferPropList xfer;
-                /* Ensures that malloc()/free() are from the same C runtime */
-                xfer.setVlenMemManager(kealibmalloc, nullptr, kealibfree, nullptr);
-                gcpsDataset.read(gcpsHDF, *fieldDtMem, gcpsMemspace, gcpsDataspace, xfer);
-                
-                gcpsDataset.close();
-                gcpsDataspace.close();
-                gcpsMemspace.close();
-                
-                delete fieldDtMem;
-            }
-            catch( const H5::Exception &e )
-            {
-                throw KEAIOException(e.getDetailMsg());
-            }
-            
-            KEAImageGCP *tmpGCP = nullptr;
-            for(uint32_t i = 0; i < numGCPs; ++i)
-            {
-                tmpGCP = new KEAImageGCP();
-                tmpGCP->pszId = std::string(gcpsHDF[i].pszId);
-                free(gcpsHDF[i].pszId);
-                tmpGCP->pszInfo = std::string(gcpsHDF[i].pszInfo);
-                free(gcpsHDF[i].pszInfo);
-                tmpGCP->dfGCPLine = gcpsHDF[i].dfGCPLine;
-                tmpGCP->dfGCPPixel = gcpsHDF[i].dfGCPPixel;
-                tmpGCP->dfGCPX = gcpsHDF[i].dfGCPX;
-                tmpGCP->dfGCPY = gcpsHDF[i].dfGCPY;
-                tmpGCP->dfGCPZ = gcpsHDF[i].dfGCPZ;
-                gcps->push_back(tmpGCP);
-            }
-            
-            delete[] gcpsHDF;
-        }
-        catch (const H5::Exception &e)
-        {
-            throw KEAIOException(e.getCDetailMsg());
-        }
-        catch ( const KEAIOException &e)
         {
-            throw e;
+            H5::DataSet dataset = keaImgH5File->openDataSet( datasetPath );
+            dataset.read(&value, H5::PredType::NATIVE_DOUBLE);
+            dataset.close();
         }
-        catch ( const std::exception &e)
+        catch ( const H5::Exception &e)
         {
-            throw KEAIOException(e.what());
+            value = defaultValue;
         }
-        
-        return gcps;
+        return value;
     }
     
-    void KEAImageIO::setGCPs(std::vector<KEAImageGCP*> *gcps, const std::string &projWKT)
+    void KEAImageIO::writeBandScaleOffset(uint32_t band, const std::string &datasetName, double value)
     {
-        if(!this->fileOpen)
+        if(band == 0)
         {
-            throw KEAIOException("Image was not open.");
+            throw KEAIOException("KEA Image Bands start at 1.");
         }
-        
-        uint32_t numGCPs = gcps->size();
-        
-        KEAImageGCP_HDF5 *gcpsHDF = new KEAImageGCP_HDF5[numGCPs];
-        
-        uint32_t i = 0;
-        for(auto iterGCP = gcps->begin(); iterGCP != gcps->end(); ++iterGCP)
+        else if(band > this->numImgBands)
         {
-            // Copy the char from one to the other for PSZ ID.
-            const size_t lenPSZId = strlen((*iterGCP)->pszId.c_str());
-            gcpsHDF[i].pszId = new char[lenPSZId + 1];
-            strncpy(gcpsHDF[i].pszId, (*iterGCP)->pszId.c_str(), lenPSZId);
-            gcpsHDF[i].pszId[lenPSZId] = '\0';
-            
-            // Copy the char from one to the other for PSZ INFO.
-            const size_t lenPSZInfo = strlen((*iterGCP)->pszInfo.c_str());
-            gcpsHDF[i].pszInfo = new char[lenPSZInfo + 1];
-            strncpy(gcpsHDF[i].pszInfo, (*iterGCP)->pszInfo.c_str(), lenPSZInfo);
-            gcpsHDF[i].pszInfo[lenPSZInfo] = '\0';
-            
-            gcpsHDF[i].dfGCPPixel = (*iterGCP)->dfGCPPixel;
-            gcpsHDF[i].dfGCPLine = (*iterGCP)->dfGCPLine;
-            gcpsHDF[i].dfGCPX = (*iterGCP)->dfGCPX;
-            gcpsHDF[i].dfGCPY = (*iterGCP)->dfGCPY;
-            gcpsHDF[i].dfGCPZ = (*iterGCP)->dfGCPZ;            
-            
-            ++i;
+            throw KEAIOException("Band is not present within image.");
         }
         
+        std::string datasetPath = KEA_DATASETNAME_BAND + uint2Str(band) + datasetName;
         try
         {
-            // Open or create the GCPs dataset 
-            try
-            {
-                H5::DataSet gcpsDataset = this->keaImgFile->openDataSet(KEA_GCPS_DATA);
-                H5::DataSpace gcpsWriteDataSpace = gcpsDataset.getSpace();
-                
-                H5::CompType *fieldDtMem = this->createGCPCompTypeMem();
-                
-                hsize_t gcpsDataDims[1];
-                gcpsWriteDataSpace.getSimpleExtentDims(gcpsDataDims);
-                
-                if(numGCPs > gcpsDataDims[0])
-                {
-                    hsize_t extendGCPsDatasetTo[1];
-                    extendGCPsDatasetTo[0] = numGCPs;
-                    gcpsDataset.extend( extendGCPsDatasetTo );
-                }
-                
-                hsize_t gcpsOffset[1];
-                gcpsOffset[0] = 0;
-                gcpsDataDims[0] = numGCPs;
-                
-                gcpsWriteDataSpace.close();
-                gcpsWriteDataSpace = gcpsDataset.getSpace();
-                gcpsWriteDataSpace.selectHyperslab(H5S_SELECT_SET, gcpsDataDims, gcpsOffset);
-                H5::DataSpace newGCPsDataspace = H5::DataSpace(1, gcpsDataDims);
-                
-                gcpsDataset.write(gcpsHDF, *fieldDtMem, newGCPsDataspace, gcpsWriteDataSpace);
-                
-                gcpsWriteDataSpace.close();
-                newGCPsDataspace.close();
-                gcpsDataset.close();
-                
-                delete fieldDtMem;
-            }
-            catch ( const H5::Exception &e)
-            {
-                H5::CompType *fieldDtDisk = this->createGCPCompTypeDisk();
-                H5::CompType *fieldDtMem = this->createGCPCompTypeMem();
-                
-                hsize_t initDimsGCPsDS[1];
-                initDimsGCPsDS[0] = numGCPs;
-                hsize_t maxDimsGCPsDS[1];
-                maxDimsGCPsDS[0] = H5S_UNLIMITED;
-                H5::DataSpace gcpsDataSpace = H5::DataSpace(1, initDimsGCPsDS, maxDimsGCPsDS);
-                
-                hsize_t dimsGCPsChunk[1];
-                dimsGCPsChunk[0] = numGCPs;
-                
-                H5::DSetCreatPropList creationGCPsDSPList;
-                creationGCPsDSPList.setChunk(1, dimsGCPsChunk);
-                creationGCPsDSPList.setShuffle();
-                creationGCPsDSPList.setDeflate(1);
-                H5::DataSet gcpsDataset = this->keaImgFile->createDataSet(KEA_GCPS_DATA, *fieldDtDisk, gcpsDataSpace, creationGCPsDSPList);
-                
-                hsize_t gcpsOffset[1];
-                gcpsOffset[0] = 0;
-                hsize_t gcpsDataDims[1];
-                gcpsDataDims[0] = numGCPs;
-                
-                H5::DataSpace gcpsWriteDataSpace = gcpsDataset.getSpace();
-                gcpsWriteDataSpace.selectHyperslab(H5S_SELECT_SET, gcpsDataDims, gcpsOffset);
-                H5::DataSpace newGCPsDataspace = H5::DataSpace(1, gcpsDataDims);
-                
-                gcpsDataset.write(gcpsHDF, *fieldDtMem, newGCPsDataspace, gcpsWriteDataSpace);
-                
-                gcpsDataSpace.close();
-                gcpsWriteDataSpace.close();
-                newGCPsDataspace.close();
-                gcpsDataset.close();                
-                
-                delete fieldDtDisk;
-                delete fieldDtMem;
-            }
-            
-            
-            // Set the number of GCPs
-            try
-            {
-                H5::DataSet numBandsDataset;
-                try
-                {
-                    // open the dataset
-                    numBandsDataset = this->keaImgFile->openDataSet(KEA_GCPS_NUM);
-                }
-                catch (const H5::Exception &e)
-                {
-                    // create the dataset if it does not exist
-                    hsize_t dimsNumBands[] = { 1 };
-                    H5::DataSpace numBandsDataSpace(1, dimsNumBands);
-                    numBandsDataset = this->keaImgFile->createDataSet(KEA_GCPS_NUM, H5::PredType::STD_U32LE, numBandsDataSpace);
-                    numBandsDataSpace.close();
-                }
-                numBandsDataset.write(&numGCPs, H5::PredType::NATIVE_UINT32);
-                numBandsDataset.close();
-            }
-            catch (const H5::Exception &e)
-            {
-                throw KEAIOException("Could not write the number of GCPs.");
-            }
-            catch ( const KEAIOException &e)
+            this->beginHeaderChange();
+            if(H5Lexists(this->keaImgFile->getId(), datasetPath.c_str(), H5P_DEFAULT) > 0)
             {
-                throw e;
+                H5::DataSet dataset = this->keaImgFile->openDataSet( datasetPath );
+                dataset.write(&value, H5::PredType::NATIVE_DOUBLE);
+                dataset.close();
             }
-            catch ( const std::exception &e)
+            else
             {
-                throw KEAIOException(e.what());
+                hsize_t dimsValue[1];
+                dimsValue[0] = 1;
+                H5::DataSpace valueDataSpace(1, dimsValue);
+                H5::DataSet dataset = this->keaImgFile->createDataSet(datasetPath, H5::PredType::IEEE_F64LE, valueDataSpace);
+                dataset.write(&value, H5::PredType::NATIVE_DOUBLE);
+                dataset.close();
+                valueDataSpace.close();
             }
         }
-        catch (const H5::Exception &e)
-        {
-            throw KEAIOException(e.getCDetailMsg());
-        }
-        catch ( const KEAIOException &e)
-        {
-            throw e;
-        }
-        catch ( const std::exception &e)
+        catch ( const H5::Exception &e)
         {
-            throw KEAIOException(e.what());
+            throw KEAIOException("Could not write the band " + datasetName.substr(1) + ".");
         }
         
-        for(uint32_t j = 0; j < i; j++)
+        this->updateConsolidatedHeader(band);
+        keaFlushFile(this->keaImgFile);
+    }
+    
+    void KEAImageIO::setImageBandScale(uint32_t band, double scale)
+    {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
+        if(!this->fileOpen)
         {
-            delete[] gcpsHDF[j].pszId;
-            delete[] gcpsHDF[j].pszInfo;
+            throw KEAIOException("Image was not open.");
         }
         
-        delete[] gcpsHDF;
-        
+        this->writeBandScaleOffset(band, KEA_BANDNAME_SCALE, scale);
+    }
+    
+    double KEAImageIO::getImageBandScale(uint32_t band)
+    {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
         
-        // Set the projection string
-        try
+        if(!this->fileOpen)
         {
-            this->setGCPProjection(projWKT);
+            throw KEAIOException("Image was not open.");
         }
-        catch ( const KEAIOException &e)
+        
+        const KEABandHeader *bandHeader = this->getBandHeader(band);
+        if(bandHeader != nullptr)
         {
-            throw e;
+            return bandHeader->scale;
         }
-        catch ( const std::exception &e)
+        return readBandScaleOffset(this->keaImgFile, KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_SCALE, 1);
+    }
+    
+    void KEAImageIO::setImageBandOffset(uint32_t band, double offset)
+    {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
+        if(!this->fileOpen)
         {
-            throw KEAIOException(e.what());
+            throw KEAIOException("Image was not open.");
         }
         
+        this->writeBandScaleOffset(band, KEA_BANDNAME_OFFSET, offset);
     }
     
-    uint32_t KEAImageIO::getGCPCount()
+    double KEAImageIO::getImageBandOffset(uint32_t band)
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        // READ NUMBER OF GCPs
-        uint32_t numGCPs = 0;
-        try
-        {
-            hsize_t dimsValue[1];
-            dimsValue[0] = 1;
-            H5::DataSpace valueDataSpace(1, dimsValue);
-            uint32_t value[1];
-            H5::DataSet datasetNumGCPs = this->keaImgFile->openDataSet( KEA_GCPS_NUM );
-            datasetNumGCPs.read(value, H5::PredType::NATIVE_UINT32, valueDataSpace);
-            numGCPs = value[0];
-            datasetNumGCPs.close();
-            valueDataSpace.close();
-        }
-        catch ( const H5::Exception &e)
+        const KEABandHeader *bandHeader = this->getBandHeader(band);
+        if(bandHeader != nullptr)
         {
-            throw KEAIOException("The number of image bands was not specified.");
+            return bandHeader->offset;
         }
-        
-        return numGCPs;
+        return readBandScaleOffset(this->keaImgFile, KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_OFFSET, 0);
     }
     
-    std::string KEAImageIO::getGCPProjection()
+    void KEAImageIO::createOverview(uint32_t band, uint32_t overview, uint64_t xSize, uint64_t ySize)
     {
+        KEATraceScope trace("KEAImageIO::createOverview", KEA_TRACE_API);
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        // READ WKT STRING
-        std::string gcpProj = "";
-        try
+        // THE OVERVIEW DATASET MAY BE CACHED BY THE READ PATH
+        this->clearChunkedDatasets();
+        
+        std::string overviewName = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_OVERVIEWSNAME_OVERVIEW + uint2Str(overview);
+                
+        try 
         {
-            H5::DataSet datasetGCPSpatialReference = this->keaImgFile->openDataSet( KEA_GCPS_PROJ );
-            H5::DataType strDataType = datasetGCPSpatialReference.getDataType();
-            gcpProj = readString(datasetGCPSpatialReference, strDataType);
-            datasetGCPSpatialReference.close();
+            // Try to open dataset with overviewName
+            H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( overviewName );
+            this->beginHeaderChange();
+            this->keaImgFile->unlink(overviewName);
         }
-        catch ( const H5::Exception &e)
+        catch (const H5::Exception &e)
         {
-            throw KEAIOException("The spatial reference was not specified.");
+            // Do nothing as dataset does not exist.
         }
         
-        return gcpProj;
+        try 
+        {
+            KEADataType imgDataType = this->getImageBandDataType(band);
+            
+            H5::DataType imgBandDT = convertDatatypeKeaToH5STD(imgDataType);
+            int initFillVal = 0;
+            
+            hsize_t imageBandDims[2];
+            imageBandDims[0] = ySize;
+            imageBandDims[1] = xSize;
+            H5::DataSpace imgBandDataSpace(2, imageBandDims);
+            
+            hsize_t dimsImageBandChunk[2];
+            // Make sure that the chuck size is not bigger than the dataset.
+            uint32_t imgBlockSize = this->getImageBlockSize(band);
+            uint64_t smallestAxis = 0;
+            if(xSize < ySize)
+            {
+                smallestAxis = xSize;
+            }
+            else
+            {
+                smallestAxis = ySize;
+            }
+            if(smallestAxis < imgBlockSize)
+            {
+                dimsImageBandChunk[0] = smallestAxis;
+                dimsImageBandChunk[1] = smallestAxis;
+            }
+            else
+            {
+                dimsImageBandChunk[0] = imgBlockSize;
+                dimsImageBandChunk[1] = imgBlockSize;
+            }
+			
+            
+            H5::DSetCreatPropList initParamsImgBand;
+			initParamsImgBand.setChunk(2, dimsImageBandChunk);			
+			initParamsImgBand.setShuffle();
+            initParamsImgBand.setDeflate(KEA_DEFLATE);
+			initParamsImgBand.setFillValue( H5::PredType::NATIVE_INT, &initFillVal);
+            
+            H5::StrType strdatatypeLen6(H5::PredType::C_S1, 6);
+            H5::StrType strdatatypeLen4(H5::PredType::C_S1, 4);
+            const H5std_string strClassVal ("IMAGE");
+            const H5std_string strImgVerVal ("1.2");
+            H5::DataSpace attr_dataspace = H5::DataSpace(H5S_SCALAR);
+                        
+            // CREATE THE IMAGE DATA ARRAY
+            this->beginHeaderChange();
+            H5::DataSet imgBandDataSet = this->keaImgFile->createDataSet(overviewName, imgBandDT, imgBandDataSpace, initParamsImgBand);
+            
+            H5::Attribute classAttribute = imgBandDataSet.createAttribute(KEA_ATTRIBUTENAME_CLASS, strdatatypeLen6, attr_dataspace);
+            classAttribute.write(strdatatypeLen6, strClassVal); 
+            classAttribute.close();
+            
+            H5::Attribute imgVerAttribute = imgBandDataSet.createAttribute(KEA_ATTRIBUTENAME_IMAGE_VERSION, strdatatypeLen4, attr_dataspace);
+            imgVerAttribute.write(strdatatypeLen4, strImgVerVal);
+            imgVerAttribute.close();
+            
+            H5::Attribute blockSizeAttribute = imgBandDataSet.createAttribute(KEA_ATTRIBUTENAME_BLOCK_SIZE, H5::PredType::STD_U16LE, attr_dataspace);
+            uint32_t blockSizeTmp = dimsImageBandChunk[0]; // copy into a temporary variable to write to the file - fixing a bug on solaris.
+            blockSizeAttribute.write(H5::PredType::NATIVE_UINT32, &blockSizeTmp);
+            blockSizeAttribute.close();
+            
+            imgBandDataSet.close();
+            
+            attr_dataspace.close();
+            imgBandDataSet.close();
+            
+            this->updateConsolidatedHeader(band);
+            keaFlushFile(this->keaImgFile);
+        }
+        catch (const H5::Exception &e)
+        {
+            throw KEAIOException(e.getCDetailMsg());
+        }
+        catch ( const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
     }
     
-    void KEAImageIO::setGCPProjection(const std::string &projWKT)
+    void KEAImageIO::removeOverview(uint32_t band, uint32_t overview)
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        // SET THE WKT STRING SPATAIL REFERENCE IN GLOBAL HEADER
-        try
+        // THE OVERVIEW DATASET MAY BE CACHED BY THE READ PATH
+        this->clearChunkedDatasets();
+        
+        std::string overviewName = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_OVERVIEWSNAME_OVERVIEW + uint2Str(overview);
+        
+        try 
         {
-            const char *wStrdata[1];
-            H5::DataSet datasetSpatialReference = this->keaImgFile->openDataSet(KEA_GCPS_PROJ);
-            H5::DataType strDataType = datasetSpatialReference.getDataType();
-            wStrdata[0] = projWKT.c_str();
-            datasetSpatialReference.write((void*)wStrdata, strDataType);
-            datasetSpatialReference.close();
-            this->keaImgFile->flush(H5F_SCOPE_GLOBAL);
+            // Try to open dataset with overviewName
+            H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( overviewName );
+            this->beginHeaderChange();
+            this->keaImgFile->unlink(overviewName);
+            this->updateConsolidatedHeader(band);
+            keaFlushFile(this->keaImgFile);
         }
         catch (const H5::Exception &e)
         {
-            const char *wStrdata[1];
-			hsize_t	dimsForStr[1];
-			dimsForStr[0] = 1; // number of lines;
-            H5::DataSpace dataspaceStrAll(1, dimsForStr);
-            H5::StrType strTypeAll(0, H5T_VARIABLE);
-            H5::DataSet datasetSpatialReference = this->keaImgFile->createDataSet(KEA_GCPS_PROJ, strTypeAll, dataspaceStrAll);
-			wStrdata[0] = projWKT.c_str();
-			datasetSpatialReference.write((void*)wStrdata, strTypeAll);
-			datasetSpatialReference.close();
+            // Do nothing as dataset does not exist.
         }
         catch ( const KEAIOException &e)
         {
@@ -1829,92 +4598,203 @@ namespace kealib{
         {
             throw KEAIOException(e.what());
         }
+        
     }
     
-    void KEAImageIO::setSpatialInfo(KEAImageSpatialInfo *inSpatialInfo)
+    uint32_t KEAImageIO::getOverviewBlockSize(uint32_t band, uint32_t overview)
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
+        uint32_t ovBlockSize = 0;
+        
         try 
         {
-            // SET X AND Y TL IN GLOBAL HEADER
-            double doubleVals[2];
-            doubleVals[0] = inSpatialInfo->tlX;
-            doubleVals[1] = inSpatialInfo->tlY;
-            H5::DataSet spatialTLDataset = this->keaImgFile->openDataSet(KEA_DATASETNAME_HEADER_TL);
-			spatialTLDataset.write( doubleVals, H5::PredType::NATIVE_DOUBLE );
-            spatialTLDataset.close();
-            
-            // SET X AND Y RESOLUTION IN GLOBAL HEADER
-            doubleVals[0] = inSpatialInfo->xRes;
-            doubleVals[1] = inSpatialInfo->yRes;
-            H5::DataSet spatialResDataset = this->keaImgFile->openDataSet(KEA_DATASETNAME_HEADER_RES);
-			spatialResDataset.write( doubleVals, H5::PredType::NATIVE_DOUBLE );
-            spatialResDataset.close();
-            
-            // SET X AND Y ROTATION IN GLOBAL HEADER
-            doubleVals[0] = inSpatialInfo->xRot;
-            doubleVals[1] = inSpatialInfo->yRot;
-            H5::DataSet spatialRotDataset = this->keaImgFile->openDataSet(KEA_DATASETNAME_HEADER_ROT);
-			spatialRotDataset.write( doubleVals, H5::PredType::NATIVE_DOUBLE );
-            spatialRotDataset.close();
-            
-            // SET THE WKT STRING SPATAIL REFERENCE IN GLOBAL HEADER
-			const char *wStrdata[1];
-            H5::DataSet datasetSpatialReference = this->keaImgFile->openDataSet(KEA_DATASETNAME_HEADER_WKT);
-            H5::DataType strDataType = datasetSpatialReference.getDataType();
-			wStrdata[0] = inSpatialInfo->wktString.c_str();			
-			datasetSpatialReference.write((void*)wStrdata, strDataType);
-			datasetSpatialReference.close();
+            // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
+            if(band == 0)
+            {
+                throw KEAIOException("KEA Image Bands start at 1.");
+            }
+            else if(band > this->numImgBands)
+            {
+                throw KEAIOException("Band is not present within image."); 
+            }
             
-            this->keaImgFile->flush(H5F_SCOPE_GLOBAL);
-        } 
-        catch (const H5::Exception &e)
-        {
-            throw KEAIOException(e.getCDetailMsg());
+            // OPEN BAND DATASET
+            try 
+            {
+                std::string overviewName = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_OVERVIEWSNAME_OVERVIEW + uint2Str(overview);
+                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( overviewName );
+                H5::Attribute blockSizeAtt = imgBandDataset.openAttribute(KEA_ATTRIBUTENAME_BLOCK_SIZE);
+                blockSizeAtt.read(H5::PredType::NATIVE_UINT32, &ovBlockSize);
+                imgBandDataset.close();
+                blockSizeAtt.close();
+            } 
+            catch ( const H5::Exception &e) 
+            {
+                throw KEAIOException("Could not retrieve the overview block size.");
+            }            
         }
-        catch ( const KEAIOException &e)
+        catch(const KEAIOException &e)
         {
             throw e;
         }
+        catch( const H5::FileIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataSetIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataSpaceIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataTypeIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
         catch ( const std::exception &e)
         {
             throw KEAIOException(e.what());
         }
+        
+        return ovBlockSize;
     }
     
-    KEAImageSpatialInfo* KEAImageIO::getSpatialInfo()
+    void KEAImageIO::writeToOverview(uint32_t band, uint32_t overview, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeOut, uint64_t ySizeOut, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType)
     {
+        KEATraceScope trace("KEAImageIO::writeToOverview", KEA_TRACE_API, xSizeOut * ySizeOut * getDataTypeSize(inDataType));
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        return spatialInfoFile;
-    }
-    
-    uint32_t KEAImageIO::getNumOfImageBands()
-    {
-        if(!this->fileOpen)
+        try 
         {
-            throw KEAIOException("Image was not open.");
+            // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
+            if(band == 0)
+            {
+                throw KEAIOException("KEA Image Bands start at 1.");
+            }
+            else if(band > this->numImgBands)
+            {
+                throw KEAIOException("Band is not present within image."); 
+            }
+            
+            // GET NATIVE DATASET
+            H5::DataType imgBandDT = convertDatatypeKeaToH5Native(inDataType);
+
+            // OPEN BAND DATASET AND WRITE IMAGE DATA
+            try 
+            {
+                std::string overviewName = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_OVERVIEWSNAME_OVERVIEW + uint2Str(overview);
+                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( overviewName );
+                H5::DataSpace imgBandDataspace = imgBandDataset.getSpace();                
+                
+                hsize_t imgOffset[2];
+                imgOffset[0] = yPxlOff;
+                imgOffset[1] = xPxlOff;
+                hsize_t dataDims[2];
+                dataDims[0] = ySizeBuf;
+                dataDims[1] = xSizeBuf;
+                H5::DataSpace write2BandDataspace = H5::DataSpace(2, dataDims);
+                
+                if((ySizeOut != ySizeBuf) | (xSizeOut != xSizeBuf))
+                {                    
+                    hsize_t dataSelectMemDims[2];
+                    dataSelectMemDims[0] = ySizeOut;
+                    dataSelectMemDims[1] = 1;
+
+                    hsize_t dataOffDims[2];
+                    dataOffDims[0] = 0;
+                    dataOffDims[1] = 0;
+
+                    hsize_t dataSelectStrideDims[2];
+                    dataSelectStrideDims[0] = 1;
+                    if(xSizeBuf == xSizeOut)
+                    {
+                        dataSelectStrideDims[1] = 1;
+                    }
+                    else
+                    {
+                        dataSelectStrideDims[1] = xSizeBuf - xSizeOut;
+                    }
+
+                    hsize_t dataSelectBlockSizeDims[2];
+                    dataSelectBlockSizeDims[0] = 1;
+                    dataSelectBlockSizeDims[1] = xSizeOut;
+                    write2BandDataspace.selectHyperslab(H5S_SELECT_SET, dataSelectMemDims, dataOffDims, dataSelectStrideDims, dataSelectBlockSizeDims);
+                    
+                    hsize_t dataOutDims[2];
+                    dataOutDims[0] = ySizeOut;
+                    dataOutDims[1] = xSizeOut;
+                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataOutDims, imgOffset);
+                }
+                else
+                {
+                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataDims, imgOffset);
+                }
+                
+                {
+                    KEATraceScope h5Trace("H5Dwrite", KEA_TRACE_HDF5, xSizeOut * ySizeOut * getDataTypeSize(inDataType));
+                    imgBandDataset.write( data, imgBandDT, write2BandDataspace, imgBandDataspace);
+                }
+                
+                imgBandDataset.close();
+                imgBandDataspace.close();
+                write2BandDataspace.close();
+            } 
+            catch ( const H5::Exception &e) 
+            {
+                throw KEAIOException("Could not write image data.");
+            }
+            
+            keaFlushFile(this->keaImgFile);
+        }
+        catch(const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch( const H5::FileIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataSetIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataSpaceIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataTypeIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
         }
-        
-        return this->numImgBands;
     }
     
-    uint32_t KEAImageIO::getImageBlockSize(uint32_t band)
+    void KEAImageIO::readFromOverview(uint32_t band, uint32_t overview, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType)
     {
+        KEATraceScope trace("KEAImageIO::readFromOverview", KEA_TRACE_API, xSizeIn * ySizeIn * getDataTypeSize(inDataType));
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_pixels);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        uint32_t imgBlockSize = 0;
-        
         try 
         {
             // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
@@ -1927,19 +4807,77 @@ namespace kealib{
                 throw KEAIOException("Band is not present within image."); 
             }
             
-            // OPEN BAND DATASET
+            if(this->threadSafe)
+            {
+                this->readChunkedDataset(KEA_DATASETNAME_BAND + uint2Str(band) + KEA_OVERVIEWSNAME_OVERVIEW + uint2Str(overview), data, xPxlOff, yPxlOff, xSizeIn, ySizeIn, xSizeBuf, ySizeBuf, inDataType);
+                return;
+            }
+            
+            // GET NATIVE DATASET
+            H5::DataType imgBandDT = convertDatatypeKeaToH5Native(inDataType);
+            
+            // OPEN BAND DATASET AND READ IMAGE DATA
             try 
             {
-                std::string imageBandPath = KEA_DATASETNAME_BAND + uint2Str(band);
-                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( imageBandPath + KEA_BANDNAME_DATA );
-                H5::Attribute blockSizeAtt = imgBandDataset.openAttribute(KEA_ATTRIBUTENAME_BLOCK_SIZE);
-                blockSizeAtt.read(H5::PredType::NATIVE_UINT32, &imgBlockSize);
+                std::string overviewName = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_OVERVIEWSNAME_OVERVIEW + uint2Str(overview);
+                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( overviewName );
+                H5::DataSpace imgBandDataspace = imgBandDataset.getSpace();                
+                
+                hsize_t dataOffset[2];
+                dataOffset[0] = yPxlOff;
+                dataOffset[1] = xPxlOff;
+                hsize_t dataDims[2];
+                dataDims[0] = ySizeBuf;
+                dataDims[1] = xSizeBuf;
+                H5::DataSpace read2BandDataspace = H5::DataSpace(2, dataDims);
+                
+                if((ySizeBuf != ySizeIn) | (xSizeBuf != xSizeIn))
+                {
+                    hsize_t dataSelectMemDims[2];
+                    dataSelectMemDims[0] = ySizeIn;
+                    dataSelectMemDims[1] = 1;
+
+                    hsize_t dataOffDims[2];
+                    dataOffDims[0] = 0;
+                    dataOffDims[1] = 0;
+
+                    hsize_t dataSelectStrideDims[2];
+                    dataSelectStrideDims[0] = 1;
+                    if(xSizeBuf == xSizeIn)
+                    {
+                        dataSelectStrideDims[1] = 1;
+                    }
+                    else
+                    {
+                        dataSelectStrideDims[1] = xSizeBuf - xSizeIn;
+                    }
+
+                    hsize_t dataSelectBlockSizeDims[2];
+                    dataSelectBlockSizeDims[0] = 1;
+                    dataSelectBlockSizeDims[1] = xSizeIn;
+                    read2BandDataspace.selectHyperslab(H5S_SELECT_SET, dataSelectMemDims, dataOffDims, dataSelectStrideDims, dataSelectBlockSizeDims);
+                    
+                    hsize_t dataInDims[2];
+                    dataInDims[0] = ySizeIn;
+                    dataInDims[1] = xSizeIn;
+                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataInDims, dataOffset);
+                }
+                else
+                {
+                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataDims, dataOffset);
+                }
+                {
+                    KEATraceScope h5Trace("H5Dread", KEA_TRACE_HDF5, xSizeIn * ySizeIn * getDataTypeSize(inDataType));
+                    imgBandDataset.read( data, imgBandDT, read2BandDataspace, imgBandDataspace);
+                }
+                
                 imgBandDataset.close();
-                blockSizeAtt.close();
+                imgBandDataspace.close();
+                read2BandDataspace.close();
             } 
             catch ( const H5::Exception &e) 
             {
-                throw KEAIOException("Could not get image block size.");
+                throw KEAIOException("Could not read from image overview.");
             }            
         }
         catch(const KEAIOException &e)
@@ -1966,18 +4904,55 @@ namespace kealib{
         {
             throw KEAIOException(e.what());
         }
-        
-        return imgBlockSize;
     }
-
-    uint32_t KEAImageIO::getAttributeTableChunkSize(uint32_t band)
+    
+    uint32_t KEAImageIO::getNumOfOverviews(uint32_t band)
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        uint32_t attChunkSize = 0;
+        const KEABandHeader *bandHeader = this->getBandHeader(band);
+        if(bandHeader != nullptr)
+        {
+            return bandHeader->numOverviews;
+        }
+        
+        std::string overviewGroupName = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_OVERVIEWS;
+        uint32_t numOverviews = 0;
+        try 
+        {
+            // Try to open dataset with overviewName
+            H5::Group imgOverviewsGrp = this->keaImgFile->openGroup(overviewGroupName);
+            numOverviews = imgOverviewsGrp.getNumObjs();
+        }
+        catch (const H5::Exception &e)
+        {
+            throw KEAIOException("Could not retrieve the number of image band overviews.");
+        }
+        catch ( const KEAIOException &e)
+        {
+            throw e;
+        }
+        catch ( const std::exception &e)
+        {
+            throw KEAIOException(e.what());
+        }
+        
+        return numOverviews;
+    }
+    
+    void KEAImageIO::getOverviewSize(uint32_t band, uint32_t overview, uint64_t *xSize, uint64_t *ySize)
+    {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
         
         try 
         {
@@ -1988,78 +4963,76 @@ namespace kealib{
             }
             else if(band > this->numImgBands)
             {
-                throw KEAIOException("Band is not present within image."); 
+                throw KEAIOException("Band is not present within image."); 
+            }
+                        
+            // OPEN BAND DATASET AND READ THE IMAGE DIMENSIONS
+            try 
+            {
+                std::string overviewName = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_OVERVIEWSNAME_OVERVIEW + uint2Str(overview);
+                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( overviewName );
+                H5::DataSpace imgBandDataspace = imgBandDataset.getSpace();                
+                
+                uint32_t nDims = imgBandDataspace.getSimpleExtentNdims();
+                if(nDims != 2)
+                {
+                    throw KEAIOException("The number of dimensions for the overview must be 2.");
+                }
+                hsize_t dims[2];
+                imgBandDataspace.getSimpleExtentDims(dims);
+                
+                *xSize = dims[1];
+                *ySize = dims[0];
+
+                imgBandDataset.close();
+            } 
+            catch(const KEAIOException &e)
+            {
+                throw e;
             }
-            
-            // OPEN BAND DATASET
-            try 
-            {
-                hsize_t dimsValue[1];
-                dimsValue[0] = 1;
-                H5::DataSpace valueDataSpace(1, dimsValue);
-                std::string imageBandPath = KEA_DATASETNAME_BAND + uint2Str(band);
-                H5::DataSet datasetAttSize = this->keaImgFile->openDataSet( imageBandPath + KEA_ATT_CHUNKSIZE_HEADER);
-                datasetAttSize.read(&attChunkSize, H5::PredType::NATIVE_UINT32, valueDataSpace);
-                datasetAttSize.close();
-                valueDataSpace.close();
-            } 
             catch ( const H5::Exception &e) 
             {
-                throw KEAIOException("Could not get image block size.");
+                throw KEAIOException("Could not read from image overview.");
             }            
         }
-        catch(const KEAIOException &e)
+        catch( const H5::Exception &e )
+		{
+			throw KEAIOException("Could not get the overview size.");
+		}
+        catch ( const KEAIOException &e)
         {
             throw e;
         }
-        catch( const H5::FileIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataSetIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataSpaceIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataTypeIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
         catch ( const std::exception &e)
         {
             throw KEAIOException(e.what());
         }
-        
-        return attChunkSize;
     }
     
-    KEADataType KEAImageIO::getImageBandDataType(uint32_t band)
+    KEAAttributeTable* KEAImageIO::getAttributeTable(KEAATTType type, uint32_t band)
     {
-        if(!this->fileOpen)
-        {
-            throw KEAIOException("Image was not open.");
-        }
-        KEADataType imgDataType = kealib::kea_undefined;
+        KEATraceScope trace("KEAImageIO::getAttributeTable", KEA_TRACE_API);
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
         
-        // READ IMAGE DATA TYPE
+        KEAAttributeTable *att = nullptr;
         try 
         {
-            hsize_t dimsValue[1];
-            dimsValue[0] = 1;
-            H5::DataSpace valueDataSpace(1, dimsValue);
-            uint32_t value[1];
-            H5::DataSet datasetImgDT = this->keaImgFile->openDataSet( KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_DT );
-            datasetImgDT.read(value, H5::PredType::NATIVE_UINT32, valueDataSpace);
-            imgDataType = (KEADataType)value[0];
-            datasetImgDT.close();
-            valueDataSpace.close();
-        } 
-        catch ( const H5::Exception &e) 
+            if(type == kea_att_mem)
+            {
+                att = kealib::KEAAttributeTableInMem::createKeaAtt(this->keaImgFile, band);
+            }
+            else if(type == kea_att_file)
+            {
+                att = kealib::KEAAttributeTableFile::createKeaAtt(this->keaImgFile, band);
+            }
+            else
+            {
+                throw KEAATTException("The attribute table type was not recognised.");
+            }
+        }
+        catch(const KEAATTException &e)
         {
-            throw KEAIOException("The image band data type was not specified.");
+            throw e;
         }
         catch ( const KEAIOException &e)
         {
@@ -2070,38 +5043,28 @@ namespace kealib{
             throw KEAIOException(e.what());
         }
         
-        return imgDataType;
+        return att;
     }
     
-    std::string KEAImageIO::getKEAImageVersion() 
+    void KEAImageIO::setAttributeTable(KEAAttributeTable* att, uint32_t band, uint32_t chunkSize, uint32_t deflate)
     {
-        if(!this->fileOpen)
-        {
-            throw KEAIOException("Image was not open.");
-        }
+        KEATraceScope trace("KEAImageIO::setAttributeTable", KEA_TRACE_API);
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
         
-        return this->keaVersion;
-    }
-    
-    void KEAImageIO::setImageBandLayerType(uint32_t band, KEALayerType imgLayerType)
-    {
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
-                
-        // WRITE IMAGE LAYER TYPE
+        
         try 
         {
-            uint32_t value = (uint32_t)imgLayerType;
-            H5::DataSet datasetImgLT = this->keaImgFile->openDataSet( KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_TYPE );
-            datasetImgLT.write(&value, H5::PredType::NATIVE_UINT32);
-            datasetImgLT.close();
-            this->keaImgFile->flush(H5F_SCOPE_GLOBAL);
-        } 
-        catch ( const H5::Exception &e) 
+            att->exportToKeaFile(this->keaImgFile, band, chunkSize, deflate);
+            keaFlushFile(this->keaImgFile);
+            this->clearColourTableCache();
+        }
+        catch(const KEAATTException &e)
         {
-            throw KEAIOException("The image band data type was not specified.");
+            throw e;
         }
         catch ( const KEAIOException &e)
         {
@@ -2113,405 +5076,606 @@ namespace kealib{
         }
     }
     
-    KEALayerType KEAImageIO::getImageBandLayerType(uint32_t band)
+    bool KEAImageIO::attributeTablePresent(uint32_t band)
     {
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_read);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
         
-        KEALayerType imgLayerType = kea_continuous;
-        
-        // READ IMAGE LAYER TYPE
+        bool attPresent = false;
         try 
         {
-            hsize_t dimsValue[1];
-            dimsValue[0] = 1;
-            H5::DataSpace valueDataSpace(1, dimsValue);
-            uint32_t value[1];
-            H5::DataSet datasetImgLT = this->keaImgFile->openDataSet( KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_TYPE );
-            datasetImgLT.read(value, H5::PredType::NATIVE_UINT32, valueDataSpace);
-            imgLayerType = (KEALayerType)value[0];
-            datasetImgLT.close();
-            valueDataSpace.close();
-        } 
-        catch ( const H5::Exception &e) 
+            std::string bandPathBase = KEA_DATASETNAME_BAND + uint2Str(band);
+            hsize_t attSize[5];
+            try 
+            {   
+                hsize_t dimsValue[1];
+                dimsValue[0] = 5;
+                H5::DataSpace valueDataSpace(1, dimsValue);
+                H5::DataSet datasetAttSize = this->keaImgFile->openDataSet( bandPathBase + KEA_ATT_SIZE_HEADER );
+                datasetAttSize.read(attSize, H5::PredType::STD_U64LE, valueDataSpace);
+                datasetAttSize.close();
+                valueDataSpace.close();
+            } 
+            catch (const H5::Exception &e) 
+            {
+                throw KEAIOException("The attribute table size field is not present.");
+            }
+            
+            if(attSize[0] > 0)
+            {
+                attPresent = true;
+            }
+        }
+        catch(const KEAIOException &e)
         {
-            throw KEAIOException("The image band data type was not specified.");
+            throw e;
         }
-        catch ( const KEAIOException &e)
+        catch(const KEAATTException &e)
         {
             throw e;
         }
+        catch( const H5::Exception &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
         catch ( const std::exception &e)
         {
             throw KEAIOException(e.what());
         }
-        
-        return imgLayerType;
+        return attPresent;
     }
-    
-    void KEAImageIO::setImageBandClrInterp(uint32_t band, KEABandClrInterp imgLayerClrInterp)
+
+    // looks up each pixel in lut, leaving pixels which are no data,
+    // negative or off the end of the table as they are (the output no
+    // data value)
+    template <typename T>
+    static void keaRemapBlock(KEABlock &block, const std::vector<T> &lut)
+    {
+        const int64_t *values = block.getInput<int64_t>(0);
+        int64_t noData = 0;
+        bool hasNoData = block.inputs[0].getIDNoData(&noData);
+        T *out = block.getOutput<T>(0);
+        const T *lutData = lut.data();
+        uint64_t lutSize = lut.size();
+        uint64_t numPixels = block.getNumPixels();
+        for(uint64_t i = 0; i < numPixels; ++i)
+        {
+            int64_t value = values[i];
+            if((value >= 0) && (static_cast<uint64_t>(value) < lutSize) && (!hasNoData || (value != noData)))
+            {
+                out[i] = lutData[value];
+            }
+        }
+    }
+
+    void KEAImageIO::remapBandThroughAttribute(uint32_t srcBand, const std::string &column, KEAImageIO *outIO, uint32_t outBand, uint32_t numThreads)
     {
+        KEATraceScope trace("KEAImageIO::remapBandThroughAttribute", KEA_TRACE_API);
+        // NO LOCK HERE, THE BLOCK PROCESSOR CALLS BACK INTO THE PUBLIC READ
+        // AND WRITE FUNCTIONS WHICH TAKE IT THEMSELVES
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
-        
-        // WRITE IMAGE LAYER USAGE
-        uint32_t value = (uint32_t) imgLayerClrInterp;
-        try 
+
+        // LOAD THE COLUMN INTO A LOOKUP TABLE A CHUNK AT A TIME
+        std::vector<int64_t> intLUT;
+        std::vector<double> floatLUT;
+        bool floatColumn = false;
+        KEAAttributeTable *att = this->getAttributeTable(kea_att_file, srcBand);
+        try
         {
-            H5::DataSet datasetImgLU = this->keaImgFile->openDataSet( KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_USAGE );
-            datasetImgLU.write(&value, H5::PredType::NATIVE_UINT32);
-            datasetImgLU.close();
-            this->keaImgFile->flush(H5F_SCOPE_GLOBAL);
-        } 
-        catch ( const H5::Exception &e) 
+            KEAATTField field = att->getField(column);
+            size_t numRows = att->getSize();
+            size_t batchRows = this->getAttributeTableChunkSize(srcBand);
+            if(batchRows == 0)
+            {
+                batchRows = KEA_ATT_CHUNK_SIZE;
+            }
+            std::vector<bool> boolBuffer;
+            if(field.dataType == kea_att_float)
+            {
+                floatColumn = true;
+                floatLUT.resize(numRows);
+            }
+            else if((field.dataType == kea_att_int) || (field.dataType == kea_att_bool))
+            {
+                intLUT.resize(numRows);
+            }
+            else
+            {
+                throw KEAATTException("Column '" + column + "' is not an int, bool or float column.");
+            }
+            for(size_t startRow = 0; startRow < numRows; startRow += batchRows)
+            {
+                size_t len = std::min(batchRows, numRows - startRow);
+                if(field.dataType == kea_att_float)
+                {
+                    att->getFloatFields(startRow, len, field.idx, &floatLUT[startRow]);
+                }
+                else if(field.dataType == kea_att_int)
+                {
+                    att->getIntFields(startRow, len, field.idx, &intLUT[startRow]);
+                }
+                else
+                {
+                    std::unique_ptr<bool[]> bools(new bool[len]);
+                    att->getBoolFields(startRow, len, field.idx, bools.get());
+                    std::copy(bools.get(), bools.get() + len, intLUT.begin() + startRow);
+                }
+            }
+        }
+        catch(...)
         {
-            hsize_t dimsUsage[1];
-            dimsUsage[0] = 1;
-            H5::DataSpace usageDataSpace(1, dimsUsage);
-            H5::DataSet usageDataset = this->keaImgFile->createDataSet((KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_USAGE), H5::PredType::STD_U8LE, usageDataSpace);
-            usageDataset.write( &value, H5::PredType::NATIVE_UINT32 );
-            usageDataset.close();
+            KEAAttributeTable::destroyAttributeTable(att);
+            throw;
         }
-        catch ( const KEAIOException &e)
+        KEAAttributeTable::destroyAttributeTable(att);
+
+        KEABlockProcessor processor(numThreads);
+        processor.addInput(this, srcBand, kea_64int);
+        if(floatColumn)
         {
-            throw e;
+            processor.addOutput(outIO, outBand, kea_64float);
+            processor.run([&floatLUT](KEABlock &block){ keaRemapBlock(block, floatLUT); });
         }
-        catch ( const std::exception &e)
+        else
         {
-            throw KEAIOException(e.what());
+            processor.addOutput(outIO, outBand, kea_64int);
+            processor.run([&intLUT](KEABlock &block){ keaRemapBlock(block, intLUT); });
         }
     }
     
-    KEABandClrInterp KEAImageIO::getImageBandClrInterp(uint32_t band)
+    // writes the colour of each value to out (4 bytes per pixel, which may
+    // not be aligned), 0 for values which are negative, noData or off the
+    // end of the table
+    static void keaColourLookup(const int64_t *values, uint64_t numPixels, const uint32_t *lut, uint64_t lutSize, int64_t noData, uint8_t *out)
     {
-        if(!this->fileOpen)
+        for(uint64_t i = 0; i < numPixels; ++i)
         {
-            throw KEAIOException("Image was not open.");
+            int64_t value = values[i];
+            uint32_t colour = ((value >= 0) && (static_cast<uint64_t>(value) < lutSize) && (value != noData)) ? lut[value] : 0;
+            memcpy(out + (i * 4), &colour, 4);
         }
-        
-        KEABandClrInterp imgLayerClrInterp = kea_generic;
-        
-        // READ IMAGE LAYER USAGE
-        try 
+    }
+
+#ifdef KEA_AVX2_GATHER
+    // the same, four pixels at a time
+    __attribute__((target("avx2")))
+    static void keaColourLookupAVX2(const int64_t *values, uint64_t numPixels, const uint32_t *lut, uint64_t lutSize, int64_t noData, uint8_t *out)
+    {
+        const __m256i maxValue = _mm256_set1_epi64x(static_cast<int64_t>(std::min<uint64_t>(lutSize, std::numeric_limits<int64_t>::max())));
+        const __m256i minusOne = _mm256_set1_epi64x(-1);
+        const __m256i noDataValue = _mm256_set1_epi64x(noData);
+        const __m256i packLow = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+        uint64_t i = 0;
+        for(; (i + 4) <= numPixels; i += 4)
+        {
+            __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+            __m256i inTable = _mm256_and_si256(_mm256_cmpgt_epi64(value, minusOne), _mm256_cmpgt_epi64(maxValue, value));
+            __m256i valid = _mm256_andnot_si256(_mm256_cmpeq_epi64(value, noDataValue), inTable);
+            // MASKED OFF LANES ARE NOT READ, THE INDEX IS ZEROED ANYWAY
+            __m128i mask = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(valid, packLow));
+            __m128i colours = _mm256_mask_i64gather_epi32(_mm_setzero_si128(), reinterpret_cast<const int*>(lut), _mm256_and_si256(value, valid), mask, 4);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (i * 4)), colours);
+        }
+        keaColourLookup(values + i, numPixels - i, lut, lutSize, noData, out + (i * 4));
+    }
+#endif
+
+    // finds a colour column by usage, falling back to the name
+    static bool keaFindColourColumn(const KEAAttributeTable *att, const std::string &colour, size_t *colIdx)
+    {
+        std::vector<std::string> names = att->getFieldNames();
+        for(int byName = 0; byName < 2; ++byName)
         {
-            hsize_t dimsValue[1];
-            dimsValue[0] = 1;
-            H5::DataSpace valueDataSpace(1, dimsValue);
-            uint32_t value[1];
-            H5::DataSet datasetImgLU = this->keaImgFile->openDataSet( KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_USAGE );
-            datasetImgLU.read(value, H5::PredType::NATIVE_UINT32, valueDataSpace);
-            imgLayerClrInterp = (KEABandClrInterp)value[0];
-            datasetImgLU.close();
-            valueDataSpace.close();
-        } 
-        catch ( const H5::Exception &e) 
+            for(const std::string &name : names)
+            {
+                KEAATTField field = att->getField(name);
+                if((field.dataType == kea_att_int) && (((byName == 0) && (field.usage == colour)) || ((byName == 1) && (name == colour))))
+                {
+                    *colIdx = field.idx;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    std::shared_ptr< const std::vector<uint32_t> > KEAImageIO::getColourTable(uint32_t band)
+    {
         {
-            //throw KEAIOException("The image band data type was not specified.");
-            imgLayerClrInterp = kea_generic; // Field was not present within the file.
+            std::lock_guard<std::mutex> lock(this->colourTablesMutex);
+            auto iterTable = this->colourTables.find(band);
+            if(iterTable != this->colourTables.end())
+            {
+                return iterTable->second;
+            }
         }
-        catch ( const KEAIOException &e)
+
+        std::shared_ptr< std::vector<uint32_t> > colourTable = std::make_shared< std::vector<uint32_t> >();
+        KEAAttributeTable *att = this->getAttributeTable(kea_att_file, band);
+        try
         {
-            throw e;
+            static const char *colourNames[] = { "Red", "Green", "Blue", "Alpha" };
+            size_t colIdxs[4];
+            bool haveAlpha = true;
+            for(int c = 0; c < 4; ++c)
+            {
+                if(!keaFindColourColumn(att, colourNames[c], &colIdxs[c]))
+                {
+                    if(c < 3)
+                    {
+                        throw KEAATTException("The attribute table does not have a colour table.");
+                    }
+                    haveAlpha = false;
+                }
+            }
+
+            size_t numRows = att->getSize();
+            size_t batchRows = this->getAttributeTableChunkSize(band);
+            if(batchRows == 0)
+            {
+                batchRows = KEA_ATT_CHUNK_SIZE;
+            }
+            colourTable->resize(numRows);
+            std::vector<int64_t> values(batchRows);
+            uint8_t *rgba = reinterpret_cast<uint8_t*>(colourTable->data());
+            for(size_t startRow = 0; startRow < numRows; startRow += batchRows)
+            {
+                size_t len = std::min(batchRows, numRows - startRow);
+                for(int c = 0; c < 4; ++c)
+                {
+                    if((c == 3) && !haveAlpha)
+                    {
+                        std::fill(values.begin(), values.begin() + len, 255);
+                    }
+                    else
+                    {
+                        att->getIntFields(startRow, len, colIdxs[c], values.data());
+                    }
+                    for(size_t r = 0; r < len; ++r)
+                    {
+                        rgba[((startRow + r) * 4) + c] = static_cast<uint8_t>(std::min<int64_t>(std::max<int64_t>(values[r], 0), 255));
+                    }
+                }
+            }
         }
-        catch ( const std::exception &e)
+        catch(...)
         {
-            throw KEAIOException(e.what());
+            KEAAttributeTable::destroyAttributeTable(att);
+            throw;
         }
-        
-        return imgLayerClrInterp;
+        KEAAttributeTable::destroyAttributeTable(att);
+
+        std::lock_guard<std::mutex> lock(this->colourTablesMutex);
+        this->colourTables[band] = colourTable;
+        return colourTable;
     }
-    
-    void KEAImageIO::createOverview(uint32_t band, uint32_t overview, uint64_t xSize, uint64_t ySize)
+
+    void KEAImageIO::clearColourTableCache()
+    {
+        std::lock_guard<std::mutex> lock(this->colourTablesMutex);
+        this->colourTables.clear();
+    }
+
+    void KEAImageIO::renderColourTable(uint32_t band, uint32_t overview, uint8_t *rgba, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSize, uint64_t ySize, uint32_t numThreads)
     {
+        KEATraceScope trace("KEAImageIO::renderColourTable", KEA_TRACE_API, xSize * ySize * 4);
+        // NO LOCK HERE, THE READS TAKE IT THEMSELVES
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
-        
-        std::string overviewName = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_OVERVIEWSNAME_OVERVIEW + uint2Str(overview);
-                
-        try 
-        {
-            // Try to open dataset with overviewName
-            H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( overviewName );
-            this->keaImgFile->unlink(overviewName);
-        }
-        catch (const H5::Exception &e)
+        if((xSize == 0) || (ySize == 0))
         {
-            // Do nothing as dataset does not exist.
+            return;
         }
-        
-        try 
+
+        std::shared_ptr< const std::vector<uint32_t> > colourTable = this->getColourTable(band);
+        const uint32_t *lut = colourTable->data();
+        uint64_t lutSize = colourTable->size();
+
+        // NEGATIVE VALUES ARE NO DATA ANYWAY SO -1 MATCHES NOTHING EXTRA
+        int64_t noData = -1;
+        try
         {
-            KEADataType imgDataType = this->getImageBandDataType(band);
-            
-            H5::DataType imgBandDT = convertDatatypeKeaToH5STD(imgDataType);
-            int initFillVal = 0;
-            
-            hsize_t imageBandDims[2];
-            imageBandDims[0] = ySize;
-            imageBandDims[1] = xSize;
-            H5::DataSpace imgBandDataSpace(2, imageBandDims);
-            
-            hsize_t dimsImageBandChunk[2];
-            // Make sure that the chuck size is not bigger than the dataset.
-            uint32_t imgBlockSize = this->getImageBlockSize(band);
-            uint64_t smallestAxis = 0;
-            if(xSize < ySize)
-            {
-                smallestAxis = xSize;
-            }
-            else
+            double noDataValue = 0;
+            this->getNoDataValue(band, &noDataValue, kea_64float);
+            if(!KEABlockBuffer::valueToID(noDataValue, &noData))
             {
-                smallestAxis = ySize;
+                noData = -1;
             }
-            if(smallestAxis < imgBlockSize)
+        }
+        catch(const KEAIOException &)
+        {
+            noData = -1;
+        }
+#ifdef KEA_AVX2_GATHER
+        const bool useAVX2 = __builtin_cpu_supports("avx2");
+#endif
+
+        // ONE STRIP OF CHUNK ROWS PER TASK
+        uint64_t stripRows = (overview == 0) ? this->getImageBlockSize(band) : this->getOverviewBlockSize(band, overview);
+        if(stripRows == 0)
+        {
+            stripRows = KEA_IMAGE_CHUNK_SIZE;
+        }
+        uint64_t firstStripEnd = std::min(yPxlOff + ySize, ((yPxlOff / stripRows) + 1) * stripRows);
+        uint64_t numStrips = 1 + (((yPxlOff + ySize) - firstStripEnd) + stripRows - 1) / stripRows;
+
+        // IMAGES WHICH AREN'T THREAD SAFE ARE READ ONE STRIP AT A TIME
+        std::mutex readMutex;
+        auto renderStrip = [&](size_t strip)
+        {
+            uint64_t stripStart = (strip == 0) ? yPxlOff : (firstStripEnd + ((strip - 1) * stripRows));
+            uint64_t stripEnd = (strip == 0) ? firstStripEnd : std::min(stripStart + stripRows, yPxlOff + ySize);
+            uint64_t numPixels = xSize * (stripEnd - stripStart);
+            std::vector<int64_t> values(numPixels);
             {
-                dimsImageBandChunk[0] = smallestAxis;
-                dimsImageBandChunk[1] = smallestAxis;
+                std::unique_lock<std::mutex> readLock(readMutex, std::defer_lock);
+                if(!this->threadSafe)
+                {
+                    readLock.lock();
+                }
+                if(overview == 0)
+                {
+                    this->readImageBlock2Band(band, values.data(), xPxlOff, stripStart, xSize, stripEnd - stripStart, xSize, stripEnd - stripStart, kea_64int);
+                }
+                else
+                {
+                    this->readFromOverview(band, overview, values.data(), xPxlOff, stripStart, xSize, stripEnd - stripStart, xSize, stripEnd - stripStart, kea_64int);
+                }
             }
-            else
+
+            uint8_t *out = rgba + ((stripStart - yPxlOff) * xSize * 4);
+#ifdef KEA_AVX2_GATHER
+            if(useAVX2)
             {
-                dimsImageBandChunk[0] = imgBlockSize;
-                dimsImageBandChunk[1] = imgBlockSize;
+                keaColourLookupAVX2(values.data(), numPixels, lut, lutSize, noData, out);
+                return;
             }
-			
-            
-            H5::DSetCreatPropList initParamsImgBand;
-			initParamsImgBand.setChunk(2, dimsImageBandChunk);			
-			initParamsImgBand.setShuffle();
-            initParamsImgBand.setDeflate(KEA_DEFLATE);
-			initParamsImgBand.setFillValue( H5::PredType::NATIVE_INT, &initFillVal);
-            
-            H5::StrType strdatatypeLen6(H5::PredType::C_S1, 6);
-            H5::StrType strdatatypeLen4(H5::PredType::C_S1, 4);
-            const H5std_string strClassVal ("IMAGE");
-            const H5std_string strImgVerVal ("1.2");
-            H5::DataSpace attr_dataspace = H5::DataSpace(H5S_SCALAR);
-                        
-            // CREATE THE IMAGE DATA ARRAY
-            H5::DataSet imgBandDataSet = this->keaImgFile->createDataSet(overviewName, imgBandDT, imgBandDataSpace, initParamsImgBand);
-            
-            H5::Attribute classAttribute = imgBandDataSet.createAttribute(KEA_ATTRIBUTENAME_CLASS, strdatatypeLen6, attr_dataspace);
-            classAttribute.write(strdatatypeLen6, strClassVal); 
-            classAttribute.close();
-            
-            H5::Attribute imgVerAttribute = imgBandDataSet.createAttribute(KEA_ATTRIBUTENAME_IMAGE_VERSION, strdatatypeLen4, attr_dataspace);
-            imgVerAttribute.write(strdatatypeLen4, strImgVerVal);
-            imgVerAttribute.close();
-            
-            H5::Attribute blockSizeAttribute = imgBandDataSet.createAttribute(KEA_ATTRIBUTENAME_BLOCK_SIZE, H5::PredType::STD_U16LE, attr_dataspace);
-            uint32_t blockSizeTmp = dimsImageBandChunk[0]; // copy into a temporary variable to write to the file - fixing a bug on solaris.
-            blockSizeAttribute.write(H5::PredType::NATIVE_UINT32, &blockSizeTmp);
-            blockSizeAttribute.close();
-            
-            imgBandDataSet.close();
-            
-            attr_dataspace.close();
-            imgBandDataSet.close();
-            
-            this->keaImgFile->flush(H5F_SCOPE_GLOBAL);
-        }
-        catch (const H5::Exception &e)
+#endif
+            keaColourLookup(values.data(), numPixels, lut, lutSize, noData, out);
+        };
+
+        if(numThreads == 0)
         {
-            throw KEAIOException(e.getCDetailMsg());
+            numThreads = KEAThreadPool::getDefaultNumThreads();
         }
-        catch ( const KEAIOException &e)
+        numThreads = static_cast<uint32_t>(std::min<uint64_t>(numThreads, numStrips));
+        if(numThreads <= 1)
         {
-            throw e;
+            for(uint64_t strip = 0; strip < numStrips; ++strip)
+            {
+                renderStrip(strip);
+            }
         }
-        catch ( const std::exception &e)
+        else
         {
-            throw KEAIOException(e.what());
+            KEAThreadPool threadPool(numThreads - 1);
+            threadPool.parallelFor(numStrips, renderStrip);
         }
     }
     
-    void KEAImageIO::removeOverview(uint32_t band, uint32_t overview)
+    void KEAImageIO::close()
     {
-        if(!this->fileOpen)
+        KEATraceScope trace("KEAImageIO::close", KEA_TRACE_API);
+        // THE I/O THREADS NEED THE LOCK SO HAVE TO FINISH FIRST
+        this->stopAsyncReader();
+        std::exception_ptr asyncError = this->stopAsyncWriter();
         {
-            throw KEAIOException("Image was not open.");
+            std::lock_guard<std::mutex> poolLock(this->samplePoolMutex);
+            this->samplePool.reset();
         }
         
-        std::string overviewName = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_OVERVIEWSNAME_OVERVIEW + uint2Str(overview);
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
         
         try 
         {
-            // Try to open dataset with overviewName
-            H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( overviewName );
-            this->keaImgFile->unlink(overviewName);
-            this->keaImgFile->flush(H5F_SCOPE_GLOBAL);
-        }
-        catch (const H5::Exception &e)
-        {
-            // Do nothing as dataset does not exist.
+            this->clearChunkedDatasets();
+            delete this->spatialInfoFile;
+            this->bandHeaders.clear();
+            this->bandHeadersLoaded = false;
+            this->haveConsolidatedHeader = false;
+            this->clearColourTableCache();
+            this->keaImgFile->close();
+            delete this->keaImgFile;
+            this->keaImgFile = nullptr;
+            this->fileOpen = false;
+            
+            if(asyncError)
+            {
+                std::rethrow_exception(asyncError);
+            }
         }
-        catch ( const KEAIOException &e)
+        catch(const KEAIOException &e)
         {
             throw e;
         }
+        catch( const H5::Exception &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
         catch ( const std::exception &e)
         {
             throw KEAIOException(e.what());
         }
-        
     }
-    
-    uint32_t KEAImageIO::getOverviewBlockSize(uint32_t band, uint32_t overview)
+        
+    H5::H5File* KEAImageIO::createKEAImage(const std::string &fileName, KEADataType dataType, uint32_t xSize, uint32_t ySize, uint32_t numImgBands, std::vector<std::string> *bandDescrips, KEAImageSpatialInfo * spatialInfo, uint32_t imageBlockSize, uint32_t attBlockSize, int mdcElmts, hsize_t rdccNElmts, hsize_t rdccNBytes, double rdccW0, hsize_t sieveBuf, hsize_t metaBlockSize, uint32_t deflate, KEAImageExtend extend, hsize_t fileSpacePageSize)
     {
-        if(!this->fileOpen)
-        {
-            throw KEAIOException("Image was not open.");
-        }
+        KEATraceScope trace("KEAImageIO::createKEAImage", KEA_TRACE_API);
+        H5::Exception::dontPrint();
         
-        uint32_t ovBlockSize = 0;
+        H5::H5File *keaImgH5File = nullptr;
         
         try 
         {
-            // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
-            if(band == 0)
+            // CREATE HDF FILE ACCESS PROPERTIES - DEFAULT VALUES CAN BE TUNED FROM KEACommon.h
+            H5::FileAccPropList keaAccessPlist = H5::FileAccPropList(H5::FileAccPropList::DEFAULT);
+            keaAccessPlist.setCache(mdcElmts, rdccNElmts, rdccNBytes, rdccW0);
+            keaAccessPlist.setSieveBufSize(sieveBuf);
+            keaAccessPlist.setMetaBlockSize(metaBlockSize);
+            
+            // PAGED AGGREGATION KEEPS THE METADATA TOGETHER IN ALIGNED PAGES
+            H5::FileCreatPropList keaCreatePlist;
+            if(fileSpacePageSize > 0)
             {
-                throw KEAIOException("KEA Image Bands start at 1.");
+#if H5_VERSION_GE(1,10,1)
+                if((H5Pset_file_space_strategy(keaCreatePlist.getId(), H5F_FSPACE_STRATEGY_PAGE, false, 1) < 0) ||
+                   (H5Pset_file_space_page_size(keaCreatePlist.getId(), fileSpacePageSize) < 0))
+                {
+                    throw KEAIOException("Could not set the file space page size.");
+                }
+#else
+                throw KEAIOException("Paged aggregation needs HDF5 1.10.1 or later.");
+#endif
             }
-            else if(band > this->numImgBands)
+            
+            // CREATE THE HDF FILE - EXISTING FILE WILL BE TRUNCATED
+            keaImgH5File = new H5::H5File( fileName, H5F_ACC_TRUNC, keaCreatePlist, keaAccessPlist);
+            
+            //////////// CREATE GLOBAL HEADER ////////////////
+            keaImgH5File->createGroup( KEA_DATASETNAME_HEADER );
+            
+            bool deleteSpatialInfo = false;
+            if(spatialInfo == nullptr)
             {
-                throw KEAIOException("Band is not present within image."); 
+                spatialInfo = new KEAImageSpatialInfo();
+                spatialInfo->tlX = 0.0;
+                spatialInfo->tlY = 0.0;
+                spatialInfo->xRes = 1.0;
+                spatialInfo->yRes = -1.0;
+                spatialInfo->xRot = 0.0;
+                spatialInfo->yRot = 0.0;
+                spatialInfo->wktString = "";
+                deleteSpatialInfo = true;
             }
             
-            // OPEN BAND DATASET
-            try 
-            {
-                std::string overviewName = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_OVERVIEWSNAME_OVERVIEW + uint2Str(overview);
-                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( overviewName );
-                H5::Attribute blockSizeAtt = imgBandDataset.openAttribute(KEA_ATTRIBUTENAME_BLOCK_SIZE);
-                blockSizeAtt.read(H5::PredType::NATIVE_UINT32, &ovBlockSize);
-                imgBandDataset.close();
-                blockSizeAtt.close();
-            } 
-            catch ( const H5::Exception &e) 
-            {
-                throw KEAIOException("Could not retrieve the overview block size.");
-            }            
-        }
-        catch(const KEAIOException &e)
-        {
-            throw e;
-        }
-        catch( const H5::FileIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataSetIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataSpaceIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataTypeIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-        catch ( const std::exception &e)
-        {
-            throw KEAIOException(e.what());
-        }
-        
-        return ovBlockSize;
-    }
-    
-    void KEAImageIO::writeToOverview(uint32_t band, uint32_t overview, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeOut, uint64_t ySizeOut, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType)
-    {
-        if(!this->fileOpen)
-        {
-            throw KEAIOException("Image was not open.");
-        }
-        
-        try 
-        {
-            // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
-            if(band == 0)
-            {
-                throw KEAIOException("KEA Image Bands start at 1.");
-            }
-            else if(band > this->numImgBands)
+            spatialInfo->xSize = xSize;
+            spatialInfo->ySize = ySize;
+                        
+            // SET NUMBER OF IMAGE BANDS IN GLOBAL HEADER
+            KEAImageIO::setNumImgBandsInFileMetadata(keaImgH5File, numImgBands);
+                                    
+            // SET X AND Y TL IN GLOBAL HEADER
+            double doubleVals[2];
+            doubleVals[0] = spatialInfo->tlX;
+            doubleVals[1] = spatialInfo->tlY;
+            hsize_t dimsSpatialTL[1];
+			dimsSpatialTL[0] = 2;
+            H5::DataSpace spatialTLDataSpace(1, dimsSpatialTL);
+            H5::DataSet spatialTLDataset = keaImgH5File->createDataSet(KEA_DATASETNAME_HEADER_TL, H5::PredType::IEEE_F64LE, spatialTLDataSpace);
+			spatialTLDataset.write( doubleVals, H5::PredType::NATIVE_DOUBLE );
+            spatialTLDataset.close();
+            spatialTLDataSpace.close();
+            
+            // SET X AND Y RESOLUTION IN GLOBAL HEADER
+            float floatVals[2];
+            floatVals[0] = spatialInfo->xRes;
+            floatVals[1] = spatialInfo->yRes;
+            hsize_t dimsSpatialRes[1];
+			dimsSpatialRes[0] = 2;
+            H5::DataSpace spatialResDataSpace(1, dimsSpatialRes);
+            H5::DataSet spatialResDataset = keaImgH5File->createDataSet(KEA_DATASETNAME_HEADER_RES, H5::PredType::IEEE_F64LE, spatialResDataSpace);
+			spatialResDataset.write( floatVals, H5::PredType::NATIVE_FLOAT );
+            spatialResDataset.close();
+            spatialResDataSpace.close();
+            
+            // SET X AND Y ROTATION IN GLOBAL HEADER
+            floatVals[0] = spatialInfo->xRot;
+            floatVals[1] = spatialInfo->yRot;
+            hsize_t dimsSpatialRot[1];
+			dimsSpatialRot[0] = 2;
+            H5::DataSpace spatialRotDataSpace(1, dimsSpatialRot);
+            H5::DataSet spatialRotDataset = keaImgH5File->createDataSet(KEA_DATASETNAME_HEADER_ROT, H5::PredType::IEEE_F64LE, spatialRotDataSpace);
+			spatialRotDataset.write( floatVals, H5::PredType::NATIVE_FLOAT );
+            spatialRotDataset.close();
+            spatialRotDataSpace.close();
+                        
+            // SET NUMBER OF X AND Y PIXELS
+            uint64_t uLongVals[2];
+            uLongVals[0] = spatialInfo->xSize;
+            uLongVals[1] = spatialInfo->ySize;
+            hsize_t dimsSpatialSize[1];
+			dimsSpatialSize[0] = 2;
+            H5::DataSpace spatialSizeDataSpace(1, dimsSpatialSize);
+            H5::DataSet spatialSizeDataset = keaImgH5File->createDataSet(KEA_DATASETNAME_HEADER_SIZE, H5::PredType::STD_U64LE, spatialSizeDataSpace);
+			spatialSizeDataset.write( uLongVals, H5::PredType::NATIVE_UINT64 );
+            spatialSizeDataset.close();
+            spatialSizeDataSpace.close();
+            
+            // SET THE WKT STRING SPATAIL REFERENCE IN GLOBAL HEADER
+			const char *wStrdata[1];
+			hsize_t	dimsForStr[1];
+			dimsForStr[0] = 1; // number of lines;
+            H5::DataSpace dataspaceStrAll(1, dimsForStr);
+            H5::StrType strTypeAll(0, H5T_VARIABLE);
+            H5::DataSet datasetSpatialReference = keaImgH5File->createDataSet(KEA_DATASETNAME_HEADER_WKT, strTypeAll, dataspaceStrAll);
+			wStrdata[0] = spatialInfo->wktString.c_str();			
+			datasetSpatialReference.write((void*)wStrdata, strTypeAll);
+			datasetSpatialReference.close();
+            
+            // SET THE FILE TYPE IN GLOBAL HEADER
+            H5::DataSet datasetFileType = keaImgH5File->createDataSet(KEA_DATASETNAME_HEADER_FILETYPE, strTypeAll, dataspaceStrAll);
+            std::string strVal = "KEA";
+			wStrdata[0] = strVal.c_str();			
+			datasetFileType.write((void*)wStrdata, strTypeAll);
+			datasetFileType.close();
+            
+            // SET THE FILE GENARATOR IN GLOBAL HEADER
+            H5::DataSet datasetGenarator = keaImgH5File->createDataSet(KEA_DATASETNAME_HEADER_GENERATOR, strTypeAll, dataspaceStrAll);
+            strVal = "LibKEA";
+			wStrdata[0] = strVal.c_str();			
+			datasetGenarator.write((void*)wStrdata, strTypeAll);
+			datasetGenarator.close();
+            
+            // SET THE FILE VERSION IN GLOBAL HEADER
+            H5::DataSet datasetVersion = keaImgH5File->createDataSet(KEA_DATASETNAME_HEADER_VERSION, strTypeAll, dataspaceStrAll);
+            strVal = "1.1";
+			wStrdata[0] = strVal.c_str();			
+			datasetVersion.write((void*)wStrdata, strTypeAll);
+			datasetVersion.close();
+            
+            if(deleteSpatialInfo)
             {
-                throw KEAIOException("Band is not present within image."); 
+                delete spatialInfo;
             }
+            //////////// CREATED GLOBAL HEADER ////////////////
             
-            // GET NATIVE DATASET
-            H5::DataType imgBandDT = convertDatatypeKeaToH5Native(inDataType);
-
-            // OPEN BAND DATASET AND WRITE IMAGE DATA
-            try 
-            {
-                std::string overviewName = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_OVERVIEWSNAME_OVERVIEW + uint2Str(overview);
-                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( overviewName );
-                H5::DataSpace imgBandDataspace = imgBandDataset.getSpace();                
-                
-                hsize_t imgOffset[2];
-                imgOffset[0] = yPxlOff;
-                imgOffset[1] = xPxlOff;
-                hsize_t dataDims[2];
-                dataDims[0] = ySizeBuf;
-                dataDims[1] = xSizeBuf;
-                H5::DataSpace write2BandDataspace = H5::DataSpace(2, dataDims);
-                
-                if((ySizeOut != ySizeBuf) | (xSizeOut != xSizeBuf))
-                {                    
-                    hsize_t dataSelectMemDims[2];
-                    dataSelectMemDims[0] = ySizeOut;
-                    dataSelectMemDims[1] = 1;
-
-                    hsize_t dataOffDims[2];
-                    dataOffDims[0] = 0;
-                    dataOffDims[1] = 0;
-
-                    hsize_t dataSelectStrideDims[2];
-                    dataSelectStrideDims[0] = 1;
-                    if(xSizeBuf == xSizeOut)
-                    {
-                        dataSelectStrideDims[1] = 1;
-                    }
-                    else
-                    {
-                        dataSelectStrideDims[1] = xSizeBuf - xSizeOut;
-                    }
-
-                    hsize_t dataSelectBlockSizeDims[2];
-                    dataSelectBlockSizeDims[0] = 1;
-                    dataSelectBlockSizeDims[1] = xSizeOut;
-                    write2BandDataspace.selectHyperslab(H5S_SELECT_SET, dataSelectMemDims, dataOffDims, dataSelectStrideDims, dataSelectBlockSizeDims);
-                    
-                    hsize_t dataOutDims[2];
-                    dataOutDims[0] = ySizeOut;
-                    dataOutDims[1] = xSizeOut;
-                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataOutDims, imgOffset);
-                }
-                else
-                {
-                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataDims, imgOffset);
+            //////////// CREATE GLOBAL META-DATA ////////////////
+			keaImgH5File->createGroup( KEA_DATASETNAME_METADATA );
+            //////////// CREATED GLOBAL META-DATA ////////////////
+            
+            //////////// CREATE GCPS ////////////////
+			keaImgH5File->createGroup( KEA_GCPS );
+            //////////// CREATED GCPS ////////////////
+            
+            //////////// CREATE IMAGE BANDS ////////////////
+            for(uint32_t i = 0; i < numImgBands; ++i) {
+                std::string bandDescription = "";
+                if (bandDescrips != nullptr && i < bandDescrips->size()) {
+                    bandDescription = bandDescrips->at(i);
                 }
-                
-                imgBandDataset.write( data, imgBandDT, write2BandDataspace, imgBandDataspace);
-                
-                imgBandDataset.close();
-                imgBandDataspace.close();
-                write2BandDataspace.close();
-            } 
-            catch ( const H5::Exception &e) 
-            {
-                throw KEAIOException("Could not write image data.");
+
+                addImageBandToFile(keaImgH5File, dataType, xSize, ySize,
+                        i+1, bandDescription, imageBlockSize, attBlockSize,
+                        deflate, extend);
             }
+            //////////// CREATED IMAGE BANDS ////////////////
+            
+            // READ BACK FROM THE DATASETS SO BOTH HOLD EXACTLY THE SAME VALUES
+            KEAImageIO::writeConsolidatedHeaderFromFile(keaImgH5File);
             
-            this->keaImgFile->flush(H5F_SCOPE_GLOBAL);
+            dataspaceStrAll.close();
+            keaFlushFile(keaImgH5File);
         }
-        catch(const KEAIOException &e)
+        catch (const KEAIOException &e) 
         {
             throw e;
         }
@@ -2535,92 +5699,28 @@ namespace kealib{
         {
             throw KEAIOException(e.what());
         }
-    }
-    
-    void KEAImageIO::readFromOverview(uint32_t band, uint32_t overview, void *data, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSizeIn, uint64_t ySizeIn, uint64_t xSizeBuf, uint64_t ySizeBuf, KEADataType inDataType)
-    {
-        if(!this->fileOpen)
-        {
-            throw KEAIOException("Image was not open.");
-        }
         
-        try 
-        {
-            // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
-            if(band == 0)
-            {
-                throw KEAIOException("KEA Image Bands start at 1.");
-            }
-            else if(band > this->numImgBands)
-            {
-                throw KEAIOException("Band is not present within image."); 
-            }
-            
-            // GET NATIVE DATASET
-            H5::DataType imgBandDT = convertDatatypeKeaToH5Native(inDataType);
-            
-            // OPEN BAND DATASET AND READ IMAGE DATA
-            try 
-            {
-                std::string overviewName = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_OVERVIEWSNAME_OVERVIEW + uint2Str(overview);
-                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( overviewName );
-                H5::DataSpace imgBandDataspace = imgBandDataset.getSpace();                
-                
-                hsize_t dataOffset[2];
-                dataOffset[0] = yPxlOff;
-                dataOffset[1] = xPxlOff;
-                hsize_t dataDims[2];
-                dataDims[0] = ySizeBuf;
-                dataDims[1] = xSizeBuf;
-                H5::DataSpace read2BandDataspace = H5::DataSpace(2, dataDims);
-                
-                if((ySizeBuf != ySizeIn) | (xSizeBuf != xSizeIn))
-                {
-                    hsize_t dataSelectMemDims[2];
-                    dataSelectMemDims[0] = ySizeIn;
-                    dataSelectMemDims[1] = 1;
-
-                    hsize_t dataOffDims[2];
-                    dataOffDims[0] = 0;
-                    dataOffDims[1] = 0;
-
-                    hsize_t dataSelectStrideDims[2];
-                    dataSelectStrideDims[0] = 1;
-                    if(xSizeBuf == xSizeIn)
-                    {
-                        dataSelectStrideDims[1] = 1;
-                    }
-                    else
-                    {
-                        dataSelectStrideDims[1] = xSizeBuf - xSizeIn;
-                    }
-
-                    hsize_t dataSelectBlockSizeDims[2];
-                    dataSelectBlockSizeDims[0] = 1;
-                    dataSelectBlockSizeDims[1] = xSizeIn;
-                    read2BandDataspace.selectHyperslab(H5S_SELECT_SET, dataSelectMemDims, dataOffDims, dataSelectStrideDims, dataSelectBlockSizeDims);
-                    
-                    hsize_t dataInDims[2];
-                    dataInDims[0] = ySizeIn;
-                    dataInDims[1] = xSizeIn;
-                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataInDims, dataOffset);
-                }
-                else
-                {
-                    imgBandDataspace.selectHyperslab( H5S_SELECT_SET, dataDims, dataOffset);
-                }
-                imgBandDataset.read( data, imgBandDT, read2BandDataspace, imgBandDataspace);
-                
-                imgBandDataset.close();
-                imgBandDataspace.close();
-                read2BandDataspace.close();
-            } 
-            catch ( const H5::Exception &e) 
-            {
-                throw KEAIOException("Could not read from image overview.");
-            }            
-        }
-        catch(const KEAIOException &e)
+        return keaImgH5File;
+    }
+    
+    H5::H5File* KEAImageIO::openKeaH5RW(const std::string &fileName, int mdcElmts, hsize_t rdccNElmts, hsize_t rdccNBytes, double rdccW0, hsize_t sieveBuf, hsize_t metaBlockSize, size_t pageBufSize)
+    {
+        KEATraceScope trace("KEAImageIO::openKeaH5RW", KEA_TRACE_API);
+        H5::Exception::dontPrint();
+        
+        H5::H5File *keaImgH5File = nullptr;
+        try 
+        {
+            H5::FileAccPropList keaAccessPlist = H5::FileAccPropList(H5::FileAccPropList::DEFAULT);
+            keaAccessPlist.setCache(mdcElmts, rdccNElmts, rdccNBytes, rdccW0);
+            keaAccessPlist.setSieveBufSize(sieveBuf);
+            keaAccessPlist.setMetaBlockSize(metaBlockSize);
+            
+            const H5std_string keaImgFilePath(fileName);
+            keaImgH5File = keaOpenH5File(keaImgFilePath, H5F_ACC_RDWR, keaAccessPlist, pageBufSize);
+            
+        } 
+        catch (const KEAIOException &e) 
         {
             throw e;
         }
@@ -2644,90 +5744,118 @@ namespace kealib{
         {
             throw KEAIOException(e.what());
         }
+        
+        return keaImgH5File;
     }
     
-    uint32_t KEAImageIO::getNumOfOverviews(uint32_t band)
+    H5::H5File* KEAImageIO::openKeaH5RDOnly(const std::string &fileName, int mdcElmts, hsize_t rdccNElmts, hsize_t rdccNBytes, double rdccW0, hsize_t sieveBuf, hsize_t metaBlockSize, size_t pageBufSize, hid_t fileDriver)
     {
-        if(!this->fileOpen)
-        {
-            throw KEAIOException("Image was not open.");
-        }
+        KEATraceScope trace("KEAImageIO::openKeaH5RDOnly", KEA_TRACE_API);
+        H5::Exception::dontPrint();
         
-        std::string overviewGroupName = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_BANDNAME_OVERVIEWS;
-        uint32_t numOverviews = 0;
+        H5::H5File *keaImgH5File = nullptr;
         try 
         {
-            // Try to open dataset with overviewName
-            H5::Group imgOverviewsGrp = this->keaImgFile->openGroup(overviewGroupName);
-            numOverviews = imgOverviewsGrp.getNumObjs();
-        }
-        catch (const H5::Exception &e)
-        {
-            throw KEAIOException("Could not retrieve the number of image band overviews.");
+            H5::FileAccPropList keaAccessPlist = H5::FileAccPropList(H5::FileAccPropList::DEFAULT);
+            keaAccessPlist.setCache(mdcElmts, rdccNElmts, rdccNBytes, rdccW0);
+            keaAccessPlist.setSieveBufSize(sieveBuf);
+            keaAccessPlist.setMetaBlockSize(metaBlockSize);
+            if(fileDriver >= 0)
+            {
+                keaAccessPlist.setDriver(fileDriver, nullptr);
+            }
+            
+            const H5std_string keaImgFilePath(fileName);
+            keaImgH5File = keaOpenH5File(keaImgFilePath, H5F_ACC_RDONLY, keaAccessPlist, pageBufSize);
+            
         }
-        catch ( const KEAIOException &e)
+        catch (const KEAIOException &e) 
         {
             throw e;
         }
+        catch( const H5::FileIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataSetIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataSpaceIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
+		catch( const H5::DataTypeIException &e )
+		{
+			throw KEAIOException(e.getCDetailMsg());
+		}
         catch ( const std::exception &e)
         {
             throw KEAIOException(e.what());
         }
         
-        return numOverviews;
+        return keaImgH5File;
     }
-    
-    void KEAImageIO::getOverviewSize(uint32_t band, uint32_t overview, uint64_t *xSize, uint64_t *ySize)
+        
+    bool KEAImageIO::isKEAImage(const std::string &fileName)
     {
-        if(!this->fileOpen)
-        {
-            throw KEAIOException("Image was not open.");
-        }
+        KEATraceScope trace("KEAImageIO::isKEAImage", KEA_TRACE_API);
+        bool keaImageFound = false;
+        H5::Exception::dontPrint();
         
         try 
         {
-            // CHECK PARAMETERS PROVIDED FIT WITHIN IMAGE
-            if(band == 0)
-            {
-                throw KEAIOException("KEA Image Bands start at 1.");
-            }
-            else if(band > this->numImgBands)
-            {
-                throw KEAIOException("Band is not present within image."); 
-            }
-                        
-            // OPEN BAND DATASET AND READ THE IMAGE DIMENSIONS
+            H5::H5File *keaImgH5File = nullptr;
+            const H5std_string keaImgFilePath(fileName);
+            keaImgH5File = new H5::H5File(keaImgFilePath, H5F_ACC_RDONLY);
+            
             try 
             {
-                std::string overviewName = KEA_DATASETNAME_BAND + uint2Str(band) + KEA_OVERVIEWSNAME_OVERVIEW + uint2Str(overview);
-                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet( overviewName );
-                H5::DataSpace imgBandDataspace = imgBandDataset.getSpace();                
-                
-                uint32_t nDims = imgBandDataspace.getSimpleExtentNdims();
-                if(nDims != 2)
+                H5::DataSet datasetFileType = keaImgH5File->openDataSet( KEA_DATASETNAME_HEADER_FILETYPE );
+                H5::DataType strFTDataType = datasetFileType.getDataType();
+                std::string fileType = readString(datasetFileType, strFTDataType);
+                datasetFileType.close();
+                                
+                try 
                 {
-                    throw KEAIOException("The number of dimensions for the overview must be 2.");
+                    if(fileType == "KEA")
+                    {
+                        H5::DataSet datasetFileVersion = keaImgH5File->openDataSet( KEA_DATASETNAME_HEADER_VERSION );
+                        H5::DataType strVerDataType = datasetFileVersion.getDataType();
+                        std::string fileVersion = readString(datasetFileVersion, strVerDataType);
+                        datasetFileVersion.close();
+                        
+                        if((fileVersion == "1.0") || (fileVersion == "1.1"))
+                        {
+                            keaImageFound = true;
+                        }
+                        else
+                        {
+                            keaImageFound = false;
+                        }
+                    }
+                    else
+                    {
+                        keaImageFound = false;
+                    }
+                } 
+                catch ( const H5::Exception &e) // WILL BE THROWN IF THE FILE VERSION DATASET IS NOT PRESENT
+                {
+                    keaImageFound = false;
                 }
-                hsize_t dims[2];
-                imgBandDataspace.getSimpleExtentDims(dims);
                 
-                *xSize = dims[1];
-                *ySize = dims[0];
-
-                imgBandDataset.close();
             } 
-            catch(const KEAIOException &e)
+            catch ( const H5::Exception &e) // WILL BE THROWN IF THE FILE TYPE DATASET IS NOT PRESENT
             {
-                throw e;
+                keaImageFound = false;
             }
-            catch ( const H5::Exception &e) 
-            {
-                throw KEAIOException("Could not read from image overview.");
-            }            
-        }
-        catch( const H5::Exception &e )
+            
+            keaImgH5File->close();
+            delete keaImgH5File;
+        } 
+        catch( const H5::Exception &e ) // WILL BE THROWN WHEN THE HDF LIBRARY CANNOT OPEN THE FILE - IE IT IS NOT A HDF5 FILE!
 		{
-			throw KEAIOException("Could not get the overview size.");
+			keaImageFound = false;
 		}
         catch ( const KEAIOException &e)
         {
@@ -2737,520 +5865,633 @@ namespace kealib{
         {
             throw KEAIOException(e.what());
         }
+        
+        return keaImageFound;
     }
-    
-    KEAAttributeTable* KEAImageIO::getAttributeTable(KEAATTType type, uint32_t band)
+
+    bool KEAImageIO::probeKEAImage(const std::string &fileName, KEAImageHeaderSummary &summary)
     {
-        KEAAttributeTable *att = nullptr;
-        try 
+        KEATraceScope trace("KEAImageIO::probeKEAImage", KEA_TRACE_API);
+        // MOST FILES WHICH AREN'T KEA ARE TURNED AWAY HERE, IN PARALLEL
+        if(!keaHasHDF5Signature(fileName))
         {
-            if(type == kea_att_mem)
-            {
-                att = kealib::KEAAttributeTableInMem::createKeaAtt(this->keaImgFile, band);
-            }
-            else if(type == kea_att_file)
+            return false;
+        }
+        
+        // A THREAD SAFE HDF5 SERIALISES THE CALLS ITSELF SO PROBES OF
+        // DIFFERENT FILES DON'T QUEUE BEHIND EACH OTHER OR OPEN IMAGES
+        std::unique_lock<std::recursive_mutex> h5Lock(getH5Mutex(), std::defer_lock);
+        if(!keaH5LibraryThreadSafe())
+        {
+            h5Lock.lock();
+        }
+        H5::Exception::dontPrint();
+        
+        H5::H5File *keaImgH5File = nullptr;
+        try
+        {
+            // NO PIXELS ARE READ SO THERE IS NO CHUNK CACHE OR SIEVE BUFFER
+            H5::FileAccPropList keaAccessPlist = H5::FileAccPropList(H5::FileAccPropList::DEFAULT);
+            keaAccessPlist.setCache(KEA_MDC_NELMTS, 0, 0, KEA_RDCC_W0);
+            keaAccessPlist.setSieveBufSize(0);
+            keaImgH5File = new H5::H5File(fileName, H5F_ACC_RDONLY, H5::FileCreatPropList::DEFAULT, keaAccessPlist);
+        }
+        catch( const H5::Exception &e ) // THE HDF LIBRARY CANNOT OPEN THE FILE
+        {
+            return false;
+        }
+        
+        bool keaImageFound = false;
+        try
+        {
+            std::string fileType = "";
+            if(H5Lexists(keaImgH5File->getId(), KEA_DATASETNAME_HEADER.c_str(), H5P_DEFAULT) > 0)
             {
-                att = kealib::KEAAttributeTableFile::createKeaAtt(this->keaImgFile, band);
+                try
+                {
+                    H5::DataSet datasetFileType = keaImgH5File->openDataSet( KEA_DATASETNAME_HEADER_FILETYPE );
+                    fileType = readString(datasetFileType, datasetFileType.getDataType());
+                    datasetFileType.close();
+                }
+                catch ( const H5::Exception &e) // THE FILE TYPE DATASET IS NOT PRESENT
+                {
+                    fileType = "";
+                }
             }
-            else
+            
+            if(fileType == "KEA")
             {
-                throw KEAATTException("The attribute table type was not recognised.");
+                std::vector<KEABandHeader> bandHeaders;
+                if(!readConsolidatedHeader(keaImgH5File, summary.keaVersion, &summary.spatialInfo, bandHeaders))
+                {
+                    uint32_t numImgBands = 0;
+                    readImageHeader(keaImgH5File, summary.keaVersion, numImgBands, &summary.spatialInfo);
+                    bandHeaders.resize(numImgBands);
+                    for(uint32_t band = 1; band <= numImgBands; ++band)
+                    {
+                        readBandHeader(keaImgH5File, band, bandHeaders[band-1]);
+                    }
+                }
+                keaImageFound = (summary.keaVersion == "1.0") || (summary.keaVersion == "1.1");
+                
+                summary.bands.clear();
+                for(uint32_t band = 1; keaImageFound && (band <= bandHeaders.size()); ++band)
+                {
+                    const KEABandHeader &bandHeader = bandHeaders[band-1];
+                    KEAImageBandSummary bandSummary;
+                    bandSummary.dataType = bandHeader.dataType;
+                    bandSummary.layerType = bandHeader.layerType;
+                    bandSummary.clrInterp = bandHeader.clrInterp;
+                    bandSummary.description = bandHeader.description;
+                    bandSummary.noDataDefined = (bandHeader.noDataState == 2);
+                    bandSummary.noDataValue = 0;
+                    if(bandSummary.noDataDefined)
+                    {
+                        keaConvertBlock(bandHeader.noDataValue.data(), bandHeader.dataType, 1, (char*)&bandSummary.noDataValue, kea_64float, 1, 1, 1);
+                    }
+                    bandSummary.numOverviews = bandHeader.numOverviews;
+                    bandSummary.scale = bandHeader.scale;
+                    bandSummary.offset = bandHeader.offset;
+                    summary.bands.push_back(bandSummary);
+                }
             }
+            
+            keaImgH5File->close();
+            delete keaImgH5File;
         }
-        catch(const KEAATTException &e)
+        catch ( const H5::Exception &e)
         {
-            throw e;
+            delete keaImgH5File;
+            throw KEAIOException(e.getCDetailMsg());
         }
         catch ( const KEAIOException &e)
         {
+            delete keaImgH5File;
             throw e;
         }
         catch ( const std::exception &e)
         {
+            delete keaImgH5File;
             throw KEAIOException(e.what());
         }
         
-        return att;
+        return keaImageFound;
+    }
+
+    KEAImageIO::~KEAImageIO()
+    {
+        this->stopAsyncReader();
+        this->stopAsyncWriter();
+        this->clearChunkedDatasets();
+    }
+
+    void KEAImageIO::addImageBand(const KEADataType dataType, const std::string &bandDescrip, const uint32_t imageBlockSize, const uint32_t attBlockSize, const uint32_t deflate)
+    {
+        KEATraceScope trace("KEAImageIO::addImageBand", KEA_TRACE_API);
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+        
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+
+        const uint32_t xSize = this->spatialInfoFile->xSize;
+        const uint32_t ySize = this->spatialInfoFile->ySize;
+
+        // new bands must be extendable if the existing ones are
+        KEAImageExtend extend = kea_extend_none;
+        if(this->numImgBands > 0)
+        {
+            try
+            {
+                H5::DataSet imgBandDataset = this->keaImgFile->openDataSet(KEA_DATASETNAME_BAND + uint2Str(1) + KEA_BANDNAME_DATA);
+                extend = KEAImageIO::getDatasetExtend(imgBandDataset);
+                imgBandDataset.close();
+            }
+            catch(const H5::Exception &e)
+            {
+                throw KEAIOException(e.getCDetailMsg());
+            }
+        }
+
+        this->beginHeaderChange();
+        // add a new image band to the file
+        KEAImageIO::addImageBandToFile(this->keaImgFile, dataType, xSize, ySize, this->numImgBands + 1, bandDescrip, imageBlockSize, attBlockSize, deflate, extend);
+        ++this->numImgBands;
+
+        // update the band counter in the file metadata
+        KEAImageIO::setNumImgBandsInFileMetadata(this->keaImgFile, this->numImgBands);
+        this->updateConsolidatedHeader(this->numImgBands);
+
+        keaFlushFile(this->keaImgFile);
+    }
+    
+    void KEAImageIO::removeImageBand(const uint32_t bandIndex)
+    {
+        KEATraceScope trace("KEAImageIO::removeImageBand", KEA_TRACE_API);
+        KEAImageIOLock lock(this->ioMutex, this->threadSafe, kea_lock_write);
+
+        if(!this->fileOpen)
+        {
+            throw KEAIOException("Image was not open.");
+        }
+        
+        this->beginHeaderChange();
+        // THE BANDS ABOVE bandIndex ARE RENAMED
+        this->clearChunkedDatasets();
+        KEAImageIO::removeImageBandFromFile(this->keaImgFile, bandIndex, this->numImgBands);
+    
+        --this->numImgBands;
+        if(this->bandHeadersLoaded && (bandIndex >= 1) && (bandIndex <= this->bandHeaders.size()))
+        {
+            this->bandHeaders.erase(this->bandHeaders.begin() + (bandIndex - 1));
+        }
+
+        // update the band counter in the file metadata
+        KEAImageIO::setNumImgBandsInFileMetadata(this->keaImgFile, this->numImgBands);
+        this->updateConsolidatedHeader(0);
+
+        keaFlushFile(this->keaImgFile);
     }
     
-    void KEAImageIO::setAttributeTable(KEAAttributeTable* att, uint32_t band, uint32_t chunkSize, uint32_t deflate)
+    void KEAImageIO::copyBandFrom(KEAImageIO *srcIO, const uint32_t srcBand)
     {
-        if(!this->fileOpen)
-        {
-            throw KEAIOException("Image was not open.");
-        }
+        KEATraceScope trace("KEAImageIO::copyBandFrom", KEA_TRACE_API);
+        KEAImageIOPairLock lock(this->ioMutex, this->threadSafe, kea_lock_write, srcIO->ioMutex, srcIO->threadSafe, kea_lock_read);
         
-        try 
-        {
-            att->exportToKeaFile(this->keaImgFile, band, chunkSize, deflate);
-            this->keaImgFile->flush(H5F_SCOPE_GLOBAL);
-        }
-        catch(const KEAATTException &e)
+        if(!srcIO->fileOpen)
         {
-            throw e;
+            throw KEAIOException("Source image was not open.");
         }
-        catch ( const KEAIOException &e)
+        
+        // KEEPING THE SOURCE LAYOUT MEANS THE CHUNKS CAN BE COPIED AS THEY ARE
+        uint32_t imageBlockSize = srcIO->getImageBlockSize(srcBand);
+        uint32_t deflate = 0;
+        try
         {
-            throw e;
+            H5::DataSet srcDataset = srcIO->keaImgFile->openDataSet(KEA_DATASETNAME_BAND + uint2Str(srcBand) + KEA_BANDNAME_DATA);
+            deflate = getDatasetDeflate(srcDataset);
+            srcDataset.close();
         }
-        catch ( const std::exception &e)
+        catch(const H5::Exception &e)
         {
-            throw KEAIOException(e.what());
+            throw KEAIOException(e.getCDetailMsg());
         }
+        
+        this->copyBandFrom(srcIO, srcBand, imageBlockSize, deflate);
     }
     
-    bool KEAImageIO::attributeTablePresent(uint32_t band)
+    void KEAImageIO::copyBandFrom(KEAImageIO *srcIO, const uint32_t srcBand, const uint32_t imageBlockSize, const uint32_t deflate)
     {
+        KEATraceScope trace("KEAImageIO::copyBandFrom", KEA_TRACE_API);
+        KEAImageIOPairLock lock(this->ioMutex, this->threadSafe, kea_lock_write, srcIO->ioMutex, srcIO->threadSafe, kea_lock_read);
+        
         if(!this->fileOpen)
         {
             throw KEAIOException("Image was not open.");
         }
+        if(!srcIO->fileOpen)
+        {
+            throw KEAIOException("Source image was not open.");
+        }
         
-        bool attPresent = false;
-        try 
+        try
         {
-            std::string bandPathBase = KEA_DATASETNAME_BAND + uint2Str(band);
-            hsize_t attSize[5];
-            try 
-            {   
-                hsize_t dimsValue[1];
-                dimsValue[0] = 5;
-                H5::DataSpace valueDataSpace(1, dimsValue);
-                H5::DataSet datasetAttSize = this->keaImgFile->openDataSet( bandPathBase + KEA_ATT_SIZE_HEADER );
-                datasetAttSize.read(attSize, H5::PredType::STD_U64LE, valueDataSpace);
-                datasetAttSize.close();
-                valueDataSpace.close();
-            } 
-            catch (const H5::Exception &e) 
+            if(srcBand == 0)
             {
-                throw KEAIOException("The attribute table size field is not present.");
+                throw KEAIOException("KEA Image Bands start at 1.");
+            }
+            else if(srcBand > srcIO->numImgBands)
+            {
+                throw KEAIOException("Band is not present within source image.");
             }
             
-            if(attSize[0] > 0)
+            const uint64_t xSize = this->spatialInfoFile->xSize;
+            const uint64_t ySize = this->spatialInfoFile->ySize;
+            if((srcIO->spatialInfoFile->xSize != xSize) || (srcIO->spatialInfoFile->ySize != ySize))
             {
-                attPresent = true;
+                throw KEAIOException("The source image is not the same size as this image.");
+            }
+            
+            this->beginHeaderChange();
+            const uint32_t dstBand = this->numImgBands + 1;
+            const std::string srcBandPath = KEA_DATASETNAME_BAND + uint2Str(srcBand);
+            const std::string dstBandPath = KEA_DATASETNAME_BAND + uint2Str(dstBand);
+            
+            H5::DataSet srcDataset = srcIO->keaImgFile->openDataSet(srcBandPath + KEA_BANDNAME_DATA);
+            KEAImageExtend extend = getDatasetExtend(srcDataset);
+            uint32_t srcDeflate = getDatasetDeflate(srcDataset);
+            srcDataset.close();
+            uint32_t srcBlockSize = srcIO->getImageBlockSize(srcBand);
+            
+            if((imageBlockSize == srcBlockSize) && (deflate == srcDeflate))
+            {
+                // SAME LAYOUT - HDF5 COPIES THE WHOLE BAND WITHOUT DECODING ANY CHUNKS
+                if(H5Ocopy(srcIO->keaImgFile->getId(), srcBandPath.c_str(), this->keaImgFile->getId(), dstBandPath.c_str(), H5P_DEFAULT, H5P_DEFAULT) < 0)
+                {
+                    throw KEAIOException("Could not copy the image band.");
+                }
+            }
+            else
+            {
+                // DIFFERENT LAYOUT - THE PIXELS ARE RE-ENCODED AND EVERYTHING ELSE IS COPIED
+                KEADataType dataType = srcIO->getImageBandDataType(srcBand);
+                KEAImageIO::addImageBandToFile(this->keaImgFile, dataType, xSize, ySize, dstBand, "", imageBlockSize, KEA_ATT_CHUNK_SIZE_AUTO, deflate, extend);
+                
+                std::vector<std::string> skipNames = { KEA_BANDNAME_DATA, KEA_BANDNAME_MASK };
+                KEAImageIO::copyGroupMembers(srcIO->keaImgFile, srcBandPath, this->keaImgFile, dstBandPath, skipNames);
+            }
+            
+            ++this->numImgBands;
+            KEAImageIO::setNumImgBandsInFileMetadata(this->keaImgFile, this->numImgBands);
+            this->updateConsolidatedHeader(dstBand);
+            
+            if((imageBlockSize != srcBlockSize) || (deflate != srcDeflate))
+            {
+                // COPY THE PIXELS (AND MASK) A ROW OF BLOCKS AT A TIME
+                KEADataType dataType = srcIO->getImageBandDataType(srcBand);
+                uint64_t blockSize = this->getImageBlockSize(dstBand);
+                bool haveMask = srcIO->maskCreated(srcBand);
+                if(haveMask)
+                {
+                    this->createMask(dstBand, deflate);
+                }
+                std::vector<char> buffer(xSize * blockSize * getDataTypeSize(dataType));
+                for(uint64_t yOff = 0; yOff < ySize; yOff += blockSize)
+                {
+                    uint64_t rows = std::min<uint64_t>(blockSize, ySize - yOff);
+                    srcIO->readImageBlock2Band(srcBand, buffer.data(), 0, yOff, xSize, rows, xSize, rows, dataType);
+                    this->writeImageBlock2Band(dstBand, buffer.data(), 0, yOff, xSize, rows, xSize, rows, dataType);
+                    if(haveMask)
+                    {
+                        srcIO->readImageBlock2BandMask(srcBand, buffer.data(), 0, yOff, xSize, rows, xSize, rows, kea_8uint);
+                        this->writeImageBlock2BandMask(dstBand, buffer.data(), 0, yOff, xSize, rows, xSize, rows, kea_8uint);
+                    }
+                }
             }
+            
+            keaFlushFile(this->keaImgFile);
         }
-        catch(const KEAIOException &e)
+        catch ( const H5::Exception &e)
         {
-            throw e;
+            throw KEAIOException(e.getCDetailMsg());
         }
-        catch(const KEAATTException &e)
+        catch ( const KEAIOException &e)
         {
             throw e;
         }
-        catch( const H5::Exception &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
         catch ( const std::exception &e)
         {
             throw KEAIOException(e.what());
         }
-        return attPresent;
     }
     
-    void KEAImageIO::close()
+    H5::H5File* KEAImageIO::createKEAImageSubset(KEAImageIO *srcIO, const std::string &fileName, uint64_t xPxlOff, uint64_t yPxlOff, uint64_t xSize, uint64_t ySize, int mdcElmts, hsize_t rdccNElmts, hsize_t rdccNBytes, double rdccW0, hsize_t sieveBuf, hsize_t metaBlockSize)
     {
-        try 
-        {
-            delete this->spatialInfoFile;
-            this->keaImgFile->close();
-            delete this->keaImgFile;
-            this->keaImgFile = nullptr;
-            this->fileOpen = false;
-        }
-        catch(const KEAIOException &e)
+        KEATraceScope trace("KEAImageIO::createKEAImageSubset", KEA_TRACE_API);
+        KEAImageIOLock srcLock(srcIO->ioMutex, srcIO->threadSafe, kea_lock_read);
+        
+        if(!srcIO->fileOpen)
         {
-            throw e;
+            throw KEAIOException("Source image was not open.");
         }
-        catch( const H5::Exception &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-        catch ( const std::exception &e)
+        
+        const KEAImageSpatialInfo *srcSpatialInfo = srcIO->spatialInfoFile;
+        if((xSize == 0) || (ySize == 0) || ((xPxlOff + xSize) > srcSpatialInfo->xSize) || ((yPxlOff + ySize) > srcSpatialInfo->ySize))
         {
-            throw KEAIOException(e.what());
+            throw KEAIOException("The subset is not within the source image.");
         }
-    }
-        
-    H5::H5File* KEAImageIO::createKEAImage(const std::string &fileName, KEADataType dataType, uint32_t xSize, uint32_t ySize, uint32_t numImgBands, std::vector<std::string> *bandDescrips, KEAImageSpatialInfo * spatialInfo, uint32_t imageBlockSize, uint32_t attBlockSize, int mdcElmts, hsize_t rdccNElmts, hsize_t rdccNBytes, double rdccW0, hsize_t sieveBuf, hsize_t metaBlockSize, uint32_t deflate)
-    {
-        H5::Exception::dontPrint();
         
-        H5::H5File *keaImgH5File = nullptr;
-        
-        try 
+        try
         {
-            // CREATE HDF FILE ACCESS PROPERTIES - DEFAULT VALUES CAN BE TUNED FROM KEACommon.h
-            H5::FileAccPropList keaAccessPlist = H5::FileAccPropList(H5::FileAccPropList::DEFAULT);
-            keaAccessPlist.setCache(mdcElmts, rdccNElmts, rdccNBytes, rdccW0);
-            keaAccessPlist.setSieveBufSize(sieveBuf);
-            keaAccessPlist.setMetaBlockSize(metaBlockSize);
-            
-            // CREATE THE HDF FILE - EXISTING FILE WILL BE TRUNCATED
-            keaImgH5File = new H5::H5File( fileName, H5F_ACC_TRUNC, H5::FileCreatPropList::DEFAULT, keaAccessPlist);
+            // MOVE THE TOP LEFT CORNER TO THE START OF THE SUBSET
+            KEAImageSpatialInfo spatialInfo = *srcSpatialInfo;
+            spatialInfo.tlX = srcSpatialInfo->tlX + (xPxlOff * srcSpatialInfo->xRes) + (yPxlOff * srcSpatialInfo->xRot);
+            spatialInfo.tlY = srcSpatialInfo->tlY + (xPxlOff * srcSpatialInfo->yRot) + (yPxlOff * srcSpatialInfo->yRes);
             
-            //////////// CREATE GLOBAL HEADER ////////////////
-            keaImgH5File->createGroup( KEA_DATASETNAME_HEADER );
+            H5::H5File *keaImgH5File = KEAImageIO::createKEAImage(fileName, kea_8uint, xSize, ySize, 0, nullptr, &spatialInfo, KEA_IMAGE_CHUNK_SIZE, KEA_ATT_CHUNK_SIZE_AUTO, mdcElmts, rdccNElmts, rdccNBytes, rdccW0, sieveBuf, metaBlockSize);
+            KEAImageIO dstIO;
+            dstIO.openKEAImageHeader(keaImgH5File);
             
-            bool deleteSpatialInfo = false;
-            if(spatialInfo == nullptr)
+            // IMAGE METADATA, GCPS ETC. ARE COPIED AS THEY ARE
+            std::vector<std::string> skipNames = { KEA_DATASETNAME_HEADER };
+            for(uint32_t band = 1; band <= srcIO->numImgBands; ++band)
             {
-                spatialInfo = new KEAImageSpatialInfo();
-                spatialInfo->tlX = 0.0;
-                spatialInfo->tlY = 0.0;
-                spatialInfo->xRes = 1.0;
-                spatialInfo->yRes = -1.0;
-                spatialInfo->xRot = 0.0;
-                spatialInfo->yRot = 0.0;
-                spatialInfo->wktString = "";
-                deleteSpatialInfo = true;
+                skipNames.push_back(KEA_DATASETNAME_BAND + uint2Str(band));
             }
+            KEAImageIO::copyGroupMembers(srcIO->keaImgFile, "/", dstIO.keaImgFile, "/", skipNames);
             
-            spatialInfo->xSize = xSize;
-            spatialInfo->ySize = ySize;
-                        
-            // SET NUMBER OF IMAGE BANDS IN GLOBAL HEADER
-            KEAImageIO::setNumImgBandsInFileMetadata(keaImgH5File, numImgBands);
-                                    
-            // SET X AND Y TL IN GLOBAL HEADER
-            double doubleVals[2];
-            doubleVals[0] = spatialInfo->tlX;
-            doubleVals[1] = spatialInfo->tlY;
-            hsize_t dimsSpatialTL[1];
-			dimsSpatialTL[0] = 2;
-            H5::DataSpace spatialTLDataSpace(1, dimsSpatialTL);
-            H5::DataSet spatialTLDataset = keaImgH5File->createDataSet(KEA_DATASETNAME_HEADER_TL, H5::PredType::IEEE_F64LE, spatialTLDataSpace);
-			spatialTLDataset.write( doubleVals, H5::PredType::NATIVE_DOUBLE );
-            spatialTLDataset.close();
-            spatialTLDataSpace.close();
-            
-            // SET X AND Y RESOLUTION IN GLOBAL HEADER
-            float floatVals[2];
-            floatVals[0] = spatialInfo->xRes;
-            floatVals[1] = spatialInfo->yRes;
-            hsize_t dimsSpatialRes[1];
-			dimsSpatialRes[0] = 2;
-            H5::DataSpace spatialResDataSpace(1, dimsSpatialRes);
-            H5::DataSet spatialResDataset = keaImgH5File->createDataSet(KEA_DATASETNAME_HEADER_RES, H5::PredType::IEEE_F64LE, spatialResDataSpace);
-			spatialResDataset.write( floatVals, H5::PredType::NATIVE_FLOAT );
-            spatialResDataset.close();
-            spatialResDataSpace.close();
-            
-            // SET X AND Y ROTATION IN GLOBAL HEADER
-            floatVals[0] = spatialInfo->xRot;
-            floatVals[1] = spatialInfo->yRot;
-            hsize_t dimsSpatialRot[1];
-			dimsSpatialRot[0] = 2;
-            H5::DataSpace spatialRotDataSpace(1, dimsSpatialRot);
-            H5::DataSet spatialRotDataset = keaImgH5File->createDataSet(KEA_DATASETNAME_HEADER_ROT, H5::PredType::IEEE_F64LE, spatialRotDataSpace);
-			spatialRotDataset.write( floatVals, H5::PredType::NATIVE_FLOAT );
-            spatialRotDataset.close();
-            spatialRotDataSpace.close();
-                        
-            // SET NUMBER OF X AND Y PIXELS
-            uint64_t uLongVals[2];
-            uLongVals[0] = spatialInfo->xSize;
-            uLongVals[1] = spatialInfo->ySize;
-            hsize_t dimsSpatialSize[1];
-			dimsSpatialSize[0] = 2;
-            H5::DataSpace spatialSizeDataSpace(1, dimsSpatialSize);
-            H5::DataSet spatialSizeDataset = keaImgH5File->createDataSet(KEA_DATASETNAME_HEADER_SIZE, H5::PredType::STD_U64LE, spatialSizeDataSpace);
-			spatialSizeDataset.write( uLongVals, H5::PredType::NATIVE_UINT64 );
-            spatialSizeDataset.close();
-            spatialSizeDataSpace.close();
-            
-            // SET THE WKT STRING SPATAIL REFERENCE IN GLOBAL HEADER
-			const char *wStrdata[1];
-			hsize_t	dimsForStr[1];
-			dimsForStr[0] = 1; // number of lines;
-            H5::DataSpace dataspaceStrAll(1, dimsForStr);
-            H5::StrType strTypeAll(0, H5T_VARIABLE);
-            H5::DataSet datasetSpatialReference = keaImgH5File->createDataSet(KEA_DATASETNAME_HEADER_WKT, strTypeAll, dataspaceStrAll);
-			wStrdata[0] = spatialInfo->wktString.c_str();			
-			datasetSpatialReference.write((void*)wStrdata, strTypeAll);
-			datasetSpatialReference.close();
-            
-            // SET THE FILE TYPE IN GLOBAL HEADER
-            H5::DataSet datasetFileType = keaImgH5File->createDataSet(KEA_DATASETNAME_HEADER_FILETYPE, strTypeAll, dataspaceStrAll);
-            std::string strVal = "KEA";
-			wStrdata[0] = strVal.c_str();			
-			datasetFileType.write((void*)wStrdata, strTypeAll);
-			datasetFileType.close();
-            
-            // SET THE FILE GENARATOR IN GLOBAL HEADER
-            H5::DataSet datasetGenarator = keaImgH5File->createDataSet(KEA_DATASETNAME_HEADER_GENERATOR, strTypeAll, dataspaceStrAll);
-            strVal = "LibKEA";
-			wStrdata[0] = strVal.c_str();			
-			datasetGenarator.write((void*)wStrdata, strTypeAll);
-			datasetGenarator.close();
-            
-            // SET THE FILE VERSION IN GLOBAL HEADER
-            H5::DataSet datasetVersion = keaImgH5File->createDataSet(KEA_DATASETNAME_HEADER_VERSION, strTypeAll, dataspaceStrAll);
-            strVal = "1.1";
-			wStrdata[0] = strVal.c_str();			
-			datasetVersion.write((void*)wStrdata, strTypeAll);
-			datasetVersion.close();
-            
-            if(deleteSpatialInfo)
+            // GCPS ARE IN PIXEL COORDINATES SO NEED SHIFTING
+            hid_t dstFileId = dstIO.keaImgFile->getId();
+            bool haveGCPs = (H5Lexists(dstFileId, KEA_GCPS.c_str(), H5P_DEFAULT) > 0) && (H5Lexists(dstFileId, KEA_GCPS_NUM.c_str(), H5P_DEFAULT) > 0);
+            if(haveGCPs && (dstIO.getGCPCount() > 0))
             {
-                delete spatialInfo;
+                std::vector<KEAImageGCP*> *gcps = dstIO.getGCPs();
+                for(KEAImageGCP *gcp : *gcps)
+                {
+                    gcp->dfGCPPixel -= xPxlOff;
+                    gcp->dfGCPLine -= yPxlOff;
+                }
+                dstIO.setGCPs(gcps, dstIO.getGCPProjection());
+                for(KEAImageGCP *gcp : *gcps)
+                {
+                    delete gcp;
+                }
+                delete gcps;
             }
-            //////////// CREATED GLOBAL HEADER ////////////////
-            
-            //////////// CREATE GLOBAL META-DATA ////////////////
-			keaImgH5File->createGroup( KEA_DATASETNAME_METADATA );
-            //////////// CREATED GLOBAL META-DATA ////////////////
-            
-            //////////// CREATE GCPS ////////////////
-			keaImgH5File->createGroup( KEA_GCPS );
-            //////////// CREATED GCPS ////////////////
             
-            //////////// CREATE IMAGE BANDS ////////////////
-            for(uint32_t i = 0; i < numImgBands; ++i) {
-                std::string bandDescription = "";
-                if (bandDescrips != nullptr && i < bandDescrips->size()) {
-                    bandDescription = bandDescrips->at(i);
+            for(uint32_t band = 1; band <= srcIO->numImgBands; ++band)
+            {
+                // SAME LAYOUT AS THE SOURCE SO ALIGNED CHUNKS CAN BE COPIED RAW
+                const std::string bandPath = KEA_DATASETNAME_BAND + uint2Str(band);
+                H5::DataSet srcDataset = srcIO->keaImgFile->openDataSet(bandPath + KEA_BANDNAME_DATA);
+                uint32_t deflate = getDatasetDeflate(srcDataset);
+                KEAImageIO::addImageBandToFile(dstIO.keaImgFile, srcIO->getImageBandDataType(band), xSize, ySize, band, "", srcIO->getImageBlockSize(band), KEA_ATT_CHUNK_SIZE_AUTO, deflate);
+                ++dstIO.numImgBands;
+                KEAImageIO::setNumImgBandsInFileMetadata(dstIO.keaImgFile, dstIO.numImgBands);
+                
+                std::vector<std::string> skipBandNames = { KEA_BANDNAME_DATA, KEA_BANDNAME_MASK, KEA_BANDNAME_OVERVIEWS };
+                KEAImageIO::copyGroupMembers(srcIO->keaImgFile, bandPath, dstIO.keaImgFile, bandPath, skipBandNames);
+                
+                H5::DataSet dstDataset = dstIO.keaImgFile->openDataSet(bandPath + KEA_BANDNAME_DATA);
+                KEAImageIO::copyDatasetWindow(srcDataset, dstDataset, xPxlOff, yPxlOff);
+                dstDataset.close();
+                srcDataset.close();
+                
+                if(srcIO->maskCreated(band))
+                {
+                    H5::DataSet srcMaskDataset = srcIO->keaImgFile->openDataSet(bandPath + KEA_BANDNAME_MASK);
+                    dstIO.createMask(band, getDatasetDeflate(srcMaskDataset));
+                    H5::DataSet dstMaskDataset = dstIO.keaImgFile->openDataSet(bandPath + KEA_BANDNAME_MASK);
+                    KEAImageIO::copyDatasetWindow(srcMaskDataset, dstMaskDataset, xPxlOff, yPxlOff);
+                    dstMaskDataset.close();
+                    srcMaskDataset.close();
+                }
+                
+                // THE SAME AREA OF EACH OVERVIEW, ROUNDED OUT TO WHOLE PIXELS
+                uint32_t numOverviews = srcIO->getNumOfOverviews(band);
+                for(uint32_t overview = 1; overview <= numOverviews; ++overview)
+                {
+                    uint64_t ovXSize = 0;
+                    uint64_t ovYSize = 0;
+                    srcIO->getOverviewSize(band, overview, &ovXSize, &ovYSize);
+                    uint64_t ovXOff = (xPxlOff * ovXSize) / srcSpatialInfo->xSize;
+                    uint64_t ovYOff = (yPxlOff * ovYSize) / srcSpatialInfo->ySize;
+                    uint64_t ovXEnd = std::min<uint64_t>(ovXSize, (((xPxlOff + xSize) * ovXSize) + srcSpatialInfo->xSize - 1) / srcSpatialInfo->xSize);
+                    uint64_t ovYEnd = std::min<uint64_t>(ovYSize, (((yPxlOff + ySize) * ovYSize) + srcSpatialInfo->ySize - 1) / srcSpatialInfo->ySize);
+                    if((ovXEnd <= ovXOff) || (ovYEnd <= ovYOff))
+                    {
+                        continue;
+                    }
+                    
+                    std::string overviewName = bandPath + KEA_OVERVIEWSNAME_OVERVIEW + uint2Str(overview);
+                    dstIO.createOverview(band, overview, ovXEnd - ovXOff, ovYEnd - ovYOff);
+                    H5::DataSet srcOverviewDataset = srcIO->keaImgFile->openDataSet(overviewName);
+                    H5::DataSet dstOverviewDataset = dstIO.keaImgFile->openDataSet(overviewName);
+                    KEAImageIO::copyDatasetWindow(srcOverviewDataset, dstOverviewDataset, ovXOff, ovYOff);
+                    dstOverviewDataset.close();
+                    srcOverviewDataset.close();
                 }
-
-                addImageBandToFile(keaImgH5File, dataType, xSize, ySize,
-                        i+1, bandDescription, imageBlockSize, attBlockSize,
-                        deflate);
             }
-            //////////// CREATED IMAGE BANDS ////////////////
             
-            dataspaceStrAll.close();
-            keaImgH5File->flush(H5F_SCOPE_GLOBAL);
+            // THE BANDS WERE ADDED BEHIND ITS BACK
+            dstIO.rebuildConsolidatedHeader();
+            dstIO.close();
         }
-        catch (const KEAIOException &e) 
+        catch ( const H5::Exception &e)
+        {
+            throw KEAIOException(e.getCDetailMsg());
+        }
+        catch ( const KEAIOException &e)
         {
             throw e;
         }
-        catch( const H5::FileIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataSetIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataSpaceIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataTypeIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
         catch ( const std::exception &e)
         {
             throw KEAIOException(e.what());
         }
         
-        return keaImgH5File;
+        return KEAImageIO::openKeaH5RW(fileName, mdcElmts, rdccNElmts, rdccNBytes, rdccW0, sieveBuf, metaBlockSize);
     }
     
-    H5::H5File* KEAImageIO::openKeaH5RW(const std::string &fileName, int mdcElmts, hsize_t rdccNElmts, hsize_t rdccNBytes, double rdccW0, hsize_t sieveBuf, hsize_t metaBlockSize)
+    H5::H5File* KEAImageIO::cloneKEAImage(KEAImageIO *srcIO, const std::string &fileName, int mdcElmts, hsize_t rdccNElmts, hsize_t rdccNBytes, double rdccW0, hsize_t sieveBuf, hsize_t metaBlockSize)
     {
-        H5::Exception::dontPrint();
+        KEATraceScope trace("KEAImageIO::cloneKEAImage", KEA_TRACE_API);
+        KEAImageIOLock srcLock(srcIO->ioMutex, srcIO->threadSafe, kea_lock_read);
         
-        H5::H5File *keaImgH5File = nullptr;
-        try 
-        {
-            H5::FileAccPropList keaAccessPlist = H5::FileAccPropList(H5::FileAccPropList::DEFAULT);
-            keaAccessPlist.setCache(mdcElmts, rdccNElmts, rdccNBytes, rdccW0);
-            keaAccessPlist.setSieveBufSize(sieveBuf);
-            keaAccessPlist.setMetaBlockSize(metaBlockSize);
-            
-            const H5std_string keaImgFilePath(fileName);
-            keaImgH5File = new H5::H5File(keaImgFilePath, H5F_ACC_RDWR, H5::FileCreatPropList::DEFAULT, keaAccessPlist);
-            
-        } 
-        catch (const KEAIOException &e) 
-        {
-            throw e;
-        }
-        catch( const H5::FileIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataSetIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataSpaceIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataTypeIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-        catch ( const std::exception &e)
+        if(!srcIO->fileOpen)
         {
-            throw KEAIOException(e.what());
+            throw KEAIOException("Source image was not open.");
         }
         
-        return keaImgH5File;
-    }
-    
-    H5::H5File* KEAImageIO::openKeaH5RDOnly(const std::string &fileName, int mdcElmts, hsize_t rdccNElmts, hsize_t rdccNBytes, double rdccW0, hsize_t sieveBuf, hsize_t metaBlockSize)
-    {
         H5::Exception::dontPrint();
         
         H5::H5File *keaImgH5File = nullptr;
-        try 
+        try
         {
             H5::FileAccPropList keaAccessPlist = H5::FileAccPropList(H5::FileAccPropList::DEFAULT);
             keaAccessPlist.setCache(mdcElmts, rdccNElmts, rdccNBytes, rdccW0);
             keaAccessPlist.setSieveBufSize(sieveBuf);
             keaAccessPlist.setMetaBlockSize(metaBlockSize);
             
-            const H5std_string keaImgFilePath(fileName);
-            keaImgH5File = new H5::H5File(keaImgFilePath, H5F_ACC_RDONLY, H5::FileCreatPropList::DEFAULT, keaAccessPlist);
+            keaImgH5File = new H5::H5File( fileName, H5F_ACC_TRUNC, H5::FileCreatPropList::DEFAULT, keaAccessPlist);
+            
+            // COPY EVERY TOP LEVEL OBJECT - CHUNKS ARE MOVED WITHOUT BEING DECODED
+            H5::Group srcRoot = srcIO->keaImgFile->openGroup("/");
+            hsize_t numItems = srcRoot.getNumObjs();
+            for(hsize_t i = 0; i < numItems; ++i)
+            {
+                std::string name = srcRoot.getObjnameByIdx(i);
+                if(H5Ocopy(srcRoot.getId(), name.c_str(), keaImgH5File->getId(), name.c_str(), H5P_DEFAULT, H5P_DEFAULT) < 0)
+                {
+                    throw KEAIOException("Could not copy '" + name + "' from the source image.");
+                }
+            }
+            srcRoot.close();
             
+            keaFlushFile(keaImgH5File);
         }
-        catch (const KEAIOException &e) 
+        catch ( const H5::Exception &e)
+        {
+            delete keaImgH5File;
+            throw KEAIOException(e.getCDetailMsg());
+        }
+        catch ( const KEAIOException &e)
         {
+            delete keaImgH5File;
             throw e;
         }
-        catch( const H5::FileIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataSetIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataSpaceIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
-		catch( const H5::DataTypeIException &e )
-		{
-			throw KEAIOException(e.getCDetailMsg());
-		}
         catch ( const std::exception &e)
         {
+            delete keaImgH5File;
             throw KEAIOException(e.what());
         }
         
         return keaImgH5File;
     }
-        
-    bool KEAImageIO::isKEAImage(const std::string &fileName)
+
+    int64_t KEAImageIO::repackKEAImage(const std::string &fileName, const std::string &dstFileName, uint32_t imageBlockSize, uint32_t deflate, uint32_t attBlockSize)
     {
-        bool keaImageFound = false;
+        KEATraceScope trace("KEAImageIO::repackKEAImage", KEA_TRACE_API);
         H5::Exception::dontPrint();
         
-        try 
+        const bool inPlace = dstFileName.empty() || (dstFileName == fileName);
+        const std::string outFileName = inPlace ? (fileName + ".repack.tmp") : dstFileName;
+        int64_t srcFileSize = 0;
+        int64_t dstFileSize = 0;
+        
+        try
         {
-            H5::H5File *keaImgH5File = nullptr;
-            const H5std_string keaImgFilePath(fileName);
-            keaImgH5File = new H5::H5File(keaImgFilePath, H5F_ACC_RDONLY);
+            KEAImageIO srcIO;
+            srcIO.openKEAImageHeader(KEAImageIO::openKeaH5RDOnly(fileName));
+            srcFileSize = srcIO.keaImgFile->getFileSize();
             
-            try 
+            // EVERYTHING BUT THE BANDS IS SMALL SO IS COPIED AS IT IS
+            H5::FileAccPropList keaAccessPlist = H5::FileAccPropList(H5::FileAccPropList::DEFAULT);
+            keaAccessPlist.setCache(KEA_MDC_NELMTS, KEA_RDCC_NELMTS, KEA_RDCC_NBYTES, KEA_RDCC_W0);
+            keaAccessPlist.setSieveBufSize(KEA_SIEVE_BUF);
+            hsize_t metaBlockSize = KEA_META_BLOCKSIZE;
+            keaAccessPlist.setMetaBlockSize(metaBlockSize);
+            
+            // KEEP THE FILE SPACE STRATEGY (E.G. PAGED AGGREGATION) OF THE SOURCE
+            H5::FileCreatPropList keaCreatePlist;
+#if H5_VERSION_GE(1,10,1)
+            H5::FileCreatPropList srcCreatePlist = srcIO.keaImgFile->getCreatePlist();
+            H5F_fspace_strategy_t fsStrategy = H5F_FSPACE_STRATEGY_FSM_AGGR;
+            hbool_t fsPersist = false;
+            hsize_t fsThreshold = 1;
+            hsize_t fsPageSize = 0;
+            if((H5Pget_file_space_strategy(srcCreatePlist.getId(), &fsStrategy, &fsPersist, &fsThreshold) < 0) ||
+               (H5Pget_file_space_page_size(srcCreatePlist.getId(), &fsPageSize) < 0) ||
+               (H5Pset_file_space_strategy(keaCreatePlist.getId(), fsStrategy, fsPersist, fsThreshold) < 0) ||
+               ((fsStrategy == H5F_FSPACE_STRATEGY_PAGE) && (H5Pset_file_space_page_size(keaCreatePlist.getId(), fsPageSize) < 0)))
             {
-                H5::DataSet datasetFileType = keaImgH5File->openDataSet( KEA_DATASETNAME_HEADER_FILETYPE );
-                H5::DataType strFTDataType = datasetFileType.getDataType();
-                std::string fileType = readString(datasetFileType, strFTDataType);
-                datasetFileType.close();
-                                
-                try 
+                throw KEAIOException("Could not copy the file space strategy of the image.");
+            }
+#endif
+            H5::H5File *keaImgH5File = new H5::H5File(outFileName, H5F_ACC_TRUNC, keaCreatePlist, keaAccessPlist);
+            std::vector<std::string> skipNames;
+            for(uint32_t band = 1; band <= srcIO.numImgBands; ++band)
+            {
+                skipNames.push_back(KEA_DATASETNAME_BAND + uint2Str(band));
+            }
+            KEAImageIO::copyGroupMembers(srcIO.keaImgFile, "/", keaImgH5File, "/", skipNames);
+            KEAImageIO::setNumImgBandsInFileMetadata(keaImgH5File, 0);
+            if(H5Lexists(keaImgH5File->getId(), KEA_DATASETNAME_HEADER_CONSOLIDATED.c_str(), H5P_DEFAULT) > 0)
+            {
+                // WRITTEN AGAIN AS THE BANDS ARE ADDED
+                keaImgH5File->unlink(KEA_DATASETNAME_HEADER_CONSOLIDATED);
+            }
+            
+            KEAImageIO dstIO;
+            dstIO.openKEAImageHeader(keaImgH5File);
+            for(uint32_t band = 1; band <= srcIO.numImgBands; ++band)
+            {
+                const std::string bandPath = KEA_DATASETNAME_BAND + uint2Str(band);
+                H5::DataSet srcDataset = srcIO.keaImgFile->openDataSet(bandPath + KEA_BANDNAME_DATA);
+                uint32_t bandDeflate = (deflate == KEA_REPACK_KEEP) ? getDatasetDeflate(srcDataset) : deflate;
+                srcDataset.close();
+                uint32_t bandBlockSize = (imageBlockSize == KEA_REPACK_KEEP) ? srcIO.getImageBlockSize(band) : imageBlockSize;
+                
+                // UNCHANGED LAYOUTS ARE COPIED CHUNK FOR CHUNK
+                dstIO.copyBandFrom(&srcIO, band, bandBlockSize, bandDeflate);
+                
+                // TABLES FLAGGED AS AUTO SIZED ARE RESIZED FOR THEIR ROWS WHEN KEPT
+                const uint32_t srcAttBlockSize = srcIO.getAttributeTableChunkSize(band);
+                const bool attAuto = (attBlockSize == KEA_ATT_CHUNK_SIZE_AUTO) || ((attBlockSize == KEA_REPACK_KEEP) && KEAAttributeTable::getAutoChunkSizeFlag(srcIO.keaImgFile, bandPath));
+                uint32_t bandAttBlockSize = (attBlockSize == KEA_REPACK_KEEP) ? srcAttBlockSize : attBlockSize;
+                if(attAuto)
                 {
-                    if(fileType == "KEA")
-                    {
-                        H5::DataSet datasetFileVersion = keaImgH5File->openDataSet( KEA_DATASETNAME_HEADER_VERSION );
-                        H5::DataType strVerDataType = datasetFileVersion.getDataType();
-                        std::string fileVersion = readString(datasetFileVersion, strVerDataType);
-                        datasetFileVersion.close();
-                        
-                        if((fileVersion == "1.0") || (fileVersion == "1.1"))
-                        {
-                            keaImageFound = true;
-                        }
-                        else
-                        {
-                            keaImageFound = false;
-                        }
-                    }
-                    else
+                    KEAAttributeTable *srcAtt = srcIO.getAttributeTable(kea_att_file, band);
+                    bandAttBlockSize = KEAAttributeTable::getAutoChunkSize(srcAtt->getSize());
+                    KEAAttributeTable::destroyAttributeTable(srcAtt);
+                }
+                if(bandAttBlockSize != srcAttBlockSize)
+                {
+                    // THE ATTRIBUTE TABLE HAS TO BE WRITTEN OUT AGAIN WITH THE NEW CHUNKING
+                    KEAAttributeTable *att = srcIO.getAttributeTable(kea_att_mem, band);
+                    dstIO.keaImgFile->unlink(bandPath + KEA_BANDNAME_ATT);
+                    KEAImageIO::addATTGroupToBand(dstIO.keaImgFile, bandPath, bandAttBlockSize);
+                    if(att->getSize() > 0)
                     {
-                        keaImageFound = false;
+                        dstIO.setAttributeTable(att, band, bandAttBlockSize, bandDeflate);
                     }
-                } 
-                catch ( const H5::Exception &e) // WILL BE THROWN IF THE FILE VERSION DATASET IS NOT PRESENT
+                    KEAAttributeTable::destroyAttributeTable(att);
+                }
+                if((attBlockSize != KEA_REPACK_KEEP) || (bandAttBlockSize != srcAttBlockSize))
                 {
-                    keaImageFound = false;
+                    KEAAttributeTable::setAutoChunkSizeFlag(dstIO.keaImgFile, bandPath, attAuto);
                 }
-                
-            } 
-            catch ( const H5::Exception &e) // WILL BE THROWN IF THE FILE TYPE DATASET IS NOT PRESENT
-            {
-                keaImageFound = false;
             }
             
-            keaImgH5File->close();
-            delete keaImgH5File;
-        } 
-        catch( const H5::Exception &e ) // WILL BE THROWN WHEN THE HDF LIBRARY CANNOT OPEN THE FILE - IE IT IS NOT A HDF5 FILE!
-		{
-			keaImageFound = false;
-		}
+            keaFlushFile(dstIO.keaImgFile);
+            dstFileSize = dstIO.keaImgFile->getFileSize();
+            dstIO.close();
+            srcIO.close();
+        }
+        catch ( const H5::Exception &e)
+        {
+            remove(outFileName.c_str());
+            throw KEAIOException(e.getCDetailMsg());
+        }
         catch ( const KEAIOException &e)
         {
+            remove(outFileName.c_str());
             throw e;
         }
         catch ( const std::exception &e)
         {
+            remove(outFileName.c_str());
             throw KEAIOException(e.what());
         }
         
-        return keaImageFound;
-    }
-
-    KEAImageIO::~KEAImageIO()
-    {
-        
-    }
-
-    void KEAImageIO::addImageBand(const KEADataType dataType, const std::string &bandDescrip, const uint32_t imageBlockSize, const uint32_t attBlockSize, const uint32_t deflate)
-    {
-        if(!this->fileOpen)
-        {
-            throw KEAIOException("Image was not open.");
-        }
-
-        const uint32_t xSize = this->spatialInfoFile->xSize;
-        const uint32_t ySize = this->spatialInfoFile->ySize;
-
-        // add a new image band to the file
-        KEAImageIO::addImageBandToFile(this->keaImgFile, dataType, xSize, ySize, this->numImgBands + 1, bandDescrip, imageBlockSize, attBlockSize, deflate);
-        ++this->numImgBands;
-
-        // update the band counter in the file metadata
-        KEAImageIO::setNumImgBandsInFileMetadata(this->keaImgFile, this->numImgBands);
-
-        this->keaImgFile->flush(H5F_SCOPE_GLOBAL);
-    }
-    
-    void KEAImageIO::removeImageBand(const uint32_t bandIndex)
-    {
-
-        if(!this->fileOpen)
+        if(inPlace && (rename(outFileName.c_str(), fileName.c_str()) != 0))
         {
-            throw KEAIOException("Image was not open.");
+            remove(outFileName.c_str());
+            throw KEAIOException("Could not replace '" + fileName + "' with the repacked file.");
         }
         
-        KEAImageIO::removeImageBandFromFile(this->keaImgFile, bandIndex, this->numImgBands);
-    
-        --this->numImgBands;
-
-        // update the band counter in the file metadata
-        KEAImageIO::setNumImgBandsInFileMetadata(this->keaImgFile, this->numImgBands);
-
-        this->keaImgFile->flush(H5F_SCOPE_GLOBAL);
+        return srcFileSize - dstFileSize;
     }
 
     H5::DataType KEAImageIO::convertDatatypeKeaToH5STD(const KEADataType dataType)
@@ -3315,14 +6556,27 @@ namespace kealib{
         return h5Datatype;
     }
 
-    void KEAImageIO::addImageBandToFile(H5::H5File *keaImgH5File, const KEADataType dataType, const uint32_t xSize,   const uint32_t ySize, const uint32_t bandIndex, const std::string &bandDescripIn, const uint32_t imageBlockSize, const uint32_t attBlockSize,  const uint32_t deflate)
+    void KEAImageIO::addImageBandToFile(H5::H5File *keaImgH5File, const KEADataType dataType, const uint32_t xSize,   const uint32_t ySize, const uint32_t bandIndex, const std::string &bandDescripIn, const uint32_t imageBlockSize, const uint32_t attBlockSize,  const uint32_t deflate, const KEAImageExtend extend)
     {
         int initFillVal = 0;
         std::string bandDescrip = bandDescripIn; // may be updated below
 
-        // Find the smallest axis of the image.
-        uint64_t minImgDim = xSize < ySize ? xSize : ySize; 
+        // Find the smallest fixed axis of the image - an extendable axis
+        // will grow so shouldn't limit the block size.
+        uint64_t minImgDim = imageBlockSize;
+        if(extend == kea_extend_none)
+        {
+            minImgDim = xSize < ySize ? xSize : ySize;
+        }
+        else if(extend == kea_extend_y)
+        {
+            minImgDim = xSize;
+        }
         uint32_t blockSize2Use = imageBlockSize > minImgDim ? minImgDim : imageBlockSize;
+        if(blockSize2Use == 0)
+        {
+            blockSize2Use = 1;
+        }
 
         try
         {
@@ -3349,7 +6603,9 @@ namespace kealib{
             // CREATE THE IMAGE DATA ARRAY
             H5::DataType imgBandDT = convertDatatypeKeaToH5STD(dataType);
             hsize_t imageBandDims[] = { ySize, xSize };
-            H5::DataSpace imgBandDataSpace(2, imageBandDims);
+            hsize_t imageBandMaxDims[2];
+            getExtendMaxDims(extend, imageBandDims, imageBandMaxDims);
+            H5::DataSpace imgBandDataSpace(2, imageBandDims, imageBandMaxDims);
             H5::DataSet imgBandDataSet = keaImgH5File->createDataSet((bandName+KEA_BANDNAME_DATA), imgBandDT, imgBandDataSpace, initParamsImgBand);
             H5::Attribute classAttribute = imgBandDataSet.createAttribute(KEA_ATTRIBUTENAME_CLASS, strdatatypeLen6, attr_dataspace);
             classAttribute.write(strdatatypeLen6, strClassVal); 
@@ -3413,28 +6669,7 @@ namespace kealib{
             keaImgH5File->createGroup( bandName+KEA_BANDNAME_OVERVIEWS );
 
             // CREATE ATTRIBUTE TABLE GROUP
-            keaImgH5File->createGroup( bandName+KEA_BANDNAME_ATT );
-            keaImgH5File->createGroup( bandName+KEA_ATT_GROUPNAME_DATA );
-            keaImgH5File->createGroup( bandName+KEA_ATT_GROUPNAME_NEIGHBOURS );
-            keaImgH5File->createGroup( bandName+KEA_ATT_GROUPNAME_HEADER );
-
-            // SET ATTRIBUTE TABLE CHUNK SIZE
-            int attChunkSize = attBlockSize;
-            hsize_t dimsAttChunkSize[] = { 1 };
-            H5::DataSpace attChunkSizeDataSpace(1, dimsAttChunkSize);
-            H5::DataSet attChunkSizeDataset = keaImgH5File->createDataSet((bandName+KEA_ATT_CHUNKSIZE_HEADER), H5::PredType::STD_U64LE, attChunkSizeDataSpace);
-            attChunkSizeDataset.write( &attChunkSize, H5::PredType::NATIVE_INT);
-            attChunkSizeDataset.close();
-            attChunkSizeDataSpace.close();
-
-            // SET ATTRIBUTE TABLE SIZE
-            int attSize[] = { 0, 0, 0, 0, 0 };
-            hsize_t dimsAttSize[] = { 5 };
-            H5::DataSpace attSizeDataSpace(1, dimsAttSize);
-            H5::DataSet attSizeDataset = keaImgH5File->createDataSet((bandName+KEA_ATT_SIZE_HEADER), H5::PredType::STD_U64LE, attSizeDataSpace);
-            attSizeDataset.write( attSize, H5::PredType::NATIVE_INT );
-            attSizeDataset.close();
-            attSizeDataSpace.close();
+            addATTGroupToBand(keaImgH5File, bandName, attBlockSize);
 
             attr_dataspace.close();
         }
@@ -3460,6 +6695,184 @@ namespace kealib{
         }
     }
     
+    void KEAImageIO::getExtendMaxDims(const KEAImageExtend extend, const hsize_t *dims, hsize_t *maxDims)
+    {
+        // DIMS ARE IN HDF5 ORDER (Y, X)
+        maxDims[0] = (extend == kea_extend_none) ? dims[0] : H5S_UNLIMITED;
+        maxDims[1] = (extend == kea_extend_xy) ? H5S_UNLIMITED : dims[1];
+    }
+    
+    void KEAImageIO::addATTGroupToBand(H5::H5File *keaImgH5File, const std::string &bandName, const uint32_t attBlockSize)
+    {
+        keaImgH5File->createGroup( bandName+KEA_BANDNAME_ATT );
+        keaImgH5File->createGroup( bandName+KEA_ATT_GROUPNAME_DATA );
+        keaImgH5File->createGroup( bandName+KEA_ATT_GROUPNAME_NEIGHBOURS );
+        keaImgH5File->createGroup( bandName+KEA_ATT_GROUPNAME_HEADER );
+
+        // SET ATTRIBUTE TABLE CHUNK SIZE - AN AUTOMATIC ONE STARTS AT THE DEFAULT AND IS CHOSEN FROM THE ROWS ON EXPORT
+        int attChunkSize = (attBlockSize == KEA_ATT_CHUNK_SIZE_AUTO) ? KEA_ATT_CHUNK_SIZE : attBlockSize;
+        hsize_t dimsAttChunkSize[] = { 1 };
+        H5::DataSpace attChunkSizeDataSpace(1, dimsAttChunkSize);
+        H5::DataSet attChunkSizeDataset = keaImgH5File->createDataSet((bandName+KEA_ATT_CHUNKSIZE_HEADER), H5::PredType::STD_U64LE, attChunkSizeDataSpace);
+        attChunkSizeDataset.write( &attChunkSize, H5::PredType::NATIVE_INT);
+        attChunkSizeDataset.close();
+        attChunkSizeDataSpace.close();
+        KEAAttributeTable::setAutoChunkSizeFlag(keaImgH5File, bandName, attBlockSize == KEA_ATT_CHUNK_SIZE_AUTO);
+
+        // SET ATTRIBUTE TABLE SIZE
+        int attSize[] = { 0, 0, 0, 0, 0 };
+        hsize_t dimsAttSize[] = { 5 };
+        H5::DataSpace attSizeDataSpace(1, dimsAttSize);
+        H5::DataSet attSizeDataset = keaImgH5File->createDataSet((bandName+KEA_ATT_SIZE_HEADER), H5::PredType::STD_U64LE, attSizeDataSpace);
+        attSizeDataset.write( attSize, H5::PredType::NATIVE_INT );
+        attSizeDataset.close();
+        attSizeDataSpace.close();
+    }
+    
+    void KEAImageIO::copyGroupMembers(H5::H5File *srcH5File, const std::string &srcGroupPath, H5::H5File *dstH5File, const std::string &dstGroupPath, const std::vector<std::string> &skipNames)
+    {
+        H5::Group srcGrp = srcH5File->openGroup(srcGroupPath);
+        H5::Group dstGrp = dstH5File->openGroup(dstGroupPath);
+        hsize_t numItems = srcGrp.getNumObjs();
+        for(hsize_t i = 0; i < numItems; ++i)
+        {
+            // THE SKIP NAMES ARE THE KEA_* CONSTANTS SO HAVE A LEADING SLASH
+            std::string name = srcGrp.getObjnameByIdx(i);
+            if(std::find(skipNames.begin(), skipNames.end(), "/" + name) != skipNames.end())
+            {
+                continue;
+            }
+            if(H5Lexists(dstGrp.getId(), name.c_str(), H5P_DEFAULT) > 0)
+            {
+                dstGrp.unlink(name);
+            }
+            if(H5Ocopy(srcGrp.getId(), name.c_str(), dstGrp.getId(), name.c_str(), H5P_DEFAULT, H5P_DEFAULT) < 0)
+            {
+                throw KEAIOException("Could not copy '" + name + "' from the source image.");
+            }
+        }
+        srcGrp.close();
+        dstGrp.close();
+    }
+    
+    uint64_t KEAImageIO::copyDatasetWindow(const H5::DataSet &srcDataset, H5::DataSet &dstDataset, uint64_t xPxlOff, uint64_t yPxlOff)
+    {
+        hsize_t dstDims[2];
+        H5::DataSpace dstDataspace = dstDataset.getSpace();
+        dstDataspace.getSimpleExtentDims(dstDims);
+        
+        H5::DSetCreatPropList srcCreatePList = srcDataset.getCreatePlist();
+        H5::DSetCreatPropList dstCreatePList = dstDataset.getCreatePlist();
+        hsize_t srcChunkDims[2];
+        hsize_t chunkDims[2];
+        srcCreatePList.getChunk(2, srcChunkDims);
+        dstCreatePList.getChunk(2, chunkDims);
+        
+        // CHUNKS CAN ONLY BE MOVED AS THEY ARE IF THEY LINE UP AND ARE
+        // ENCODED THE SAME WAY
+        H5::DataType dataType = srcDataset.getDataType();
+        bool rawCopy = (srcChunkDims[0] == chunkDims[0]) && (srcChunkDims[1] == chunkDims[1]) &&
+                        ((yPxlOff % chunkDims[0]) == 0) && ((xPxlOff % chunkDims[1]) == 0) &&
+                        (dataType == dstDataset.getDataType()) &&
+                        (srcCreatePList.getNfilters() == dstCreatePList.getNfilters()) &&
+                        (getDatasetDeflate(srcDataset) == getDatasetDeflate(dstDataset));
+        srcCreatePList.close();
+        dstCreatePList.close();
+        
+        uint64_t numRawChunks = 0;
+        std::vector<char> buffer(chunkDims[0] * chunkDims[1] * dataType.getSize());
+        std::vector<char> rawData;
+        H5::DataSpace srcDataspace = srcDataset.getSpace();
+        for(hsize_t yChunk = 0; yChunk < dstDims[0]; yChunk += chunkDims[0])
+        {
+            for(hsize_t xChunk = 0; xChunk < dstDims[1]; xChunk += chunkDims[1])
+            {
+                hsize_t count[2];
+                count[0] = std::min<hsize_t>(chunkDims[0], dstDims[0] - yChunk);
+                count[1] = std::min<hsize_t>(chunkDims[1], dstDims[1] - xChunk);
+                hsize_t srcOffset[2] = { yPxlOff + yChunk, xPxlOff + xChunk };
+                hsize_t dstOffset[2] = { yChunk, xChunk };
+#ifdef KEA_DIRECT_CHUNK_COPY
+                if(rawCopy && (count[0] == chunkDims[0]) && (count[1] == chunkDims[1]))
+                {
+                    unsigned int filterMask = 0;
+                    haddr_t chunkAddr = HADDR_UNDEF;
+                    hsize_t chunkStorageSize = 0;
+                    if(H5Dget_chunk_info_by_coord(srcDataset.getId(), srcOffset, &filterMask, &chunkAddr, &chunkStorageSize) < 0)
+                    {
+                        throw KEAIOException("Could not read image data.");
+                    }
+                    if((chunkAddr != HADDR_UNDEF) && (chunkStorageSize > 0))
+                    {
+                        // AN UNWRITTEN CHUNK IS LEFT UNWRITTEN - THE FILL VALUES MATCH
+                        rawData.resize(chunkStorageSize);
+                        uint32_t readFilterMask = 0;
+                        if((H5Dread_chunk(srcDataset.getId(), H5P_DEFAULT, srcOffset, &readFilterMask, rawData.data()) < 0) ||
+                           (H5Dwrite_chunk(dstDataset.getId(), H5P_DEFAULT, readFilterMask, dstOffset, chunkStorageSize, rawData.data()) < 0))
+                        {
+                            throw KEAIOException("Could not copy image chunk.");
+                        }
+                    }
+                    ++numRawChunks;
+                    continue;
+                }
+#endif
+                // EDGE CHUNK - GO THROUGH THE FILTERS
+                srcDataspace.selectHyperslab(H5S_SELECT_SET, count, srcOffset);
+                dstDataspace.selectHyperslab(H5S_SELECT_SET, count, dstOffset);
+                H5::DataSpace memDataspace(2, count);
+                srcDataset.read(buffer.data(), dataType, memDataspace, srcDataspace);
+                dstDataset.write(buffer.data(), dataType, memDataspace, dstDataspace);
+                memDataspace.close();
+            }
+        }
+        srcDataspace.close();
+        dstDataspace.close();
+        
+        return numRawChunks;
+    }
+    
+    uint32_t KEAImageIO::getDatasetDeflate(const H5::DataSet &dataset)
+    {
+        H5::DSetCreatPropList creationPList = dataset.getCreatePlist();
+        uint32_t deflate = 0;
+        int numFilters = creationPList.getNfilters();
+        for(int i = 0; i < numFilters; ++i)
+        {
+            unsigned int flags = 0;
+            size_t cdNElmts = 1;
+            unsigned int cdValues[1] = { 0 };
+            unsigned int filterConfig = 0;
+            char name[64];
+            H5Z_filter_t filter = creationPList.getFilter(i, flags, cdNElmts, cdValues, sizeof(name), name, filterConfig);
+            if(filter == H5Z_FILTER_DEFLATE)
+            {
+                deflate = (cdNElmts > 0) ? cdValues[0] : 0;
+            }
+        }
+        creationPList.close();
+        return deflate;
+    }
+    
+    KEAImageExtend KEAImageIO::getDatasetExtend(const H5::DataSet &dataset)
+    {
+        hsize_t dims[2];
+        hsize_t maxDims[2];
+        H5::DataSpace dataspace = dataset.getSpace();
+        if(dataspace.getSimpleExtentNdims() != 2)
+        {
+            throw KEAIOException("Image dataset is not 2 dimensional.");
+        }
+        dataspace.getSimpleExtentDims(dims, maxDims);
+        dataspace.close();
+        
+        if(maxDims[0] != H5S_UNLIMITED)
+        {
+            return kea_extend_none;
+        }
+        return (maxDims[1] == H5S_UNLIMITED) ? kea_extend_xy : kea_extend_y;
+    }
+    
     void KEAImageIO::removeImageBandFromFile(H5::H5File *keaImgH5File, const uint32_t bandIndex, const uint32_t numImgBands)
     {
         if( ( bandIndex < 1) || ( bandIndex > numImgBands ) )
@@ -0,0 +1,198 @@
+/*
+ *  KEAThreadPool.cpp
+ *  LibKEA
+ *
+ *  Copyright 2026 LibKEA. All rights reserved.
+ *
+ *  This file is part of LibKEA.
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify,
+ *  merge, publish, distribute, sublicense, and/or sell copies of the
+ *  Software, and to permit persons to whom the Software is furnished
+ *  to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ *  ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *  CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "libkea/KEAThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace kealib{
+
+    // shared between the caller of parallelFor and the helper tasks
+    // it queues. Helpers may start after the caller has returned so
+    // everything they touch lives here.
+    struct KEAParallelForState
+    {
+        std::function<void(size_t)> func;
+        size_t numTasks;
+        std::atomic<size_t> next;
+        size_t numDone;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable cond;
+
+        void run()
+        {
+            while(true)
+            {
+                size_t i = next.fetch_add(1);
+                if(i >= numTasks)
+                {
+                    break;
+                }
+
+                std::exception_ptr taskError;
+                bool failed = false;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    failed = (error != nullptr);
+                }
+                if(!failed)
+                {
+                    try
+                    {
+                        func(i);
+                    }
+                    catch(...)
+                    {
+                        taskError = std::current_exception();
+                    }
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if(taskError && !error)
+                {
+                    error = taskError;
+                }
+                if(++numDone == numTasks)
+                {
+                    cond.notify_all();
+                }
+            }
+        }
+    };
+
+    KEAThreadPool::KEAThreadPool(uint32_t numThreads)
+    {
+        this->stopping = false;
+        if(numThreads == 0)
+        {
+            numThreads = getDefaultNumThreads();
+        }
+        for(uint32_t i = 0; i < numThreads; ++i)
+        {
+            this->workers.push_back(std::thread(&KEAThreadPool::workerLoop, this));
+        }
+    }
+
+    void KEAThreadPool::submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->tasksMutex);
+            if(this->stopping)
+            {
+                throw KEAException("Cannot submit a task to a thread pool which is shutting down.");
+            }
+            this->tasks.push_back(std::move(task));
+        }
+        this->tasksCond.notify_one();
+    }
+
+    void KEAThreadPool::parallelFor(size_t numTasks, const std::function<void(size_t)> &func)
+    {
+        if(numTasks == 0)
+        {
+            return;
+        }
+
+        auto state = std::make_shared<KEAParallelForState>();
+        state->func = func;
+        state->numTasks = numTasks;
+        state->next = 0;
+        state->numDone = 0;
+
+        // the calling thread does its share so only queue enough helpers
+        // for the remaining tasks.
+        size_t numHelpers = std::min<size_t>(this->workers.size(), numTasks - 1);
+        for(size_t i = 0; i < numHelpers; ++i)
+        {
+            this->submit([state](){ state->run(); });
+        }
+
+        state->run();
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->cond.wait(lock, [&state](){ return state->numDone == state->numTasks; });
+        if(state->error)
+        {
+            std::rethrow_exception(state->error);
+        }
+    }
+
+    uint32_t KEAThreadPool::getNumThreads() const
+    {
+        return this->workers.size();
+    }
+
+    uint32_t KEAThreadPool::getDefaultNumThreads()
+    {
+        uint32_t numThreads = std::thread::hardware_concurrency();
+        if(numThreads == 0)
+        {
+            numThreads = 1;
+        }
+        return numThreads;
+    }
+
+    void KEAThreadPool::workerLoop()
+    {
+        while(true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(this->tasksMutex);
+                this->tasksCond.wait(lock, [this](){ return this->stopping || !this->tasks.empty(); });
+                if(this->tasks.empty())
+                {
+                    // only get here when stopping and all tasks are done
+                    return;
+                }
+                task = std::move(this->tasks.front());
+                this->tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    KEAThreadPool::~KEAThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->tasksMutex);
+            this->stopping = true;
+        }
+        this->tasksCond.notify_all();
+        for(auto iterWorker = this->workers.begin(); iterWorker != this->workers.end(); ++iterWorker)
+        {
+            (*iterWorker).join();
+        }
+    }
+
+}
@@ -0,0 +1,199 @@
+/*
+ *  KEATrace.cpp
+ *  LibKEA
+ *
+ *  Copyright 2026 LibKEA. All rights reserved.
+ *
+ *  This file is part of LibKEA.
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify,
+ *  merge, publish, distribute, sublicense, and/or sell copies of the
+ *  Software, and to permit persons to whom the Software is furnished
+ *  to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ *  ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *  CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "libkea/KEATrace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+namespace kealib{
+
+    std::atomic<bool> KEATrace::enabled(false);
+
+    struct KEATraceState
+    {
+        std::mutex mutex;
+        FILE *file;
+        bool firstEvent;
+        std::shared_ptr<KEATraceCallback> callback;
+    };
+
+    // created on first use so it is available to the KEA_TRACE setup below
+    // and outlives it at exit
+    static KEATraceState& traceState()
+    {
+        static KEATraceState state{ {}, NULL, true, nullptr };
+        return state;
+    }
+
+    static void writeJSONString(FILE *file, const char *str)
+    {
+        fputc('"', file);
+        for(const char *c = str; *c != '\0'; ++c)
+        {
+            if((*c == '"') || (*c == '\\'))
+            {
+                fputc('\\', file);
+            }
+            fputc(*c, file);
+        }
+        fputc('"', file);
+    }
+
+    void KEATrace::setCallback(KEATraceCallback callback)
+    {
+        KEATraceState &state = traceState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if(callback)
+        {
+            state.callback = std::make_shared<KEATraceCallback>(callback);
+        }
+        else
+        {
+            state.callback = nullptr;
+        }
+        updateEnabled();
+    }
+
+    bool KEATrace::startTraceFile(const std::string &fileName)
+    {
+        stopTraceFile();
+
+        KEATraceState &state = traceState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.file = fopen(fileName.c_str(), "w");
+        if(state.file == NULL)
+        {
+            updateEnabled();
+            return false;
+        }
+        // THE JSON ARRAY FORM, WHICH THE VIEWERS STILL LOAD IF THE
+        // PROCESS DIES BEFORE THE CLOSING BRACKET IS WRITTEN
+        fputs("[", state.file);
+        state.firstEvent = true;
+        nowMicros();
+        updateEnabled();
+        return true;
+    }
+
+    void KEATrace::stopTraceFile()
+    {
+        KEATraceState &state = traceState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if(state.file != NULL)
+        {
+            fputs("\n]\n", state.file);
+            fclose(state.file);
+            state.file = NULL;
+        }
+        updateEnabled();
+    }
+
+    uint64_t KEATrace::nowMicros()
+    {
+        static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    static uint32_t traceThreadId()
+    {
+        static std::atomic<uint32_t> nextThreadId(1);
+        thread_local uint32_t threadId = nextThreadId.fetch_add(1);
+        return threadId;
+    }
+
+    void KEATrace::record(const char *name, const char *category, uint64_t startMicros, uint64_t bytes)
+    {
+        KEATraceEvent event;
+        event.name = name;
+        event.category = category;
+        event.startMicros = startMicros;
+        event.durationMicros = nowMicros() - startMicros;
+        event.bytes = bytes;
+        event.threadId = traceThreadId();
+
+        std::shared_ptr<KEATraceCallback> callback;
+        KEATraceState &state = traceState();
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if(state.file != NULL)
+            {
+                fputs(state.firstEvent ? "\n{\"name\":" : ",\n{\"name\":", state.file);
+                writeJSONString(state.file, event.name);
+                fputs(",\"cat\":", state.file);
+                writeJSONString(state.file, event.category);
+                fprintf(state.file, ",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":1,\"tid\":%u,\"args\":{\"bytes\":%llu}}",
+                        static_cast<unsigned long long>(event.startMicros), static_cast<unsigned long long>(event.durationMicros),
+                        event.threadId, static_cast<unsigned long long>(event.bytes));
+                state.firstEvent = false;
+            }
+            callback = state.callback;
+        }
+
+        // CALLED WITHOUT THE LOCK SO THE CALLBACK MAY ITSELF USE LIBKEA
+        if(callback)
+        {
+            (*callback)(event);
+        }
+    }
+
+    void KEATrace::updateEnabled()
+    {
+        KEATraceState &state = traceState();
+        enabled.store((state.file != NULL) || (state.callback != nullptr), std::memory_order_relaxed);
+    }
+
+    // STARTS A TRACE WHEN KEA_TRACE IS SET AND FINISHES IT AT EXIT
+    class KEATraceFromEnv
+    {
+    public:
+        KEATraceFromEnv()
+        {
+            traceState();
+            const char *fileName = getenv("KEA_TRACE");
+            if((fileName != NULL) && (fileName[0] != '\0'))
+            {
+                if(!KEATrace::startTraceFile(fileName))
+                {
+                    fprintf(stderr, "libkea: could not create trace file %s\n", fileName);
+                }
+            }
+        }
+        ~KEATraceFromEnv()
+        {
+            KEATrace::stopTraceFile();
+        }
+    };
+
+    static KEATraceFromEnv traceFromEnv;
+
+}
@@ -0,0 +1,597 @@
+/*
+ *  KEAZonalStats.cpp
+ *  LibKEA
+ *
+ *  Copyright 2026 LibKEA. All rights reserved.
+ *
+ *  This file is part of LibKEA.
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify,
+ *  merge, publish, distribute, sublicense, and/or sell copies of the
+ *  Software, and to permit persons to whom the Software is furnished
+ *  to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ *  ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *  CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "libkea/KEAZonalStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "libkea/KEAAttributeTable.h"
+#include "libkea/KEABlockProcessor.h"
+#include "libkea/KEAImageIO.h"
+#include "libkea/KEATrace.h"
+
+namespace kealib{
+
+    // running statistics using Welford's method so partial results from
+    // different threads can be combined without losing precision.
+    struct KEAZonalAccumulator
+    {
+        uint64_t count;
+        double mean;
+        double m2;
+        double min;
+        double max;
+
+        KEAZonalAccumulator(): count(0), mean(0), m2(0), min(0), max(0)
+        {
+        }
+
+        void add(double value)
+        {
+            if(this->count == 0)
+            {
+                this->min = value;
+                this->max = value;
+            }
+            else
+            {
+                this->min = std::min(this->min, value);
+                this->max = std::max(this->max, value);
+            }
+            this->count++;
+            double delta = value - this->mean;
+            this->mean += delta / this->count;
+            this->m2 += delta * (value - this->mean);
+        }
+
+        void merge(const KEAZonalAccumulator &other)
+        {
+            if(other.count == 0)
+            {
+                return;
+            }
+            if(this->count == 0)
+            {
+                *this = other;
+                return;
+            }
+            uint64_t total = this->count + other.count;
+            double delta = other.mean - this->mean;
+            this->mean += delta * other.count / total;
+            this->m2 += other.m2 + (delta * delta * this->count * other.count / total);
+            this->min = std::min(this->min, other.min);
+            this->max = std::max(this->max, other.max);
+            this->count = total;
+        }
+    };
+
+    // accumulators, numBands per clump
+    typedef std::vector<KEAZonalAccumulator> KEAZonalAccumulators;
+
+    // number of rows written to the attribute table at a time
+    static const size_t KEA_ZONAL_WRITE_ROWS = 100000;
+
+    // clumps with accumulators below this index are held in an array,
+    // anything above in a hash
+    static const uint64_t KEA_ZONAL_DENSE_ACCUMULATORS = 1048576;
+
+    struct KEAZonalThreadStats
+    {
+        KEAZonalAccumulators dense;
+        std::unordered_map<uint64_t, KEAZonalAccumulators> sparse;
+    };
+
+    // values below this are counted in an array, anything above in a hash
+    static const uint64_t KEA_HISTOGRAM_DENSE_VALUES = 4194304;
+
+    struct KEAHistogramCounts
+    {
+        std::vector<int64_t> dense;
+        std::unordered_map<uint64_t, int64_t> sparse;
+    };
+
+    // number of finished clumps held before they are written out
+    static const size_t KEA_NEIGHBOURS_WRITE_CLUMPS = 10000;
+
+    // what one tile found about a clump
+    struct KEATileClump
+    {
+        int64_t numPixels;
+        std::vector<size_t> neighbours;
+    };
+    typedef std::unordered_map<uint64_t, KEATileClump> KEATileClumps;
+
+    static void keaAddNeighbour(std::vector<size_t> &neighbours, size_t neighbour)
+    {
+        if(std::find(neighbours.begin(), neighbours.end(), neighbour) == neighbours.end())
+        {
+            neighbours.push_back(neighbour);
+        }
+    }
+
+    void calcZonalStats(KEAImageIO *io, uint32_t clumpBand, const std::vector<KEAZonalStatsBand> &valueBands, uint32_t numThreads)
+    {
+        KEATraceScope trace("calcZonalStats", KEA_TRACE_API);
+
+        if(valueBands.empty())
+        {
+            throw KEAIOException("No value bands were given for the zonal statistics.");
+        }
+        size_t numBands = valueBands.size();
+
+        KEABlockProcessor processor(numThreads);
+        processor.addInput(io, clumpBand, kea_64int);
+        for(const KEAZonalStatsBand &valueBand : valueBands)
+        {
+            processor.addInput(valueBand.io, valueBand.band, kea_64float);
+        }
+
+        uint64_t denseClumps = std::max<uint64_t>(KEA_ZONAL_DENSE_ACCUMULATORS / numBands, 1);
+        std::mutex threadsMutex;
+        std::map< std::thread::id, std::unique_ptr<KEAZonalThreadStats> > threadStats;
+        processor.run([&](KEABlock &block)
+        {
+            KEAZonalThreadStats *stats = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(threadsMutex);
+                std::unique_ptr<KEAZonalThreadStats> &threadStat = threadStats[std::this_thread::get_id()];
+                if(!threadStat)
+                {
+                    threadStat.reset(new KEAZonalThreadStats());
+                }
+                stats = threadStat.get();
+            }
+
+            // NEGATIVE CLUMPS ARE NO DATA
+            const int64_t *clumps = block.getInput<int64_t>(0);
+            int64_t clumpNoData = 0;
+            bool clumpHasNoData = block.inputs[0].getIDNoData(&clumpNoData);
+            for(uint64_t i = 0; i < block.getNumPixels(); ++i)
+            {
+                if((clumps[i] < 0) || (clumpHasNoData && (clumps[i] == clumpNoData)))
+                {
+                    continue;
+                }
+                uint64_t clump = static_cast<uint64_t>(clumps[i]);
+                KEAZonalAccumulator *accumulators = nullptr;
+                if(clump < denseClumps)
+                {
+                    size_t accIdx = clump * numBands;
+                    if(accIdx >= stats->dense.size())
+                    {
+                        stats->dense.resize(accIdx + numBands);
+                    }
+                    accumulators = &stats->dense[accIdx];
+                }
+                else
+                {
+                    KEAZonalAccumulators &clumpStats = stats->sparse[clump];
+                    clumpStats.resize(numBands);
+                    accumulators = clumpStats.data();
+                }
+                for(size_t b = 0; b < numBands; ++b)
+                {
+                    const KEABlockBuffer &valueBuffer = block.inputs[b + 1];
+                    double value = block.getInput<double>(b + 1)[i];
+                    if(std::isnan(value) || (valueBuffer.hasNoData && (value == valueBuffer.noData)))
+                    {
+                        continue;
+                    }
+                    accumulators[b].add(value);
+                }
+            }
+        });
+
+        // MERGE THE THREADS INTO THE LARGEST SET OF DENSE ACCUMULATORS
+        KEAZonalAccumulators dense;
+        std::map<uint64_t, KEAZonalAccumulators> sparse;
+        for(auto &threadStat : threadStats)
+        {
+            if(threadStat.second->dense.size() > dense.size())
+            {
+                dense.swap(threadStat.second->dense);
+            }
+        }
+        for(auto &threadStat : threadStats)
+        {
+            const KEAZonalThreadStats &stats = *threadStat.second;
+            for(size_t i = 0; i < stats.dense.size(); ++i)
+            {
+                dense[i].merge(stats.dense[i]);
+            }
+            for(const auto &clumpStats : stats.sparse)
+            {
+                KEAZonalAccumulators &merged = sparse[clumpStats.first];
+                merged.resize(numBands);
+                for(size_t b = 0; b < numBands; ++b)
+                {
+                    merged[b].merge(clumpStats.second[b]);
+                }
+            }
+        }
+        threadStats.clear();
+        uint64_t numClumps = sparse.empty() ? (dense.size() / numBands) : (sparse.rbegin()->first + 1);
+
+        std::unique_ptr<KEAAttributeTable, void(*)(KEAAttributeTable*)> att(io->getAttributeTable(kea_att_file, clumpBand), KEAAttributeTable::destroyAttributeTable);
+        if(att->getSize() < numClumps)
+        {
+            att->addRows(numClumps - att->getSize());
+        }
+
+        static const char *statNames[] = { "Mean", "StdDev", "Min", "Max", "Count" };
+        static const size_t numStats = sizeof(statNames) / sizeof(statNames[0]);
+        std::vector<size_t> colIdxs;
+        for(const KEAZonalStatsBand &valueBand : valueBands)
+        {
+            for(size_t s = 0; s < numStats; ++s)
+            {
+                std::string name = valueBand.prefix + statNames[s];
+                if(!att->hasField(name))
+                {
+                    att->addAttFloatField(name, 0);
+                }
+                else if(att->getDataFieldType(name) != kea_att_float)
+                {
+                    throw KEAATTException("Column '" + name + "' exists but is not a float column.");
+                }
+                colIdxs.push_back(att->getFieldIndex(name));
+            }
+        }
+
+        // ROWS WITHOUT ANY PIXELS GET THE STATISTICS OF AN EMPTY CLUMP
+        const KEAZonalAccumulators empty(numBands);
+        std::vector<const KEAZonalAccumulator*> rowStats;
+        std::vector<double> values;
+        auto iterSparse = sparse.begin();
+        for(uint64_t startRow = 0; startRow < numClumps; startRow += KEA_ZONAL_WRITE_ROWS)
+        {
+            size_t numRows = std::min<uint64_t>(KEA_ZONAL_WRITE_ROWS, numClumps - startRow);
+            rowStats.assign(numRows, empty.data());
+            for(uint64_t r = startRow; (r < (startRow + numRows)) && (r < (dense.size() / numBands)); ++r)
+            {
+                rowStats[r - startRow] = &dense[r * numBands];
+            }
+            for(; (iterSparse != sparse.end()) && (iterSparse->first < (startRow + numRows)); ++iterSparse)
+            {
+                rowStats[iterSparse->first - startRow] = iterSparse->second.data();
+            }
+            values.resize(numRows);
+            for(size_t b = 0; b < numBands; ++b)
+            {
+                for(size_t s = 0; s < numStats; ++s)
+                {
+                    for(size_t r = 0; r < numRows; ++r)
+                    {
+                        const KEAZonalAccumulator &acc = rowStats[r][b];
+                        switch(s)
+                        {
+                            case 0: values[r] = acc.mean; break;
+                            case 1: values[r] = (acc.count > 0) ? std::sqrt(acc.m2 / acc.count) : 0; break;
+                            case 2: values[r] = acc.min; break;
+                            case 3: values[r] = acc.max; break;
+                            default: values[r] = static_cast<double>(acc.count); break;
+                        }
+                    }
+                    att->setFloatFields(startRow, numRows, colIdxs[(b * numStats) + s], values.data());
+                }
+            }
+        }
+        // A SHORT LAST BATCH IS BUFFERED, WRITE IT WHILE ERRORS CAN BE THROWN
+        att->flush();
+    }
+
+    // counts the pixels of each value in the band, skipping no data and
+    // negative values
+    static void keaCountValues(KEAImageIO *io, uint32_t band, uint32_t numThreads, std::vector<int64_t> &dense, std::map<uint64_t, int64_t> &sparse)
+    {
+        KEABlockProcessor processor(numThreads);
+        processor.addInput(io, band, kea_64int);
+
+        std::mutex threadsMutex;
+        std::map< std::thread::id, std::unique_ptr<KEAHistogramCounts> > threadCounts;
+        processor.run([&](KEABlock &block)
+        {
+            KEAHistogramCounts *counts = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(threadsMutex);
+                std::unique_ptr<KEAHistogramCounts> &threadCount = threadCounts[std::this_thread::get_id()];
+                if(!threadCount)
+                {
+                    threadCount.reset(new KEAHistogramCounts());
+                }
+                counts = threadCount.get();
+            }
+
+            const int64_t *values = block.getInput<int64_t>(0);
+            int64_t noData = 0;
+            bool hasNoData = block.inputs[0].getIDNoData(&noData);
+            for(uint64_t i = 0; i < block.getNumPixels(); ++i)
+            {
+                if((values[i] < 0) || (hasNoData && (values[i] == noData)))
+                {
+                    continue;
+                }
+                uint64_t value = static_cast<uint64_t>(values[i]);
+                if(value < KEA_HISTOGRAM_DENSE_VALUES)
+                {
+                    if(value >= counts->dense.size())
+                    {
+                        counts->dense.resize(value + 1);
+                    }
+                    counts->dense[value]++;
+                }
+                else
+                {
+                    counts->sparse[value]++;
+                }
+            }
+        });
+
+        // MERGE THE THREADS
+        for(auto &threadCount : threadCounts)
+        {
+            const KEAHistogramCounts &counts = *threadCount.second;
+            if(counts.dense.size() > dense.size())
+            {
+                dense.resize(counts.dense.size());
+            }
+            for(size_t i = 0; i < counts.dense.size(); ++i)
+            {
+                dense[i] += counts.dense[i];
+            }
+            for(const auto &count : counts.sparse)
+            {
+                sparse[count.first] += count.second;
+            }
+        }
+        threadCounts.clear();
+    }
+
+    void calcHistogramColumn(KEAImageIO *io, uint32_t band, const std::string &columnName, uint32_t numThreads)
+    {
+        KEATraceScope trace("calcHistogramColumn", KEA_TRACE_API);
+
+        std::vector<int64_t> dense;
+        std::map<uint64_t, int64_t> sparse;
+        keaCountValues(io, band, numThreads, dense, sparse);
+        uint64_t numRows = sparse.empty() ? dense.size() : (sparse.rbegin()->first + 1);
+
+        std::unique_ptr<KEAAttributeTable, void(*)(KEAAttributeTable*)> att(io->getAttributeTable(kea_att_file, band), KEAAttributeTable::destroyAttributeTable);
+        if(att->getSize() < numRows)
+        {
+            att->addRows(numRows - att->getSize());
+        }
+        bool floatColumn = false;
+        if(!att->hasField(columnName))
+        {
+            att->addAttIntField(columnName, 0, "PixelCount");
+        }
+        else if(att->getDataFieldType(columnName) == kea_att_float)
+        {
+            floatColumn = true;
+        }
+        else if(att->getDataFieldType(columnName) != kea_att_int)
+        {
+            throw KEAATTException("Column '" + columnName + "' exists but is not an int or float column.");
+        }
+        size_t colIdx = att->getFieldIndex(columnName);
+
+        // WRITE A CHUNK OF THE TABLE AT A TIME, ROWS PAST THE END OF THE
+        // HISTOGRAM ARE ZEROED
+        size_t numTableRows = att->getSize();
+        size_t batchRows = io->getAttributeTableChunkSize(band);
+        if(batchRows == 0)
+        {
+            batchRows = KEA_ATT_CHUNK_SIZE;
+        }
+        std::vector<int64_t> intCounts;
+        std::vector<double> floatCounts;
+        auto iterSparse = sparse.begin();
+        for(size_t startRow = 0; startRow < numTableRows; startRow += batchRows)
+        {
+            size_t batchLen = std::min(batchRows, numTableRows - startRow);
+            intCounts.assign(batchLen, 0);
+            for(size_t r = startRow; (r < (startRow + batchLen)) && (r < dense.size()); ++r)
+            {
+                intCounts[r - startRow] = dense[r];
+            }
+            for(; (iterSparse != sparse.end()) && (iterSparse->first < (startRow + batchLen)); ++iterSparse)
+            {
+                intCounts[iterSparse->first - startRow] = iterSparse->second;
+            }
+            if(floatColumn)
+            {
+                floatCounts.assign(intCounts.begin(), intCounts.end());
+                att->setFloatFields(startRow, batchLen, colIdx, floatCounts.data());
+            }
+            else
+            {
+                att->setIntFields(startRow, batchLen, colIdx, intCounts.data());
+            }
+        }
+        att->flush();
+    }
+
+    // writes the finished clumps, one setNeighbours call per run of
+    // consecutive ids
+    static void keaWriteNeighbours(KEAAttributeTable *att, std::map< size_t, std::vector<size_t> > &finished)
+    {
+        std::vector< std::vector<size_t>* > run;
+        size_t runStart = 0;
+        for(auto iterClump = finished.begin(); iterClump != finished.end(); ++iterClump)
+        {
+            if(!run.empty() && (iterClump->first != (runStart + run.size())))
+            {
+                att->setNeighbours(runStart, run.size(), &run);
+                run.clear();
+            }
+            if(run.empty())
+            {
+                runStart = iterClump->first;
+            }
+            run.push_back(&iterClump->second);
+        }
+        if(!run.empty())
+        {
+            att->setNeighbours(runStart, run.size(), &run);
+        }
+        finished.clear();
+    }
+
+    void calcNeighbours(KEAImageIO *io, uint32_t band, bool eightConnected, uint64_t blockSize, uint32_t numThreads)
+    {
+        KEATraceScope trace("calcNeighbours", KEA_TRACE_API);
+
+        // PIXELS LEFT TO SEE OF EACH CLUMP
+        std::vector<int64_t> denseRemaining;
+        std::map<uint64_t, int64_t> sparseRemaining;
+        keaCountValues(io, band, numThreads, denseRemaining, sparseRemaining);
+        uint64_t numRows = sparseRemaining.empty() ? denseRemaining.size() : (sparseRemaining.rbegin()->first + 1);
+
+        std::unique_ptr<KEAAttributeTable, void(*)(KEAAttributeTable*)> att(io->getAttributeTable(kea_att_file, band), KEAAttributeTable::destroyAttributeTable);
+        if(att->getSize() < numRows)
+        {
+            att->addRows(numRows - att->getSize());
+        }
+
+        uint64_t xSize = io->getSpatialInfo()->xSize;
+        uint64_t ySize = io->getSpatialInfo()->ySize;
+        KEABlockProcessor processor(numThreads);
+        processor.addInput(io, band, kea_64int);
+        processor.setMargin(1);
+        if(blockSize != 0)
+        {
+            processor.setBlockSize(blockSize);
+        }
+
+        std::mutex tilesMutex;
+        std::map< uint64_t, std::unique_ptr<KEATileClumps> > tiles;
+        std::unordered_map< uint64_t, std::vector<size_t> > open;
+        std::map< size_t, std::vector<size_t> > finished;
+        processor.run([&](KEABlock &block)
+        {
+            std::unique_ptr<KEATileClumps> clumps(new KEATileClumps());
+            // NEGATIVE CLUMPS ARE NO DATA
+            const int64_t *values = block.getInput<int64_t>(0);
+            int64_t noData = 0;
+            bool hasNoData = block.inputs[0].getIDNoData(&noData);
+            uint64_t rowLen = block.getInputXSize();
+            KEATileClump *clump = nullptr;
+            int64_t clumpValue = 0;
+            for(uint64_t y = 0; y < block.ySize; ++y)
+            {
+                for(uint64_t x = 0; x < block.xSize; ++x)
+                {
+                    int64_t value = values[((y + 1) * rowLen) + x + 1];
+                    if((value < 0) || (hasNoData && (value == noData)))
+                    {
+                        continue;
+                    }
+                    // RUNS OF THE SAME CLUMP ARE COMMON SO AVOID THE LOOKUP
+                    if((clump == nullptr) || (value != clumpValue))
+                    {
+                        clump = &(*clumps)[value];
+                        clumpValue = value;
+                    }
+                    clump->numPixels++;
+
+                    for(int yOff = -1; yOff <= 1; ++yOff)
+                    {
+                        for(int xOff = -1; xOff <= 1; ++xOff)
+                        {
+                            if(((xOff == 0) && (yOff == 0)) || (!eightConnected && (xOff != 0) && (yOff != 0)))
+                            {
+                                continue;
+                            }
+                            // THE MARGIN IS FILLED OFF THE IMAGE SO CHECK THE BOUNDS
+                            int64_t imgX = static_cast<int64_t>(block.xOff + x) + xOff;
+                            int64_t imgY = static_cast<int64_t>(block.yOff + y) + yOff;
+                            if((imgX < 0) || (imgY < 0) || (imgX >= static_cast<int64_t>(xSize)) || (imgY >= static_cast<int64_t>(ySize)))
+                            {
+                                continue;
+                            }
+                            int64_t other = values[((y + 1 + yOff) * rowLen) + x + 1 + xOff];
+                            if((other != value) && (other >= 0) && !(hasNoData && (other == noData)))
+                            {
+                                keaAddNeighbour(clump->neighbours, other);
+                            }
+                        }
+                    }
+                }
+            }
+            std::lock_guard<std::mutex> lock(tilesMutex);
+            tiles[block.blockIndex] = std::move(clumps);
+        },
+        [&](KEABlock &block)
+        {
+            // MERGE IN TILE ORDER, ONLY EVER ONE THREAD IN HERE
+            std::unique_ptr<KEATileClumps> clumps;
+            {
+                std::lock_guard<std::mutex> lock(tilesMutex);
+                auto iterTile = tiles.find(block.blockIndex);
+                clumps = std::move(iterTile->second);
+                tiles.erase(iterTile);
+            }
+            for(auto &tileClump : *clumps)
+            {
+                uint64_t value = tileClump.first;
+                std::vector<size_t> &neighbours = open[value];
+                for(size_t neighbour : tileClump.second.neighbours)
+                {
+                    keaAddNeighbour(neighbours, neighbour);
+                }
+                int64_t &remaining = (value < KEA_HISTOGRAM_DENSE_VALUES) ? denseRemaining[value] : sparseRemaining[value];
+                remaining -= tileClump.second.numPixels;
+                if(remaining <= 0)
+                {
+                    finished[value].swap(neighbours);
+                    open.erase(value);
+                }
+            }
+            if(finished.size() >= KEA_NEIGHBOURS_WRITE_CLUMPS)
+            {
+                keaWriteNeighbours(att.get(), finished);
+            }
+        });
+
+        // ANYTHING LEFT OPEN MEANS THE BAND CHANGED SINCE IT WAS COUNTED
+        for(auto &openClump : open)
+        {
+            finished[openClump.first].swap(openClump.second);
+        }
+        keaWriteNeighbours(att.get(), finished);
+    }
+
+}
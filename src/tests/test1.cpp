@@ -30,12 +30,19 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "libkea/KEAImageIO.h"
+#include "libkea/KEAAttributeTableFile.h"
+#include "libkea/KEATrace.h"
+#include "libkea/KEAZonalStats.h"
 
 #define IMG_XSIZE 20
 #define IMG_YSIZE 20
 #define TEST_FIELD "test"
 #define RAT_SIZE 256
+#define STRIP_YSIZE 8
+#define NUM_STRIPS 5
+#define BIG_RAT_SIZE 5000
 
 int main()
 {
@@ -71,7 +78,632 @@ int main()
         pRat->setIntFields(0, RAT_SIZE, colIdx, pRATData);
 
         free(pRATData);
+
+        // a fixed size image can't be grown
+        bool extendFailed = false;
+        try
+        {
+            io.extendImage(IMG_XSIZE, IMG_YSIZE * 2);
+        }
+        catch(const kealib::KEAException &e)
+        {
+            extendFailed = true;
+        }
+        io.close();
+        if(!extendFailed)
+        {
+            fprintf(stderr, "Extending a fixed size image did not fail\n");
+            return 1;
+        }
+
+        // scattered points match the same pixels read as a block
+        io.openKEAImageHeader(kealib::KEAImageIO::openKeaH5RDOnly("bob.kea"));
+        unsigned char blockData[IMG_XSIZE * IMG_YSIZE];
+        io.readImageBlock2Band(1, blockData, 0, 0, IMG_XSIZE, IMG_YSIZE,
+                    IMG_XSIZE, IMG_YSIZE, kealib::kea_8uint);
+        std::vector<uint32_t> sampleBands(1, 1);
+        uint64_t xPoints[] = {0, IMG_XSIZE - 1, 3, 17, 0};
+        uint64_t yPoints[] = {0, IMG_YSIZE - 1, 12, 5, IMG_YSIZE - 1};
+        unsigned char sampled[5];
+        io.samplePoints(sampleBands, xPoints, yPoints, 5, sampled, kealib::kea_8uint);
+        bool sampleMatch = true;
+        for( int i = 0; i < 5; i++ )
+        {
+            sampleMatch = sampleMatch && (sampled[i] == blockData[(yPoints[i] * IMG_XSIZE) + xPoints[i]]);
+        }
+        bool sampleOutsideFailed = false;
+        uint64_t xOutside[] = {1, IMG_XSIZE};
+        uint64_t yOutside[] = {1, 0};
+        try
+        {
+            io.samplePoints(sampleBands, xOutside, yOutside, 2, sampled, kealib::kea_8uint);
+        }
+        catch(const kealib::KEAException &e)
+        {
+            sampleOutsideFailed = true;
+        }
+        io.close();
+        if( !sampleMatch || !sampleOutsideFailed )
+        {
+            fprintf(stderr, "samplePoints did not match the block read\n");
+            return 1;
+        }
+
+        // single rows go through the chunk cache and are written back
+        io.openKEAImageHeader(kealib::KEAImageIO::openKeaH5RW("bob.kea"));
+        kealib::KEAAttributeTableFile *pFileRat = dynamic_cast<kealib::KEAAttributeTableFile*>(io.getAttributeTable(kealib::kea_att_file, 1));
+        int64_t ratValues[RAT_SIZE];
+        pFileRat->getIntFields(0, RAT_SIZE, colIdx, ratValues);
+        bool cacheMatch = true;
+        for( int i = 0; i < RAT_SIZE; i += 7 )
+        {
+            cacheMatch = cacheMatch && (pFileRat->getIntField(i, colIdx) == ratValues[i]);
+        }
+        pFileRat->setIntField(10, colIdx, 1000);
+        pFileRat->getIntFields(0, RAT_SIZE, colIdx, ratValues);
+        kealib::KEAATTChunkCacheStats cacheStats = pFileRat->getChunkCacheStats();
+        kealib::KEAAttributeTable::destroyAttributeTable(pFileRat);
+        pRat = io.getAttributeTable(kealib::kea_att_file, 1);
+        int64_t writtenBack = pRat->getIntField(10, colIdx);
+        kealib::KEAAttributeTable::destroyAttributeTable(pRat);
+        if( !cacheMatch || (ratValues[10] != 1000) || (writtenBack != 1000) ||
+            (cacheStats.misses != 1) || (cacheStats.hits == 0) || (cacheStats.numChunks != 1) )
+        {
+            fprintf(stderr, "Chunk cache returned the wrong values\n");
+            return 1;
+        }
+
+        // without the cache single row writes are buffered until flushed
+        pFileRat = dynamic_cast<kealib::KEAAttributeTableFile*>(io.getAttributeTable(kealib::kea_att_file, 1));
+        pFileRat->setChunkCacheSize(0);
+        pRat = pFileRat;
+        pRat->addAttStringField("label", "");
+        size_t labelIdx = pRat->getFieldIndex("label");
+        for( int i = 20; i < 23; i++ )
+        {
+            pFileRat->setIntField(i, colIdx, 2000 + i);
+        }
+        pFileRat->setIntField(40, colIdx, 2040);
+        // overwriting a buffered string replaces its size
+        pFileRat->setStringField(30, labelIdx, "abcd");
+        size_t labelBytes = pFileRat->getChunkCacheStats().bufferBytes;
+        pFileRat->setStringField(30, labelIdx, "efgh");
+        bool labelCounted = (pFileRat->getChunkCacheStats().bufferBytes == labelBytes);
+        int64_t bufferedValue = pFileRat->getIntField(21, colIdx);
+        pFileRat->getIntFields(0, RAT_SIZE, colIdx, ratValues);
+        kealib::KEAATTChunkCacheStats bufferStats = pFileRat->getChunkCacheStats();
+        pFileRat->flush();
+        kealib::KEAATTChunkCacheStats flushedStats = pFileRat->getChunkCacheStats();
+        kealib::KEAAttributeTable::destroyAttributeTable(pFileRat);
+        pRat = io.getAttributeTable(kealib::kea_att_file, 1);
+        int64_t flushedValues[RAT_SIZE];
+        pRat->getIntFields(0, RAT_SIZE, colIdx, flushedValues);
+        kealib::KEAAttributeTable::destroyAttributeTable(pRat);
+        io.close();
+        if( (bufferedValue != 2021) || (ratValues[22] != 2022) || (ratValues[40] != 2040) ||
+            (bufferStats.bufferedWrites != 6) || (bufferStats.bufferBytes == 0) || !labelCounted ||
+            (flushedStats.bufferFlushes != 1) || (flushedStats.bufferBytes != 0) ||
+            (memcmp(ratValues, flushedValues, sizeof(ratValues)) != 0) )
+        {
+            fprintf(stderr, "Buffered writes returned the wrong values\n");
+            return 1;
+        }
+
+        // the chunk size of a table is changed by exporting it again
+        h5file = kealib::KEAImageIO::createKEAImage("bob_att.kea",
+                        kealib::kea_8uint, IMG_XSIZE, IMG_YSIZE, 1);
+        io.openKEAImageHeader(h5file);
+        pRat = io.getAttributeTable(kealib::kea_att_file, 1);
+        pRat->addAttIntField(TEST_FIELD, 0);
+        pRat->addAttStringField("name", "");
+        pRat->addRows(RAT_SIZE);
+        pRat->setIntField(RAT_SIZE - 1, colIdx, 256);
+        pRat->setStringField(RAT_SIZE - 1, pRat->getFieldIndex("name"), "last");
+        size_t smallChunkSize = io.getAttributeTableChunkSize(1);
+        pRat->addRows(BIG_RAT_SIZE - RAT_SIZE);
+        pRat->setIntField(BIG_RAT_SIZE - 1, colIdx, 5000);
+        pRat->flush();
+        size_t addedChunkSize = io.getAttributeTableChunkSize(1);
+        // another table on the band keeps working after the data is rewritten
+        kealib::KEAAttributeTable *pOtherRat = io.getAttributeTable(kealib::kea_att_file, 1);
+        pOtherRat->getIntField(0, colIdx);
+        pRat->exportToKeaFile(h5file, 1);
+        size_t grownChunkSize = io.getAttributeTableChunkSize(1);
+        pOtherRat->setIntField(1, colIdx, 7);
+        pOtherRat->flush();
+        kealib::KEAAttributeTable::destroyAttributeTable(pOtherRat);
+        kealib::KEAAttributeTable::destroyAttributeTable(pRat);
+        pRat = io.getAttributeTable(kealib::kea_att_file, 1);
+        bool otherMatch = (pRat->getIntField(1, colIdx) == 7) && (pRat->getIntField(BIG_RAT_SIZE - 1, colIdx) == 5000);
+        // exporting without compression drops the deflate filter, the shuffle stays
+        pRat->exportToKeaFile(h5file, 1, kealib::KEA_ATT_CHUNK_SIZE, 0);
+        size_t exportedChunkSize = io.getAttributeTableChunkSize(1);
+        H5::DataSet intAttDataset = h5file->openDataSet(kealib::KEA_DATASETNAME_BAND + "1" + kealib::KEA_ATT_INT_DATA);
+        int exportedFilters = intAttDataset.getCreatePlist().getNfilters();
+        intAttDataset.close();
+        bool grownMatch = (pRat->getIntField(RAT_SIZE - 1, colIdx) == 256) &&
+                        (pRat->getStringField(RAT_SIZE - 1, pRat->getFieldIndex("name")) == "last") &&
+                        (pRat->getIntField(BIG_RAT_SIZE - 1, colIdx) == 5000);
+        kealib::KEAAttributeTable::destroyAttributeTable(pRat);
+        io.close();
+        if( (smallChunkSize != kealib::KEA_ATT_CHUNK_SIZE) || (addedChunkSize != kealib::KEA_ATT_CHUNK_SIZE) || !otherMatch ||
+            (grownChunkSize != kealib::KEAAttributeTable::getAutoChunkSize(BIG_RAT_SIZE)) ||
+            (grownChunkSize <= kealib::KEA_ATT_CHUNK_SIZE) ||
+            (exportedChunkSize != kealib::KEA_ATT_CHUNK_SIZE) || (exportedFilters != 1) || !grownMatch )
+        {
+            fprintf(stderr, "Attribute table chunk size was not adapted\n");
+            return 1;
+        }
+
+        // grow an image a strip at a time as it would be when streaming
+        h5file = kealib::KEAImageIO::createKEAImage("bob_extend.kea",
+                        kealib::kea_8uint, IMG_XSIZE, STRIP_YSIZE, 1, NULL, NULL,
+                        16, kealib::KEA_ATT_CHUNK_SIZE, kealib::KEA_MDC_NELMTS,
+                        kealib::KEA_RDCC_NELMTS, kealib::KEA_RDCC_NBYTES, kealib::KEA_RDCC_W0,
+                        kealib::KEA_SIEVE_BUF, kealib::KEA_META_BLOCKSIZE, kealib::KEA_DEFLATE,
+                        kealib::kea_extend_y);
+        io.openKEAImageHeader(h5file);
+        io.createMask(1);
+        unsigned char strip[IMG_XSIZE * STRIP_YSIZE];
+        for( int n = 0; n < NUM_STRIPS; n++ )
+        {
+            if( n > 0 )
+            {
+                io.extendImage(IMG_XSIZE, (n + 1) * STRIP_YSIZE);
+            }
+            for( int i = 0; i < (IMG_XSIZE * STRIP_YSIZE); i++ )
+            {
+                strip[i] = n + 1;
+            }
+            io.writeImageBlock2Band(1, strip, 0, n * STRIP_YSIZE, IMG_XSIZE, STRIP_YSIZE,
+                        IMG_XSIZE, STRIP_YSIZE, kealib::kea_8uint);
+        }
+        io.close();
+
+        h5file = kealib::KEAImageIO::openKeaH5RDOnly("bob_extend.kea");
+        io.openKEAImageHeader(h5file);
+        kealib::KEAImageSpatialInfo *pInfo = io.getSpatialInfo();
+        if( (io.getImageExtend() != kealib::kea_extend_y) || (pInfo->xSize != IMG_XSIZE) ||
+            (pInfo->ySize != (STRIP_YSIZE * NUM_STRIPS)) || (io.getImageBlockSize(1) != 16) )
+        {
+            fprintf(stderr, "Extended image has the wrong size\n");
+            return 1;
+        }
+        unsigned char mask[IMG_XSIZE];
+        for( int n = 0; n < NUM_STRIPS; n++ )
+        {
+            io.readImageBlock2Band(1, strip, 0, n * STRIP_YSIZE, IMG_XSIZE, STRIP_YSIZE,
+                        IMG_XSIZE, STRIP_YSIZE, kealib::kea_8uint);
+            io.readImageBlock2BandMask(1, mask, 0, n * STRIP_YSIZE, IMG_XSIZE, 1,
+                        IMG_XSIZE, 1, kealib::kea_8uint);
+            if( (strip[0] != n + 1) || (strip[IMG_XSIZE * STRIP_YSIZE - 1] != n + 1) || (mask[0] != 255) )
+            {
+                fprintf(stderr, "Extended image has the wrong values\n");
+                return 1;
+            }
+        }
+        io.close();
+
+        // copy the band verbatim and re-encoded, then clone the whole file
+        kealib::KEAImageIO srcIO;
+        srcIO.openKEAImageHeader(kealib::KEAImageIO::openKeaH5RDOnly("bob.kea"));
+        h5file = kealib::KEAImageIO::createKEAImage("bob_copy.kea",
+                        kealib::kea_8uint, IMG_XSIZE, IMG_YSIZE, 0);
+        io.openKEAImageHeader(h5file);
+        io.copyBandFrom(&srcIO, 1);
+        io.copyBandFrom(&srcIO, 1, 8, 1);
+        kealib::KEAImageIO cloneIO;
+        cloneIO.openKEAImageHeader(kealib::KEAImageIO::cloneKEAImage(&srcIO, "bob_clone.kea"));
+
+        unsigned char srcData[IMG_XSIZE * IMG_YSIZE];
+        unsigned char copyData[IMG_XSIZE * IMG_YSIZE];
+        srcIO.readImageBlock2Band(1, srcData, 0, 0, IMG_XSIZE, IMG_YSIZE,
+                    IMG_XSIZE, IMG_YSIZE, kealib::kea_8uint);
+        for( int n = 0; n < 3; n++ )
+        {
+            kealib::KEAImageIO &checkIO = (n < 2) ? io : cloneIO;
+            uint32_t band = (n < 2) ? n + 1 : 1;
+            checkIO.readImageBlock2Band(band, copyData, 0, 0, IMG_XSIZE, IMG_YSIZE,
+                        IMG_XSIZE, IMG_YSIZE, kealib::kea_8uint);
+            pRat = checkIO.getAttributeTable(kealib::kea_att_file, band);
+            size_t ratSize = pRat->getSize();
+            kealib::KEAAttributeTable::destroyAttributeTable(pRat);
+            if( (memcmp(srcData, copyData, sizeof(srcData)) != 0) || (ratSize != RAT_SIZE) ||
+                (checkIO.getImageBandLayerType(band) != kealib::kea_thematic) )
+            {
+                fprintf(stderr, "Copy %d does not match the source band\n", n);
+                return 1;
+            }
+        }
+        if( (io.getImageBlockSize(1) != srcIO.getImageBlockSize(1)) || (io.getImageBlockSize(2) != 8) )
+        {
+            fprintf(stderr, "Copied bands have the wrong block size\n");
+            return 1;
+        }
+        cloneIO.close();
+        io.close();
+        srcIO.close();
+
+        // cut a block aligned window out of the strip image
+        srcIO.openKEAImageHeader(kealib::KEAImageIO::openKeaH5RDOnly("bob_extend.kea"));
+        io.openKEAImageHeader(kealib::KEAImageIO::createKEAImageSubset(&srcIO, "bob_subset.kea",
+                        0, 2 * STRIP_YSIZE, IMG_XSIZE, 3 * STRIP_YSIZE));
+        pInfo = io.getSpatialInfo();
+        if( (pInfo->xSize != IMG_XSIZE) || (pInfo->ySize != 3 * STRIP_YSIZE) ||
+            (pInfo->tlY != -2.0 * STRIP_YSIZE) || !io.maskCreated(1) )
+        {
+            fprintf(stderr, "Subset has the wrong size or position\n");
+            return 1;
+        }
+        for( int n = 0; n < 3; n++ )
+        {
+            io.readImageBlock2Band(1, strip, 0, n * STRIP_YSIZE, IMG_XSIZE, STRIP_YSIZE,
+                        IMG_XSIZE, STRIP_YSIZE, kealib::kea_8uint);
+            io.readImageBlock2BandMask(1, mask, 0, n * STRIP_YSIZE, IMG_XSIZE, 1,
+                        IMG_XSIZE, 1, kealib::kea_8uint);
+            if( (strip[0] != n + 3) || (strip[IMG_XSIZE * STRIP_YSIZE - 1] != n + 3) || (mask[IMG_XSIZE - 1] != 255) )
+            {
+                fprintf(stderr, "Subset has the wrong values\n");
+                return 1;
+            }
+        }
+        io.close();
+        srcIO.close();
+
+        // removing a band leaves dead space which repacking gets back
+        h5file = kealib::KEAImageIO::openKeaH5RW("bob_copy.kea");
+        io.openKEAImageHeader(h5file);
+        io.removeImageBand(1);
+        io.close();
+        int64_t reclaimed = kealib::KEAImageIO::repackKEAImage("bob_copy.kea", "",
+                        kealib::KEA_REPACK_KEEP, kealib::KEA_REPACK_KEEP, 100);
+        io.openKEAImageHeader(kealib::KEAImageIO::openKeaH5RDOnly("bob_copy.kea"));
+        io.readImageBlock2Band(1, copyData, 0, 0, IMG_XSIZE, IMG_YSIZE,
+                    IMG_XSIZE, IMG_YSIZE, kealib::kea_8uint);
+        pRat = io.getAttributeTable(kealib::kea_att_file, 1);
+        size_t ratSize = pRat->getSize();
+        kealib::KEAAttributeTable::destroyAttributeTable(pRat);
+        if( (reclaimed <= 0) || (io.getNumOfImageBands() != 1) || (io.getImageBlockSize(1) != 8) ||
+            (io.getAttributeTableChunkSize(1) != 100) || (ratSize != RAT_SIZE) ||
+            (memcmp(srcData, copyData, sizeof(srcData)) != 0) )
+        {
+            fprintf(stderr, "Repacked file does not match (%lld bytes reclaimed)\n", (long long)reclaimed);
+            return 1;
+        }
+        io.close();
+
+        // a table flagged as auto sized is resized when its chunking is kept
+        h5file = kealib::KEAImageIO::openKeaH5RW("bob_copy.kea");
+        kealib::KEAAttributeTable::setAutoChunkSizeFlag(h5file, kealib::KEA_DATASETNAME_BAND + std::string("1"), true);
+        h5file->close();
+        delete h5file;
+        kealib::KEAImageIO::repackKEAImage("bob_copy.kea");
+        h5file = kealib::KEAImageIO::openKeaH5RDOnly("bob_copy.kea");
+        io.openKEAImageHeader(h5file);
+        if( (io.getAttributeTableChunkSize(1) != kealib::KEAAttributeTable::getAutoChunkSize(RAT_SIZE)) ||
+            !kealib::KEAAttributeTable::getAutoChunkSizeFlag(h5file, kealib::KEA_DATASETNAME_BAND + std::string("1")) )
+        {
+            fprintf(stderr, "Repack did not resize the auto sized table\n");
+            return 1;
+        }
+        io.close();
+
+        // paged aggregation, read back through a page buffer
+        h5file = kealib::KEAImageIO::createKEAImage("bob_paged.kea",
+                        kealib::kea_8uint, IMG_XSIZE, IMG_YSIZE, 1, NULL, NULL,
+                        kealib::KEA_IMAGE_CHUNK_SIZE, kealib::KEA_ATT_CHUNK_SIZE, kealib::KEA_MDC_NELMTS,
+                        kealib::KEA_RDCC_NELMTS, kealib::KEA_RDCC_NBYTES, kealib::KEA_RDCC_W0,
+                        kealib::KEA_SIEVE_BUF, kealib::KEA_META_BLOCKSIZE, kealib::KEA_DEFLATE,
+                        kealib::kea_extend_none, 4096);
+        io.openKEAImageHeader(h5file);
+        io.writeImageBlock2Band(1, srcData, 0, 0, IMG_XSIZE, IMG_YSIZE,
+                    IMG_XSIZE, IMG_YSIZE, kealib::kea_8uint);
+        io.close();
+        io.openKEAImageHeader(kealib::KEAImageIO::openKeaH5RDOnly("bob_paged.kea",
+                        kealib::KEA_MDC_NELMTS, kealib::KEA_RDCC_NELMTS, kealib::KEA_RDCC_NBYTES,
+                        kealib::KEA_RDCC_W0, kealib::KEA_SIEVE_BUF, kealib::KEA_META_BLOCKSIZE, 65536));
+        io.readImageBlock2Band(1, copyData, 0, 0, IMG_XSIZE, IMG_YSIZE,
+                    IMG_XSIZE, IMG_YSIZE, kealib::kea_8uint);
+        io.close();
+        if( memcmp(srcData, copyData, sizeof(srcData)) != 0 )
+        {
+            fprintf(stderr, "Paged file does not match\n");
+            return 1;
+        }
+        kealib::KEAImageIO::repackKEAImage("bob_paged.kea", "bob_paged_repack.kea");
+        h5file = kealib::KEAImageIO::openKeaH5RDOnly("bob_paged_repack.kea");
+        H5F_fspace_strategy_t fsStrategy;
+        hbool_t fsPersist;
+        hsize_t fsThreshold, fsPageSize;
+        H5::FileCreatPropList pagedCreatePlist = h5file->getCreatePlist();
+        H5Pget_file_space_strategy(pagedCreatePlist.getId(), &fsStrategy, &fsPersist, &fsThreshold);
+        H5Pget_file_space_page_size(pagedCreatePlist.getId(), &fsPageSize);
+        pagedCreatePlist.close();
+        h5file->close();
+        delete h5file;
+        if( (fsStrategy != H5F_FSPACE_STRATEGY_PAGE) || (fsPageSize != 4096) )
+        {
+            fprintf(stderr, "Repacked file lost paged aggregation\n");
+            return 1;
+        }
+
+        // scaled read applies scale/offset and turns no data into NaN
+        io.openKEAImageHeader(kealib::KEAImageIO::openKeaH5RW("bob_paged.kea"));
+        io.setImageBandScale(1, 0.5);
+        io.setImageBandOffset(1, -10.0);
+        unsigned char noData = srcData[0];
+        io.setNoDataValue(1, &noData, kealib::kea_8uint);
+        io.close();
+        io.openKEAImageHeader(kealib::KEAImageIO::openKeaH5RDOnly("bob_paged.kea"));
+        float *scaledData = (float*)calloc(IMG_XSIZE * IMG_YSIZE, sizeof(float));
+        io.readImageBlock2BandScaled(1, scaledData, 0, 0, IMG_XSIZE, IMG_YSIZE,
+                    IMG_XSIZE, IMG_YSIZE, kealib::kea_32float);
+        bool scaledOk = (io.getImageBandScale(1) == 0.5) && (io.getImageBandOffset(1) == -10.0);
+        io.close();
+        for( int i = 0; i < (IMG_XSIZE * IMG_YSIZE); i++ )
+        {
+            if( srcData[i] == noData )
+                scaledOk = scaledOk && (scaledData[i] != scaledData[i]);
+            else
+                scaledOk = scaledOk && (scaledData[i] == (srcData[i] * 0.5f - 10.0f));
+        }
+        free(scaledData);
+        kealib::KEAImageHeaderSummary scaledSummary;
+        if( !scaledOk || !kealib::KEAImageIO::probeKEAImage("bob_paged.kea", scaledSummary) ||
+            (scaledSummary.bands[0].scale != 0.5) || (scaledSummary.bands[0].offset != -10.0) )
+        {
+            fprintf(stderr, "Scaled read does not match\n");
+            return 1;
+        }
+
+        // zonal statistics of band 2 over 5x5 clumps in band 1, with
+        // value 0 as no data so clump 0 is one pixel short
+        h5file = kealib::KEAImageIO::createKEAImage("bob_zonal.kea",
+                        kealib::kea_32uint, IMG_XSIZE, IMG_YSIZE, 2);
+        io.openKEAImageHeader(h5file);
+        uint32_t clumpData[IMG_XSIZE * IMG_YSIZE];
+        float valueData[IMG_XSIZE * IMG_YSIZE];
+        for( int i = 0; i < (IMG_XSIZE * IMG_YSIZE); i++ )
+        {
+            clumpData[i] = ((i / IMG_XSIZE / 5) * (IMG_XSIZE / 5)) + ((i % IMG_XSIZE) / 5);
+            valueData[i] = (float)i;
+        }
+        io.writeImageBlock2Band(1, clumpData, 0, 0, IMG_XSIZE, IMG_YSIZE,
+                    IMG_XSIZE, IMG_YSIZE, kealib::kea_32uint);
+        io.writeImageBlock2Band(2, valueData, 0, 0, IMG_XSIZE, IMG_YSIZE,
+                    IMG_XSIZE, IMG_YSIZE, kealib::kea_32float);
+        uint32_t valueNoData = 0;
+        io.setNoDataValue(2, &valueNoData, kealib::kea_32uint);
+        std::vector<kealib::KEAZonalStatsBand> zonalBands(1);
+        zonalBands[0].io = &io;
+        zonalBands[0].band = 2;
+        zonalBands[0].prefix = "b2";
+        kealib::calcZonalStats(&io, 1, zonalBands, 3);
+        // a clump id far past the rest goes through the sparse counts
+        clumpData[0] = 5000000;
+        io.writeImageBlock2Band(1, clumpData, 0, 0, 1, 1, 1, 1, kealib::kea_32uint);
+        kealib::calcHistogramColumn(&io, 1, "Histogram", 3);
+        // and through the sparse statistics, counting pixel 0 without no data
+        io.undefineNoDataValue(2);
+        zonalBands[0].prefix = "b2Sparse";
+        kealib::calcZonalStats(&io, 1, zonalBands, 3);
+        // 8 pixel tiles so clumps cross the tile seams
+        kealib::calcNeighbours(&io, 1, false, 8, 3);
+        kealib::KEAAttributeTable *zonalRat = io.getAttributeTable(kealib::kea_att_file, 1);
+        std::vector<std::vector<size_t>* > clumpNeighbours;
+        zonalRat->getNeighbours(4, 2, &clumpNeighbours);
+        size_t numNeighbours4 = clumpNeighbours[0]->size();
+        size_t numNeighbours5 = clumpNeighbours[1]->size();
+        zonalRat->getNeighbours(5000000, 1, &clumpNeighbours);
+        bool cornerNeighbour = (clumpNeighbours[0]->size() == 1) && (clumpNeighbours[0]->at(0) == 0);
+        kealib::KEAAttributeTable::destroyAttributeTable(zonalRat);
+        kealib::calcNeighbours(&io, 1, true, 8, 3);
+        zonalRat = io.getAttributeTable(kealib::kea_att_file, 1);
+        zonalRat->getNeighbours(5, 1, &clumpNeighbours);
+        size_t numNeighbours5Diag = clumpNeighbours[0]->size();
+        delete clumpNeighbours[0];
+        if( (numNeighbours4 != 3) || (numNeighbours5 != 4) || !cornerNeighbour || (numNeighbours5Diag != 8) )
+        {
+            fprintf(stderr, "Neighbours do not match\n");
+            return 1;
+        }
+        size_t numHistoRows = zonalRat->getSize();
+        double clumpMean[2], clumpMin[2], clumpCount[2];
+        int64_t clumpHisto[2], lastHisto;
+        zonalRat->getFloatFields(0, 2, zonalRat->getFieldIndex("b2Mean"), clumpMean);
+        zonalRat->getFloatFields(0, 2, zonalRat->getFieldIndex("b2Min"), clumpMin);
+        zonalRat->getFloatFields(0, 2, zonalRat->getFieldIndex("b2Count"), clumpCount);
+        zonalRat->getIntFields(0, 2, zonalRat->getFieldIndex("Histogram"), clumpHisto);
+        zonalRat->getIntFields(numHistoRows - 1, 1, zonalRat->getFieldIndex("Histogram"), &lastHisto);
+        double sparseCount[2];
+        zonalRat->getFloatFields(0, 1, zonalRat->getFieldIndex("b2SparseCount"), &sparseCount[0]);
+        zonalRat->getFloatFields(5000000, 1, zonalRat->getFieldIndex("b2SparseCount"), &sparseCount[1]);
+        kealib::KEAAttributeTable::destroyAttributeTable(zonalRat);
+        // paint the clump means and pixel counts back onto the image
+        io.addImageBand(kealib::kea_32float, "mean");
+        io.addImageBand(kealib::kea_32uint, "count");
+        io.remapBandThroughAttribute(1, "b2Mean", &io, 3, 3);
+        io.remapBandThroughAttribute(1, "Histogram", &io, 4, 3);
+        float remapMean;
+        uint32_t remapCount[2];
+        io.readImageBlock2Band(3, &remapMean, 5, 0, 1, 1, 1, 1, kealib::kea_32float);
+        io.readImageBlock2Band(4, remapCount, 0, 0, 2, 1, 2, 1, kealib::kea_32uint);
+        // colour clump 1, leaving the others black, and render across it
+        zonalRat = io.getAttributeTable(kealib::kea_att_file, 1);
+        const char *colourNames[] = { "Red", "Green", "Blue" };
+        for( int c = 0; c < 3; c++ )
+        {
+            zonalRat->addAttIntField(colourNames[c], 0, colourNames[c]);
+            zonalRat->setIntField(1, zonalRat->getFieldIndex(colourNames[c]), (c + 1) * 10);
+        }
+        kealib::KEAAttributeTable::destroyAttributeTable(zonalRat);
+        uint8_t rgba[8];
+        io.renderColourTable(1, 0, rgba, 4, 0, 2, 1, 2);
+        io.close();
+        if( (remapMean != (float)clumpMean[1]) || (remapCount[0] != 1) || (remapCount[1] != 24) )
+        {
+            fprintf(stderr, "Remapped band does not match\n");
+            return 1;
+        }
+        const uint8_t expectedRGBA[8] = { 0, 0, 0, 255, 10, 20, 30, 255 };
+        if( memcmp(rgba, expectedRGBA, sizeof(rgba)) != 0 )
+        {
+            fprintf(stderr, "Rendered colours do not match\n");
+            return 1;
+        }
+        if( (numHistoRows != 5000001) || (clumpHisto[0] != 24) || (clumpHisto[1] != 25) || (lastHisto != 1) )
+        {
+            fprintf(stderr, "Histogram column does not match\n");
+            return 1;
+        }
+        // clump 1 covers x 5-9 of rows 0-4, clump 0 x 0-4 without pixel 0
+        double clump1Mean = (5 + 9 + (4 * IMG_XSIZE) + 5 + (4 * IMG_XSIZE) + 9) / 4.0;
+        if( (clumpCount[0] != 24) ||
+            (clumpCount[1] != 25) || (clumpMin[0] != 1) || (clumpMin[1] != 5) ||
+            (clumpMean[1] != clump1Mean) || (sparseCount[0] != 24) || (sparseCount[1] != 1) )
+        {
+            fprintf(stderr, "Zonal statistics do not match\n");
+            return 1;
+        }
+
+        // negative clump ids, and a negative no data value, are no data
+        h5file = kealib::KEAImageIO::createKEAImage("bob_signed.kea",
+                        kealib::kea_32int, 4, 1, 2);
+        io.openKEAImageHeader(h5file);
+        int32_t signedClumps[4] = { 0, -1, 1, -2 };
+        io.writeImageBlock2Band(1, signedClumps, 0, 0, 4, 1, 4, 1, kealib::kea_32int);
+        int32_t signedNoData = -2;
+        io.setNoDataValue(1, &signedNoData, kealib::kea_32int);
+        kealib::KEAAttributeTable *signedRat = io.getAttributeTable(kealib::kea_att_file, 1);
+        signedRat->addAttIntField("id", 0);
+        signedRat->addRows(2);
+        signedRat->setIntField(0, signedRat->getFieldIndex("id"), 10);
+        signedRat->setIntField(1, signedRat->getFieldIndex("id"), 20);
+        signedRat->addAttIntField("Red", 0, "Red");
+        signedRat->addAttIntField("Green", 0, "Green");
+        signedRat->addAttIntField("Blue", 0, "Blue");
+        signedRat->setIntField(0, signedRat->getFieldIndex("Red"), 100);
+        signedRat->setIntField(1, signedRat->getFieldIndex("Blue"), 200);
+        kealib::KEAAttributeTable::destroyAttributeTable(signedRat);
+        uint8_t signedRGBA[16];
+        io.renderColourTable(1, 0, signedRGBA, 0, 0, 4, 1, 1);
+        io.remapBandThroughAttribute(1, "id", &io, 2, 1);
+        int32_t signedRemap[4];
+        io.readImageBlock2Band(2, signedRemap, 0, 0, 4, 1, 4, 1, kealib::kea_32int);
+        std::vector<kealib::KEAZonalStatsBand> signedBands(1);
+        signedBands[0].io = &io;
+        signedBands[0].band = 2;
+        signedBands[0].prefix = "s";
+        kealib::calcZonalStats(&io, 1, signedBands, 1);
+        kealib::calcHistogramColumn(&io, 1, "Histogram", 1);
+        // clumps 0 and 1 are only separated by the negative pixel
+        kealib::calcNeighbours(&io, 1, false, 0, 1);
+        signedRat = io.getAttributeTable(kealib::kea_att_file, 1);
+        std::vector<std::vector<size_t>* > signedNeighbours;
+        signedRat->getNeighbours(0, 1, &signedNeighbours);
+        size_t numSignedNeighbours = signedNeighbours[0]->size();
+        delete signedNeighbours[0];
+        double signedCount[2];
+        signedRat->getFloatFields(0, 2, signedRat->getFieldIndex("sCount"), signedCount);
+        int64_t signedHisto[2];
+        signedRat->getIntFields(0, 2, signedRat->getFieldIndex("Histogram"), signedHisto);
+        size_t signedRows = signedRat->getSize();
+        kealib::KEAAttributeTable::destroyAttributeTable(signedRat);
+        io.close();
+        const int32_t expectedRemap[4] = { 10, 0, 20, 0 };
+        const uint8_t expectedSignedRGBA[16] = { 100, 0, 0, 255, 0, 0, 0, 0, 0, 0, 200, 255, 0, 0, 0, 0 };
+        if( memcmp(signedRemap, expectedRemap, sizeof(signedRemap)) != 0 ||
+            memcmp(signedRGBA, expectedSignedRGBA, sizeof(signedRGBA)) != 0 ||
+            (signedRows != 2) || (signedCount[0] != 1) || (signedCount[1] != 1) ||
+            (signedHisto[0] != 1) || (signedHisto[1] != 1) || (numSignedNeighbours != 0) )
+        {
+            fprintf(stderr, "Negative clump ids were not treated as no data\n");
+            return 1;
+        }
+
+        // the header is read from the consolidated header when there is one
+        io.openKEAImageHeader(kealib::KEAImageIO::openKeaH5RDOnly("bob.kea"));
+        bool consolidated = io.consolidatedHeaderPresent();
+        kealib::KEALayerType layerType = io.getImageBandLayerType(1);
+        io.close();
+        if( !consolidated || (layerType != kealib::kea_thematic) )
+        {
+            fprintf(stderr, "Consolidated header not read\n");
+            return 1;
+        }
+        
+        // files from older versions only have the individual datasets
+        h5file = kealib::KEAImageIO::openKeaH5RW("bob.kea");
+        h5file->unlink(kealib::KEA_DATASETNAME_HEADER_CONSOLIDATED);
+        io.openKEAImageHeader(h5file);
+        consolidated = io.consolidatedHeaderPresent();
+        layerType = io.getImageBandLayerType(1);
+        io.rebuildConsolidatedHeader();
         io.close();
+        io.openKEAImageHeader(kealib::KEAImageIO::openKeaH5RDOnly("bob.kea"));
+        if( consolidated || (layerType != kealib::kea_thematic) || !io.consolidatedHeaderPresent() ||
+            (io.getImageBandLayerType(1) != kealib::kea_thematic) )
+        {
+            fprintf(stderr, "Consolidated header not rebuilt\n");
+            return 1;
+        }
+        io.close();
+
+        // a change which bumped the generation but did not get as far as
+        // rewriting the consolidated header
+        h5file = kealib::KEAImageIO::openKeaH5RW("bob.kea");
+        H5::Group headerGroup = h5file->openGroup(kealib::KEA_DATASETNAME_HEADER);
+        H5::Attribute generationAttribute = headerGroup.openAttribute(kealib::KEA_ATTRIBUTENAME_HEADER_GENERATION);
+        uint64_t generation = 0;
+        generationAttribute.read(H5::PredType::NATIVE_UINT64, &generation);
+        generation++;
+        generationAttribute.write(H5::PredType::NATIVE_UINT64, &generation);
+        generationAttribute.close();
+        headerGroup.close();
+        uint32_t olderLayerType = kealib::kea_continuous;
+        H5::DataSet layerTypeDataset = h5file->openDataSet(kealib::KEA_DATASETNAME_BAND + "1" + kealib::KEA_BANDNAME_TYPE);
+        layerTypeDataset.write(&olderLayerType, H5::PredType::NATIVE_UINT32);
+        layerTypeDataset.close();
+        io.openKEAImageHeader(h5file);
+        consolidated = io.consolidatedHeaderPresent();
+        layerType = io.getImageBandLayerType(1);
+        io.setImageBandLayerType(1, kealib::kea_thematic);
+        io.close();
+        if( consolidated || (layerType != kealib::kea_continuous) )
+        {
+            fprintf(stderr, "Out of date consolidated header was read\n");
+            return 1;
+        }
+
+        kealib::KEAImageHeaderSummary summary;
+        if( !kealib::KEAImageIO::probeKEAImage("bob.kea", summary) || (summary.bands.size() != 1) ||
+            (summary.spatialInfo.xSize != IMG_XSIZE) || (summary.bands[0].layerType != kealib::kea_thematic) ||
+            kealib::KEAImageIO::probeKEAImage("bob_missing.kea", summary) )
+        {
+            fprintf(stderr, "Probing the header failed\n");
+            return 1;
+        }
+
+        int numReadEvents = 0;
+        uint64_t readBytes = 0;
+        kealib::KEATrace::setCallback([&numReadEvents, &readBytes](const kealib::KEATraceEvent &event)
+        {
+            if( strcmp(event.name, "KEAImageIO::readImageBlock2Band") == 0 )
+            {
+                numReadEvents++;
+                readBytes += event.bytes;
+            }
+        });
+        unsigned char traceData[IMG_XSIZE * IMG_YSIZE];
+        io.openKEAImageHeader(kealib::KEAImageIO::openKeaH5RDOnly("bob.kea"));
+        io.readImageBlock2Band(1, traceData, 0, 0, IMG_XSIZE, IMG_YSIZE, IMG_XSIZE, IMG_YSIZE, kealib::kea_8uint);
+        io.close();
+        kealib::KEATrace::setCallback(nullptr);
+        if( (numReadEvents != 1) || (readBytes != (IMG_XSIZE * IMG_YSIZE)) )
+        {
+            fprintf(stderr, "Tracing callback not called as expected\n");
+            return 1;
+        }
     }
     catch(const kealib::KEAException &e)
     {
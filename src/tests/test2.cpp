@@ -0,0 +1,562 @@
+/*
+ *  test2.cpp
+ *  LibKEA
+ *
+ *  Copyright 2026 LibKEA. All rights reserved.
+ *
+ *  This file is part of LibKEA.
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without restriction,
+ *  including without limitation the rights to use, copy, modify,
+ *  merge, publish, distribute, sublicense, and/or sell copies of the
+ *  Software, and to permit persons to whom the Software is furnished
+ *  to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ *  ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *  CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+// Stress test for thread safe mode. Many threads read windows of the
+// bands, mask and overview in different data types while another thread
+// writes, and the results are compared with single threaded reads. The
+// asynchronous reads are checked the same way, then several threads write
+// scanlines through the asynchronous writer. Finally a band is computed
+// from two others with the block processor.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <future>
+#include <random>
+#include <thread>
+#include <vector>
+#include "libkea/KEAImageIO.h"
+#include "libkea/KEABlockProcessor.h"
+
+#define IMG_XSIZE 700
+#define IMG_YSIZE 500
+#define IMG_BLOCK 128
+#define OVV_XSIZE 350
+#define OVV_YSIZE 250
+#define NUM_READERS 8
+#define NUM_READS 200
+#define NUM_WRITERS 4
+
+static const kealib::KEADataType testTypes[] = { kealib::kea_32float, kealib::kea_64float,
+                kealib::kea_8uint, kealib::kea_16int, kealib::kea_32uint };
+static const size_t numTestTypes = sizeof(testTypes) / sizeof(testTypes[0]);
+
+#ifdef KEA_HAVE_COROUTINES
+// a coroutine which runs until its first suspension, no result
+struct KEATestTask
+{
+    struct promise_type
+    {
+        KEATestTask get_return_object() { return KEATestTask(); }
+        std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+        std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// reads a block with co_await, done is set to whether the read succeeded
+static KEATestTask awaitRead(kealib::KEAImageIO &io, uint32_t band, float *data, uint64_t xOff, uint64_t yOff, std::promise<bool> *done)
+{
+    try
+    {
+        co_await io.readImageBlock2BandAwaitable(band, data, xOff, yOff, 64, 64, 64, 64, kealib::kea_32float);
+        done->set_value(true);
+    }
+    catch(const kealib::KEAException &e)
+    {
+        done->set_value(false);
+    }
+}
+#endif
+
+// the datasets read by the test
+enum TestDataset
+{
+    test_band1,
+    test_band2,
+    test_mask,
+    test_overview,
+    test_num_datasets
+};
+
+static void readDataset(kealib::KEAImageIO &io, int dataset, void *data, uint64_t xOff, uint64_t yOff,
+                uint64_t xSize, uint64_t ySize, uint64_t xSizeBuf, uint64_t ySizeBuf, kealib::KEADataType dataType)
+{
+    switch(dataset)
+    {
+        case test_band1:
+            io.readImageBlock2Band(1, data, xOff, yOff, xSize, ySize, xSizeBuf, ySizeBuf, dataType); break;
+        case test_band2:
+            io.readImageBlock2Band(2, data, xOff, yOff, xSize, ySize, xSizeBuf, ySizeBuf, dataType); break;
+        case test_mask:
+            io.readImageBlock2BandMask(1, data, xOff, yOff, xSize, ySize, xSizeBuf, ySizeBuf, dataType); break;
+        default:
+            io.readFromOverview(1, 1, data, xOff, yOff, xSize, ySize, xSizeBuf, ySizeBuf, dataType); break;
+    }
+}
+
+static void datasetSize(int dataset, uint64_t *xSize, uint64_t *ySize)
+{
+    *xSize = (dataset == test_overview) ? OVV_XSIZE : IMG_XSIZE;
+    *ySize = (dataset == test_overview) ? OVV_YSIZE : IMG_YSIZE;
+}
+
+int main()
+{
+    try
+    {
+        kealib::KEAImageIO io;
+        H5::H5File *h5file = kealib::KEAImageIO::createKEAImage("test2.kea",
+                        kealib::kea_32float, IMG_XSIZE, IMG_YSIZE, 1, NULL, NULL, IMG_BLOCK);
+        io.openKEAImageHeader(h5file);
+        io.addImageBand(kealib::kea_16uint, "band2", IMG_BLOCK);
+
+        // band 1 has values outside the range of the smaller types
+        std::vector<float> band1(IMG_XSIZE * IMG_YSIZE);
+        for( int y = 0; y < IMG_YSIZE; y++ )
+        {
+            for( int x = 0; x < IMG_XSIZE; x++ )
+            {
+                band1[(y * IMG_XSIZE) + x] = (x * 3.0f) - (y * 2.0f) + 0.25f;
+            }
+        }
+        io.writeImageBlock2Band(1, band1.data(), 0, 0, IMG_XSIZE, IMG_YSIZE,
+                    IMG_XSIZE, IMG_YSIZE, kealib::kea_32float);
+
+        // only the top of band 2 is written so the rest is fill value
+        std::vector<uint16_t> band2(IMG_XSIZE * (IMG_YSIZE / 2));
+        for( size_t i = 0; i < band2.size(); i++ )
+        {
+            band2[i] = rand() % 65535;
+        }
+        io.writeImageBlock2Band(2, band2.data(), 0, 0, IMG_XSIZE, IMG_YSIZE / 2,
+                    IMG_XSIZE, IMG_YSIZE / 2, kealib::kea_16uint);
+
+        io.createMask(1);
+        std::vector<uint8_t> mask(IMG_XSIZE * 200);
+        for( size_t i = 0; i < mask.size(); i++ )
+        {
+            mask[i] = i % 251;
+        }
+        io.writeImageBlock2BandMask(1, mask.data(), 0, 100, IMG_XSIZE, 200,
+                    IMG_XSIZE, 200, kealib::kea_8uint);
+
+        io.createOverview(1, 1, OVV_XSIZE, OVV_YSIZE);
+        std::vector<float> overview(OVV_XSIZE * OVV_YSIZE);
+        for( size_t i = 0; i < overview.size(); i++ )
+        {
+            overview[i] = (float)(rand() % 1000) - 500.0f;
+        }
+        io.writeToOverview(1, 1, overview.data(), 0, 0, OVV_XSIZE, OVV_YSIZE,
+                    OVV_XSIZE, OVV_YSIZE, kealib::kea_32float);
+
+        // reference copies of everything in each type, read by HDF5
+        std::vector<char> reference[test_num_datasets][numTestTypes];
+        for( int d = 0; d < test_num_datasets; d++ )
+        {
+            uint64_t xSize, ySize;
+            datasetSize(d, &xSize, &ySize);
+            for( size_t t = 0; t < numTestTypes; t++ )
+            {
+                reference[d][t].resize(xSize * ySize * kealib::getDataTypeSize(testTypes[t]));
+                readDataset(io, d, reference[d][t].data(), 0, 0, xSize, ySize, xSize, ySize, testTypes[t]);
+            }
+        }
+
+        io.setThreadSafe(true);
+
+        std::atomic<int> failures(0);
+        std::atomic<bool> readersDone(false);
+        std::vector<std::thread> threads;
+        for( int r = 0; r < NUM_READERS; r++ )
+        {
+            threads.push_back(std::thread([&, r]()
+            {
+                std::mt19937 rng(r);
+                try
+                {
+                    for( int i = 0; i < NUM_READS; i++ )
+                    {
+                        int d = rng() % test_num_datasets;
+                        size_t t = rng() % numTestTypes;
+                        size_t dtSize = kealib::getDataTypeSize(testTypes[t]);
+                        uint64_t xSize, ySize;
+                        datasetSize(d, &xSize, &ySize);
+                        uint64_t xOff = rng() % xSize;
+                        uint64_t yOff = rng() % ySize;
+                        uint64_t xSizeIn = 1 + (rng() % (xSize - xOff));
+                        uint64_t ySizeIn = 1 + (rng() % (ySize - yOff));
+                        uint64_t xSizeBuf = xSizeIn + (rng() % 3);
+
+                        std::vector<char> data(xSizeBuf * ySizeIn * dtSize);
+                        readDataset(io, d, data.data(), xOff, yOff, xSizeIn, ySizeIn, xSizeBuf, ySizeIn, testTypes[t]);
+                        for( uint64_t y = 0; y < ySizeIn; y++ )
+                        {
+                            const char *expected = reference[d][t].data() + ((((yOff + y) * xSize) + xOff) * dtSize);
+                            if(memcmp(data.data() + (y * xSizeBuf * dtSize), expected, xSizeIn * dtSize) != 0)
+                            {
+                                fprintf(stderr, "Dataset %d type %d window (%d, %d, %d, %d) row %d differs\n", d, (int)testTypes[t],
+                                        (int)xOff, (int)yOff, (int)xSizeIn, (int)ySizeIn, (int)y);
+                                failures++;
+                                break;
+                            }
+                        }
+
+                        std::string description = io.getImageBandDescription(2);
+                        if(description != "band2")
+                        {
+                            fprintf(stderr, "Band description was '%s'\n", description.c_str());
+                            failures++;
+                        }
+                    }
+                }
+                catch(const kealib::KEAException &e)
+                {
+                    fprintf(stderr, "Exception raised in reader: %s\n", e.what());
+                    failures++;
+                }
+            }));
+        }
+
+        // rewrites the same values while the readers run
+        threads.push_back(std::thread([&]()
+        {
+            try
+            {
+                int n = 0;
+                while(!readersDone)
+                {
+                    uint64_t yOff = (n * 37) % (IMG_YSIZE - 64);
+                    io.writeImageBlock2Band(1, band1.data() + (yOff * IMG_XSIZE), 0, yOff, IMG_XSIZE, 64,
+                                IMG_XSIZE, 64, kealib::kea_32float);
+                    io.setImageMetaData("ITERATION", std::to_string(n));
+                    n++;
+                }
+            }
+            catch(const kealib::KEAException &e)
+            {
+                fprintf(stderr, "Exception raised in writer: %s\n", e.what());
+                failures++;
+            }
+        }));
+
+        for( int r = 0; r < NUM_READERS; r++ )
+        {
+            threads[r].join();
+        }
+        readersDone = true;
+        threads.back().join();
+
+        // many reads in flight at once, overlapping so chunks are shared
+        std::vector< std::vector<float> > asyncData(300);
+        std::vector< std::future<void> > asyncReads;
+        std::vector<uint64_t> asyncOffs;
+        for( size_t i = 0; i < asyncData.size(); i++ )
+        {
+            uint64_t xOff = (i * 7) % (IMG_XSIZE - 64);
+            uint64_t yOff = (i * 13) % (IMG_YSIZE - 64);
+            asyncData[i].resize(64 * 64);
+            asyncOffs.push_back((yOff * IMG_XSIZE) + xOff);
+            asyncReads.push_back(io.readImageBlock2BandAsync(1, asyncData[i].data(), xOff, yOff, 64, 64,
+                        64, 64, kealib::kea_32float));
+        }
+        for( size_t i = 0; i < asyncData.size(); i++ )
+        {
+            asyncReads[i].get();
+            const float *refBand1 = (const float*)reference[test_band1][0].data();
+            for( int y = 0; y < 64; y++ )
+            {
+                if(memcmp(asyncData[i].data() + (y * 64), refBand1 + asyncOffs[i] + (y * IMG_XSIZE), 64 * sizeof(float)) != 0)
+                {
+                    fprintf(stderr, "Asynchronous read %d differs\n", (int)i);
+                    failures++;
+                    break;
+                }
+            }
+        }
+
+#ifdef KEA_HAVE_COROUTINES
+        // the same through co_await, and a read of a missing band fails in the coroutine
+        {
+            std::vector<float> awaitData(64 * 64);
+            std::promise<bool> awaitDone;
+            std::future<bool> awaitResult = awaitDone.get_future();
+            awaitRead(io, 1, awaitData.data(), 70, 30, &awaitDone);
+            std::vector<float> badAwaitData(64 * 64);
+            std::promise<bool> badAwaitDone;
+            std::future<bool> badAwaitResult = badAwaitDone.get_future();
+            awaitRead(io, 99, badAwaitData.data(), 0, 0, &badAwaitDone);
+            bool awaitOk = awaitResult.get();
+            const float *refBand1 = (const float*)reference[test_band1][0].data();
+            for( int y = 0; awaitOk && (y < 64); y++ )
+            {
+                awaitOk = (memcmp(awaitData.data() + (y * 64), refBand1 + ((30 + y) * IMG_XSIZE) + 70, 64 * sizeof(float)) == 0);
+            }
+            if(!awaitOk || badAwaitResult.get())
+            {
+                fprintf(stderr, "co_await read differs or did not fail\n");
+                failures++;
+            }
+        }
+#endif
+
+        // re-encoding a band holds HDF5 while other threads are reading it
+        {
+            H5::H5File *copyFile = kealib::KEAImageIO::createKEAImage("test2_copy.kea",
+                            kealib::kea_32float, IMG_XSIZE, IMG_YSIZE, 0);
+            kealib::KEAImageIO copyIO;
+            copyIO.openKEAImageHeader(copyFile);
+            copyIO.setThreadSafe(true);
+            std::atomic<bool> copyDone(false);
+            std::vector<std::thread> copyReaders;
+            for( int r = 0; r < 4; r++ )
+            {
+                copyReaders.push_back(std::thread([&, r]()
+                {
+                    std::vector<float> data(IMG_XSIZE * IMG_BLOCK);
+                    try
+                    {
+                        for( int n = r; !copyDone; n++ )
+                        {
+                            io.readImageBlock2Band(1, data.data(), 0, (n * 61) % (IMG_YSIZE - IMG_BLOCK), IMG_XSIZE, IMG_BLOCK,
+                                        IMG_XSIZE, IMG_BLOCK, kealib::kea_32float);
+                        }
+                    }
+                    catch(const kealib::KEAException &e)
+                    {
+                        fprintf(stderr, "Exception raised in reader: %s\n", e.what());
+                        failures++;
+                    }
+                }));
+            }
+            copyIO.copyBandFrom(&io, 1, IMG_BLOCK / 2, 0);
+            copyDone = true;
+            for( std::thread &reader : copyReaders )
+            {
+                reader.join();
+            }
+            std::vector<float> copied(IMG_XSIZE * IMG_YSIZE);
+            copyIO.readImageBlock2Band(1, copied.data(), 0, 0, IMG_XSIZE, IMG_YSIZE, IMG_XSIZE, IMG_YSIZE, kealib::kea_32float);
+            copyIO.close();
+            if(memcmp(copied.data(), reference[test_band1][0].data(), copied.size() * sizeof(float)) != 0)
+            {
+                fprintf(stderr, "Band copied during reads differs\n");
+                failures++;
+            }
+        }
+
+        // sampled points must match the reference too
+        std::vector<uint64_t> xPxls(1000);
+        std::vector<uint64_t> yPxls(1000);
+        for( size_t i = 0; i < xPxls.size(); i++ )
+        {
+            xPxls[i] = rand() % IMG_XSIZE;
+            yPxls[i] = rand() % IMG_YSIZE;
+        }
+        std::vector<uint32_t> bands = { 1, 2 };
+        std::vector<int16_t> samples(bands.size() * xPxls.size());
+        io.samplePoints(bands, xPxls.data(), yPxls.data(), xPxls.size(), samples.data(), kealib::kea_16int);
+        const int16_t *refBand1 = (const int16_t*)reference[test_band1][3].data();
+        const int16_t *refBand2 = (const int16_t*)reference[test_band2][3].data();
+        for( size_t i = 0; i < xPxls.size(); i++ )
+        {
+            size_t pxl = (yPxls[i] * IMG_XSIZE) + xPxls[i];
+            if((samples[i] != refBand1[pxl]) || (samples[xPxls.size() + i] != refBand2[pxl]))
+            {
+                fprintf(stderr, "Sampled point %d differs\n", (int)i);
+                failures++;
+                break;
+            }
+        }
+
+        // scanlines from several threads through a small write queue so
+        // producers block and partial chunks are merged
+        io.addImageBand(kealib::kea_32int, "band3", IMG_BLOCK);
+        io.setAsyncWriteQueueSize(IMG_XSIZE * sizeof(int32_t) * 16);
+        std::vector<std::thread> writers;
+        for( int w = 0; w < NUM_WRITERS; w++ )
+        {
+            writers.push_back(std::thread([&, w]()
+            {
+                std::vector<int32_t> line(IMG_XSIZE);
+                std::vector< std::future<void> > written;
+                try
+                {
+                    for( int y = w; y < IMG_YSIZE; y += NUM_WRITERS )
+                    {
+                        for( int x = 0; x < IMG_XSIZE; x++ )
+                        {
+                            line[x] = (y * IMG_XSIZE) + x;
+                        }
+                        written.push_back(io.writeImageBlock2BandAsync(3, line.data(), 0, y, IMG_XSIZE, 1,
+                                    IMG_XSIZE, 1, kealib::kea_32int));
+                    }
+                    for( size_t i = 0; i < written.size(); i++ )
+                    {
+                        written[i].get();
+                    }
+                }
+                catch(const kealib::KEAException &e)
+                {
+                    fprintf(stderr, "Exception raised in async writer: %s\n", e.what());
+                    failures++;
+                }
+            }));
+        }
+        for( int w = 0; w < NUM_WRITERS; w++ )
+        {
+            writers[w].join();
+        }
+        io.waitForAsyncWrites();
+
+        std::vector<int32_t> band3(IMG_XSIZE * IMG_YSIZE);
+        io.readImageBlock2Band(3, band3.data(), 0, 0, IMG_XSIZE, IMG_YSIZE,
+                    IMG_XSIZE, IMG_YSIZE, kealib::kea_32int);
+        for( size_t i = 0; i < band3.size(); i++ )
+        {
+            if(band3[i] != (int32_t)i)
+            {
+                fprintf(stderr, "Asynchronously written pixel %d differs\n", (int)i);
+                failures++;
+                break;
+            }
+        }
+
+        // errors come back through the future and waitForAsyncWrites
+        std::future<void> badWrite = io.writeImageBlock2BandAsync(3, band3.data(), 0, IMG_YSIZE - 1, IMG_XSIZE, 2,
+                    IMG_XSIZE, 2, kealib::kea_32int);
+        bool futureFailed = false;
+        try
+        {
+            badWrite.get();
+        }
+        catch(const kealib::KEAException &e)
+        {
+            futureFailed = true;
+        }
+        bool waitFailed = false;
+        try
+        {
+            io.waitForAsyncWrites();
+        }
+        catch(const kealib::KEAException &e)
+        {
+            waitFailed = true;
+        }
+        if(!futureFailed || !waitFailed)
+        {
+            fprintf(stderr, "Failed asynchronous write was not reported\n");
+            failures++;
+        }
+
+        // the writer thread relies on thread safe mode so it can't be switched off
+        bool threadSafeOffFailed = false;
+        try
+        {
+            io.setThreadSafe(false);
+        }
+        catch(const kealib::KEAException &e)
+        {
+            threadSafeOffFailed = true;
+        }
+        if(!threadSafeOffFailed || !io.isThreadSafe())
+        {
+            fprintf(stderr, "Thread safe mode was switched off under the asynchronous writer\n");
+            failures++;
+        }
+
+        // band 4 = band 1 + band 2 through the block processor, with the
+        // unwritten part of band 2 treated as no data. The block size
+        // doesn't divide the image so there are edge blocks.
+        uint16_t band2NoData = 0;
+        float band4NoData = -9999.0f;
+        io.setNoDataValue(2, &band2NoData, kealib::kea_16uint);
+        io.addImageBand(kealib::kea_32float, "band4", IMG_BLOCK);
+        io.setNoDataValue(4, &band4NoData, kealib::kea_32float);
+        kealib::KEABlockProcessor processor(NUM_WRITERS);
+        processor.addInput(&io, 1, kealib::kea_32float);
+        processor.addInput(&io, 2, kealib::kea_32float);
+        processor.addOutput(&io, 4, kealib::kea_32float);
+        processor.setBlockSize(96);
+        std::atomic<uint64_t> processedPixels(0);
+        processor.run([&processedPixels](kealib::KEABlock &block)
+        {
+            const float *in1 = block.getInput<float>(0);
+            const float *in2 = block.getInput<float>(1);
+            float *out = block.getOutput<float>(0);
+            for( uint64_t i = 0; i < block.getNumPixels(); i++ )
+            {
+                if( !block.inputs[1].hasNoData || (in2[i] != block.inputs[1].noData) )
+                    out[i] = in1[i] + in2[i];
+            }
+            processedPixels += block.getNumPixels();
+        });
+        std::vector<float> band4(IMG_XSIZE * IMG_YSIZE);
+        io.readImageBlock2Band(4, band4.data(), 0, 0, IMG_XSIZE, IMG_YSIZE,
+                    IMG_XSIZE, IMG_YSIZE, kealib::kea_32float);
+        for( size_t i = 0; i < band4.size(); i++ )
+        {
+            float expected = (i < band2.size()) && (band2[i] != 0) ? band1[i] + band2[i] : band4NoData;
+            if( (band4[i] != expected) || (processedPixels != band4.size()) )
+            {
+                fprintf(stderr, "Block processor pixel %d differs\n", (int)i);
+                failures++;
+                break;
+            }
+        }
+
+        // an error in the function stops the run and is rethrown
+        bool processorFailed = false;
+        try
+        {
+            processor.run([](kealib::KEABlock &block)
+            {
+                if( block.blockIndex == 5 )
+                    throw kealib::KEAException("stop");
+            });
+        }
+        catch(const kealib::KEAException &e)
+        {
+            processorFailed = true;
+        }
+        if(!processorFailed)
+        {
+            fprintf(stderr, "Block processor error was not reported\n");
+            failures++;
+        }
+
+        io.close();
+
+        if(failures > 0)
+        {
+            fprintf(stderr, "%d failures\n", (int)failures);
+            return 1;
+        }
+    }
+    catch(const kealib::KEAException &e)
+    {
+        fprintf(stderr, "Exception raised: %s\n", e.what());
+        return 1;
+    }
+    printf("Success\n");
+
+    return 0;
+}